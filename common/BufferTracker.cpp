@@ -21,7 +21,6 @@
 #include <memory>
 #include <mutex>
 #include <set>
-#include <stack>
 #include <utility>
 #include <vector>
 
@@ -185,54 +184,31 @@ void ManagedBuffer::setInitialized(bool initialized) {
     mInitialized = initialized;
 }
 
-BufferTracker::BufferTracker() {
-    constexpr size_t kPreallocatedElements = 1024;
-    using StackSpace = std::vector<Request::MemoryDomainToken>;
-    using Stack = std::stack<Request::MemoryDomainToken, StackSpace>;
-    StackSpace stackSpace;
-    stackSpace.reserve(kPreallocatedElements);
-    mFreeTokens = Stack(std::move(stackSpace));
-    mTokenToBuffers.reserve(kPreallocatedElements);
-    mTokenToBuffers.emplace_back();
-}
-
 std::unique_ptr<BufferTracker::Token> BufferTracker::add(std::shared_ptr<ManagedBuffer> buffer) {
     if (buffer == nullptr) {
         return nullptr;
     }
-    std::lock_guard<std::mutex> guard(mMutex);
-    auto token = Request::MemoryDomainToken{0};
-    if (mFreeTokens.empty()) {
-        token = static_cast<Request::MemoryDomainToken>(mTokenToBuffers.size());
-        mTokenToBuffers.push_back(std::move(buffer));
-    } else {
-        token = mFreeTokens.top();
-        mFreeTokens.pop();
-        const auto index = static_cast<uint32_t>(token);
-        mTokenToBuffers[index] = std::move(buffer);
+    const auto token =
+            static_cast<Request::MemoryDomainToken>(mTokenToBuffers.add(std::move(buffer)));
+    if (token == Request::MemoryDomainToken{0}) {
+        LOG(ERROR) << "BufferTracker::add -- out of tokens";
+        return nullptr;
     }
     VLOG(MEMORY) << "BufferTracker::add -- new token = " << token;
     return std::make_unique<Token>(token, shared_from_this());
 }
 
 std::shared_ptr<ManagedBuffer> BufferTracker::get(Request::MemoryDomainToken token) const {
-    std::lock_guard<std::mutex> guard(mMutex);
-    const auto index = static_cast<uint32_t>(token);
-    if (mTokenToBuffers.size() <= index || mTokenToBuffers[index] == nullptr) {
+    auto buffer = mTokenToBuffers.get(static_cast<uint32_t>(token));
+    if (buffer == nullptr) {
         LOG(ERROR) << "BufferTracker::get -- unknown token " << token;
-        return nullptr;
     }
-    return mTokenToBuffers[index];
+    return buffer;
 }
 
 void BufferTracker::free(Request::MemoryDomainToken token) {
-    std::lock_guard<std::mutex> guard(mMutex);
-    const auto index = static_cast<uint32_t>(token);
-    CHECK_LT(index, mTokenToBuffers.size());
-    CHECK(mTokenToBuffers[index] != nullptr);
     VLOG(MEMORY) << "BufferTracker::free -- release token = " << token;
-    mTokenToBuffers[index] = nullptr;
-    mFreeTokens.push(token);
+    CHECK(mTokenToBuffers.free(static_cast<uint32_t>(token)) != nullptr);
 }
 
 }  // namespace android::nn
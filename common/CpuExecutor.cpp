@@ -22,6 +22,8 @@
 #include <nnapi/SharedMemory.h>
 #include <nnapi/TypeUtils.h>
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <utility>
@@ -66,8 +68,16 @@ class OperationExecutionContext : public IOperationExecutionContext {
     DISALLOW_IMPLICIT_CONSTRUCTORS(OperationExecutionContext);
 
    public:
-    OperationExecutionContext(const Operation* operation, RunTimeOperandInfo* operands)
-        : operation(operation), operands(operands) {}
+    // When allocateOutputs is false, setOutputShape() only records the
+    // shapes, for a context that runs the prepare function of an operation
+    // and not its execute function.
+    OperationExecutionContext(const Operation* operation, RunTimeOperandInfo* operands,
+                              const CancellationToken* cancellationToken,
+                              bool allocateOutputs = true)
+        : operation(operation),
+          operands(operands),
+          cancellationToken(cancellationToken),
+          allocateOutputs(allocateOutputs) {}
 
     uint32_t getNumInputs() const override;
     OperandType getInputType(uint32_t index) const override;
@@ -88,6 +98,8 @@ class OperationExecutionContext : public IOperationExecutionContext {
     bool isOmittedInput(uint32_t index) const override;
     bool isOmittedOutput(uint32_t index) const override;
 
+    const CancellationToken* getCancellationToken() const override { return cancellationToken; }
+
     // Return false if any of inputs or outputs is omitted, i.e. has lifetime of NO_VALUE.
     bool checkNoOmittedOperand() const;
     // Return false if any of inputs has dimension 0.
@@ -100,6 +112,8 @@ class OperationExecutionContext : public IOperationExecutionContext {
 
     const Operation* operation;
     RunTimeOperandInfo* operands;
+    const CancellationToken* cancellationToken;
+    const bool allocateOutputs;
 
     int result = ANEURALNETWORKS_NO_ERROR;
 };
@@ -159,13 +173,9 @@ int OperationExecutionContext::getResultCode() const {
     return result;
 }
 
-// TODO: Return error code directly once we've fully integrated OperationResolver with all ops.
-// Updates the RunTimeOperandInfo with the newly calculated shape.
-// Allocate the buffer if we need to.
-//
-// TODO(b/153081229): This function currently cannot handle extension operands well. We need to
-//                    propagate the extension type info into this function.
-bool setInfoAndAllocateIfNeeded(RunTimeOperandInfo* info, const Shape& shape, int* result) {
+// Updates the RunTimeOperandInfo with the newly calculated shape, without
+// allocating its buffer.
+bool setInfo(RunTimeOperandInfo* info, const Shape& shape, int* result) {
     // For user-provided model output operands, the parameters must match the Shape
     // calculated from the preparation step.
     if (info->lifetime == Operand::LifeTime::SUBGRAPH_OUTPUT) {
@@ -211,6 +221,20 @@ bool setInfoAndAllocateIfNeeded(RunTimeOperandInfo* info, const Shape& shape, in
         *result = ANEURALNETWORKS_OP_FAILED;
         return false;
     }
+    *result = ANEURALNETWORKS_NO_ERROR;
+    return true;
+}
+
+// TODO: Return error code directly once we've fully integrated OperationResolver with all ops.
+// Updates the RunTimeOperandInfo with the newly calculated shape.
+// Allocate the buffer if we need to.
+//
+// TODO(b/153081229): This function currently cannot handle extension operands well. We need to
+//                    propagate the extension type info into this function.
+bool setInfoAndAllocateIfNeeded(RunTimeOperandInfo* info, const Shape& shape, int* result) {
+    if (!setInfo(info, shape, result)) {
+        return false;
+    }
 
     // Allocate the buffer only if the combined dimension is fully specified
     if (info->buffer == nullptr && (info->lifetime == Operand::LifeTime::TEMPORARY_VARIABLE ||
@@ -242,6 +266,9 @@ bool setInfoAndAllocateIfNeeded(RunTimeOperandInfo* info, const Shape& shape, in
 }
 
 bool OperationExecutionContext::setOutputShape(uint32_t index, const Shape& shape) {
+    if (!allocateOutputs) {
+        return setInfo(getOutputInfo(index), shape, &result);
+    }
     return setInfoAndAllocateIfNeeded(getOutputInfo(index), shape, &result);
 }
 
@@ -563,6 +590,8 @@ int CpuExecutor::run(const Model& model, const Request& request,
     mModelOperandValues = model.operandValues.data();
     mModelPoolInfos = &modelPoolInfos;
     mReferencedSubgraphs = &model.referenced;
+    const CancellationToken runCancellationToken(mDeadline, mCancellationToken);
+    mRunCancellationToken = &runCancellationToken;
 
     // b/109953668, disable OpenMP
 #ifdef NNAPI_OPENMP
@@ -594,13 +623,69 @@ int CpuExecutor::run(const Model& model, const Request& request,
     mModelOperandValues = nullptr;
     mModelPoolInfos = nullptr;
     mReferencedSubgraphs = nullptr;
+    mRunCancellationToken = nullptr;
+    return result;
+}
+
+int CpuExecutor::inferOutputShapes(const Model& model, const Request& request,
+                                   const std::vector<RunTimePoolInfo>& modelPoolInfos,
+                                   const std::vector<RunTimePoolInfo>& requestPoolInfos) {
+    NNTRACE_CPU(NNTRACE_PHASE_PREPARATION, "inferOutputShapes");
+    mModelOperandValues = model.operandValues.data();
+    mModelPoolInfos = &modelPoolInfos;
+    mReferencedSubgraphs = &model.referenced;
+    const CancellationToken runCancellationToken(mDeadline, mCancellationToken);
+    mRunCancellationToken = &runCancellationToken;
+
+    std::vector<RunTimeOperandInfo> operands = initializeRunTimeInfo(model.main);
+    updateForArguments(model.main.inputIndexes, request.inputs, requestPoolInfos, operands.data());
+    updateForArguments(model.main.outputIndexes, request.outputs, requestPoolInfos,
+                       operands.data());
+    // The prepare functions may read the values of their inputs, which the
+    // operations that are not executed here do not produce.
+    const auto hasValue = [&operands](uint32_t index) {
+        const RunTimeOperandInfo& operand = operands[index];
+        return operand.lifetime == Operand::LifeTime::NO_VALUE || operand.buffer != nullptr;
+    };
+    int result = ANEURALNETWORKS_NO_ERROR;
+    for (const auto& operation : model.main.operations) {
+        if (std::all_of(operation.inputs.begin(), operation.inputs.end(), hasValue) &&
+            !prepareOperation(operation, operands.data())) {
+            LOG(ERROR) << "CpuExecutor::inferOutputShapes: " << operation.type << " failed.";
+            result = ANEURALNETWORKS_OP_FAILED;
+            break;
+        }
+    }
+
+    if (result == ANEURALNETWORKS_NO_ERROR) {
+        setOutputShapes(model.main.outputIndexes, operands);
+    } else {
+        mOutputShapes.clear();
+    }
+
+    mFinished = true;
+    mModelOperandValues = nullptr;
+    mModelPoolInfos = nullptr;
+    mReferencedSubgraphs = nullptr;
+    mRunCancellationToken = nullptr;
     return result;
 }
 
+int CpuExecutor::getCancellationResultCode() const {
+    if (mCancellationToken != nullptr && mCancellationToken->isCancelRequested()) {
+        VLOG(CPUEXE) << "CpuExecutor: the execution was cancelled";
+        return ANEURALNETWORKS_OP_FAILED;
+    }
+    return ANEURALNETWORKS_MISSED_DEADLINE_TRANSIENT;
+}
+
 int CpuExecutor::executeSubgraph(const Model::Subgraph& subgraph, RunTimeOperandInfo* operands) {
     VLOG(CPUEXE) << "CpuExecutor::executeSubgraph " << subgraph;
     // The graph has serialized the operation in execution order.
     for (const auto& operation : subgraph.operations) {
+        if (mOperationBoundaryCallback) {
+            mOperationBoundaryCallback();
+        }
         NN_RETURN_IF_ERROR(executeOperation(operation, operands));
     }
     return ANEURALNETWORKS_NO_ERROR;
@@ -718,8 +803,8 @@ void CpuExecutor::updateForArguments(const std::vector<uint32_t>& indexes,
 int CpuExecutor::executeOperation([[maybe_unused]] const Operation& operation,
                                   [[maybe_unused]] RunTimeOperandInfo* operands) {
 #ifdef NN_INCLUDE_CPU_IMPLEMENTATION
-    if (hasDeadlinePassed(mDeadline)) {
-        return ANEURALNETWORKS_MISSED_DEADLINE_TRANSIENT;
+    if (mRunCancellationToken->isCancelled()) {
+        return getCancellationResultCode();
     }
     if (operation.type == OperationType::IF) {
         int result = executeIfOperation(operation, operands);
@@ -1654,7 +1739,7 @@ int CpuExecutor::executeOperation([[maybe_unused]] const Operation& operation,
                        operationRegistration->execute == nullptr) {
                 LOG(ERROR) << "Incomplete operation registration: " << operation.type;
             } else {
-                OperationExecutionContext context(&operation, operands);
+                OperationExecutionContext context(&operation, operands, mRunCancellationToken);
                 success = operationRegistration->flags.allowOmittedOperand ||
                           context.checkNoOmittedOperand();
                 success = success && (operationRegistration->flags.allowZeroSizedInput ||
@@ -1666,7 +1751,9 @@ int CpuExecutor::executeOperation([[maybe_unused]] const Operation& operation,
         }
     }
     if (!success && result == ANEURALNETWORKS_NO_ERROR) {
-        result = ANEURALNETWORKS_OP_FAILED;
+        // The operation may have given up because the execution was cancelled.
+        result = mRunCancellationToken->isCancelled() ? getCancellationResultCode()
+                                                      : ANEURALNETWORKS_OP_FAILED;
     }
     if (result != ANEURALNETWORKS_NO_ERROR) {
         LOG(ERROR) << operation.type << " failed.";
@@ -1680,6 +1767,84 @@ int CpuExecutor::executeOperation([[maybe_unused]] const Operation& operation,
 #endif  // NN_INCLUDE_CPU_IMPLEMENTATION
 }
 
+bool CpuExecutor::prepareOperation([[maybe_unused]] const Operation& operation,
+                                   [[maybe_unused]] RunTimeOperandInfo* operands) {
+#ifdef NN_INCLUDE_CPU_IMPLEMENTATION
+    if (operation.type == OperationType::IF || operation.type == OperationType::WHILE) {
+        // The shapes of the outputs depend on the referenced subgraphs.
+        return true;
+    }
+    const std::vector<uint32_t>& ins = operation.inputs;
+    const std::vector<uint32_t>& outs = operation.outputs;
+    // As in executeOperation(), none of the inputs of the operations that are
+    // not registered with the OperationResolver are optional. Those with an
+    // omitted input are left for executeOperation() to report.
+    const bool allInputsPresent =
+            std::none_of(ins.begin(), ins.end(), [operands](uint32_t index) {
+                return operands[index].lifetime == Operand::LifeTime::NO_VALUE;
+            });
+    RunTimeOperandInfo& output = operands[outs[0]];
+    Shape outShape = output.shape();
+    int result = ANEURALNETWORKS_NO_ERROR;
+    switch (operation.type) {
+        case OperationType::PAD:
+        case OperationType::PAD_V2: {
+            if (!allInputsPresent || ins.size() < 2) return true;
+            const RunTimeOperandInfo& paddings = operands[ins[1]];
+            return padPrepare(operands[ins[0]].shape(),
+                              reinterpret_cast<const int32_t*>(paddings.buffer), paddings.shape(),
+                              &outShape) &&
+                   setInfo(&output, outShape, &result);
+        }
+        case OperationType::CAST:
+            if (!allInputsPresent || ins.size() != 1) return true;
+            return cast::prepare(operands[ins[0]].shape(), &outShape) &&
+                   setInfo(&output, outShape, &result);
+        case OperationType::EXPAND_DIMS:
+            if (!allInputsPresent || ins.size() != 2) return true;
+            return expand_dims::prepare(operands[ins[0]].shape(),
+                                        getScalarData<int32_t>(operands[ins[1]]), &outShape) &&
+                   setInfo(&output, outShape, &result);
+        case OperationType::MAXIMUM:
+        case OperationType::MINIMUM:
+            if (!allInputsPresent || ins.size() != 2) return true;
+            return maximum_minimum::prepare(operands[ins[0]].shape(), operands[ins[1]].shape(),
+                                            &outShape) &&
+                   setInfo(&output, outShape, &result);
+        case OperationType::TILE: {
+            if (!allInputsPresent || ins.size() != 2) return true;
+            const RunTimeOperandInfo& multiples = operands[ins[1]];
+            return tile::prepare(operands[ins[0]].shape(),
+                                 reinterpret_cast<const int32_t*>(multiples.buffer),
+                                 multiples.shape(), &outShape) &&
+                   setInfo(&output, outShape, &result);
+        }
+        case OperationType::POW:
+            if (!allInputsPresent || ins.size() != 2) return true;
+            return pow::prepare(operands[ins[0]].shape(), operands[ins[1]].shape(), &outShape) &&
+                   setInfo(&output, outShape, &result);
+        default: {
+            const OperationRegistration* operationRegistration =
+                    mOperationResolver->findOperation(operation.type);
+            if (operationRegistration == nullptr || operationRegistration->prepare == nullptr) {
+                // The other operations compute the shapes of their outputs as
+                // they execute.
+                return true;
+            }
+            OperationExecutionContext context(&operation, operands, mRunCancellationToken,
+                                              /*allocateOutputs=*/false);
+            return (operationRegistration->flags.allowOmittedOperand ||
+                    context.checkNoOmittedOperand()) &&
+                   (operationRegistration->flags.allowZeroSizedInput ||
+                    context.checkNoZeroSizedInput()) &&
+                   operationRegistration->prepare(&context);
+        }
+    }
+#else
+    return true;
+#endif  // NN_INCLUDE_CPU_IMPLEMENTATION
+}
+
 // Copies RunTimeOperandInfo, preserving the original lifetime and numberOfUsesLeft
 // to prevent deallocation of subgraph inputs and outputs.
 static void setInfoExceptLifetime(RunTimeOperandInfo* to, const RunTimeOperandInfo& from) {
@@ -1729,6 +1894,44 @@ int CpuExecutor::executeIfOperation(const Operation& operation, RunTimeOperandIn
     return ANEURALNETWORKS_NO_ERROR;
 }
 
+// Keeps the temporaries of a subgraph allocated across its executions by a
+// WHILE loop, instead of freeing them once consumed and allocating them again
+// on the next iteration. Returns the temporaries whose shape is not fully
+// specified, which may need a different buffer on each iteration.
+static std::vector<uint32_t> retainLoopTemporaries(const Model::Subgraph& subgraph,
+                                                   std::vector<RunTimeOperandInfo>* operands) {
+    std::vector<uint32_t> unknownShapeTemporaries;
+    for (uint32_t i = 0, n = operands->size(); i < n; ++i) {
+        RunTimeOperandInfo& info = (*operands)[i];
+        if (info.lifetime != Operand::LifeTime::TEMPORARY_VARIABLE) {
+            continue;
+        }
+        info.numberOfUsesLeft = 0;
+        if (nonExtensionOperandSizeOfData(subgraph.operands[i]) == 0) {
+            unknownShapeTemporaries.push_back(i);
+        }
+    }
+    return unknownShapeTemporaries;
+}
+
+// Frees the temporaries of unknown shape of the previous iteration.
+static void resetLoopTemporaries(const Model::Subgraph& subgraph,
+                                 const std::vector<uint32_t>& unknownShapeTemporaries,
+                                 RunTimeOperandInfo* operands) {
+    for (uint32_t i : unknownShapeTemporaries) {
+        RunTimeOperandInfo& info = operands[i];
+        info.dimensions = subgraph.operands[i].dimensions;
+        delete[] info.buffer;
+        info.buffer = nullptr;
+        info.length = 0;
+    }
+}
+
+static bool overlaps(const RunTimeOperandInfo& a, const RunTimeOperandInfo& b) {
+    return a.buffer != nullptr && b.buffer != nullptr && a.buffer < b.buffer + b.length &&
+           b.buffer < a.buffer + a.length;
+}
+
 int CpuExecutor::executeWhileOperation(const Operation& operation, RunTimeOperandInfo* operands) {
     namespace op = operation_while;
     const RunTimeOperandInfo& condModelOperand = operands[operation.inputs[op::kCondModelOperand]];
@@ -1739,6 +1942,10 @@ int CpuExecutor::executeWhileOperation(const Operation& operation, RunTimeOperan
             *reinterpret_cast<const Model::Subgraph*>(bodyModelOperand.buffer);
     std::vector<RunTimeOperandInfo> condOperands = initializeRunTimeInfo(condSubgraph);
     std::vector<RunTimeOperandInfo> bodyOperands = initializeRunTimeInfo(bodySubgraph);
+    const std::vector<uint32_t> condUnknownShapeTemporaries =
+            retainLoopTemporaries(condSubgraph, &condOperands);
+    const std::vector<uint32_t> bodyUnknownShapeTemporaries =
+            retainLoopTemporaries(bodySubgraph, &bodyOperands);
 
     // The code below implements the following sequence of subgraph input and output buffer
     // assignments:
@@ -1746,18 +1953,28 @@ int CpuExecutor::executeWhileOperation(const Operation& operation, RunTimeOperan
     // iteration = 1   cond inputs = body inputs = tmp1           body outputs = tmp2
     // iteration = 2   cond inputs = body inputs = tmp2           body outputs = tmp1
     // iteration = 3   cond inputs = body inputs = ...            body outputs = ...
+    //
+    // Where possible, tmp1 is the buffer of the outer output, so that the outputs
+    // of loops with an odd number of iterations need not be copied.
 
     // For body output double buffering.
-    std::vector<uint8_t*> tmp1(bodySubgraph.outputIndexes.size());
-    std::vector<uint8_t*> tmp2(bodySubgraph.outputIndexes.size());
+    struct LoopBuffer {
+        uint8_t* buffer = nullptr;
+        uint32_t length = 0;
+        // Whether the buffer was allocated for the loop, rather than being
+        // the buffer of the outer output.
+        bool owned = true;
+    };
+    std::vector<LoopBuffer> tmp1(bodySubgraph.outputIndexes.size());
+    std::vector<LoopBuffer> tmp2(bodySubgraph.outputIndexes.size());
 
     // Ensure objects are freed
     auto cleanupGuard = base::make_scope_guard(
             [&tmp1, &tmp2, &condOperands, &bodyOperands, &operation, &operands] {
-                auto freeLoopOutputs = [](const std::vector<uint8_t*>& tmp) {
-                    for (auto buffer : tmp) {
-                        if (buffer != nullptr) {
-                            delete[] buffer;
+                auto freeLoopOutputs = [](const std::vector<LoopBuffer>& tmp) {
+                    for (const auto& buffer : tmp) {
+                        if (buffer.owned) {
+                            delete[] buffer.buffer;
                         }
                     }
                 };
@@ -1778,6 +1995,33 @@ int CpuExecutor::executeWhileOperation(const Operation& operation, RunTimeOperan
         bodyOutputHasUnknownShape[i] = nonExtensionOperandSizeOfData(operand) == 0;
     }
 
+    // Write the body outputs of known shape directly to the outer outputs on
+    // even iterations, unless the outer outputs may alias the outer inputs
+    // that the first iteration reads.
+    for (uint32_t i = 0, n = bodySubgraph.outputIndexes.size(); i < n; ++i) {
+        RunTimeOperandInfo& outerOperand = operands[operation.outputs[i]];
+        if (bodyOutputHasUnknownShape[i] ||
+            (outerOperand.lifetime != Operand::LifeTime::TEMPORARY_VARIABLE &&
+             outerOperand.lifetime != Operand::LifeTime::SUBGRAPH_OUTPUT)) {
+            continue;
+        }
+        const RunTimeOperandInfo& bodyOutput = bodyOperands[bodySubgraph.outputIndexes[i]];
+        int error = ANEURALNETWORKS_NO_ERROR;
+        if (!setInfoAndAllocateIfNeeded(&outerOperand, bodyOutput.shape(), &error)) {
+            return error;
+        }
+        const bool aliasesInput = std::any_of(
+                operation.inputs.begin() + op::kFirstInput, operation.inputs.end(),
+                [&outerOperand, operands](uint32_t input) {
+                    return overlaps(outerOperand, operands[input]);
+                });
+        if (!aliasesInput) {
+            tmp1[i] = {.buffer = outerOperand.buffer,
+                       .length = outerOperand.length,
+                       .owned = false};
+        }
+    }
+
     // Initialize condition inputs from outer operands.
     for (uint32_t i = 0, n = condSubgraph.inputIndexes.size(); i < n; ++i) {
         setInfoExceptLifetime(&condOperands[condSubgraph.inputIndexes[i]],
@@ -1801,6 +2045,7 @@ int CpuExecutor::executeWhileOperation(const Operation& operation, RunTimeOperan
                                       bodyOperands[bodySubgraph.outputIndexes[i]]);
             }
         }
+        resetLoopTemporaries(condSubgraph, condUnknownShapeTemporaries, condOperands.data());
         NN_RETURN_IF_ERROR(executeSubgraph(condSubgraph, condOperands.data()));
         VLOG(CPUEXE) << "CpuExecutor::executeWhileOperation: condition value: "
                      << static_cast<int>(condValue);
@@ -1827,32 +2072,38 @@ int CpuExecutor::executeWhileOperation(const Operation& operation, RunTimeOperan
             if (bodyOutputHasUnknownShape[i]) {
                 // Reset dimensions and buffer.
                 info.dimensions = bodySubgraph.operands[bodySubgraph.outputIndexes[i]].dimensions;
-                if (outputBuffer[i] != nullptr) {
-                    delete[] outputBuffer[i];
-                    outputBuffer[i] = nullptr;
-                }
+                delete[] outputBuffer[i].buffer;
+                outputBuffer[i] = {};
             }
-            info.buffer = outputBuffer[i];
+            info.buffer = outputBuffer[i].buffer;
+            info.length = outputBuffer[i].length;
         }
 
+        resetLoopTemporaries(bodySubgraph, bodyUnknownShapeTemporaries, bodyOperands.data());
         NN_RETURN_IF_ERROR(executeSubgraph(bodySubgraph, bodyOperands.data()));
 
         // Update output buffer information in case we have allocated new buffers.
         for (uint32_t i = 0, n = bodySubgraph.outputIndexes.size(); i < n; ++i) {
-            outputBuffer[i] = bodyOperands[bodySubgraph.outputIndexes[i]].buffer;
+            const RunTimeOperandInfo& info = bodyOperands[bodySubgraph.outputIndexes[i]];
+            if (info.buffer != outputBuffer[i].buffer) {
+                outputBuffer[i] = {.buffer = info.buffer, .length = info.length};
+            }
         }
     }
 
-    // Copy body outputs to outer outputs.
+    // Copy body outputs to outer outputs, unless the last iteration wrote them.
     for (uint32_t i = 0, n = operation.outputs.size(); i < n; ++i) {
         RunTimeOperandInfo& outerOperand = operands[operation.outputs[i]];
         RunTimeOperandInfo& innerOperand = condOperands[condSubgraph.inputIndexes[i]];
         if (int error; !setInfoAndAllocateIfNeeded(&outerOperand, innerOperand.shape(), &error)) {
             return error;
         }
-        CHECK_EQ(outerOperand.length, innerOperand.length);
-        // TODO: Use the outer buffer as tmp1 to avoid copies.
-        std::memcpy(outerOperand.buffer, innerOperand.buffer, innerOperand.length);
+        if (outerOperand.buffer == innerOperand.buffer) {
+            continue;
+        }
+        CHECK_GE(outerOperand.length, innerOperand.length);
+        std::memcpy(outerOperand.buffer, innerOperand.buffer,
+                    nonExtensionOperandSizeOfData(innerOperand.type, innerOperand.dimensions));
     }
 
     return ANEURALNETWORKS_NO_ERROR;
@@ -0,0 +1,469 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CpuModelOptimizer"
+
+#include "CpuModelOptimizer.h"
+
+#include <android-base/logging.h>
+#include <nnapi/TypeUtils.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ControlFlow.h"
+#include "LegacyUtils.h"
+#include "NeuralNetworks.h"
+#include "Tracing.h"
+
+namespace android::nn {
+namespace {
+
+// Larger constants would grow the prepared model more than folding saves.
+constexpr uint32_t kMaxFoldedValueLength = 1 << 20;
+
+// The most bytes that folding appends to the operand values of a model.
+constexpr size_t kMaxFoldedValuesLength = 16 << 20;
+
+bool hasValueBeforeExecution(const Operand& operand) {
+    switch (operand.lifetime) {
+        case Operand::LifeTime::CONSTANT_COPY:
+        case Operand::LifeTime::CONSTANT_REFERENCE:
+        case Operand::LifeTime::POINTER:
+        case Operand::LifeTime::NO_VALUE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Whether the outputs of an operation of this type only depend on its inputs.
+bool isPure(OperationType type) {
+    switch (type) {
+        case OperationType::IF:
+        case OperationType::WHILE:
+        case OperationType::OEM_OPERATION:
+        case OperationType::RANDOM_MULTINOMIAL:
+            return false;
+        default:
+            return !isExtension(type);
+    }
+}
+
+bool isFloatTensorOfKnownShape(const Operand& operand) {
+    return (operand.type == OperandType::TENSOR_FLOAT32 ||
+            operand.type == OperandType::TENSOR_FLOAT16) &&
+           !tensorHasUnspecifiedDimensions(operand);
+}
+
+// Returns the shape of the broadcast of two tensors, or std::nullopt if they
+// cannot be broadcast together.
+std::optional<Dimensions> broadcastShapes(const Dimensions& a, const Dimensions& b) {
+    Dimensions result(std::max(a.size(), b.size()));
+    for (size_t i = 1; i <= result.size(); ++i) {
+        const uint32_t dimA = i <= a.size() ? a[a.size() - i] : 1;
+        const uint32_t dimB = i <= b.size() ? b[b.size() - i] : 1;
+        if (dimA != dimB && dimA != 1 && dimB != 1) {
+            return std::nullopt;
+        }
+        result[result.size() - i] = std::max(dimA, dimB);
+    }
+    return result;
+}
+
+// Whether the operation cannot fail, whatever the values of its inputs. A loop
+// invariant is only hoisted if it cannot fail, because the hoisted operation
+// also runs when the loop does not iterate. This is the case of elementwise
+// floating point operations whose shapes are known and consistent, and whose
+// fused activation, if any, is a valid constant.
+bool cannotFail(const Model& model, const Model::Subgraph& subgraph, const Operation& operation) {
+    size_t tensorInputCount = 0;
+    bool hasActivation = false;
+    switch (operation.type) {
+        case OperationType::ADD:
+        case OperationType::MUL:
+        case OperationType::SUB:
+            hasActivation = true;
+            [[fallthrough]];
+        case OperationType::MAXIMUM:
+        case OperationType::MINIMUM:
+            tensorInputCount = 2;
+            break;
+        case OperationType::ABS:
+        case OperationType::EXP:
+        case OperationType::FLOOR:
+        case OperationType::HARD_SWISH:
+        case OperationType::LOG:
+        case OperationType::LOGISTIC:
+        case OperationType::NEG:
+        case OperationType::RELU:
+        case OperationType::RELU1:
+        case OperationType::RELU6:
+        case OperationType::RSQRT:
+        case OperationType::SIN:
+        case OperationType::SQRT:
+        case OperationType::TANH:
+            tensorInputCount = 1;
+            break;
+        default:
+            return false;
+    }
+    if (operation.inputs.size() != tensorInputCount + (hasActivation ? 1 : 0) ||
+        operation.outputs.size() != 1) {
+        return false;
+    }
+    const Operand& output = subgraph.operands[operation.outputs[0]];
+    if (!isFloatTensorOfKnownShape(output)) {
+        return false;
+    }
+    std::optional<Dimensions> shape;
+    for (size_t i = 0; i < tensorInputCount; ++i) {
+        const Operand& input = subgraph.operands[operation.inputs[i]];
+        if (!isFloatTensorOfKnownShape(input) || input.type != output.type) {
+            return false;
+        }
+        shape = shape.has_value() ? broadcastShapes(*shape, input.dimensions) : input.dimensions;
+        if (!shape.has_value()) {
+            return false;
+        }
+    }
+    if (*shape != output.dimensions) {
+        return false;
+    }
+    if (hasActivation) {
+        const Operand& activation = subgraph.operands[operation.inputs[tensorInputCount]];
+        if (activation.type != OperandType::INT32 ||
+            activation.lifetime != Operand::LifeTime::CONSTANT_COPY ||
+            activation.location.length != sizeof(int32_t)) {
+            return false;
+        }
+        int32_t value = 0;
+        std::memcpy(&value, model.operandValues.data() + activation.location.offset,
+                    sizeof(value));
+        if (value < ANEURALNETWORKS_FUSED_NONE || value > ANEURALNETWORKS_FUSED_RELU6) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether the outputs of the operation are temporaries of a fully specified
+// shape, which can become constants or temporaries of another subgraph.
+bool hasMovableOutputs(const Model::Subgraph& subgraph, const Operation& operation) {
+    return std::all_of(operation.outputs.begin(), operation.outputs.end(), [&](uint32_t index) {
+        const Operand& operand = subgraph.operands[index];
+        return operand.lifetime == Operand::LifeTime::TEMPORARY_VARIABLE &&
+               !isExtension(operand.type) && nonExtensionOperandSizeOfData(operand) != 0;
+    });
+}
+
+// The number of operations that use each referenced subgraph.
+std::vector<uint32_t> countSubgraphReferences(const Model& model) {
+    std::vector<uint32_t> counts(model.referenced.size(), 0);
+    auto count = [&counts](const Model::Subgraph& subgraph) {
+        for (const Operation& operation : subgraph.operations) {
+            for (uint32_t input : operation.inputs) {
+                const Operand& operand = subgraph.operands[input];
+                if (operand.lifetime == Operand::LifeTime::SUBGRAPH) {
+                    ++counts[operand.location.offset];
+                }
+            }
+        }
+    };
+    count(model.main);
+    std::for_each(model.referenced.begin(), model.referenced.end(), count);
+    return counts;
+}
+
+#ifdef NN_INCLUDE_CPU_IMPLEMENTATION
+
+// Executes an operation of `subgraph` whose inputs all have a value before
+// execution, and returns the values of its outputs.
+std::optional<std::vector<std::vector<uint8_t>>> evaluate(
+        const Model& model, const Model::Subgraph& subgraph, const Operation& operation,
+        const std::vector<RunTimePoolInfo>& modelPoolInfos) {
+    Model evaluated;
+    std::unordered_map<uint32_t, uint32_t> indexes;
+    auto addOperand = [&](uint32_t index) -> std::optional<uint32_t> {
+        const auto [it, inserted] = indexes.try_emplace(index, evaluated.main.operands.size());
+        if (!inserted) {
+            return it->second;
+        }
+        Operand operand = subgraph.operands[index];
+        const DataLocation location = operand.location;
+        if (operand.lifetime == Operand::LifeTime::CONSTANT_COPY) {
+            operand.location = {.pointer = model.operandValues.data() + location.offset,
+                                .length = location.length};
+            operand.lifetime = Operand::LifeTime::POINTER;
+        } else if (operand.lifetime == Operand::LifeTime::CONSTANT_REFERENCE) {
+            if (location.poolIndex >= modelPoolInfos.size()) {
+                return std::nullopt;
+            }
+            const uint8_t* buffer = modelPoolInfos[location.poolIndex].getBuffer();
+            operand.location = {.pointer = buffer + location.offset, .length = location.length};
+            operand.lifetime = Operand::LifeTime::POINTER;
+        } else if (operand.lifetime == Operand::LifeTime::TEMPORARY_VARIABLE) {
+            operand.lifetime = Operand::LifeTime::SUBGRAPH_OUTPUT;
+        }
+        evaluated.main.operands.push_back(std::move(operand));
+        return it->second;
+    };
+
+    Operation evaluatedOperation = {.type = operation.type};
+    for (uint32_t input : operation.inputs) {
+        const auto index = addOperand(input);
+        if (!index.has_value()) {
+            return std::nullopt;
+        }
+        evaluatedOperation.inputs.push_back(*index);
+    }
+    std::vector<std::vector<uint8_t>> values;
+    Request request;
+    for (uint32_t output : operation.outputs) {
+        const auto index = addOperand(output);
+        if (!index.has_value()) {
+            return std::nullopt;
+        }
+        evaluatedOperation.outputs.push_back(*index);
+        evaluated.main.outputIndexes.push_back(*index);
+        values.emplace_back(nonExtensionOperandSizeOfData(subgraph.operands[output]));
+    }
+    for (auto& value : values) {
+        request.outputs.push_back(
+                {.lifetime = Request::Argument::LifeTime::POINTER,
+                 .location = {.pointer = static_cast<void*>(value.data()),
+                              .length = static_cast<uint32_t>(value.size())}});
+    }
+    evaluated.main.operations.push_back(std::move(evaluatedOperation));
+
+    CpuExecutor executor;
+    if (executor.run(evaluated, request, {}, {}) != ANEURALNETWORKS_NO_ERROR) {
+        return std::nullopt;
+    }
+    return values;
+}
+
+// Replaces the operations of `subgraph` whose inputs are all constant by the
+// values of their outputs, in execution order, so that an operation that only
+// depends on folded operations is folded too. Stops folding once the values
+// would exceed *valuesLengthLeft bytes, and subtracts the bytes it appends.
+uint32_t foldConstants(Model* model, Model::Subgraph* subgraph,
+                       const std::vector<RunTimePoolInfo>& modelPoolInfos,
+                       size_t* valuesLengthLeft) {
+    uint32_t folded = 0;
+    std::vector<Operation> operations;
+    operations.reserve(subgraph->operations.size());
+    for (Operation& operation : subgraph->operations) {
+        size_t valuesLength = 0;
+        for (uint32_t output : operation.outputs) {
+            valuesLength += nonExtensionOperandSizeOfData(subgraph->operands[output]);
+        }
+        const bool foldable =
+                isPure(operation.type) && hasMovableOutputs(*subgraph, operation) &&
+                valuesLength <= *valuesLengthLeft &&
+                std::all_of(operation.inputs.begin(), operation.inputs.end(),
+                            [subgraph](uint32_t input) {
+                                return hasValueBeforeExecution(subgraph->operands[input]);
+                            }) &&
+                std::all_of(operation.outputs.begin(), operation.outputs.end(),
+                            [subgraph](uint32_t output) {
+                                return nonExtensionOperandSizeOfData(subgraph->operands[output]) <=
+                                       kMaxFoldedValueLength;
+                            });
+        const auto values =
+                foldable ? evaluate(*model, *subgraph, operation, modelPoolInfos) : std::nullopt;
+        if (!values.has_value()) {
+            operations.push_back(std::move(operation));
+            continue;
+        }
+        for (size_t i = 0; i < operation.outputs.size(); ++i) {
+            const std::vector<uint8_t>& value = (*values)[i];
+            Operand& operand = subgraph->operands[operation.outputs[i]];
+            operand.lifetime = Operand::LifeTime::CONSTANT_COPY;
+            operand.location = model->operandValues.append(value.data(), value.size());
+        }
+        *valuesLengthLeft -= valuesLength;
+        ++folded;
+    }
+    subgraph->operations = std::move(operations);
+    return folded;
+}
+
+#endif  // NN_INCLUDE_CPU_IMPLEMENTATION
+
+// Removes from the body of `whileOperation` the operations that cannot fail and
+// only depend on constants, on input-only operands of the loop and on other
+// such operations, and returns them rewritten as operations of `outer`, the
+// subgraph of the WHILE operation. Their outputs that the rest of the body uses
+// become input-only operands of the loop.
+std::vector<Operation> hoistLoopInvariants(Model* model, Model::Subgraph* outer,
+                                           Operation* whileOperation) {
+    namespace op = operation_while;
+    const uint32_t condModelOperand = whileOperation->inputs[op::kCondModelOperand];
+    const uint32_t bodyModelOperand = whileOperation->inputs[op::kBodyModelOperand];
+    Model::Subgraph& cond = model->referenced[outer->operands[condModelOperand].location.offset];
+    Model::Subgraph& body = model->referenced[outer->operands[bodyModelOperand].location.offset];
+
+    // Whether each operand of the body has the same value on every iteration.
+    std::vector<bool> invariant(body.operands.size());
+    for (uint32_t i = 0; i < body.operands.size(); ++i) {
+        invariant[i] = hasValueBeforeExecution(body.operands[i]);
+    }
+    // The operand of `outer` of each body operand that hoisted operations use
+    // or produce.
+    std::unordered_map<uint32_t, uint32_t> outerOperands;
+    for (uint32_t i = body.outputIndexes.size(); i < body.inputIndexes.size(); ++i) {
+        invariant[body.inputIndexes[i]] = true;
+        outerOperands.emplace(body.inputIndexes[i], whileOperation->inputs[op::kFirstInput + i]);
+    }
+    auto getOuterOperand = [&](uint32_t index) {
+        const auto [it, inserted] = outerOperands.try_emplace(index, outer->operands.size());
+        if (inserted) {
+            outer->operands.push_back(body.operands[index]);
+        }
+        return it->second;
+    };
+
+    std::vector<Operation> hoisted;
+    std::vector<uint32_t> hoistedOutputs;
+    std::vector<Operation> remaining;
+    for (Operation& operation : body.operations) {
+        const bool isInvariant = cannotFail(*model, body, operation) &&
+                                 hasMovableOutputs(body, operation) &&
+                                 std::all_of(operation.inputs.begin(), operation.inputs.end(),
+                                             [&invariant](uint32_t i) { return invariant[i]; });
+        if (!isInvariant) {
+            remaining.push_back(std::move(operation));
+            continue;
+        }
+        Operation outerOperation = {.type = operation.type};
+        std::transform(operation.inputs.begin(), operation.inputs.end(),
+                       std::back_inserter(outerOperation.inputs), getOuterOperand);
+        std::transform(operation.outputs.begin(), operation.outputs.end(),
+                       std::back_inserter(outerOperation.outputs), getOuterOperand);
+        for (uint32_t output : operation.outputs) {
+            invariant[output] = true;
+            hoistedOutputs.push_back(output);
+        }
+        hoisted.push_back(std::move(outerOperation));
+    }
+    body.operations = std::move(remaining);
+
+    std::vector<bool> used(body.operands.size(), false);
+    for (const Operation& operation : body.operations) {
+        for (uint32_t input : operation.inputs) {
+            used[input] = true;
+        }
+    }
+    // The condition and body subgraphs take the same inputs.
+    for (uint32_t index : hoistedOutputs) {
+        if (!used[index]) {
+            continue;
+        }
+        Operand& operand = body.operands[index];
+        operand.lifetime = Operand::LifeTime::SUBGRAPH_INPUT;
+        body.inputIndexes.push_back(index);
+        cond.inputIndexes.push_back(cond.operands.size());
+        cond.operands.push_back(operand);
+        whileOperation->inputs.push_back(outerOperands.at(index));
+    }
+    return hoisted;
+}
+
+bool canHoistFrom(const Model::Subgraph& subgraph, const Operation& whileOperation,
+                  const std::vector<uint32_t>& referenceCounts) {
+    namespace op = operation_while;
+    const Operand& cond = subgraph.operands[whileOperation.inputs[op::kCondModelOperand]];
+    const Operand& body = subgraph.operands[whileOperation.inputs[op::kBodyModelOperand]];
+    return cond.lifetime == Operand::LifeTime::SUBGRAPH &&
+           body.lifetime == Operand::LifeTime::SUBGRAPH &&
+           referenceCounts[cond.location.offset] == 1 &&
+           referenceCounts[body.location.offset] == 1;
+}
+
+class CpuModelOptimizer {
+   public:
+    CpuModelOptimizer(Model* model, const std::vector<RunTimePoolInfo>& modelPoolInfos)
+        : mModel(model),
+          mModelPoolInfos(modelPoolInfos),
+          mReferenceCounts(countSubgraphReferences(*model)),
+          mOptimized(model->referenced.size(), false) {}
+
+    CpuModelOptimizationStats optimize() {
+        optimize(&mModel->main);
+        return mStats;
+    }
+
+   private:
+    void optimize(Model::Subgraph* subgraph) {
+        // Inner subgraphs first, so that the operations hoisted out of an inner
+        // loop can be hoisted again out of an outer loop.
+        for (const Operation& operation : subgraph->operations) {
+            for (uint32_t input : operation.inputs) {
+                const Operand& operand = subgraph->operands[input];
+                if (operand.lifetime == Operand::LifeTime::SUBGRAPH &&
+                    !mOptimized[operand.location.offset]) {
+                    mOptimized[operand.location.offset] = true;
+                    optimize(&mModel->referenced[operand.location.offset]);
+                }
+            }
+        }
+
+        std::vector<Operation> operations;
+        operations.reserve(subgraph->operations.size());
+        for (Operation& operation : subgraph->operations) {
+            if (operation.type == OperationType::WHILE &&
+                canHoistFrom(*subgraph, operation, mReferenceCounts)) {
+                std::vector<Operation> hoisted = hoistLoopInvariants(mModel, subgraph, &operation);
+                mStats.hoistedOperations += hoisted.size();
+                operations.insert(operations.end(), std::make_move_iterator(hoisted.begin()),
+                                  std::make_move_iterator(hoisted.end()));
+            }
+            operations.push_back(std::move(operation));
+        }
+        subgraph->operations = std::move(operations);
+
+        // After hoisting, as the hoisted operations may only depend on
+        // constants of this subgraph.
+#ifdef NN_INCLUDE_CPU_IMPLEMENTATION
+        mStats.foldedOperations +=
+                foldConstants(mModel, subgraph, mModelPoolInfos, &mFoldedValuesLengthLeft);
+#endif  // NN_INCLUDE_CPU_IMPLEMENTATION
+    }
+
+    Model* const mModel;
+    const std::vector<RunTimePoolInfo>& mModelPoolInfos;
+    const std::vector<uint32_t> mReferenceCounts;
+    std::vector<bool> mOptimized;
+    size_t mFoldedValuesLengthLeft = kMaxFoldedValuesLength;
+    CpuModelOptimizationStats mStats;
+};
+
+}  // namespace
+
+CpuModelOptimizationStats optimizeModelForCpu(Model* model,
+                                              const std::vector<RunTimePoolInfo>& modelPoolInfos) {
+    NNTRACE_CPU(NNTRACE_PHASE_PREPARATION, "optimizeModelForCpu");
+    CHECK(model != nullptr);
+    return CpuModelOptimizer(model, modelPoolInfos).optimize();
+}
+
+}  // namespace android::nn
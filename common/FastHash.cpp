@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FastHash"
+
+#include "FastHash.h"
+
+#include <cstring>
+
+namespace android {
+namespace nn {
+
+namespace {
+
+constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+
+constexpr size_t kStripeSize = 32;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Reads are little-endian on all supported targets.
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+    acc ^= round(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+inline uint64_t avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Computes XXH64 and leaves the four lane accumulators in lanes.
+uint64_t xxh64(const uint8_t* p, size_t length, uint64_t seed, uint64_t (&lanes)[4]) {
+    const uint8_t* const end = p + length;
+    lanes[0] = seed + kPrime1 + kPrime2;
+    lanes[1] = seed + kPrime2;
+    lanes[2] = seed;
+    lanes[3] = seed - kPrime1;
+
+    uint64_t h;
+    if (length >= kStripeSize) {
+        const uint8_t* const limit = end - kStripeSize;
+        do {
+            lanes[0] = round(lanes[0], read64(p));
+            lanes[1] = round(lanes[1], read64(p + 8));
+            lanes[2] = round(lanes[2], read64(p + 16));
+            lanes[3] = round(lanes[3], read64(p + 24));
+            p += kStripeSize;
+        } while (p <= limit);
+        h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+        for (uint64_t lane : lanes) {
+            h = mergeRound(h, lane);
+        }
+    } else {
+        h = seed + kPrime5;
+    }
+    h += length;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+    return avalanche(h);
+}
+
+}  // namespace
+
+uint64_t fastHash64(const void* data, size_t length, uint64_t seed) {
+    uint64_t lanes[4];
+    return xxh64(static_cast<const uint8_t*>(data), length, seed, lanes);
+}
+
+void fastHash256(const void* data, size_t length, uint8_t* out) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t lanes[4];
+    const uint64_t digest = xxh64(bytes, length, 0, lanes);
+    // XXH64 only folds the bytes after the last full stripe into the digest,
+    // so an input shorter than a stripe would leave the lanes at their seeds.
+    // Absorb the tail, zero padded to a stripe, into every lane as well.
+    const size_t tailLength = length % kStripeSize;
+    uint8_t tail[kStripeSize] = {};
+    // data may be null for an empty input.
+    if (tailLength > 0) {
+        std::memcpy(tail, bytes + length - tailLength, tailLength);
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        lanes[i] = round(lanes[i], read64(tail + i * sizeof(uint64_t)) ^ digest);
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        const uint64_t word = avalanche(lanes[i] ^ (digest + kPrime4 * (i + 1)));
+        std::memcpy(out + i * sizeof(word), &word, sizeof(word));
+    }
+}
+
+}  // namespace nn
+}  // namespace android
@@ -21,7 +21,6 @@
 #include <memory>
 #include <mutex>
 #include <set>
-#include <stack>
 #include <utility>
 #include <vector>
 
@@ -193,36 +192,26 @@ std::unique_ptr<HalBufferTracker::Token> HalBufferTracker::add(
     if (buffer == nullptr) {
         return nullptr;
     }
-    std::lock_guard<std::mutex> guard(mMutex);
-    uint32_t token = 0;
-    if (mFreeTokens.empty()) {
-        token = mTokenToBuffers.size();
-        mTokenToBuffers.push_back(std::move(buffer));
-    } else {
-        token = mFreeTokens.top();
-        mFreeTokens.pop();
-        mTokenToBuffers[token] = std::move(buffer);
+    const uint32_t token = mTokenToBuffers.add(std::move(buffer));
+    if (token == 0) {
+        LOG(ERROR) << "HalBufferTracker::add -- out of tokens";
+        return nullptr;
     }
     VLOG(MEMORY) << "HalBufferTracker::add -- new token = " << token;
     return std::make_unique<Token>(token, shared_from_this());
 }
 
 std::shared_ptr<HalManagedBuffer> HalBufferTracker::get(uint32_t token) const {
-    std::lock_guard<std::mutex> guard(mMutex);
-    if (mTokenToBuffers.size() <= token || mTokenToBuffers[token] == nullptr) {
+    auto buffer = mTokenToBuffers.get(token);
+    if (buffer == nullptr) {
         LOG(ERROR) << "HalBufferTracker::get -- unknown token " << token;
-        return nullptr;
     }
-    return mTokenToBuffers[token];
+    return buffer;
 }
 
 void HalBufferTracker::free(uint32_t token) {
-    std::lock_guard<std::mutex> guard(mMutex);
-    CHECK_LT(token, mTokenToBuffers.size());
-    CHECK(mTokenToBuffers[token] != nullptr);
     VLOG(MEMORY) << "HalBufferTracker::free -- release token = " << token;
-    mTokenToBuffers[token] = nullptr;
-    mFreeTokens.push(token);
+    CHECK(mTokenToBuffers.free(token) != nullptr);
 }
 
 }  // namespace android::nn
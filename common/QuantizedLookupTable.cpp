@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Operations"
+
+#include "QuantizedLookupTable.h"
+
+#include <android-base/logging.h>
+#include <android-base/no_destructor.h>
+#include <android-base/thread_annotations.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <shared_mutex>
+#include <tuple>
+#include <vector>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif  // defined(__aarch64__)
+
+namespace android {
+namespace nn {
+namespace {
+
+// A model has few distinct activation quantizations and constant scalar
+// operands. Scalars that are model inputs may each need a table, so the least
+// recently used table is evicted once the cache is full, rather than the
+// tables that every execution uses.
+constexpr size_t kMaxCachedTables = 64;
+
+// The operation, the type, scale and zero point of its input and output, and
+// its other parameters.
+using TableKey = std::tuple<OperationType, OperandType, float, int32_t, OperandType, float, int32_t,
+                            std::vector<int32_t>>;
+
+class QuantizedLookupTableCache {
+   public:
+    static QuantizedLookupTableCache& get() {
+        static base::NoDestructor<QuantizedLookupTableCache> cache;
+        return *cache;
+    }
+
+    // Lookups far outnumber insertions, so they only take the lock shared and
+    // executions on different threads do not wait for each other. A lookup
+    // marks the table as used since the latest insertion, which is as precise
+    // as eviction needs to be.
+    std::shared_ptr<const QuantizedLookupTable> find(const TableKey& key) const {
+        mMutex.lock_shared();
+        const auto it = mTables.find(key);
+        std::shared_ptr<const QuantizedLookupTable> table;
+        if (it != mTables.end()) {
+            table = it->second.table;
+            const uint64_t insertions = mInsertions.load(std::memory_order_relaxed);
+            // Only the first lookup since the latest insertion writes.
+            if (it->second.lastUse.load(std::memory_order_relaxed) != insertions) {
+                it->second.lastUse.store(insertions, std::memory_order_relaxed);
+            }
+        }
+        mMutex.unlock_shared();
+        return table;
+    }
+
+    void insert(const TableKey& key, std::shared_ptr<const QuantizedLookupTable> table) {
+        std::lock_guard<std::shared_mutex> guard(mMutex);
+        const uint64_t insertions = mInsertions.load(std::memory_order_relaxed) + 1;
+        mInsertions.store(insertions, std::memory_order_relaxed);
+        if (const auto it = mTables.find(key); it != mTables.end()) {
+            it->second.lastUse.store(insertions, std::memory_order_relaxed);
+            return;
+        }
+        if (mTables.size() >= kMaxCachedTables) {
+            const auto leastRecentlyUsed = std::min_element(
+                    mTables.begin(), mTables.end(), [](const auto& a, const auto& b) {
+                        return a.second.lastUse.load(std::memory_order_relaxed) <
+                               b.second.lastUse.load(std::memory_order_relaxed);
+                    });
+            mTables.erase(leastRecentlyUsed);
+        }
+        mTables.try_emplace(key, std::move(table), insertions);
+    }
+
+   private:
+    struct Entry {
+        Entry(std::shared_ptr<const QuantizedLookupTable> table, uint64_t lastUse)
+            : table(std::move(table)), lastUse(lastUse) {}
+
+        const std::shared_ptr<const QuantizedLookupTable> table;
+        // The value of mInsertions when the table was last used.
+        mutable std::atomic<uint64_t> lastUse;
+    };
+
+    mutable std::shared_mutex mMutex;
+    std::map<TableKey, Entry> mTables GUARDED_BY(mMutex);
+    // Only written with mMutex held exclusively.
+    std::atomic<uint64_t> mInsertions = 0;
+};
+
+}  // namespace
+
+std::shared_ptr<const QuantizedLookupTable> getQuantizedLookupTable(
+        OperationType operationType, const Shape& inputShape, const Shape& outputShape,
+        const QuantizedElementwiseFunction& compute, const std::vector<int32_t>& parameters) {
+    const TableKey key = {operationType,      inputShape.type,  inputShape.scale,
+                          inputShape.offset,  outputShape.type, outputShape.scale,
+                          outputShape.offset, parameters};
+    QuantizedLookupTableCache& cache = QuantizedLookupTableCache::get();
+    if (auto table = cache.find(key)) {
+        return table;
+    }
+    // Two threads may both compute a missing table. They compute the same one.
+    uint8_t inputs[256];
+    std::iota(std::begin(inputs), std::end(inputs), 0);
+    auto table = std::make_shared<QuantizedLookupTable>();
+    if (!compute(inputs, 256, table->data())) {
+        LOG(ERROR) << "Unable to compute the lookup table of " << operationType;
+        return nullptr;
+    }
+    cache.insert(key, table);
+    return table;
+}
+
+void applyQuantizedLookupTable(const QuantizedLookupTable& table, const uint8_t* input,
+                               uint32_t size, uint8_t* output) {
+    uint32_t i = 0;
+#if defined(__aarch64__)
+    // TBL looks up 16 bytes at once in a table of up to 64 bytes, and returns 0
+    // for the indexes past the end of the table. The table is split in four,
+    // each looked up with the index rebased to its first entry.
+    const uint8x16x4_t table0 = vld1q_u8_x4(table.data());
+    const uint8x16x4_t table1 = vld1q_u8_x4(table.data() + 64);
+    const uint8x16x4_t table2 = vld1q_u8_x4(table.data() + 128);
+    const uint8x16x4_t table3 = vld1q_u8_x4(table.data() + 192);
+    const uint8x16_t offset = vdupq_n_u8(64);
+    for (; i + 16 <= size; i += 16) {
+        const uint8x16_t index0 = vld1q_u8(input + i);
+        const uint8x16_t index1 = vsubq_u8(index0, offset);
+        const uint8x16_t index2 = vsubq_u8(index1, offset);
+        const uint8x16_t index3 = vsubq_u8(index2, offset);
+        uint8x16_t result = vqtbl4q_u8(table0, index0);
+        result = vqtbx4q_u8(result, table1, index1);
+        result = vqtbx4q_u8(result, table2, index2);
+        result = vqtbx4q_u8(result, table3, index3);
+        vst1q_u8(output + i, result);
+    }
+#endif  // defined(__aarch64__)
+    for (; i < size; ++i) {
+        output[i] = table[input[i]];
+    }
+}
+
+}  // namespace nn
+}  // namespace android
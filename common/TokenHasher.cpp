@@ -38,15 +38,35 @@ TokenHasher::TokenHasher(const uint8_t* token) : mIsError(token == nullptr) {
 
 bool TokenHasher::update(const void* bytes, size_t length) {
     CHECK(!mIsError) << "Calling update on an token in error state";
-    if (SHA256_Update(&mHasher, bytes, length) == 0) {
+    if (mBuffer.size() + length > kBatchSize && !flush()) {
+        return false;
+    }
+    if (length >= kBatchSize) {
+        if (SHA256_Update(&mHasher, bytes, length) == 0) {
+            mIsError = true;
+            return false;
+        }
+        return true;
+    }
+    const auto* begin = static_cast<const uint8_t*>(bytes);
+    mBuffer.insert(mBuffer.end(), begin, begin + length);
+    return true;
+}
+
+bool TokenHasher::flush() {
+    if (!mBuffer.empty() && SHA256_Update(&mHasher, mBuffer.data(), mBuffer.size()) == 0) {
         mIsError = true;
         return false;
     }
+    mBuffer.clear();
     return true;
 }
 
 bool TokenHasher::finish() {
     CHECK(!mIsError) << "Calling finish on an token in error state";
+    if (!flush()) {
+        return false;
+    }
     static_assert(SHA256_DIGEST_LENGTH == ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN,
                   "SHA256_DIGEST_LENGTH != ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN");
     mToken.resize(ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN);
@@ -17,14 +17,20 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "FastHash.h"
 #include "HalInterfaces.h"
 #include "MemoryUtils.h"
 #include "OperationsExecutionUtils.h"
 #include "QuantUtils.h"
+#include "QuantizedLookupTable.h"
+#include "TokenHasher.h"
 #include "Utils.h"
 #include "ValidateHal.h"
 #include "nnapi/TypeUtils.h"
@@ -370,6 +376,168 @@ TEST(QuantizationUtilTest, GetInvSqrtQuantizedMultiplierExp) {
     checkInvSqrtQuantization(kInt32Max, 189812531, 12);
 }
 
+TEST(FastHashTest, MatchesXxh64) {
+    const auto hash = [](const std::string& s) { return fastHash64(s.data(), s.size()); };
+    EXPECT_EQ(hash(""), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(hash("abc"), 0x44BC2CF5AD770999ULL);
+    EXPECT_EQ(hash("Nobody inspects the spammish repetition"), 0xFBCEA83C8A378BF1ULL);
+}
+
+TEST(FastHashTest, Hash256DependsOnEveryByte) {
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+    uint8_t reference[kFastHash256Size];
+    fastHash256(data.data(), data.size(), reference);
+    for (size_t i : {0ul, 31ul, 32ul, 500ul, 998ul, 999ul}) {
+        data[i] ^= 1;
+        uint8_t hash[kFastHash256Size];
+        fastHash256(data.data(), data.size(), hash);
+        data[i] ^= 1;
+        for (size_t word = 0; word < kFastHash256Size; word += sizeof(uint64_t)) {
+            EXPECT_NE(std::memcmp(hash + word, reference + word, sizeof(uint64_t)), 0)
+                    << "byte " << i << ", word " << word / sizeof(uint64_t);
+        }
+    }
+}
+
+TEST(FastHashTest, Hash256OfShortInputsUsesEveryLane) {
+    // Inputs shorter than a stripe that differ in one byte differ in every
+    // 64-bit word, and the words are not copies of each other.
+    for (size_t length = 1; length < 32; ++length) {
+        std::vector<uint8_t> data(length, 0x5A);
+        uint8_t reference[kFastHash256Size];
+        fastHash256(data.data(), data.size(), reference);
+        uint64_t words[4];
+        std::memcpy(words, reference, sizeof(words));
+        EXPECT_NE(words[0], words[1]) << "length " << length;
+        EXPECT_NE(words[2], words[3]) << "length " << length;
+        for (size_t i = 0; i < length; ++i) {
+            data[i] ^= 0x80;
+            uint8_t hash[kFastHash256Size];
+            fastHash256(data.data(), data.size(), hash);
+            data[i] ^= 0x80;
+            for (size_t word = 0; word < kFastHash256Size; word += sizeof(uint64_t)) {
+                EXPECT_NE(std::memcmp(hash + word, reference + word, sizeof(uint64_t)), 0)
+                        << "length " << length << ", byte " << i << ", word "
+                        << word / sizeof(uint64_t);
+            }
+        }
+    }
+}
+
+TEST(FastHashTest, Hash256OfEmptyInput) {
+    uint8_t fromNull[kFastHash256Size];
+    fastHash256(nullptr, 0, fromNull);
+    const uint8_t byte = 0;
+    uint8_t fromEmpty[kFastHash256Size];
+    fastHash256(&byte, 0, fromEmpty);
+    EXPECT_EQ(std::memcmp(fromNull, fromEmpty, kFastHash256Size), 0);
+}
+
+TEST(FastHashTest, HashBufferSeparatesVectors) {
+    // Vectors with the same concatenation but split differently append
+    // different bytes.
+    HashBuffer buffer1;
+    buffer1.append(std::vector<uint32_t>{1, 2});
+    buffer1.append(std::vector<uint32_t>{3});
+    HashBuffer buffer2;
+    buffer2.append(std::vector<uint32_t>{1});
+    buffer2.append(std::vector<uint32_t>{2, 3});
+    ASSERT_EQ(buffer1.size(), buffer2.size());
+    EXPECT_NE(std::memcmp(buffer1.data(), buffer2.data(), buffer1.size()), 0);
+}
+
+TEST(QuantizedLookupTableTest, MatchesFunction) {
+    int calls = 0;
+    const QuantizedElementwiseFunction square = [&calls](const uint8_t* input, uint32_t size,
+                                                         uint8_t* output) {
+        ++calls;
+        for (uint32_t i = 0; i < size; ++i) {
+            const int8_t value = static_cast<int8_t>(input[i]);
+            output[i] = static_cast<uint8_t>(std::min(value * value, 127));
+        }
+        return true;
+    };
+    const Shape shape = {.type = OperandType::TENSOR_QUANT8_ASYMM_SIGNED,
+                         .dimensions = {1001},
+                         .scale = 0.125f,
+                         .offset = -3};
+    const auto table = getQuantizedLookupTable(OperationType::ABS, shape, shape, square);
+    ASSERT_NE(table, nullptr);
+    EXPECT_EQ(getQuantizedLookupTable(OperationType::ABS, shape, shape, square), table);
+    EXPECT_EQ(calls, 1);
+
+    // An odd number of elements, so that some are not looked up 16 at a time.
+    std::vector<int8_t> input(1001);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<int8_t>(i * 37);
+    }
+    std::vector<int8_t> expected(input.size());
+    ASSERT_TRUE(square(reinterpret_cast<const uint8_t*>(input.data()), input.size(),
+                       reinterpret_cast<uint8_t*>(expected.data())));
+    std::vector<int8_t> output(input.size());
+    applyQuantizedLookupTable(*table, reinterpret_cast<const uint8_t*>(input.data()),
+                              input.size(), reinterpret_cast<uint8_t*>(output.data()));
+    EXPECT_EQ(output, expected);
+}
+
+TEST(QuantizedLookupTableTest, KeepsTablesInUse) {
+    int calls = 0;
+    const QuantizedElementwiseFunction identity = [&calls](const uint8_t* input, uint32_t size,
+                                                           uint8_t* output) {
+        ++calls;
+        std::copy(input, input + size, output);
+        return true;
+    };
+    const Shape shape = {.type = OperandType::TENSOR_QUANT8_ASYMM,
+                         .dimensions = {1000},
+                         .scale = 0.5f,
+                         .offset = 7};
+    // Far more tables than the cache holds, such as those of a scalar that is
+    // a model input, do not evict the table that every execution uses.
+    const auto table =
+            getQuantizedLookupTable(OperationType::FLOOR, shape, shape, identity, {-1});
+    ASSERT_NE(table, nullptr);
+    for (int32_t i = 0; i < 1000; ++i) {
+        ASSERT_NE(getQuantizedLookupTable(OperationType::FLOOR, shape, shape, identity, {i}),
+                  nullptr);
+        EXPECT_EQ(getQuantizedLookupTable(OperationType::FLOOR, shape, shape, identity, {-1}),
+                  table);
+    }
+    EXPECT_EQ(calls, 1001);
+}
+
+TEST(TokenHasherTest, BatchingDoesNotChangeToken) {
+    const std::vector<uint8_t> seed(ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN, 1);
+    std::vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+
+    TokenHasher oneUpdate(seed.data());
+    ASSERT_TRUE(oneUpdate.update(data.data(), data.size()));
+    ASSERT_TRUE(oneUpdate.finish());
+
+    // Mix small updates, which are batched, with large ones, which are not.
+    TokenHasher manyUpdates(seed.data());
+    size_t offset = 0;
+    for (size_t length : {1ul, 3ul, 4ul, 8ul, 5000ul, 2ul, 7ul}) {
+        ASSERT_TRUE(manyUpdates.update(data.data() + offset, length));
+        offset += length;
+    }
+    while (offset < data.size()) {
+        ASSERT_TRUE(manyUpdates.update(data.data() + offset, 1));
+        ++offset;
+    }
+    ASSERT_TRUE(manyUpdates.finish());
+
+    EXPECT_EQ(std::memcmp(oneUpdate.getCacheToken(), manyUpdates.getCacheToken(),
+                          ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN),
+              0);
+}
+
 }  // namespace wrapper
 }  // namespace nn
 }  // namespace android
@@ -25,6 +25,7 @@
 #include "ActivationFunctor.h"
 #include "OperationResolver.h"
 #include "OperationsExecutionUtils.h"
+#include "QuantizedLookupTable.h"
 #include "Tracing.h"
 
 #ifdef NN_INCLUDE_CPU_IMPLEMENTATION
@@ -358,6 +359,25 @@ bool hardSwishQuant(const T* inputData, const Shape& inputShape, T* outputData,
     return true;
 }
 
+// Computes a quant8 activation with a lookup table when the tensor is large
+// enough. The table is filled by the activation function itself, so the results
+// are the same either way.
+template <typename T>
+bool quant8Activation(OperationType opType,
+                      bool activation(const T*, const Shape&, T*, const Shape&),
+                      const T* inputData, const Shape& inputShape, T* outputData,
+                      const Shape& outputShape) {
+    return computeQuantizedElementwise<T>(
+            opType, inputData, inputShape, outputData, outputShape,
+            [&](const T* input, uint32_t size, T* output) {
+                Shape flatInputShape = inputShape;
+                flatInputShape.dimensions = {size};
+                Shape flatOutputShape = outputShape;
+                flatOutputShape.dimensions = {size};
+                return activation(input, flatInputShape, output, flatOutputShape);
+            });
+}
+
 }  // namespace
 
 bool prepare(OperationType opType, IOperationExecutionContext* context) {
@@ -496,15 +516,17 @@ bool executeLogistic(IOperationExecutionContext* context) {
                                  context->getOutputBuffer<float>(kOutputTensor),
                                  context->getOutputShape(kOutputTensor));
         case OperandType::TENSOR_QUANT8_ASYMM:
-            return logisticQuant8(context->getInputBuffer<uint8_t>(kInputTensor),
-                                  context->getInputShape(kInputTensor),
-                                  context->getOutputBuffer<uint8_t>(kOutputTensor),
-                                  context->getOutputShape(kOutputTensor));
+            return quant8Activation(OperationType::LOGISTIC, logisticQuant8,
+                                    context->getInputBuffer<uint8_t>(kInputTensor),
+                                    context->getInputShape(kInputTensor),
+                                    context->getOutputBuffer<uint8_t>(kOutputTensor),
+                                    context->getOutputShape(kOutputTensor));
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-            return logisticQuant8Signed(context->getInputBuffer<int8_t>(kInputTensor),
-                                        context->getInputShape(kInputTensor),
-                                        context->getOutputBuffer<int8_t>(kOutputTensor),
-                                        context->getOutputShape(kOutputTensor));
+            return quant8Activation(OperationType::LOGISTIC, logisticQuant8Signed,
+                                    context->getInputBuffer<int8_t>(kInputTensor),
+                                    context->getInputShape(kInputTensor),
+                                    context->getOutputBuffer<int8_t>(kOutputTensor),
+                                    context->getOutputShape(kOutputTensor));
         default:
             NN_RET_CHECK_FAIL() << "Unsupported tensor type for operation LOGISTIC";
     }
@@ -525,12 +547,14 @@ bool executeTanh(IOperationExecutionContext* context) {
                                context->getOutputBuffer<float>(kOutputTensor),
                                context->getOutputShape(kOutputTensor));
         case OperandType::TENSOR_QUANT8_ASYMM:
-            return tanhQuant8(context->getInputBuffer<uint8_t>(kInputTensor),
-                              context->getInputShape(kInputTensor),
-                              context->getOutputBuffer<uint8_t>(kOutputTensor),
-                              context->getOutputShape(kOutputTensor));
+            return quant8Activation(OperationType::TANH, tanhQuant8,
+                                    context->getInputBuffer<uint8_t>(kInputTensor),
+                                    context->getInputShape(kInputTensor),
+                                    context->getOutputBuffer<uint8_t>(kOutputTensor),
+                                    context->getOutputShape(kOutputTensor));
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-            return tanhQuant8Signed(context->getInputBuffer<int8_t>(kInputTensor),
+            return quant8Activation(OperationType::TANH, tanhQuant8Signed,
+                                    context->getInputBuffer<int8_t>(kInputTensor),
                                     context->getInputShape(kInputTensor),
                                     context->getOutputBuffer<int8_t>(kOutputTensor),
                                     context->getOutputShape(kOutputTensor));
@@ -564,15 +588,17 @@ bool executeHardSwish(IOperationExecutionContext* context) {
             return true;
         }
         case OperandType::TENSOR_QUANT8_ASYMM:
-            return hardSwishQuant(context->getInputBuffer<uint8_t>(kInputTensor),
-                                  context->getInputShape(kInputTensor),
-                                  context->getOutputBuffer<uint8_t>(kOutputTensor),
-                                  context->getOutputShape(kOutputTensor));
+            return quant8Activation(OperationType::HARD_SWISH, hardSwishQuant<uint8_t>,
+                                    context->getInputBuffer<uint8_t>(kInputTensor),
+                                    context->getInputShape(kInputTensor),
+                                    context->getOutputBuffer<uint8_t>(kOutputTensor),
+                                    context->getOutputShape(kOutputTensor));
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-            return hardSwishQuant(context->getInputBuffer<int8_t>(kInputTensor),
-                                  context->getInputShape(kInputTensor),
-                                  context->getOutputBuffer<int8_t>(kOutputTensor),
-                                  context->getOutputShape(kOutputTensor));
+            return quant8Activation(OperationType::HARD_SWISH, hardSwishQuant<int8_t>,
+                                    context->getInputBuffer<int8_t>(kInputTensor),
+                                    context->getInputShape(kInputTensor),
+                                    context->getOutputBuffer<int8_t>(kOutputTensor),
+                                    context->getOutputShape(kOutputTensor));
         default:
             NN_RET_CHECK_FAIL() << "Unsupported tensor type for operation TANH";
     }
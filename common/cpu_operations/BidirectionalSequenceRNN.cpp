@@ -225,6 +225,9 @@ bool executeTyped(IOperationExecutionContext* context) {
 
     // Forward pass
     for (uint32_t i = 0; i < maxTime; ++i) {
+        if (context->isCancelled()) {
+            return false;
+        }
         const T* inputBatchPtr = input + i * batchSize * inputSize;
         const T* auxInputBatchPtr = nullptr;
         if (hasAuxWeights) {
@@ -244,6 +247,9 @@ bool executeTyped(IOperationExecutionContext* context) {
 
     // Backward pass
     for (int i = maxTime - 1; i >= 0; --i) {
+        if (context->isCancelled()) {
+            return false;
+        }
         const T* inputBatchPtr = bwInput + i * batchSize * inputSize;
         const T* auxInputBatchPtr = nullptr;
         if (hasAuxWeights) {
@@ -21,7 +21,9 @@
 #include "Broadcast.h"
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <type_traits>
 #include <vector>
 
 #include "IndexedShapeWrapper.h"
@@ -44,6 +46,11 @@
 #pragma clang diagnostic pop
 
 #include "CpuOperationUtils.h"
+#include "QuantizedLookupTable.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif  // defined(__aarch64__)
 #endif  // NN_INCLUDE_CPU_IMPLEMENTATION
 
 namespace android {
@@ -409,6 +416,173 @@ bool subQuant8(const T* in1, const Shape& shape1, const T* in2, const Shape& sha
     return true;
 }
 
+// Tensors with fewer elements than this are computed with the general kernels
+// when an input is a scalar, as building the table costs a computation on 256
+// elements.
+constexpr uint32_t kMinElementsForScalarTable = 1024;
+
+template <typename T>
+using binaryFunctionQuant8 = bool (*)(const T* in1, const Shape& shape1, const T* in2,
+                                      const Shape& shape2, int32_t activation, T* out,
+                                      const Shape& shapeOut);
+
+// An ADD or SUB whose inputs are quantized like its output needs no rescaling:
+// the output is in1 + in2 - zeroPoint for ADD and in1 - in2 + zeroPoint for
+// SUB, clamped to the activation range. This is exactly what the fixed-point
+// kernels compute for such quantizations.
+template <typename T, bool isSub>
+void addSameQuantization(const T* in1, const T* in2, uint32_t size, int32_t zeroPoint,
+                         int32_t activationMin, int32_t activationMax, T* out) {
+    uint32_t i = 0;
+#if defined(__aarch64__)
+    // 16 lanes at a time, computed on 16 bits.
+    const int16x8_t offset = vdupq_n_s16(isSub ? zeroPoint : -zeroPoint);
+    const int16x8_t minimum = vdupq_n_s16(activationMin);
+    const int16x8_t maximum = vdupq_n_s16(activationMax);
+    const auto clamp = [&](int16x8_t value) {
+        return vminq_s16(vmaxq_s16(vaddq_s16(value, offset), minimum), maximum);
+    };
+    for (; i + 16 <= size; i += 16) {
+        if constexpr (std::is_same_v<T, uint8_t>) {
+            const uint8x16_t a = vld1q_u8(in1 + i);
+            const uint8x16_t b = vld1q_u8(in2 + i);
+            // The 16-bit differences of unsigned bytes wrap around to their
+            // signed values.
+            const uint16x8_t low = isSub ? vsubl_u8(vget_low_u8(a), vget_low_u8(b))
+                                         : vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+            const uint16x8_t high = isSub ? vsubl_high_u8(a, b) : vaddl_high_u8(a, b);
+            vst1q_u8(out + i, vcombine_u8(vqmovun_s16(clamp(vreinterpretq_s16_u16(low))),
+                                          vqmovun_s16(clamp(vreinterpretq_s16_u16(high)))));
+        } else {
+            const int8x16_t a = vld1q_s8(in1 + i);
+            const int8x16_t b = vld1q_s8(in2 + i);
+            const int16x8_t low = isSub ? vsubl_s8(vget_low_s8(a), vget_low_s8(b))
+                                        : vaddl_s8(vget_low_s8(a), vget_low_s8(b));
+            const int16x8_t high = isSub ? vsubl_high_s8(a, b) : vaddl_high_s8(a, b);
+            vst1q_s8(out + i, vcombine_s8(vqmovn_s16(clamp(low)), vqmovn_s16(clamp(high))));
+        }
+    }
+#endif  // defined(__aarch64__)
+    for (; i < size; ++i) {
+        const int32_t value = isSub ? in1[i] - in2[i] + zeroPoint : in1[i] + in2[i] - zeroPoint;
+        out[i] = static_cast<T>(std::min(std::max(value, activationMin), activationMax));
+    }
+}
+
+// Returns the number of elements of `repeated` if the tensor is repeated along
+// the leading dimensions of `shape` and spans its trailing dimensions, such as
+// a bias of shape [C] for an input of shape [N, H, W, C], and 0 otherwise.
+uint32_t getRepeatedBlockSize(const Shape& shape, const Shape& repeated) {
+    const auto& dimensions = shape.dimensions;
+    const auto& repeatedDimensions = repeated.dimensions;
+    if (repeatedDimensions.size() > dimensions.size()) {
+        return 0;
+    }
+    const size_t leading = dimensions.size() - repeatedDimensions.size();
+    size_t i = 0;
+    while (i < repeatedDimensions.size() && repeatedDimensions[i] == 1) {
+        ++i;
+    }
+    uint32_t size = 1;
+    for (; i < repeatedDimensions.size(); ++i) {
+        if (repeatedDimensions[i] != dimensions[leading + i]) {
+            return 0;
+        }
+        size *= repeatedDimensions[i];
+    }
+    return size;
+}
+
+// Computes a quant8 ADD, SUB or MUL with a kernel specialized for the shapes
+// and the quantization of its operands if there is one, and with `general`
+// otherwise:
+// - If an input is a scalar, the output is a function of the other input, so
+//   it is looked up in the table of the 256 outputs computed by `general`.
+//   The table is cached by the value and quantization of the scalar, as the
+//   same scalar is usually applied on every execution.
+// - If ADD or SUB inputs are quantized like the output and one of them is
+//   either of the shape of the output or repeated along its leading dimensions,
+//   the output is computed without rescaling.
+// Which kernel is used only depends on the shapes of the operands, which are
+// known once the operation is prepared.
+template <typename T>
+bool binaryOperationQuant8(OperationType operationType, const T* in1, const Shape& shape1,
+                           const T* in2, const Shape& shape2, int32_t activation, T* out,
+                           const Shape& shapeOut, binaryFunctionQuant8<T> general) {
+    const uint32_t size = getNumberOfElements(shapeOut);
+    const bool isScalar1 = getNumberOfElements(shape1) == 1;
+    const bool isScalar2 = getNumberOfElements(shape2) == 1;
+    if (size >= kMinElementsForScalarTable && (isScalar1 || isScalar2)) {
+        NNTRACE_COMP("binaryOperationQuant8::scalarTable");
+        const T* scalar = isScalar1 ? in1 : in2;
+        Shape scalarShape = isScalar1 ? shape1 : shape2;
+        scalarShape.dimensions = {1};
+        const Shape& inputShape = isScalar1 ? shape2 : shape1;
+        int32_t scalarScaleBits;
+        static_assert(sizeof(scalarScaleBits) == sizeof(scalarShape.scale));
+        std::memcpy(&scalarScaleBits, &scalarShape.scale, sizeof(scalarScaleBits));
+        const std::vector<int32_t> parameters = {isScalar1, *scalar, scalarScaleBits,
+                                                 scalarShape.offset, activation};
+        const auto table = getQuantizedLookupTable(
+                operationType, inputShape, shapeOut,
+                [&](const uint8_t* tableInput, uint32_t tableSize, uint8_t* tableOutput) {
+                    Shape tableInputShape = inputShape;
+                    tableInputShape.dimensions = {tableSize};
+                    Shape tableOutputShape = shapeOut;
+                    tableOutputShape.dimensions = {tableSize};
+                    const T* input = reinterpret_cast<const T*>(tableInput);
+                    T* output = reinterpret_cast<T*>(tableOutput);
+                    return isScalar1 ? general(scalar, scalarShape, input, tableInputShape,
+                                               activation, output, tableOutputShape)
+                                     : general(input, tableInputShape, scalar, scalarShape,
+                                               activation, output, tableOutputShape);
+                },
+                parameters);
+        NN_RET_CHECK(table != nullptr);
+        applyQuantizedLookupTable(*table, reinterpret_cast<const uint8_t*>(isScalar1 ? in2 : in1),
+                                  size, reinterpret_cast<uint8_t*>(out));
+        return true;
+    }
+
+    const bool sameQuantization =
+            shape1.scale == shapeOut.scale && shape1.offset == shapeOut.offset &&
+            shape2.scale == shapeOut.scale && shape2.offset == shapeOut.offset;
+    if (sameQuantization && operationType != OperationType::MUL) {
+        const bool isFull1 = shape1.dimensions == shapeOut.dimensions;
+        const bool isFull2 = shape2.dimensions == shapeOut.dimensions;
+        uint32_t blockSize = 0;
+        bool isRepeated1 = false;
+        if (isFull1) {
+            blockSize = getRepeatedBlockSize(shapeOut, shape2);
+        } else if (isFull2) {
+            blockSize = getRepeatedBlockSize(shapeOut, shape1);
+            isRepeated1 = true;
+        }
+        if (blockSize != 0) {
+            NNTRACE_COMP("binaryOperationQuant8::sameQuantization");
+            int32_t activationMin;
+            int32_t activationMax;
+            if constexpr (std::is_same_v<T, int8_t>) {
+                CalculateActivationRangeInt8(activation, shapeOut, &activationMin,
+                                             &activationMax);
+            } else {
+                CalculateActivationRangeUint8(activation, shapeOut, &activationMin,
+                                              &activationMax);
+            }
+            const auto kernel = operationType == OperationType::SUB
+                                        ? &addSameQuantization<T, /*isSub=*/true>
+                                        : &addSameQuantization<T, /*isSub=*/false>;
+            for (uint32_t offset = 0; offset < size; offset += blockSize) {
+                kernel(in1 + (isRepeated1 ? 0 : offset), in2 + (isRepeated1 ? offset : 0),
+                       blockSize, shapeOut.offset, activationMin, activationMax, out + offset);
+            }
+            return true;
+        }
+    }
+
+    return general(in1, shape1, in2, shape2, activation, out, shapeOut);
+}
+
 bool divFloat32(const float* in1, const Shape& shape1, const float* in2, const Shape& shape2,
                 int32_t activation, float* out, const Shape& shapeOut) {
     NNTRACE_TRANS("divFloat32");
@@ -469,21 +643,25 @@ bool executeAdd(IOperationExecutionContext* context) {
                               context->getOutputBuffer<float>(kOutputTensor),
                               context->getOutputShape(kOutputTensor));
         case OperandType::TENSOR_QUANT8_ASYMM:
-            return addQuant8(context->getInputBuffer<uint8_t>(kInputTensor1),
-                             context->getInputShape(kInputTensor1),
-                             context->getInputBuffer<uint8_t>(kInputTensor2),
-                             context->getInputShape(kInputTensor2),
-                             context->getInputValue<int32_t>(kActivationScalar),
-                             context->getOutputBuffer<uint8_t>(kOutputTensor),
-                             context->getOutputShape(kOutputTensor));
+            return binaryOperationQuant8(OperationType::ADD,
+                                         context->getInputBuffer<uint8_t>(kInputTensor1),
+                                         context->getInputShape(kInputTensor1),
+                                         context->getInputBuffer<uint8_t>(kInputTensor2),
+                                         context->getInputShape(kInputTensor2),
+                                         context->getInputValue<int32_t>(kActivationScalar),
+                                         context->getOutputBuffer<uint8_t>(kOutputTensor),
+                                         context->getOutputShape(kOutputTensor),
+                                         &addQuant8<uint8_t>);
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-            return addQuant8(context->getInputBuffer<int8_t>(kInputTensor1),
-                             context->getInputShape(kInputTensor1),
-                             context->getInputBuffer<int8_t>(kInputTensor2),
-                             context->getInputShape(kInputTensor2),
-                             context->getInputValue<int32_t>(kActivationScalar),
-                             context->getOutputBuffer<int8_t>(kOutputTensor),
-                             context->getOutputShape(kOutputTensor));
+            return binaryOperationQuant8(OperationType::ADD,
+                                         context->getInputBuffer<int8_t>(kInputTensor1),
+                                         context->getInputShape(kInputTensor1),
+                                         context->getInputBuffer<int8_t>(kInputTensor2),
+                                         context->getInputShape(kInputTensor2),
+                                         context->getInputValue<int32_t>(kActivationScalar),
+                                         context->getOutputBuffer<int8_t>(kOutputTensor),
+                                         context->getOutputShape(kOutputTensor),
+                                         &addQuant8<int8_t>);
         case OperandType::TENSOR_INT32:
             return executeInt32(context->getInputBuffer<int32_t>(kInputTensor1),
                                 context->getInputShape(kInputTensor1),
@@ -519,21 +697,25 @@ bool executeMul(IOperationExecutionContext* context) {
                               context->getOutputBuffer<float>(kOutputTensor),
                               context->getOutputShape(kOutputTensor));
         case OperandType::TENSOR_QUANT8_ASYMM:
-            return mulQuant8(context->getInputBuffer<uint8_t>(kInputTensor1),
-                             context->getInputShape(kInputTensor1),
-                             context->getInputBuffer<uint8_t>(kInputTensor2),
-                             context->getInputShape(kInputTensor2),
-                             context->getInputValue<int32_t>(kActivationScalar),
-                             context->getOutputBuffer<uint8_t>(kOutputTensor),
-                             context->getOutputShape(kOutputTensor));
+            return binaryOperationQuant8(OperationType::MUL,
+                                         context->getInputBuffer<uint8_t>(kInputTensor1),
+                                         context->getInputShape(kInputTensor1),
+                                         context->getInputBuffer<uint8_t>(kInputTensor2),
+                                         context->getInputShape(kInputTensor2),
+                                         context->getInputValue<int32_t>(kActivationScalar),
+                                         context->getOutputBuffer<uint8_t>(kOutputTensor),
+                                         context->getOutputShape(kOutputTensor),
+                                         &mulQuant8<uint8_t>);
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-            return mulQuant8(context->getInputBuffer<int8_t>(kInputTensor1),
-                             context->getInputShape(kInputTensor1),
-                             context->getInputBuffer<int8_t>(kInputTensor2),
-                             context->getInputShape(kInputTensor2),
-                             context->getInputValue<int32_t>(kActivationScalar),
-                             context->getOutputBuffer<int8_t>(kOutputTensor),
-                             context->getOutputShape(kOutputTensor));
+            return binaryOperationQuant8(OperationType::MUL,
+                                         context->getInputBuffer<int8_t>(kInputTensor1),
+                                         context->getInputShape(kInputTensor1),
+                                         context->getInputBuffer<int8_t>(kInputTensor2),
+                                         context->getInputShape(kInputTensor2),
+                                         context->getInputValue<int32_t>(kActivationScalar),
+                                         context->getOutputBuffer<int8_t>(kOutputTensor),
+                                         context->getOutputShape(kOutputTensor),
+                                         &mulQuant8<int8_t>);
         case OperandType::TENSOR_INT32:
             return executeInt32(context->getInputBuffer<int32_t>(kInputTensor1),
                                 context->getInputShape(kInputTensor1),
@@ -569,21 +751,25 @@ bool executeSub(IOperationExecutionContext* context) {
                               context->getOutputBuffer<float>(kOutputTensor),
                               context->getOutputShape(kOutputTensor));
         case OperandType::TENSOR_QUANT8_ASYMM:
-            return subQuant8(context->getInputBuffer<uint8_t>(kInputTensor1),
-                             context->getInputShape(kInputTensor1),
-                             context->getInputBuffer<uint8_t>(kInputTensor2),
-                             context->getInputShape(kInputTensor2),
-                             context->getInputValue<int32_t>(kActivationScalar),
-                             context->getOutputBuffer<uint8_t>(kOutputTensor),
-                             context->getOutputShape(kOutputTensor));
+            return binaryOperationQuant8(OperationType::SUB,
+                                         context->getInputBuffer<uint8_t>(kInputTensor1),
+                                         context->getInputShape(kInputTensor1),
+                                         context->getInputBuffer<uint8_t>(kInputTensor2),
+                                         context->getInputShape(kInputTensor2),
+                                         context->getInputValue<int32_t>(kActivationScalar),
+                                         context->getOutputBuffer<uint8_t>(kOutputTensor),
+                                         context->getOutputShape(kOutputTensor),
+                                         &subQuant8<uint8_t>);
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-            return subQuant8(context->getInputBuffer<int8_t>(kInputTensor1),
-                             context->getInputShape(kInputTensor1),
-                             context->getInputBuffer<int8_t>(kInputTensor2),
-                             context->getInputShape(kInputTensor2),
-                             context->getInputValue<int32_t>(kActivationScalar),
-                             context->getOutputBuffer<int8_t>(kOutputTensor),
-                             context->getOutputShape(kOutputTensor));
+            return binaryOperationQuant8(OperationType::SUB,
+                                         context->getInputBuffer<int8_t>(kInputTensor1),
+                                         context->getInputShape(kInputTensor1),
+                                         context->getInputBuffer<int8_t>(kInputTensor2),
+                                         context->getInputShape(kInputTensor2),
+                                         context->getInputValue<int32_t>(kActivationScalar),
+                                         context->getOutputBuffer<int8_t>(kOutputTensor),
+                                         context->getOutputShape(kOutputTensor),
+                                         &subQuant8<int8_t>);
         case OperandType::TENSOR_INT32:
             return executeInt32(context->getInputBuffer<int32_t>(kInputTensor1),
                                 context->getInputShape(kInputTensor1),
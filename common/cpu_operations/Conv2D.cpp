@@ -326,22 +326,117 @@ bool convNhwc(const _Float16* inputData, const Shape& inputShape, const _Float16
     return true;
 }
 
+// Calls convolve(inputOffset, tileInputShape, tilePaddingTop, tilePaddingBottom,
+// outputOffset, tileOutputShape) on tiles of an NHWC convolution, where the
+// offsets are in elements. A tile is either whole batches or output rows of a
+// single batch, so that a single large batch can also be cancelled partway
+// through. The input of a tile of rows is the slice of input rows that its
+// receptive field covers, with the padding that the slice leaves out.
+template <typename Convolve>
+bool convolveInTiles(const Shape& inputShape, const Shape& filterShape, const Shape& outputShape,
+                     int32_t paddingTop, int32_t paddingBottom, int32_t strideHeight,
+                     int32_t dilationHeightFactor, const CancellationToken* cancellationToken,
+                     const Convolve& convolve) {
+    const uint32_t batches = getSizeOfDimension(outputShape, 0);
+    const uint32_t inputHeight = getSizeOfDimension(inputShape, 1);
+    const uint32_t outputHeight = getSizeOfDimension(outputShape, 1);
+    if (batches == 0 || outputHeight == 0) {
+        return true;
+    }
+    const size_t inputRowSize =
+            size_t{getSizeOfDimension(inputShape, 2)} * getSizeOfDimension(inputShape, 3);
+    const size_t outputRowSize =
+            size_t{getSizeOfDimension(outputShape, 2)} * getSizeOfDimension(outputShape, 3);
+    const int32_t effectiveFilterHeight =
+            (static_cast<int32_t>(getSizeOfDimension(filterShape, 1)) - 1) * dilationHeightFactor +
+            1;
+    // A row tile needs at least one input row, which every output row reads
+    // unless the padding is as large as the filter.
+    const bool canTileRows =
+            paddingTop < effectiveFilterHeight && paddingBottom < effectiveFilterHeight;
+    uint32_t tileSize = getTileSize(uint64_t{getSizeOfDimension(outputShape, 2)} *
+                                    getNumberOfElements(filterShape));
+    if (!canTileRows) {
+        tileSize = std::max(tileSize / outputHeight, 1u) * outputHeight;
+    }
+
+    Shape tileInputShape = inputShape;
+    Shape tileOutputShape = outputShape;
+    return forEachTile(
+            batches * outputHeight, tileSize, cancellationToken,
+            [&](uint32_t first, uint32_t count) {
+                while (count > 0) {
+                    const uint32_t batch = first / outputHeight;
+                    const uint32_t row = first % outputHeight;
+                    uint32_t done;
+                    if (row == 0 && count >= outputHeight) {
+                        // Whole batches.
+                        const uint32_t numBatches = count / outputHeight;
+                        tileInputShape.dimensions[0] = numBatches;
+                        tileInputShape.dimensions[1] = inputHeight;
+                        tileOutputShape.dimensions[0] = numBatches;
+                        tileOutputShape.dimensions[1] = outputHeight;
+                        if (!convolve(batch * inputHeight * inputRowSize, tileInputShape,
+                                      paddingTop, paddingBottom,
+                                      batch * outputHeight * outputRowSize, tileOutputShape)) {
+                            return false;
+                        }
+                        done = numBatches * outputHeight;
+                    } else {
+                        const uint32_t numRows = std::min(count, outputHeight - row);
+                        const int32_t firstInputRow =
+                                static_cast<int32_t>(row) * strideHeight - paddingTop;
+                        const int32_t lastInputRow =
+                                static_cast<int32_t>(row + numRows - 1) * strideHeight -
+                                paddingTop + effectiveFilterHeight - 1;
+                        const int32_t sliceBegin = std::max(firstInputRow, 0);
+                        const int32_t sliceEnd =
+                                std::min(lastInputRow + 1, static_cast<int32_t>(inputHeight));
+                        tileInputShape.dimensions[0] = 1;
+                        tileInputShape.dimensions[1] = sliceEnd - sliceBegin;
+                        tileOutputShape.dimensions[0] = 1;
+                        tileOutputShape.dimensions[1] = numRows;
+                        if (!convolve((batch * inputHeight + sliceBegin) * inputRowSize,
+                                      tileInputShape, sliceBegin - firstInputRow,
+                                      std::max(lastInputRow + 1 - sliceEnd, 0),
+                                      (batch * outputHeight + row) * outputRowSize,
+                                      tileOutputShape)) {
+                            return false;
+                        }
+                        done = numRows;
+                    }
+                    first += done;
+                    count -= done;
+                }
+                return true;
+            });
+}
+
 template <typename T_Input, typename T_Filter, typename T_Bias>
 bool conv(const T_Input* inputData, const Shape& inputShape, const T_Filter* filterData,
           const Shape& filterShape, const T_Bias* biasData, const Shape& biasShape,
           int32_t padding_left, int32_t padding_right, int32_t padding_top, int32_t padding_bottom,
           int32_t stride_width, int32_t stride_height, int32_t dilation_width_factor,
           int32_t dilation_height_factor, int32_t activation, bool useNchw, T_Input* outputData,
-          const Shape& outputShape) {
+          const Shape& outputShape, const CancellationToken* cancellationToken) {
     InputWithLayout<T_Input> input(useNchw);
     OutputWithLayout<T_Input> output(useNchw);
     NN_RET_CHECK(input.initialize(inputData, inputShape));
     NN_RET_CHECK(output.initialize(outputData, outputShape));
-    NN_RET_CHECK(convNhwc(input.getNhwcBuffer(), input.getNhwcShape(), filterData, filterShape,
-                          biasData, biasShape, padding_left, padding_right, padding_top,
-                          padding_bottom, stride_width, stride_height, dilation_width_factor,
-                          dilation_height_factor, activation, output.getNhwcBuffer(),
-                          output.getNhwcShape()));
+    const bool finished = convolveInTiles(
+            input.getNhwcShape(), filterShape, output.getNhwcShape(), padding_top,
+            padding_bottom, stride_height, dilation_height_factor, cancellationToken,
+            [&](size_t inputOffset, const Shape& tileInputShape, int32_t tilePaddingTop,
+                int32_t tilePaddingBottom, size_t outputOffset, const Shape& tileOutputShape) {
+                return convNhwc(input.getNhwcBuffer() + inputOffset, tileInputShape, filterData,
+                                filterShape, biasData, biasShape, padding_left, padding_right,
+                                tilePaddingTop, tilePaddingBottom, stride_width, stride_height,
+                                dilation_width_factor, dilation_height_factor, activation,
+                                output.getNhwcBuffer() + outputOffset, tileOutputShape);
+            });
+    if (!finished) {
+        return false;
+    }
     NN_RET_CHECK(output.commit());
     return true;
 }
@@ -509,16 +604,27 @@ bool convQuant8PerChannel(const T* inputData, const Shape& inputShape, const int
                           int32_t paddingRight, int32_t paddingTop, int32_t paddingBottom,
                           int32_t strideWidth, int32_t strideHeight, int32_t dilationWidthFactor,
                           int32_t dilationHeightFactor, int32_t activation, bool useNchw,
-                          T* outputData, const Shape& outputShape) {
+                          T* outputData, const Shape& outputShape,
+                          const CancellationToken* cancellationToken) {
     InputWithLayout<T> input(useNchw);
     OutputWithLayout<T> output(useNchw);
     NN_RET_CHECK(input.initialize(inputData, inputShape));
     NN_RET_CHECK(output.initialize(outputData, outputShape));
-    NN_RET_CHECK(convQuant8PerChannelNhwc(
-            input.getNhwcBuffer(), input.getNhwcShape(), filterData, filterShape, filterScales,
-            biasData, biasShape, paddingLeft, paddingRight, paddingTop, paddingBottom, strideWidth,
-            strideHeight, dilationWidthFactor, dilationHeightFactor, activation,
-            output.getNhwcBuffer(), output.getNhwcShape()));
+    const bool finished = convolveInTiles(
+            input.getNhwcShape(), filterShape, output.getNhwcShape(), paddingTop, paddingBottom,
+            strideHeight, dilationHeightFactor, cancellationToken,
+            [&](size_t inputOffset, const Shape& tileInputShape, int32_t tilePaddingTop,
+                int32_t tilePaddingBottom, size_t outputOffset, const Shape& tileOutputShape) {
+                return convQuant8PerChannelNhwc(
+                        input.getNhwcBuffer() + inputOffset, tileInputShape, filterData,
+                        filterShape, filterScales, biasData, biasShape, paddingLeft, paddingRight,
+                        tilePaddingTop, tilePaddingBottom, strideWidth, strideHeight,
+                        dilationWidthFactor, dilationHeightFactor, activation,
+                        output.getNhwcBuffer() + outputOffset, tileOutputShape);
+            });
+    if (!finished) {
+        return false;
+    }
     NN_RET_CHECK(output.commit());
     return true;
 }
@@ -607,7 +713,7 @@ bool execute(IOperationExecutionContext* context) {
                         param.stride_width, param.stride_height, param.dilation_width_factor,
                         param.dilation_height_factor, param.activation, param.useNchw,
                         context->getOutputBuffer<float>(kOutputTensor),
-                        context->getOutputShape(kOutputTensor));
+                        context->getOutputShape(kOutputTensor), context->getCancellationToken());
         case OperandType::TENSOR_FLOAT16:
             return conv(context->getInputBuffer<_Float16>(kInputTensor),
                         context->getInputShape(kInputTensor),
@@ -619,7 +725,7 @@ bool execute(IOperationExecutionContext* context) {
                         param.stride_width, param.stride_height, param.dilation_width_factor,
                         param.dilation_height_factor, param.activation, param.useNchw,
                         context->getOutputBuffer<_Float16>(kOutputTensor),
-                        context->getOutputShape(kOutputTensor));
+                        context->getOutputShape(kOutputTensor), context->getCancellationToken());
         case OperandType::TENSOR_QUANT8_ASYMM:
             if (context->getInputType(kFilterTensor) ==
                 OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL) {
@@ -637,7 +743,7 @@ bool execute(IOperationExecutionContext* context) {
                         param.stride_width, param.stride_height, param.dilation_width_factor,
                         param.dilation_height_factor, param.activation, param.useNchw,
                         context->getOutputBuffer<uint8_t>(kOutputTensor),
-                        context->getOutputShape(kOutputTensor));
+                        context->getOutputShape(kOutputTensor), context->getCancellationToken());
             } else if (context->getInputType(kFilterTensor) == OperandType::TENSOR_QUANT8_ASYMM) {
                 return conv(context->getInputBuffer<uint8_t>(kInputTensor),
                             context->getInputShape(kInputTensor),
@@ -649,7 +755,8 @@ bool execute(IOperationExecutionContext* context) {
                             param.stride_width, param.stride_height, param.dilation_width_factor,
                             param.dilation_height_factor, param.activation, param.useNchw,
                             context->getOutputBuffer<uint8_t>(kOutputTensor),
-                            context->getOutputShape(kOutputTensor));
+                            context->getOutputShape(kOutputTensor),
+                            context->getCancellationToken());
             } else {
                 NN_RET_CHECK_FAIL() << "Unsupported filter type for operation " << kOperationName;
             }
@@ -670,7 +777,7 @@ bool execute(IOperationExecutionContext* context) {
                         param.stride_width, param.stride_height, param.dilation_width_factor,
                         param.dilation_height_factor, param.activation, param.useNchw,
                         context->getOutputBuffer<int8_t>(kOutputTensor),
-                        context->getOutputShape(kOutputTensor));
+                        context->getOutputShape(kOutputTensor), context->getCancellationToken());
             } else if (context->getInputType(kFilterTensor) ==
                        OperandType::TENSOR_QUANT8_ASYMM_SIGNED) {
                 return conv(context->getInputBuffer<int8_t>(kInputTensor),
@@ -683,7 +790,8 @@ bool execute(IOperationExecutionContext* context) {
                             param.stride_width, param.stride_height, param.dilation_width_factor,
                             param.dilation_height_factor, param.activation, param.useNchw,
                             context->getOutputBuffer<int8_t>(kOutputTensor),
-                            context->getOutputShape(kOutputTensor));
+                            context->getOutputShape(kOutputTensor),
+                            context->getCancellationToken());
             } else {
                 NN_RET_CHECK_FAIL() << "Unsupported filter type for operation " << kOperationName;
             }
@@ -25,6 +25,7 @@
 
 #include "OperationResolver.h"
 #include "OperationsExecutionUtils.h"
+#include "QuantizedLookupTable.h"
 #include "Tracing.h"
 
 namespace android {
@@ -70,6 +71,24 @@ auto makeQuantized(const std::function<IntermediateType(IntermediateType)>& func
     };
 }
 
+// Computes a function on a quant8 tensor, with a lookup table when the tensor is
+// large enough.
+template <typename T>
+bool computeQuant8(OperationType opType, const std::function<float(float)>& func,
+                   IOperationExecutionContext* context) {
+    const Shape inputShape = context->getInputShape(kInputTensor);
+    const Shape outputShape = context->getOutputShape(kOutputTensor);
+    const std::function<T(T)> quantizedFunc =
+            makeQuantized(func, inputShape.scale, static_cast<T>(inputShape.offset),
+                          outputShape.scale, static_cast<T>(outputShape.offset));
+    return computeQuantizedElementwise<T>(
+            opType, context->getInputBuffer<T>(kInputTensor), inputShape,
+            context->getOutputBuffer<T>(kOutputTensor), outputShape,
+            [&quantizedFunc](const T* input, uint32_t size, T* output) {
+                return compute<T, T>(quantizedFunc, input, Shape{.dimensions = {size}}, output);
+            });
+}
+
 bool execute(IOperationExecutionContext* context, float func(float)) {
     switch (context->getInputType(kInputTensor)) {
         case OperandType::TENSOR_FLOAT16:
@@ -120,26 +139,10 @@ bool executeRsqrt(IOperationExecutionContext* context) {
             return compute<float, float>(frsqrt, context->getInputBuffer<float>(kInputTensor),
                                          context->getInputShape(kInputTensor),
                                          context->getOutputBuffer<float>(kOutputTensor));
-        case OperandType::TENSOR_QUANT8_ASYMM: {
-            const Shape inShape = context->getInputShape(kInputTensor);
-            const Shape outShape = context->getOutputShape(kOutputTensor);
-            return compute<uint8_t, uint8_t>(
-                    makeQuantized(frsqrt, inShape.scale, static_cast<uint8_t>(inShape.offset),
-                                  outShape.scale, static_cast<uint8_t>(outShape.offset)),
-                    context->getInputBuffer<uint8_t>(kInputTensor),
-                    context->getInputShape(kInputTensor),
-                    context->getOutputBuffer<uint8_t>(kOutputTensor));
-        }
-        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED: {
-            const Shape inShape = context->getInputShape(kInputTensor);
-            const Shape outShape = context->getOutputShape(kOutputTensor);
-            return compute<int8_t, int8_t>(
-                    makeQuantized(frsqrt, inShape.scale, static_cast<int8_t>(inShape.offset),
-                                  outShape.scale, static_cast<int8_t>(outShape.offset)),
-                    context->getInputBuffer<int8_t>(kInputTensor),
-                    context->getInputShape(kInputTensor),
-                    context->getOutputBuffer<int8_t>(kOutputTensor));
-        }
+        case OperandType::TENSOR_QUANT8_ASYMM:
+            return computeQuant8<uint8_t>(OperationType::RSQRT, frsqrt, context);
+        case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
+            return computeQuant8<int8_t>(OperationType::RSQRT, frsqrt, context);
         default:
             NN_RET_CHECK_FAIL() << "Unsupported tensor type " << tensorType
                                 << " for operation RSQRT";
@@ -177,6 +177,43 @@ bool fullyConnectedQuant8(const int8_t* inputData, const Shape& inputShape,
     return true;
 }
 
+template <typename T_Input, typename T_Bias>
+using FullyConnectedFunction = bool (*)(const T_Input* inputData, const Shape& inputShape,
+                                        const T_Input* weightsData, const Shape& weightsShape,
+                                        const T_Bias* biasData, const Shape& biasShape,
+                                        int32_t activation, T_Input* outputData,
+                                        const Shape& outputShape);
+
+// Computes as many rows of the output at a time as fit in a tile, so that a
+// cancelled execution stops early. Most executions fit in a single tile and
+// set up the kernel once.
+template <typename T_Input, typename T_Bias>
+bool executeInTiles(IOperationExecutionContext* context,
+                    FullyConnectedFunction<T_Input, T_Bias> fullyConnected) {
+    const T_Input* inputData = context->getInputBuffer<T_Input>(kInputTensor);
+    const Shape weightsShape = context->getInputShape(kWeightsTensor);
+    T_Input* outputData = context->getOutputBuffer<T_Input>(kOutputTensor);
+    const uint32_t numUnits = getSizeOfDimension(weightsShape, 0);
+    const uint32_t inputSize = getSizeOfDimension(weightsShape, 1);
+    const uint32_t batchSize = getSizeOfDimension(context->getOutputShape(kOutputTensor), 0);
+    // The input is flattened to [batchSize, inputSize].
+    Shape tileInputShape = context->getInputShape(kInputTensor);
+    Shape tileOutputShape = context->getOutputShape(kOutputTensor);
+    return forEachTile(
+            batchSize, getTileSize(uint64_t{numUnits} * inputSize),
+            context->getCancellationToken(),
+            [&](uint32_t first, uint32_t count) {
+                tileInputShape.dimensions = {count, inputSize};
+                tileOutputShape.dimensions = {count, numUnits};
+                return fullyConnected(inputData + first * inputSize, tileInputShape,
+                                      context->getInputBuffer<T_Input>(kWeightsTensor),
+                                      weightsShape, context->getInputBuffer<T_Bias>(kBiasTensor),
+                                      context->getInputShape(kBiasTensor),
+                                      context->getInputValue<int32_t>(kActivationScalar),
+                                      outputData + first * numUnits, tileOutputShape);
+            });
+}
+
 }  // namespace
 
 bool prepare(IOperationExecutionContext* context) {
@@ -193,45 +230,13 @@ bool execute(IOperationExecutionContext* context) {
     if (getNumberOfElements(context->getOutputShape(kOutputTensor)) == 0) return true;
     switch (context->getInputType(kInputTensor)) {
         case OperandType::TENSOR_FLOAT32:
-            return fullyConnectedFloat32(context->getInputBuffer<float>(kInputTensor),
-                                         context->getInputShape(kInputTensor),
-                                         context->getInputBuffer<float>(kWeightsTensor),
-                                         context->getInputShape(kWeightsTensor),
-                                         context->getInputBuffer<float>(kBiasTensor),
-                                         context->getInputShape(kBiasTensor),
-                                         context->getInputValue<int32_t>(kActivationScalar),
-                                         context->getOutputBuffer<float>(kOutputTensor),
-                                         context->getOutputShape(kOutputTensor));
+            return executeInTiles<float, float>(context, fullyConnectedFloat32);
         case OperandType::TENSOR_FLOAT16:
-            return fullyConnectedFloat16(context->getInputBuffer<_Float16>(kInputTensor),
-                                         context->getInputShape(kInputTensor),
-                                         context->getInputBuffer<_Float16>(kWeightsTensor),
-                                         context->getInputShape(kWeightsTensor),
-                                         context->getInputBuffer<_Float16>(kBiasTensor),
-                                         context->getInputShape(kBiasTensor),
-                                         context->getInputValue<int32_t>(kActivationScalar),
-                                         context->getOutputBuffer<_Float16>(kOutputTensor),
-                                         context->getOutputShape(kOutputTensor));
+            return executeInTiles<_Float16, _Float16>(context, fullyConnectedFloat16);
         case OperandType::TENSOR_QUANT8_ASYMM:
-            return fullyConnectedQuant8(context->getInputBuffer<uint8_t>(kInputTensor),
-                                        context->getInputShape(kInputTensor),
-                                        context->getInputBuffer<uint8_t>(kWeightsTensor),
-                                        context->getInputShape(kWeightsTensor),
-                                        context->getInputBuffer<int32_t>(kBiasTensor),
-                                        context->getInputShape(kBiasTensor),
-                                        context->getInputValue<int32_t>(kActivationScalar),
-                                        context->getOutputBuffer<uint8_t>(kOutputTensor),
-                                        context->getOutputShape(kOutputTensor));
+            return executeInTiles<uint8_t, int32_t>(context, fullyConnectedQuant8);
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
-            return fullyConnectedQuant8(context->getInputBuffer<int8_t>(kInputTensor),
-                                        context->getInputShape(kInputTensor),
-                                        context->getInputBuffer<int8_t>(kWeightsTensor),
-                                        context->getInputShape(kWeightsTensor),
-                                        context->getInputBuffer<int32_t>(kBiasTensor),
-                                        context->getInputShape(kBiasTensor),
-                                        context->getInputValue<int32_t>(kActivationScalar),
-                                        context->getOutputBuffer<int8_t>(kOutputTensor),
-                                        context->getOutputShape(kOutputTensor));
+            return executeInTiles<int8_t, int32_t>(context, fullyConnectedQuant8);
         default:
             NN_RET_CHECK_FAIL() << "Unsupported tensor type for operation " << kOperationName;
     }
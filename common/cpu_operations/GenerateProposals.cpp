@@ -441,7 +441,8 @@ bool boxWithNmsLimitFloat32Compute(float* scoresData, const Shape& scoresShape,
                                    int32_t softNmsKernel, float iouThreshold, float sigma,
                                    float nmsScoreThreshold, std::vector<uint32_t>* batchSplitIn,
                                    std::vector<uint32_t>* batchSplitOut,
-                                   std::vector<uint32_t>* selected) {
+                                   std::vector<uint32_t>* selected,
+                                   const CancellationToken* cancellationToken) {
     SoftNmsKernel kernel = nullptr;
     if (softNmsKernel == 0) {
         kernel = [&iouThreshold](float iou) { return iou < iouThreshold ? 1.0f : 0.0f; };
@@ -473,6 +474,9 @@ bool boxWithNmsLimitFloat32Compute(float* scoresData, const Shape& scoresShape,
     const float* roiBase = roiData;
     selected->clear();
     for (uint32_t b = 0; b < batchSplitIn->size(); b++) {
+        if (isCancelled(cancellationToken)) {
+            return false;
+        }
         for (uint32_t i = 0; i < batchSplitIn->at(b); i++) {
             const float* roi = roiBase + i * kRoiDim;
             // Check for malformed data: invalid region: x2 < x1 || y2 < y1
@@ -585,7 +589,7 @@ bool boxWithNmsLimitFloat32(const float* scoresData, const Shape& scoresShape, c
     NN_RET_CHECK(boxWithNmsLimitFloat32Compute(
             scores_float32.data(), scoresShape, roiData, roiShape, batchesData, batchesShape,
             scoreThreshold, maxNumDetections, softNmsKernel, iouThreshold, sigma, nmsScoreThreshold,
-            &batchSplitIn, &batchSplitOut, &selected));
+            &batchSplitIn, &batchSplitOut, &selected, context->getCancellationToken()));
     return boxWithNmsLimitWriteOutput<float, float>(selected, batchSplitIn, batchSplitOut,
                                                     scores_float32, context);
 }
@@ -609,7 +613,8 @@ bool boxWithNmsLimitFloat16(const _Float16* scoresData, const Shape& scoresShape
     NN_RET_CHECK(boxWithNmsLimitFloat32Compute(
             scores_float32.data(), scoresShape, roi_float32.data(), roiShape, batchesData,
             batchesShape, scoreThreshold, maxNumDetections, softNmsKernel, iouThreshold, sigma,
-            nmsScoreThreshold, &batchSplitIn, &batchSplitOut, &selected));
+            nmsScoreThreshold, &batchSplitIn, &batchSplitOut, &selected,
+            context->getCancellationToken()));
     return boxWithNmsLimitWriteOutput<_Float16, _Float16>(selected, batchSplitIn, batchSplitOut,
                                                           scores_float32, context);
 }
@@ -632,7 +637,8 @@ bool boxWithNmsLimitQuant(const uint8_t* scoresData, const Shape& scoresShape,
     NN_RET_CHECK(boxWithNmsLimitFloat32Compute(
             scores_float32.data(), scoresShape, roi_float32.data(), roiShape, batchesData,
             batchesShape, scoreThreshold, maxNumDetections, softNmsKernel, iouThreshold, sigma,
-            nmsScoreThreshold, &batchSplitIn, &batchSplitOut, &selected));
+            nmsScoreThreshold, &batchSplitIn, &batchSplitOut, &selected,
+            context->getCancellationToken()));
     return boxWithNmsLimitWriteOutput<uint8_t, uint16_t>(selected, batchSplitIn, batchSplitOut,
                                                          scores_float32, context);
 }
@@ -656,7 +662,8 @@ bool boxWithNmsLimitQuant(const int8_t* scoresData, const Shape& scoresShape,
     NN_RET_CHECK(boxWithNmsLimitFloat32Compute(
             scores_float32.data(), scoresShape, roi_float32.data(), roiShape, batchesData,
             batchesShape, scoreThreshold, maxNumDetections, softNmsKernel, iouThreshold, sigma,
-            nmsScoreThreshold, &batchSplitIn, &batchSplitOut, &selected));
+            nmsScoreThreshold, &batchSplitIn, &batchSplitOut, &selected,
+            context->getCancellationToken()));
     return boxWithNmsLimitWriteOutput<int8_t, uint16_t>(selected, batchSplitIn, batchSplitOut,
                                                         scores_float32, context);
 }
@@ -851,7 +858,8 @@ bool generateProposalsNhwcFloat32Compute(const float* scoresData, const Shape& s
                                          int32_t postNmsTopN, float iouThreshold, float minSize,
                                          std::vector<float>* scoresOutData,
                                          std::vector<float>* roiOutData,
-                                         std::vector<int32_t>* batchesOutData) {
+                                         std::vector<int32_t>* batchesOutData,
+                                         const CancellationToken* cancellationToken) {
     const uint32_t kRoiDim = 4;
     uint32_t numBatches = getSizeOfDimension(scoresShape, 0);
     uint32_t height = getSizeOfDimension(scoresShape, 1);
@@ -897,6 +905,9 @@ bool generateProposalsNhwcFloat32Compute(const float* scoresData, const Shape& s
     tempImageInfoShape.dimensions = {1, imageInfoLength};
 
     for (uint32_t b = 0; b < numBatches; b++) {
+        if (isCancelled(cancellationToken)) {
+            return false;
+        }
         // Apply bboxDeltas to anchor locations.
         float tempImageInfo[] = {imageInfoBase[0], imageInfoBase[1]};
         if (!bboxTransformFloat32(roiBuffer.data(), tempRoiShape, bboxDeltasBase,
@@ -953,7 +964,8 @@ bool generateProposalsFloat32Compute(const float* scoresData, const Shape& score
                                      int32_t postNmsTopN, float iouThreshold, float minSize,
                                      bool useNchw, std::vector<float>* scoresOutData,
                                      std::vector<float>* roiOutData,
-                                     std::vector<int32_t>* batchesOutData) {
+                                     std::vector<int32_t>* batchesOutData,
+                                     const CancellationToken* cancellationToken) {
     InputWithLayout<float> score_nhwc(useNchw), delta_nhwc(useNchw);
     NN_RET_CHECK(score_nhwc.initialize(scoresData, scoresShape));
     NN_RET_CHECK(delta_nhwc.initialize(bboxDeltasData, bboxDeltasShape));
@@ -961,7 +973,7 @@ bool generateProposalsFloat32Compute(const float* scoresData, const Shape& score
             score_nhwc.getNhwcBuffer(), score_nhwc.getNhwcShape(), delta_nhwc.getNhwcBuffer(),
             delta_nhwc.getNhwcShape(), anchorsData, anchorsShape, imageInfoData, imageInfoShape,
             heightStride, widthStride, preNmsTopN, postNmsTopN, iouThreshold, minSize,
-            scoresOutData, roiOutData, batchesOutData);
+            scoresOutData, roiOutData, batchesOutData, cancellationToken);
 }
 
 bool generateProposalsFloat32(const float* scoresData, const Shape& scoresShape,
@@ -976,7 +988,8 @@ bool generateProposalsFloat32(const float* scoresData, const Shape& scoresShape,
     NN_RET_CHECK(generateProposalsFloat32Compute(
             scoresData, scoresShape, bboxDeltasData, bboxDeltasShape, anchorsData, anchorsShape,
             imageInfoData, imageInfoShape, heightStride, widthStride, preNmsTopN, postNmsTopN,
-            iouThreshold, minSize, useNchw, &scoresOut_float32, &roiOut_float32, &batchesOut));
+            iouThreshold, minSize, useNchw, &scoresOut_float32, &roiOut_float32, &batchesOut,
+            context->getCancellationToken()));
 
     // Set output dimensions.
     uint32_t numOutRois = scoresOut_float32.size();
@@ -1028,7 +1041,7 @@ bool generateProposalsFloat16(const _Float16* scoresData, const Shape& scoresSha
             score_float32.data(), scoresShape, delta_float32.data(), bboxDeltasShape,
             anchors_float32.data(), anchorsShape, imageInfo_float32.data(), imageInfoShape,
             heightStride, widthStride, preNmsTopN, postNmsTopN, iouThreshold, minSize, useNchw,
-            &scoresOut_float32, &roiOut_float32, &batchesOut));
+            &scoresOut_float32, &roiOut_float32, &batchesOut, context->getCancellationToken()));
 
     // Set output dimensions.
     uint32_t numOutRois = scoresOut_float32.size();
@@ -1080,7 +1093,7 @@ bool generateProposalsQuant(const T_8QInput* scoresData, const Shape& scoresShap
             score_float32.data(), scoresShape, delta_float32.data(), bboxDeltasShape,
             anchors_float32.data(), anchorsShape, imageInfo_float32.data(), imageInfoShape,
             heightStride, widthStride, preNmsTopN, postNmsTopN, iouThreshold, minSize, useNchw,
-            &scoresOut_float32, &roiOut_float32, &batchesOut));
+            &scoresOut_float32, &roiOut_float32, &batchesOut, context->getCancellationToken()));
 
     // Set output dimensions.
     uint32_t numOutRois = scoresOut_float32.size();
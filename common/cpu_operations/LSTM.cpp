@@ -423,7 +423,7 @@ bool LSTMCell::LSTMEvalFloat32(
         const float* forget_layer_norm_weights_buffer, const float* cell_layer_norm_weights_buffer,
         const float* output_layer_norm_weights_buffer, float* output_state_out_buffer,
         float* cell_state_out_buffer, float* output_buffer, float* scratch_buffer_buffer,
-        bool timeMajor, bool forwardSequence) {
+        bool timeMajor, bool forwardSequence, const CancellationToken* cancellationToken) {
     NNTRACE_COMP("LSTMCell::LSTMEvalFloat32");
 
     const uint32_t inputRank = getNumberOfDimensions(input_shape);
@@ -481,6 +481,9 @@ bool LSTMCell::LSTMEvalFloat32(
     const int batchOutputDelta = (forwardSequence ? 1 : -1) * static_cast<int>(batchOutputSize);
 
     for (uint32_t t = 0; t < maxTime; ++t) {
+        if (isCancelled(cancellationToken)) {
+            return false;
+        }
         LSTMStep(params, inputCurrentTimeStep, batchInputShape, input_to_input_weights_buffer,
                  input_to_forget_weights_buffer, input_to_cell_weights_buffer,
                  input_to_output_weights_buffer, input_to_output_weights_shape,
@@ -543,7 +546,7 @@ bool LSTMCell::LSTMEvalFloat16(
         const _Float16* cell_layer_norm_weights_buffer,
         const _Float16* output_layer_norm_weights_buffer, _Float16* output_state_out_buffer,
         _Float16* cell_state_out_buffer, _Float16* output_buffer, _Float16* scratch_buffer_buffer,
-        bool timeMajor, bool forwardSequence) {
+        bool timeMajor, bool forwardSequence, const CancellationToken* cancellationToken) {
     NNTRACE_COMP("LSTMCell::LSTMEvalFloat16");
 
     const uint32_t inputRank = getNumberOfDimensions(input_shape);
@@ -719,6 +722,9 @@ bool LSTMCell::LSTMEvalFloat16(
     const int batchOutputDelta = (forwardSequence ? 1 : -1) * static_cast<int>(batchOutputSize);
 
     for (uint32_t t = 0; t < maxTime; ++t) {
+        if (isCancelled(cancellationToken)) {
+            return false;
+        }
         LSTMStep(params, inputCurrentTimeStep, batchInputShape,
                  input_to_input_weights_float32.data(), input_to_forget_weights_float32.data(),
                  input_to_cell_weights_float32.data(), input_to_output_weights_float32.data(),
@@ -0,0 +1,617 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Times the execute function of the operations registered with
+// BuiltinOperationResolver in isolation, without building a model. Each
+// benchmark synthesizes random inputs for an operation, a data type and an
+// input shape, prepares the operation once, and then only executes it. Reports:
+// - ns_per_element: the execution time per output element,
+// - GB/s: the bytes of the input and output tensors per second.
+//
+// Usage:
+//   NeuralNetworksBenchmark_operations
+//       [--op_types=fp32,fp16,quant8_asymm,quant8_asymm_signed,quant8_per_channel]
+//       [--op_shapes=1x8x8x16,1x32x32x32,1x64x64x64]
+//       [--benchmark_filter=<regex>]
+//
+// The benchmarks are named <operation>/<data type>/<shape>. Operations are only
+// benchmarked for the data types their prepare function accepts, and shapes of
+// rank 4 are NHWC. quant8_per_channel is a quant8 asymm input with a filter
+// quantized per channel, for the operations that have one.
+//
+// ADD, MUL and SUB are also benchmarked with their second input broadcast, as
+// <operation>:<broadcast pattern>/<data type>/<shape>, where the pattern is
+// scalar (a single element) or channel (a vector as deep as the last
+// dimension), and is suffixed with _same_quantization when the output is
+// quantized like the inputs.
+
+#include <android-base/logging.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "LegacyUtils.h"
+#include "OperationResolver.h"
+#include "OperationsExecutionUtils.h"
+
+namespace android::nn {
+namespace {
+
+struct DataType {
+    const char* name;
+    OperandType tensorType;
+    float scale;
+    int32_t zeroPoint;
+    // Whether the filters of the operation are quantized per channel.
+    bool perChannel;
+};
+
+constexpr DataType kDataTypes[] = {
+        {"fp32", OperandType::TENSOR_FLOAT32, 0.0f, 0, false},
+        {"fp16", OperandType::TENSOR_FLOAT16, 0.0f, 0, false},
+        {"quant8_asymm", OperandType::TENSOR_QUANT8_ASYMM, 0.05f, 128, false},
+        {"quant8_asymm_signed", OperandType::TENSOR_QUANT8_ASYMM_SIGNED, 0.05f, 0, false},
+        {"quant8_per_channel", OperandType::TENSOR_QUANT8_ASYMM, 0.05f, 128, true},
+};
+
+struct BenchmarkOperand {
+    Shape shape;
+    std::vector<uint8_t> data;
+};
+
+bool isTensor(const Shape& shape) {
+    return !shape.dimensions.empty();
+}
+
+// Only implements what the operations need when all their operands are present
+// and their output shapes are computed by prepare.
+class BenchmarkContext : public IOperationExecutionContext {
+   public:
+    BenchmarkContext(std::vector<BenchmarkOperand> inputs, std::vector<Shape> outputs)
+        : mInputs(std::move(inputs)) {
+        for (auto& output : outputs) {
+            mOutputs.push_back({.shape = std::move(output)});
+        }
+    }
+
+    uint32_t getNumInputs() const override { return mInputs.size(); }
+    OperandType getInputType(uint32_t index) const override {
+        return mInputs.at(index).shape.type;
+    }
+    Shape getInputShape(uint32_t index) const override { return mInputs.at(index).shape; }
+    const void* getInputBuffer(uint32_t index) const override {
+        return mInputs.at(index).data.data();
+    }
+    const Operand::ExtraParams& getInputExtraParams(uint32_t index) const override {
+        return mInputs.at(index).shape.extraParams;
+    }
+
+    uint32_t getNumOutputs() const override { return mOutputs.size(); }
+    OperandType getOutputType(uint32_t index) const override {
+        return mOutputs.at(index).shape.type;
+    }
+    Shape getOutputShape(uint32_t index) const override { return mOutputs.at(index).shape; }
+    void* getOutputBuffer(uint32_t index) override { return mOutputs.at(index).data.data(); }
+
+    bool setOutputShape(uint32_t index, const Shape& shape) override {
+        BenchmarkOperand& output = mOutputs.at(index);
+        output.shape = shape;
+        output.data.resize(nonExtensionOperandSizeOfData(shape.type, shape.dimensions));
+        return true;
+    }
+
+    bool isOmittedInput(uint32_t /*index*/) const override { return false; }
+    bool isOmittedOutput(uint32_t /*index*/) const override { return false; }
+
+    // The bytes of the tensors read and written by an execution.
+    size_t getTensorBytes() const {
+        size_t bytes = 0;
+        for (const auto& operand : mInputs) {
+            bytes += isTensor(operand.shape) ? operand.data.size() : 0;
+        }
+        for (const auto& operand : mOutputs) {
+            bytes += operand.data.size();
+        }
+        return bytes;
+    }
+
+    size_t getOutputElements() const {
+        size_t elements = 0;
+        for (const auto& operand : mOutputs) {
+            elements += getNumberOfElements(operand.shape);
+        }
+        return elements;
+    }
+
+   private:
+    std::vector<BenchmarkOperand> mInputs;
+    std::vector<BenchmarkOperand> mOutputs;
+};
+
+class OperandFactory {
+   public:
+    explicit OperandFactory(const DataType& dataType) : kDataType(dataType) {}
+
+    // A tensor of the data type with random values.
+    BenchmarkOperand tensor(std::vector<uint32_t> dimensions) {
+        return random({.type = kDataType.tensorType,
+                       .dimensions = std::move(dimensions),
+                       .scale = kDataType.scale,
+                       .offset = kDataType.zeroPoint});
+    }
+
+    // A filter of the data type with random values, quantized per channel
+    // along the first dimension if the data type says so.
+    BenchmarkOperand filter(std::vector<uint32_t> dimensions) {
+        if (!kDataType.perChannel) {
+            return tensor(std::move(dimensions));
+        }
+        const uint32_t channels = dimensions[0];
+        std::vector<float> scales(channels);
+        for (uint32_t i = 0; i < channels; ++i) {
+            scales[i] = 0.01f + 0.001f * (i % 8);
+        }
+        return random({.type = OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL,
+                       .dimensions = std::move(dimensions),
+                       .extraParams = Operand::SymmPerChannelQuantParams{
+                               .scales = std::move(scales), .channelDim = 0}});
+    }
+
+    // A bias matching an input of the data type and `filter`.
+    BenchmarkOperand bias(const BenchmarkOperand& filter) {
+        const uint32_t channels = filter.shape.dimensions[0];
+        if (kDataType.tensorType == OperandType::TENSOR_FLOAT32 ||
+            kDataType.tensorType == OperandType::TENSOR_FLOAT16) {
+            return random({.type = kDataType.tensorType, .dimensions = {channels}});
+        }
+        // Per channel biases have a scale of 0.
+        const float scale = kDataType.perChannel ? 0.0f : kDataType.scale * filter.shape.scale;
+        return random(
+                {.type = OperandType::TENSOR_INT32, .dimensions = {channels}, .scale = scale});
+    }
+
+    // The output of the operations whose quantization is up to the model.
+    Shape output() const {
+        return {.type = kDataType.tensorType,
+                .scale = kDataType.scale * 2,
+                .offset = kDataType.zeroPoint};
+    }
+
+    template <typename Type>
+    static BenchmarkOperand scalar(OperandType type, Type value) {
+        BenchmarkOperand operand = {.shape = {.type = type},
+                                    .data = std::vector<uint8_t>(sizeof(value))};
+        std::memcpy(operand.data.data(), &value, sizeof(value));
+        return operand;
+    }
+
+    // A FLOAT32 scalar, or a FLOAT16 scalar for the operations on FLOAT16.
+    BenchmarkOperand floatScalar(float value) const {
+        if (kDataType.tensorType == OperandType::TENSOR_FLOAT16) {
+            return scalar<_Float16>(OperandType::FLOAT16, static_cast<_Float16>(value));
+        }
+        return scalar<float>(OperandType::FLOAT32, value);
+    }
+
+    // An output quantized like the inputs.
+    Shape outputLikeInputs() const {
+        return {.type = kDataType.tensorType,
+                .scale = kDataType.scale,
+                .offset = kDataType.zeroPoint};
+    }
+
+    bool isPerChannel() const { return kDataType.perChannel; }
+    bool isQuantized() const { return kDataType.scale != 0.0f; }
+
+   private:
+    BenchmarkOperand random(Shape shape) {
+        BenchmarkOperand operand = {
+                .data = std::vector<uint8_t>(
+                        nonExtensionOperandSizeOfData(shape.type, shape.dimensions))};
+        std::uniform_real_distribution<float> values(-1.0f, 1.0f);
+        switch (shape.type) {
+            case OperandType::TENSOR_FLOAT32:
+                fill<float>(&operand, [&] { return values(mRandom); });
+                break;
+            case OperandType::TENSOR_FLOAT16:
+                fill<_Float16>(&operand, [&] { return values(mRandom); });
+                break;
+            case OperandType::TENSOR_INT32:
+                fill<int32_t>(&operand, [&] { return values(mRandom) * 1000; });
+                break;
+            default:
+                fill<uint8_t>(&operand, [&] { return mRandom(); });
+                break;
+        }
+        operand.shape = std::move(shape);
+        return operand;
+    }
+
+    template <typename Type, typename Generator>
+    static void fill(BenchmarkOperand* operand, Generator generate) {
+        auto* values = reinterpret_cast<Type*>(operand->data.data());
+        for (size_t i = 0; i < operand->data.size() / sizeof(Type); ++i) {
+            values[i] = static_cast<Type>(generate());
+        }
+    }
+
+    const DataType& kDataType;
+    std::mt19937 mRandom;
+};
+
+struct OperationOperands {
+    std::vector<BenchmarkOperand> inputs;
+    Shape output;
+};
+
+// Returns the operands of an operation for an input shape, or nullopt if the
+// operation does not apply to the shape or the data type.
+using OperandsBuilder = std::function<std::optional<OperationOperands>(
+        OperandFactory*, const std::vector<uint32_t>& shape)>;
+
+const BenchmarkOperand kNoActivation = OperandFactory::scalar<int32_t>(
+        OperandType::INT32, static_cast<int32_t>(FusedActivationFunc::NONE));
+const BenchmarkOperand kPaddingSameScalar =
+        OperandFactory::scalar<int32_t>(OperandType::INT32, kPaddingSame);
+const BenchmarkOperand kOne = OperandFactory::scalar<int32_t>(OperandType::INT32, 1);
+const BenchmarkOperand kThree = OperandFactory::scalar<int32_t>(OperandType::INT32, 3);
+
+// The elementwise operations with a single input.
+std::optional<OperationOperands> unary(OperandFactory* factory,
+                                       const std::vector<uint32_t>& shape) {
+    if (factory->isPerChannel()) return std::nullopt;
+    return OperationOperands{{factory->tensor(shape)}, factory->output()};
+}
+
+// The elementwise operations with two inputs of the same shape.
+std::optional<OperationOperands> binary(OperandFactory* factory,
+                                        const std::vector<uint32_t>& shape) {
+    if (factory->isPerChannel()) return std::nullopt;
+    return OperationOperands{{factory->tensor(shape), factory->tensor(shape)},
+                             factory->output()};
+}
+
+std::optional<OperationOperands> binaryWithActivation(OperandFactory* factory,
+                                                      const std::vector<uint32_t>& shape) {
+    auto operands = binary(factory, shape);
+    if (operands.has_value()) {
+        operands->inputs.push_back(kNoActivation);
+    }
+    return operands;
+}
+
+std::optional<OperationOperands> softmax(OperandFactory* factory,
+                                         const std::vector<uint32_t>& shape) {
+    auto operands = unary(factory, shape);
+    if (operands.has_value()) {
+        operands->inputs.push_back(factory->floatScalar(1.0f));
+    }
+    return operands;
+}
+
+// A 3x3 window with a stride of 1 and SAME padding.
+std::optional<OperationOperands> pooling(OperandFactory* factory,
+                                         const std::vector<uint32_t>& shape) {
+    if (factory->isPerChannel() || shape.size() != 4) return std::nullopt;
+    return OperationOperands{
+            {factory->tensor(shape), kPaddingSameScalar, kOne, kOne, kThree, kThree, kNoActivation},
+            factory->output()};
+}
+
+// A 3x3 filter as deep as the input, with a stride of 1 and SAME padding.
+std::optional<OperationOperands> conv2d(OperandFactory* factory,
+                                        const std::vector<uint32_t>& shape) {
+    if (shape.size() != 4) return std::nullopt;
+    const uint32_t depth = shape[3];
+    BenchmarkOperand filter = factory->filter({depth, 3, 3, depth});
+    BenchmarkOperand bias = factory->bias(filter);
+    return OperationOperands{{factory->tensor(shape), std::move(filter), std::move(bias),
+                              kPaddingSameScalar, kOne, kOne, kNoActivation},
+                             factory->output()};
+}
+
+// The input flattened to a batch of vectors as deep as its last dimension,
+// and a square weights matrix.
+std::optional<OperationOperands> fullyConnected(OperandFactory* factory,
+                                                const std::vector<uint32_t>& shape) {
+    if (factory->isPerChannel()) return std::nullopt;
+    const uint32_t depth = shape.back();
+    uint32_t batches = 1;
+    for (size_t i = 0; i + 1 < shape.size(); ++i) {
+        batches *= shape[i];
+    }
+    BenchmarkOperand weights = factory->tensor({depth, depth});
+    BenchmarkOperand bias = factory->bias(weights);
+    return OperationOperands{
+            {factory->tensor({batches, depth}), std::move(weights), std::move(bias), kNoActivation},
+            factory->output()};
+}
+
+// How the second input of a binary operation is broadcast against the first.
+enum class BroadcastPattern { NONE, SCALAR, CHANNEL };
+
+// ADD, MUL and SUB with their second input broadcast as `pattern` says, and
+// with an output quantized like the inputs if `sameQuantization`.
+OperandsBuilder broadcastBinary(BroadcastPattern pattern, bool sameQuantization) {
+    return [pattern, sameQuantization](
+                   OperandFactory* factory,
+                   const std::vector<uint32_t>& shape) -> std::optional<OperationOperands> {
+        if (factory->isPerChannel() || (sameQuantization && !factory->isQuantized())) {
+            return std::nullopt;
+        }
+        std::vector<uint32_t> broadcastShape = shape;
+        if (pattern == BroadcastPattern::SCALAR) {
+            broadcastShape = {1};
+        } else if (pattern == BroadcastPattern::CHANNEL) {
+            broadcastShape = {shape.back()};
+        }
+        return OperationOperands{
+                {factory->tensor(shape), factory->tensor(std::move(broadcastShape)),
+                 kNoActivation},
+                sameQuantization ? factory->outputLikeInputs() : factory->output()};
+    };
+}
+
+// The operations with a fixed output quantization, whatever their output
+// quantization in the model is.
+OperandsBuilder withOutputQuantization(OperandsBuilder builder, float scale, int32_t asymmOffset,
+                                       int32_t signedOffset) {
+    return [builder, scale, asymmOffset, signedOffset](OperandFactory* factory,
+                                                       const std::vector<uint32_t>& shape) {
+        auto operands = builder(factory, shape);
+        if (operands.has_value()) {
+            if (operands->output.type == OperandType::TENSOR_QUANT8_ASYMM) {
+                operands->output.scale = scale;
+                operands->output.offset = asymmOffset;
+            } else if (operands->output.type == OperandType::TENSOR_QUANT8_ASYMM_SIGNED) {
+                operands->output.scale = scale;
+                operands->output.offset = signedOffset;
+            }
+        }
+        return operands;
+    };
+}
+
+// The operands of the registered operations that can be benchmarked. The
+// operations that are not listed here are not benchmarked.
+const std::vector<std::pair<OperationType, OperandsBuilder>>& getOperandsBuilders() {
+    static const auto* const builders = new std::vector<std::pair<OperationType, OperandsBuilder>>{
+            {OperationType::ABS, unary},
+            {OperationType::ADD, binaryWithActivation},
+            {OperationType::AVERAGE_POOL_2D, pooling},
+            {OperationType::CONV_2D, conv2d},
+            {OperationType::DIV, binaryWithActivation},
+            {OperationType::EXP, unary},
+            {OperationType::FLOOR, unary},
+            {OperationType::FULLY_CONNECTED, fullyConnected},
+            {OperationType::HARD_SWISH, unary},
+            {OperationType::L2_POOL_2D, pooling},
+            {OperationType::LOG, unary},
+            {OperationType::LOGISTIC, withOutputQuantization(unary, 1.f / 256, 0, -128)},
+            {OperationType::MAX_POOL_2D, pooling},
+            {OperationType::MAXIMUM, binary},
+            {OperationType::MINIMUM, binary},
+            {OperationType::MUL, binaryWithActivation},
+            {OperationType::NEG, unary},
+            {OperationType::POW, binary},
+            {OperationType::PRELU, binary},
+            {OperationType::RELU, unary},
+            {OperationType::RELU1, unary},
+            {OperationType::RELU6, unary},
+            {OperationType::RSQRT, unary},
+            {OperationType::SIN, unary},
+            {OperationType::SOFTMAX, withOutputQuantization(softmax, 1.f / 256, 0, -128)},
+            {OperationType::SQRT, unary},
+            {OperationType::SUB, binaryWithActivation},
+            {OperationType::TANH, withOutputQuantization(unary, 1.f / 128, 128, 0)},
+    };
+    return *builders;
+}
+
+// The additional benchmarks of the operations, by the name of their variant.
+const std::vector<std::tuple<OperationType, std::string, OperandsBuilder>>& getVariantBuilders() {
+    static const auto* const builders = [] {
+        const std::pair<const char*, BroadcastPattern> patterns[] = {
+                {"same_shape", BroadcastPattern::NONE},
+                {"scalar", BroadcastPattern::SCALAR},
+                {"channel", BroadcastPattern::CHANNEL},
+        };
+        auto* builders = new std::vector<std::tuple<OperationType, std::string, OperandsBuilder>>;
+        for (const auto type : {OperationType::ADD, OperationType::MUL, OperationType::SUB}) {
+            for (const auto& [name, pattern] : patterns) {
+                // The same shape with a different quantization is the default benchmark.
+                if (pattern != BroadcastPattern::NONE) {
+                    builders->emplace_back(type, name, broadcastBinary(pattern, false));
+                }
+                builders->emplace_back(type, std::string(name) + "_same_quantization",
+                                       broadcastBinary(pattern, true));
+            }
+        }
+        return builders;
+    }();
+    return *builders;
+}
+
+// Returns a prepared context, or nullopt if the operation does not support the
+// data type or the shape.
+std::optional<BenchmarkContext> prepare(const OperationRegistration& registration,
+                                        const OperandsBuilder& builder, const DataType& dataType,
+                                        const std::vector<uint32_t>& shape) {
+    OperandFactory factory(dataType);
+    auto operands = builder(&factory, shape);
+    if (!operands.has_value()) {
+        return std::nullopt;
+    }
+    BenchmarkContext context(std::move(operands->inputs), {std::move(operands->output)});
+    if (!registration.prepare(&context)) {
+        return std::nullopt;
+    }
+    return context;
+}
+
+void BM_Operation(benchmark::State& state, const OperationRegistration* registration,
+                  const OperandsBuilder* builder, const DataType* dataType,
+                  std::vector<uint32_t> shape) {
+    auto context = prepare(*registration, *builder, *dataType, shape);
+    if (!context.has_value() || !registration->execute(&context.value())) {
+        state.SkipWithError("unable to execute the operation");
+        return;
+    }
+    for (auto _ : state) {
+        registration->execute(&context.value());
+    }
+    const double elements = context->getOutputElements();
+    const double bytes = context->getTensorBytes();
+    state.counters["ns_per_element"] = benchmark::Counter(
+            elements * 1e-9, benchmark::Counter::kIsIterationInvariantRate |
+                                     benchmark::Counter::kInvert);
+    state.counters["GB/s"] =
+            benchmark::Counter(bytes * 1e-9, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+std::vector<std::string> split(const std::string& list, char separator) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    for (std::string item; std::getline(stream, item, separator);) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// Parses "1x32x32x16".
+std::optional<std::vector<uint32_t>> parseShape(const std::string& name) {
+    std::vector<uint32_t> shape;
+    for (const auto& dimension : split(name, 'x')) {
+        const unsigned long value = std::strtoul(dimension.c_str(), nullptr, 10);
+        if (value == 0) return std::nullopt;
+        shape.push_back(value);
+    }
+    if (shape.empty()) return std::nullopt;
+    return shape;
+}
+
+// Registers a benchmark for each operation, data type and shape that the
+// operation supports.
+bool registerBenchmarks(const std::string& typesFlag, const std::string& shapesFlag) {
+    std::vector<const DataType*> dataTypes;
+    for (const auto& name : split(typesFlag, ',')) {
+        const auto it = std::find_if(std::begin(kDataTypes), std::end(kDataTypes),
+                                     [&name](const DataType& type) { return type.name == name; });
+        if (it == std::end(kDataTypes)) {
+            fprintf(stderr, "Unknown data type %s\n", name.c_str());
+            return false;
+        }
+        dataTypes.push_back(it);
+    }
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> shapes;
+    for (const auto& name : split(shapesFlag, ',')) {
+        auto shape = parseShape(name);
+        if (!shape.has_value()) {
+            fprintf(stderr, "Invalid shape %s\n", name.c_str());
+            return false;
+        }
+        shapes.emplace_back(name, std::move(shape.value()));
+    }
+
+    // Registers the benchmarks of an operation with the operands of `builder`.
+    const auto registerOperation = [&dataTypes, &shapes](const OperationRegistration* registration,
+                                                         const OperandsBuilder* builder,
+                                                         const std::string& operationName) {
+        for (const auto* dataType : dataTypes) {
+            // Probes support with a small shape of the same rank.
+            for (const auto& [shapeName, shape] : shapes) {
+                const std::vector<uint32_t> probe(shape.size(), 2);
+                if (!prepare(*registration, *builder, *dataType, probe).has_value()) {
+                    continue;
+                }
+                const std::string name = operationName + "/" + dataType->name + "/" + shapeName;
+                benchmark::RegisterBenchmark(name.c_str(), BM_Operation, registration, builder,
+                                             dataType, shape)
+                        ->UseRealTime();
+            }
+        }
+    };
+
+    // prepare logs why it rejects unsupported data types.
+    base::ScopedLogSeverity quiet(base::FATAL);
+    const auto& builders = getOperandsBuilders();
+    std::string notBenchmarked;
+    for (int i = 0; i < BuiltinOperationResolver::kNumberOfOperationTypes; ++i) {
+        const auto* registration =
+                BuiltinOperationResolver::get()->findOperation(static_cast<OperationType>(i));
+        if (registration == nullptr || registration->execute == nullptr) continue;
+        const auto builder = std::find_if(
+                builders.begin(), builders.end(),
+                [registration](const auto& entry) { return entry.first == registration->type; });
+        if (builder == builders.end()) {
+            notBenchmarked += std::string(" ") + registration->name;
+            continue;
+        }
+        registerOperation(registration, &builder->second, registration->name);
+        for (const auto& [type, variant, variantBuilder] : getVariantBuilders()) {
+            if (type == registration->type) {
+                registerOperation(registration, &variantBuilder,
+                                  std::string(registration->name) + ":" + variant);
+            }
+        }
+    }
+    fprintf(stderr, "Operations without synthesized inputs:%s\n", notBenchmarked.c_str());
+    return true;
+}
+
+bool consumeFlag(const char* argument, const char* prefix, std::string* value) {
+    if (std::strncmp(argument, prefix, std::strlen(prefix)) != 0) return false;
+    *value = argument + std::strlen(prefix);
+    return true;
+}
+
+}  // namespace
+}  // namespace android::nn
+
+int main(int argc, char** argv) {
+    std::string typesFlag = "fp32,fp16,quant8_asymm,quant8_asymm_signed,quant8_per_channel";
+    std::string shapesFlag = "1x8x8x16,1x32x32x32,1x64x64x64";
+    int remaining = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!android::nn::consumeFlag(argv[i], "--op_types=", &typesFlag) &&
+            !android::nn::consumeFlag(argv[i], "--op_shapes=", &shapesFlag)) {
+            argv[remaining++] = argv[i];
+        }
+    }
+    argc = remaining;
+
+    if (!android::nn::registerBenchmarks(typesFlag, shapesFlag)) {
+        return 1;
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -48,7 +48,8 @@ inline bool roiAlignNhwc(const T_Input* inputData, const Shape& inputShape, cons
                          const Shape& roiShape, const int32_t* batchSplitData,
                          const Shape& /*batchSplitShape*/, float heightStride, float widthStride,
                          int32_t heightSamplingRatio, int32_t widthSamplingRatio,
-                         T_Input* outputData, const Shape& outputShape) {
+                         T_Input* outputData, const Shape& outputShape,
+                         const CancellationToken* cancellationToken) {
     NNTRACE_TRANS("RoiAlign");
 
     const uint32_t kRoiDim = 4;
@@ -68,6 +69,9 @@ inline bool roiAlignNhwc(const T_Input* inputData, const Shape& inputShape, cons
     const T_Roi* roiDataEnd = roiData + numRois * roiInfoLength;
     uint32_t roiIndex = 0;
     for (const T_Roi* roiInfo = roiData; roiInfo < roiDataEnd; roiInfo += kRoiDim, roiIndex++) {
+        if (isCancelled(cancellationToken)) {
+            return false;
+        }
         uint32_t batchId = static_cast<uint32_t>(batchSplitData[roiIndex]);
         // Check for malformed data
         // 1. invalid batch id
@@ -174,7 +178,8 @@ inline bool roiAlignQuantNhwc(const T_Input* inputData, const Shape& inputShape,
                               const int32_t* batchSplitData, const Shape& /*batchSplitShape*/,
                               float heightStride, float widthStride, int32_t heightSamplingRatio,
                               int32_t widthSamplingRatio, T_Input* outputData,
-                              const Shape& outputShape) {
+                              const Shape& outputShape,
+                              const CancellationToken* cancellationToken) {
     NNTRACE_TRANS("RoiAlignQuant8");
 
     constexpr float wScale = 1.0f / 255.0f;
@@ -195,6 +200,9 @@ inline bool roiAlignQuantNhwc(const T_Input* inputData, const Shape& inputShape,
     const uint16_t* roiDataEnd = roiData + numRois * roiInfoLength;
     uint32_t roiIndex = 0;
     for (const uint16_t* roiInfo = roiData; roiInfo < roiDataEnd; roiInfo += kRoiDim, roiIndex++) {
+        if (isCancelled(cancellationToken)) {
+            return false;
+        }
         uint32_t batchId = static_cast<uint32_t>(batchSplitData[roiIndex]);
         float wRoiStart = static_cast<float>(roiInfo[0]) * widthScale * 0.125f;
         float hRoiStart = static_cast<float>(roiInfo[1]) * heightScale * 0.125f;
@@ -306,7 +314,8 @@ inline bool roiAlign(const T_Input* inputData, const Shape& inputShape, const T_
                      const Shape& roiShape, const int32_t* batchSplitData,
                      const Shape& batchSplitShape, float heightStride, float widthStride,
                      int32_t heightSamplingRatio, int32_t widthSamplingRatio, bool useNchw,
-                     T_Input* outputData, const Shape& outputShape) {
+                     T_Input* outputData, const Shape& outputShape,
+                     const CancellationToken* cancellationToken) {
     InputWithLayout<T_Input> input(useNchw);
     OutputWithLayout<T_Input> output(useNchw);
     NN_RET_CHECK(input.initialize(inputData, inputShape));
@@ -316,12 +325,12 @@ inline bool roiAlign(const T_Input* inputData, const Shape& inputShape, const T_
         NN_RET_CHECK(roiAlignQuantNhwc<T_Input>(
                 input.getNhwcBuffer(), input.getNhwcShape(), roiData, roiShape, batchSplitData,
                 batchSplitShape, heightStride, widthStride, heightSamplingRatio, widthSamplingRatio,
-                output.getNhwcBuffer(), output.getNhwcShape()));
+                output.getNhwcBuffer(), output.getNhwcShape(), cancellationToken));
     } else {
         NN_RET_CHECK(roiAlignNhwc(input.getNhwcBuffer(), input.getNhwcShape(), roiData, roiShape,
                                   batchSplitData, batchSplitShape, heightStride, widthStride,
                                   heightSamplingRatio, widthSamplingRatio, output.getNhwcBuffer(),
-                                  output.getNhwcShape()));
+                                  output.getNhwcShape(), cancellationToken));
     }
     NN_RET_CHECK(output.commit());
     return true;
@@ -404,7 +413,8 @@ bool execute(IOperationExecutionContext* context) {
                             context->getInputValue<int32_t>(kWidthSamplingRatioScalar),
                             context->getInputValue<bool>(kLayoutScalar),
                             context->getOutputBuffer<_Float16>(kOutputTensor),
-                            context->getOutputShape(kOutputTensor));
+                            context->getOutputShape(kOutputTensor),
+                            context->getCancellationToken());
         case OperandType::TENSOR_FLOAT32:
             return roiAlign(context->getInputBuffer<float>(kInputTensor),
                             context->getInputShape(kInputTensor),
@@ -418,7 +428,8 @@ bool execute(IOperationExecutionContext* context) {
                             context->getInputValue<int32_t>(kWidthSamplingRatioScalar),
                             context->getInputValue<bool>(kLayoutScalar),
                             context->getOutputBuffer<float>(kOutputTensor),
-                            context->getOutputShape(kOutputTensor));
+                            context->getOutputShape(kOutputTensor),
+                            context->getCancellationToken());
         case OperandType::TENSOR_QUANT8_ASYMM:
             return roiAlign(context->getInputBuffer<uint8_t>(kInputTensor),
                             context->getInputShape(kInputTensor),
@@ -432,7 +443,8 @@ bool execute(IOperationExecutionContext* context) {
                             context->getInputValue<int32_t>(kWidthSamplingRatioScalar),
                             context->getInputValue<bool>(kLayoutScalar),
                             context->getOutputBuffer<uint8_t>(kOutputTensor),
-                            context->getOutputShape(kOutputTensor));
+                            context->getOutputShape(kOutputTensor),
+                            context->getCancellationToken());
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
             return roiAlign(context->getInputBuffer<int8_t>(kInputTensor),
                             context->getInputShape(kInputTensor),
@@ -446,7 +458,8 @@ bool execute(IOperationExecutionContext* context) {
                             context->getInputValue<int32_t>(kWidthSamplingRatioScalar),
                             context->getInputValue<bool>(kLayoutScalar),
                             context->getOutputBuffer<int8_t>(kOutputTensor),
-                            context->getOutputShape(kOutputTensor));
+                            context->getOutputShape(kOutputTensor),
+                            context->getCancellationToken());
         default:
             NN_RET_CHECK_FAIL() << "Unsupported tensor type for operation " << kOperationName;
     }
@@ -42,7 +42,8 @@ template <typename T_Input, typename T_Roi>
 inline bool roiPoolingNhwc(const T_Input* inputData, const Shape& inputShape, const T_Roi* roiData,
                            const Shape& roiShape, const int32_t* batchSplitData,
                            const Shape& /*batchSplitShape*/, float heightStride, float widthStride,
-                           T_Input* outputData, const Shape& outputShape) {
+                           T_Input* outputData, const Shape& outputShape,
+                           const CancellationToken* cancellationToken) {
     NNTRACE_TRANS("RoiPooling");
 
     const uint32_t kRoiDim = 4;
@@ -62,6 +63,9 @@ inline bool roiPoolingNhwc(const T_Input* inputData, const Shape& inputShape, co
     const T_Roi* roiDataEnd = roiData + numRois * roiInfoLength;
     uint32_t roiIndex = 0;
     for (const T_Roi* roiInfo = roiData; roiInfo < roiDataEnd; roiInfo += kRoiDim, roiIndex++) {
+        if (isCancelled(cancellationToken)) {
+            return false;
+        }
         uint32_t batchId = batchSplitData[roiIndex];
         // Check for malformed data
         // 1. invalid batch id
@@ -131,14 +135,15 @@ template <typename T_Input, typename T_Roi>
 inline bool roiPooling(const T_Input* inputData, const Shape& inputShape, const T_Roi* roiData,
                        const Shape& roiShape, const int32_t* batchSplitData,
                        const Shape& batchSplitShape, float heightStride, float widthStride,
-                       bool useNchw, T_Input* outputData, const Shape& outputShape) {
+                       bool useNchw, T_Input* outputData, const Shape& outputShape,
+                       const CancellationToken* cancellationToken) {
     InputWithLayout<T_Input> input(useNchw);
     OutputWithLayout<T_Input> output(useNchw);
     NN_RET_CHECK(input.initialize(inputData, inputShape));
     NN_RET_CHECK(output.initialize(outputData, outputShape));
     NN_RET_CHECK(roiPoolingNhwc(input.getNhwcBuffer(), input.getNhwcShape(), roiData, roiShape,
                                 batchSplitData, batchSplitShape, heightStride, widthStride,
-                                output.getNhwcBuffer(), output.getNhwcShape()));
+                                output.getNhwcBuffer(), output.getNhwcShape(), cancellationToken));
     NN_RET_CHECK(output.commit());
     return true;
 }
@@ -149,12 +154,13 @@ inline bool roiPooling<uint8_t, uint16_t>(const uint8_t* inputData, const Shape&
                                           const int32_t* batchSplitData,
                                           const Shape& batchSplitShape, float heightStride,
                                           float widthStride, bool useNchw, uint8_t* outputData,
-                                          const Shape& outputShape) {
+                                          const Shape& outputShape,
+                                          const CancellationToken* cancellationToken) {
     std::vector<float> roi_float32(getNumberOfElements(roiShape));
     convertQuantToFloat32(roiData, roiShape.scale, roiShape.offset, &roi_float32);
     NN_RET_CHECK(roiPooling(inputData, inputShape, roi_float32.data(), roiShape, batchSplitData,
                             batchSplitShape, heightStride, widthStride, useNchw, outputData,
-                            outputShape));
+                            outputShape, cancellationToken));
     return true;
 }
 
@@ -164,12 +170,13 @@ inline bool roiPooling<int8_t, uint16_t>(const int8_t* inputData, const Shape& i
                                          const int32_t* batchSplitData,
                                          const Shape& batchSplitShape, float heightStride,
                                          float widthStride, bool useNchw, int8_t* outputData,
-                                         const Shape& outputShape) {
+                                         const Shape& outputShape,
+                                         const CancellationToken* cancellationToken) {
     std::vector<float> roi_float32(getNumberOfElements(roiShape));
     convertQuantToFloat32(roiData, roiShape.scale, roiShape.offset, &roi_float32);
     NN_RET_CHECK(roiPooling(inputData, inputShape, roi_float32.data(), roiShape, batchSplitData,
                             batchSplitShape, heightStride, widthStride, useNchw, outputData,
-                            outputShape));
+                            outputShape, cancellationToken));
     return true;
 }
 
@@ -235,7 +242,8 @@ bool execute(IOperationExecutionContext* context) {
                               context->getInputValue<_Float16>(kWidthStrideScalar),
                               context->getInputValue<bool>(kLayoutScalar),
                               context->getOutputBuffer<_Float16>(kOutputTensor),
-                              context->getOutputShape(kOutputTensor));
+                              context->getOutputShape(kOutputTensor),
+                              context->getCancellationToken());
         case OperandType::TENSOR_FLOAT32:
             return roiPooling(context->getInputBuffer<float>(kInputTensor),
                               context->getInputShape(kInputTensor),
@@ -247,7 +255,8 @@ bool execute(IOperationExecutionContext* context) {
                               context->getInputValue<float>(kWidthStrideScalar),
                               context->getInputValue<bool>(kLayoutScalar),
                               context->getOutputBuffer<float>(kOutputTensor),
-                              context->getOutputShape(kOutputTensor));
+                              context->getOutputShape(kOutputTensor),
+                              context->getCancellationToken());
         case OperandType::TENSOR_QUANT8_ASYMM:
             return roiPooling(context->getInputBuffer<uint8_t>(kInputTensor),
                               context->getInputShape(kInputTensor),
@@ -259,7 +268,8 @@ bool execute(IOperationExecutionContext* context) {
                               context->getInputValue<float>(kWidthStrideScalar),
                               context->getInputValue<bool>(kLayoutScalar),
                               context->getOutputBuffer<uint8_t>(kOutputTensor),
-                              context->getOutputShape(kOutputTensor));
+                              context->getOutputShape(kOutputTensor),
+                              context->getCancellationToken());
         case OperandType::TENSOR_QUANT8_ASYMM_SIGNED:
             return roiPooling(context->getInputBuffer<int8_t>(kInputTensor),
                               context->getInputShape(kInputTensor),
@@ -271,7 +281,8 @@ bool execute(IOperationExecutionContext* context) {
                               context->getInputValue<float>(kWidthStrideScalar),
                               context->getInputValue<bool>(kLayoutScalar),
                               context->getOutputBuffer<int8_t>(kOutputTensor),
-                              context->getOutputShape(kOutputTensor));
+                              context->getOutputShape(kOutputTensor),
+                              context->getCancellationToken());
         default:
             NN_RET_CHECK_FAIL() << "Unsupported tensor type for operation " << kOperationName;
     }
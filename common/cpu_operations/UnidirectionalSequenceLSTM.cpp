@@ -313,7 +313,7 @@ bool execute(IOperationExecutionContext* context) {
                 cellStateOut = cellStateOutBuffer.data();
             }
             std::vector<float> scratchBuffer(scratchSize);
-            LSTMCell::LSTMEvalFloat32(
+            const bool finished = LSTMCell::LSTMEvalFloat32(
                     getLSTMParams<float>(context), context->getInputBuffer<float>(kInputTensor),
                     context->getInputShape(kInputTensor),
                     context->getInputBuffer<float>(kInputToInputWeightsTensor),
@@ -347,7 +347,11 @@ bool execute(IOperationExecutionContext* context) {
                     context->getInputBuffer<float>(kCellLayerNormWeightsTensor),
                     context->getInputBuffer<float>(kOutputLayerNormWeightsTensor), outputStateOut,
                     cellStateOut, context->getOutputBuffer<float>(kOutputTensor),
-                    scratchBuffer.data(), isTimeMajor(context));
+                    scratchBuffer.data(), isTimeMajor(context), /*forwardSequence=*/true,
+                    context->getCancellationToken());
+            if (!finished) {
+                return false;
+            }
         } break;
         case OperandType::TENSOR_FLOAT16: {
             // Initialize empty vectors and resize below only if needed
@@ -365,7 +369,7 @@ bool execute(IOperationExecutionContext* context) {
                 cellStateOut = cellStateOutBuffer.data();
             }
             std::vector<_Float16> scratchBuffer(scratchSize);
-            LSTMCell::LSTMEvalFloat16(
+            const bool finished = LSTMCell::LSTMEvalFloat16(
                     getLSTMParams<_Float16>(context),
                     context->getInputBuffer<_Float16>(kInputTensor),
                     context->getInputShape(kInputTensor),
@@ -400,7 +404,11 @@ bool execute(IOperationExecutionContext* context) {
                     context->getInputBuffer<_Float16>(kCellLayerNormWeightsTensor),
                     context->getInputBuffer<_Float16>(kOutputLayerNormWeightsTensor),
                     outputStateOut, cellStateOut, context->getOutputBuffer<_Float16>(kOutputTensor),
-                    scratchBuffer.data(), isTimeMajor(context));
+                    scratchBuffer.data(), isTimeMajor(context), /*forwardSequence=*/true,
+                    context->getCancellationToken());
+            if (!finished) {
+                return false;
+            }
         } break;
         default: {
             LOG(ERROR) << "Unsupported data type: " << static_cast<int>(inputType);
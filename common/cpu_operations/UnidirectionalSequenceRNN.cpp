@@ -93,6 +93,9 @@ bool executeTyped(IOperationExecutionContext* context) {
     fixedTimeInputShape.dimensions[1] = inputShape.dimensions[2];
 
     for (uint32_t i = 0; i < maxTime; ++i) {
+        if (context->isCancelled()) {
+            return false;
+        }
         RNN::RNNStep<T>(input, fixedTimeInputShape, hiddenState, bias, weights, weightsShape,
                         recurrentWeights, recurrentWeightsShape, activation, output);
         input += batchSize * inputSize;
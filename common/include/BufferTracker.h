@@ -24,12 +24,12 @@
 #include <memory>
 #include <mutex>
 #include <set>
-#include <stack>
 #include <utility>
 #include <vector>
 
 #include "CpuExecutor.h"
 #include "LegacyUtils.h"
+#include "TokenTable.h"
 #include "nnapi/Types.h"
 #include "nnapi/Validation.h"
 
@@ -97,22 +97,16 @@ class BufferTracker : public std::enable_shared_from_this<BufferTracker> {
     static std::shared_ptr<BufferTracker> create() { return std::make_shared<BufferTracker>(); }
 
     // Prefer BufferTracker::create.
-    BufferTracker();
+    BufferTracker() = default;
 
     std::unique_ptr<Token> add(std::shared_ptr<ManagedBuffer> buffer);
+    // Thread-safe, and does not contend with other calls to get().
     std::shared_ptr<ManagedBuffer> get(Request::MemoryDomainToken token) const;
 
    private:
     void free(Request::MemoryDomainToken token);
 
-    mutable std::mutex mMutex;
-    std::stack<Request::MemoryDomainToken, std::vector<Request::MemoryDomainToken>> mFreeTokens
-            GUARDED_BY(mMutex);
-
-    // Since the tokens are allocated in a non-sparse way, we use a vector to represent the mapping.
-    // The index of the vector is the token. When the token gets freed, the corresponding entry is
-    // set to nullptr. mTokenToBuffers[0] is always set to nullptr because 0 is an invalid token.
-    std::vector<std::shared_ptr<ManagedBuffer>> mTokenToBuffers GUARDED_BY(mMutex);
+    TokenTable<ManagedBuffer> mTokenToBuffers;
 };
 
 }  // namespace android::nn
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_CANCELLATION_TOKEN_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_CANCELLATION_TOKEN_H
+
+#include <atomic>
+
+#include "nnapi/Types.h"
+
+namespace android {
+namespace nn {
+
+// Lets one thread ask a computation running on another thread to stop early.
+//
+// Cancellation is cooperative: the computation polls isCancelled() at
+// convenient boundaries, such as between operations, or between tiles or time
+// steps of a long running operation, and gives up when it returns true. A token
+// is also cancelled once its deadline, if any, has passed, or once its parent,
+// if any, is cancelled, so that a single poll covers all the reasons to stop.
+//
+// cancel() and isCancelled() may be called concurrently from any thread.
+class CancellationToken {
+   public:
+    CancellationToken() = default;
+
+    // The parent, if not nullptr, must outlive this token.
+    CancellationToken(const OptionalTimePoint& deadline, const CancellationToken* parent)
+        : mDeadline(deadline), mParent(parent) {}
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    void cancel() { mCancelRequested.store(true, std::memory_order_relaxed); }
+
+    // Clears a previous call to cancel(), so that the token can be reused.
+    void reset() { mCancelRequested.store(false, std::memory_order_relaxed); }
+
+    // Returns true if cancel() was called on this token or one of its
+    // ancestors, ignoring deadlines.
+    bool isCancelRequested() const {
+        return mCancelRequested.load(std::memory_order_relaxed) ||
+               (mParent != nullptr && mParent->isCancelRequested());
+    }
+
+    // Returns true if the computation should stop.
+    bool isCancelled() const {
+        return isCancelRequested() || (mDeadline.has_value() && Clock::now() >= *mDeadline) ||
+               (mParent != nullptr && mParent->isCancelled());
+    }
+
+   private:
+    std::atomic<bool> mCancelRequested = false;
+    const OptionalTimePoint mDeadline;
+    const CancellationToken* const mParent = nullptr;
+};
+
+// Returns true if token is not nullptr and is cancelled.
+inline bool isCancelled(const CancellationToken* token) {
+    return token != nullptr && token->isCancelled();
+}
+
+}  // namespace nn
+}  // namespace android
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_CANCELLATION_TOKEN_H
@@ -21,10 +21,13 @@
 #include <nnapi/Types.h>
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 
+#include "CancellationToken.h"
 #include "ControlFlow.h"
 #include "LegacyUtils.h"
 #include "OperationResolver.h"
@@ -150,6 +153,16 @@ class CpuExecutor {
             const std::vector<RunTimePoolInfo>& modelPoolInfos,
             const std::vector<RunTimePoolInfo>& requestPoolInfos);
 
+    // Computes the shapes of the model outputs without executing the model.
+    // Runs the prepare function of each operation whose inputs all have a
+    // value in the model or the request, in execution order. The outputs of
+    // the other operations keep the shapes given by the model and the request.
+    // The request outputs need no memory. On success, getOutputShapes()
+    // returns the shapes found.
+    int inferOutputShapes(const Model& model, const Request& request,
+                          const std::vector<RunTimePoolInfo>& modelPoolInfos,
+                          const std::vector<RunTimePoolInfo>& requestPoolInfos);
+
     const std::vector<OutputShape>& getOutputShapes() const {
         CHECK(mFinished) << "getOutputShapes() called by an unfinished CpuExecutor.";
         return mOutputShapes;
@@ -158,6 +171,19 @@ class CpuExecutor {
     void setDeadline(const TimePoint& deadline) { mDeadline = deadline; }
     void setLoopTimeout(uint64_t duration) { mLoopTimeoutDuration = duration; }
 
+    // Sets a function to call before each operation, including the operations
+    // of referenced subgraphs. The runtime uses it to let more urgent work run
+    // on the executing thread.
+    void setOperationBoundaryCallback(std::function<void()> callback) {
+        mOperationBoundaryCallback = std::move(callback);
+    }
+
+    // Sets a token that another thread can cancel to stop the execution early.
+    // It is polled between operations and by long running operations. A
+    // cancelled execution fails with ANEURALNETWORKS_OP_FAILED. The token must
+    // outlive run().
+    void setCancellationToken(const CancellationToken* token) { mCancellationToken = token; }
+
    private:
     // Creates runtime info from what's in the model.
     std::vector<RunTimeOperandInfo> initializeRunTimeInfo(const Model::Subgraph& subgraph);
@@ -173,10 +199,19 @@ class CpuExecutor {
     int executeOperation(const Operation& operation, RunTimeOperandInfo* operands);
     int executeIfOperation(const Operation& operation, RunTimeOperandInfo* operands);
     int executeWhileOperation(const Operation& operation, RunTimeOperandInfo* operands);
+    // Sets the shapes of the outputs of one operation, without allocating
+    // them. Returns false if the operation cannot run with these inputs. The
+    // operations whose output shapes cannot be computed without running them
+    // are left as is.
+    bool prepareOperation(const Operation& operation, RunTimeOperandInfo* operands);
 
     void setOutputShapes(const std::vector<uint32_t>& outputIndexes,
                          const std::vector<RunTimeOperandInfo>& operands);
 
+    // Returns the result code of an execution that stopped because
+    // mRunCancellationToken is cancelled.
+    int getCancellationResultCode() const;
+
     // Compile-time operand value information used by initializeRunTimeInfo.
     // The fields are only valid while run() is being executed.
     const uint8_t* mModelOperandValues = nullptr;
@@ -198,6 +233,14 @@ class CpuExecutor {
     // WHILE loop.
     uint64_t mLoopTimeoutDuration = operation_while::kTimeoutNsDefault;
 
+    std::function<void()> mOperationBoundaryCallback;
+
+    const CancellationToken* mCancellationToken = nullptr;
+
+    // Cancelled when either mCancellationToken is cancelled or mDeadline has
+    // passed. Only valid while run() is being executed.
+    const CancellationToken* mRunCancellationToken = nullptr;
+
     [[maybe_unused]] const IOperationResolver* mOperationResolver;
 };
 
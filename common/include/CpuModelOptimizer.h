@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_CPU_MODEL_OPTIMIZER_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_CPU_MODEL_OPTIMIZER_H
+
+#include <nnapi/Types.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "CpuExecutor.h"
+
+namespace android::nn {
+
+struct CpuModelOptimizationStats {
+    // Operations evaluated ahead of time, whose outputs became constants.
+    uint32_t foldedOperations = 0;
+    // Operations moved out of a WHILE body, to run once per WHILE operation
+    // rather than once per loop iteration.
+    uint32_t hoistedOperations = 0;
+};
+
+/**
+ * @brief Rewrites a model prepared for the CpuExecutor so that it executes fewer operations.
+ *
+ * - Constant folding: evaluates the operations whose inputs are all constant with the CPU
+ *   kernels, and replaces their outputs by constants appended to model->operandValues, up to
+ *   16 MiB per model.
+ * - Loop-invariant hoisting: moves the operations of a WHILE body that only depend on
+ *   constants and input-only operands of the loop to the subgraph of the WHILE operation, and
+ *   passes their results to the loop as additional input-only operands. Hoisted operations run
+ *   even if the loop does not iterate, so only elementwise floating point operations that
+ *   cannot fail are hoisted.
+ *
+ * Only temporaries of a fully specified shape are folded or hoisted, and the inputs and outputs
+ * of the main subgraph are unchanged, so the model accepts the same requests. A WHILE body or
+ * condition subgraph referenced more than once is left as is. The model may be left with dead
+ * operands, which the CpuExecutor ignores.
+ *
+ * @pre model != nullptr
+ * @pre modelPoolInfos are the pools of the model
+ *
+ * @param model The valid model to optimize.
+ * @param modelPoolInfos The pools of the model, for the constant operands that reference them.
+ * @return The number of operations that were folded and hoisted.
+ */
+CpuModelOptimizationStats optimizeModelForCpu(Model* model,
+                                              const std::vector<RunTimePoolInfo>& modelPoolInfos);
+
+}  // namespace android::nn
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_CPU_MODEL_OPTIMIZER_H
@@ -211,6 +211,39 @@ class OutputWithLayout {
     bool mUseNchw;
 };
 
+// Splits [0, size) into tiles of at most tileSize, and calls
+// function(first, count) for each of them. Long running operations use it to
+// poll cancellationToken between tiles of their outermost dimension. Stops and
+// returns false if function returns false or if the execution is cancelled.
+template <typename Function>
+bool forEachTile(uint32_t size, uint32_t tileSize, const CancellationToken* cancellationToken,
+                 const Function& function) {
+    NN_RET_CHECK_GT(tileSize, 0u);
+    for (uint32_t first = 0; first < size; first += tileSize) {
+        if (first != 0 && isCancelled(cancellationToken)) {
+            return false;
+        }
+        if (!function(first, std::min(tileSize, size - first))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The number of multiply-accumulates in a tile of forEachTile: large enough
+// that the setup of a kernel call is negligible, and small enough that a
+// cancelled execution stops within a few milliseconds.
+constexpr uint64_t kMultiplyAccumulatesPerTile = uint64_t{1} << 24;
+
+// Returns the tile size to pass to forEachTile for an operation that does
+// multiplyAccumulatesPerItem multiply-accumulates per item of the tiled
+// dimension.
+inline uint32_t getTileSize(uint64_t multiplyAccumulatesPerItem) {
+    return static_cast<uint32_t>(std::clamp<uint64_t>(
+            kMultiplyAccumulatesPerTile / std::max<uint64_t>(multiplyAccumulatesPerItem, 1), 1,
+            std::numeric_limits<uint32_t>::max()));
+}
+
 template <typename T>
 inline void CalculateActivationRange(int32_t activation, const Shape& outputShape,
                                      int32_t* outputActivationMin, int32_t* outputActivationMax);
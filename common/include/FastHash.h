@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_FAST_HASH_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_FAST_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace android {
+namespace nn {
+
+// Fast non-cryptographic hashes, for fingerprints and in-process memoization
+// keys. They do not resist deliberately constructed collisions, so anything
+// that guards the integrity of a cache must use TokenHasher (SHA-256) instead.
+
+// Computes XXH64 of length bytes at data.
+uint64_t fastHash64(const void* data, size_t length, uint64_t seed = 0);
+
+// Computes a 256-bit hash of length bytes at data in a single pass and writes
+// it to the kFastHash256Size bytes at out. The four 64-bit lanes of XXH64 are
+// kept separate, absorb the bytes after the last 32-byte stripe as well, and
+// are each finalized together with the XXH64 digest. Every input byte thus
+// reaches every lane, including for inputs shorter than a stripe.
+constexpr size_t kFastHash256Size = 32;
+void fastHash256(const void* data, size_t length, uint8_t* out);
+
+// Accumulates fields into a contiguous buffer, so that they can be hashed
+// with a single call instead of one hasher update per field.
+class HashBuffer {
+   public:
+    void appendBytes(const void* bytes, size_t length) {
+        const auto* begin = static_cast<const uint8_t*>(bytes);
+        mBuffer.insert(mBuffer.end(), begin, begin + length);
+    }
+
+    template <typename T>
+    void append(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        appendBytes(&value, sizeof(value));
+    }
+
+    // Appends the number of values before them, so that consecutive vectors
+    // split differently do not append the same bytes.
+    template <typename T>
+    void append(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        append(static_cast<uint64_t>(values.size()));
+        appendBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void reserve(size_t capacity) { mBuffer.reserve(capacity); }
+    void clear() { mBuffer.clear(); }
+
+    const uint8_t* data() const { return mBuffer.data(); }
+    size_t size() const { return mBuffer.size(); }
+
+   private:
+    std::vector<uint8_t> mBuffer;
+};
+
+}  // namespace nn
+}  // namespace android
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_FAST_HASH_H
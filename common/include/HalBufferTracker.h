@@ -23,12 +23,12 @@
 #include <memory>
 #include <mutex>
 #include <set>
-#include <stack>
 #include <utility>
 #include <vector>
 
 #include "CpuExecutor.h"
 #include "HalInterfaces.h"
+#include "TokenTable.h"
 #include "Utils.h"
 #include "ValidateHal.h"
 
@@ -99,21 +99,16 @@ class HalBufferTracker : public std::enable_shared_from_this<HalBufferTracker> {
     }
 
     // Prefer HalBufferTracker::create.
-    HalBufferTracker() : mTokenToBuffers(1) {}
+    HalBufferTracker() = default;
 
     std::unique_ptr<Token> add(std::shared_ptr<HalManagedBuffer> buffer);
+    // Thread-safe, and does not contend with other calls to get().
     std::shared_ptr<HalManagedBuffer> get(uint32_t token) const;
 
    private:
     void free(uint32_t token);
 
-    mutable std::mutex mMutex;
-    std::stack<uint32_t, std::vector<uint32_t>> mFreeTokens;
-
-    // Since the tokens are allocated in a non-sparse way, we use a vector to represent the mapping.
-    // The index of the vector is the token. When the token gets freed, the corresponding entry is
-    // set to nullptr. mTokenToBuffers[0] is always set to nullptr because 0 is an invalid token.
-    std::vector<std::shared_ptr<HalManagedBuffer>> mTokenToBuffers;
+    TokenTable<HalManagedBuffer> mTokenToBuffers;
 };
 
 }  // namespace android::nn
@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 
+#include "CancellationToken.h"
 #include "OperationsUtils.h"
 #include "nnapi/TypeUtils.h"
 #include "nnapi/Types.h"
@@ -57,6 +58,14 @@ class IOperationExecutionContext {
     virtual bool isOmittedInput(uint32_t index) const = 0;
     virtual bool isOmittedOutput(uint32_t index) const = 0;
 
+    // Returns the token that tells whether the execution should stop early, or
+    // nullptr if it cannot be cancelled.
+    virtual const CancellationToken* getCancellationToken() const { return nullptr; }
+
+    // Long running operations poll this between tiles or time steps, and
+    // return false without finishing the computation if it returns true.
+    bool isCancelled() const { return nn::isCancelled(getCancellationToken()); }
+
     template <typename T>
     const T* getInputBuffer(uint32_t index) const {
         return reinterpret_cast<const T*>(getInputBuffer(index));
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_QUANTIZED_LOOKUP_TABLE_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_QUANTIZED_LOOKUP_TABLE_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "OperationsExecutionUtils.h"
+
+namespace android {
+namespace nn {
+
+// Elementwise operations on 8-bit quantized tensors have only 256 possible
+// inputs. Once their 256 outputs are computed, the operation is a table lookup
+// per element, whatever the cost of the function.
+
+// The outputs of an elementwise operation, indexed by the bits of the input
+// value: entry i is the output for the TENSOR_QUANT8_ASYMM input i, or for the
+// TENSOR_QUANT8_ASYMM_SIGNED input static_cast<int8_t>(i).
+using QuantizedLookupTable = std::array<uint8_t, 256>;
+
+// Tensors with fewer elements than this are computed directly, as looking up
+// the table costs about as much as computing a few hundred elements.
+constexpr uint32_t kMinElementsForQuantizedLookupTable = 256;
+
+// Computes an operation on `size` elements of input to output. Both buffers
+// are of the type of the tensors, viewed as bytes.
+using QuantizedElementwiseFunction =
+        std::function<bool(const uint8_t* input, uint32_t size, uint8_t* output)>;
+
+// Returns the table of the operation `operationType` from inputShape to
+// outputShape, filled by calling `compute` on all 256 input values the first
+// time. Tables are cached per process by operation type, by the types, scales
+// and zero points of the input and output, and by `parameters`, which
+// identify anything else the outputs depend on, such as the value of another
+// operand. Returns nullptr if `compute` fails.
+std::shared_ptr<const QuantizedLookupTable> getQuantizedLookupTable(
+        OperationType operationType, const Shape& inputShape, const Shape& outputShape,
+        const QuantizedElementwiseFunction& compute, const std::vector<int32_t>& parameters = {});
+
+// output[i] = table[input[i]] for `size` bytes.
+void applyQuantizedLookupTable(const QuantizedLookupTable& table, const uint8_t* input,
+                               uint32_t size, uint8_t* output);
+
+// Computes an elementwise operation on a quant8 tensor with the table of the
+// operation if the tensor is large enough, and with `compute` otherwise.
+template <typename T>
+bool computeQuantizedElementwise(OperationType operationType, const T* input,
+                                 const Shape& inputShape, T* output, const Shape& outputShape,
+                                 const std::function<bool(const T*, uint32_t, T*)>& compute) {
+    static_assert(sizeof(T) == 1);
+    const uint32_t size = getNumberOfElements(inputShape);
+    if (size < kMinElementsForQuantizedLookupTable) {
+        return compute(input, size, output);
+    }
+    const auto table = getQuantizedLookupTable(
+            operationType, inputShape, outputShape,
+            [&compute](const uint8_t* tableInput, uint32_t tableSize, uint8_t* tableOutput) {
+                return compute(reinterpret_cast<const T*>(tableInput), tableSize,
+                               reinterpret_cast<T*>(tableOutput));
+            });
+    if (table == nullptr) {
+        return false;
+    }
+    applyQuantizedLookupTable(*table, reinterpret_cast<const uint8_t*>(input), size,
+                              reinterpret_cast<uint8_t*>(output));
+    return true;
+}
+
+}  // namespace nn
+}  // namespace android
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_QUANTIZED_LOOKUP_TABLE_H
@@ -36,6 +36,8 @@ class TokenHasher {
 
     // Updates with a byte array. Returns false and sets to be empty on fail.
     // The client must check if the hasher is valid before invoking this method.
+    // Small updates are batched and hashed together, which does not change the
+    // resulting token.
     bool update(const void* bytes, size_t length);
 
     // Updates with a string ended with '\0'. Returns false and sets to be empty on fail.
@@ -56,6 +58,14 @@ class TokenHasher {
     bool ok() const { return !mIsError; }
 
    private:
+    // Hashes and clears mBuffer. Returns false and sets to be empty on fail.
+    bool flush();
+
+    // Updates smaller than kBatchSize are accumulated in mBuffer, so that a
+    // sequence of per-field updates costs a few SHA256_Update calls.
+    static constexpr size_t kBatchSize = 4096;
+    std::vector<uint8_t> mBuffer;
+
     // Stores the transformed token, non-empty iff the hasher is not initialized
     // with nullptr and finish is called.
     std::vector<uint8_t> mToken;
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_TOKEN_TABLE_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_TOKEN_TABLE_H
+
+#include <android-base/macros.h>
+#include <android-base/thread_annotations.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace android::nn {
+
+// Maps the tokens of the buffer trackers to their buffers. Tokens are allocated
+// in a non-sparse way starting from 1, because 0 is an invalid token, and are
+// reused once freed.
+//
+// get() is called for every memory pool of every execution, so it is lock-free:
+// only add() and free() take the lock of the table. The slots live in chunks
+// that are allocated on demand and never move until the table is destroyed. A
+// lookup announces itself in the reader count of its slot before checking that
+// the slot is set, and free() clears the slot, then waits for the readers of
+// the slot to leave before it releases the object. Lookups never wait, and only
+// share cache lines with lookups of the same token.
+template <typename Type>
+class TokenTable {
+    DISALLOW_COPY_AND_ASSIGN(TokenTable);
+
+   public:
+    static constexpr uint32_t kChunkSize = 256;
+    static constexpr uint32_t kMaxChunks = 4096;
+    static constexpr uint32_t kMaxTokens = kChunkSize * kMaxChunks;
+
+    TokenTable() = default;
+
+    ~TokenTable() {
+        for (auto& chunk : mChunks) {
+            delete chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Returns the token of `object`, or 0 if the table is full.
+    uint32_t add(std::shared_ptr<Type> object) {
+        std::lock_guard<std::mutex> guard(mMutex);
+        uint32_t token = 0;
+        if (!mFreeTokens.empty()) {
+            token = mFreeTokens.back();
+            mFreeTokens.pop_back();
+        } else {
+            if (mNextToken == kMaxTokens) {
+                return 0;
+            }
+            token = mNextToken++;
+            std::atomic<Chunk*>& chunk = mChunks[token / kChunkSize];
+            if (chunk.load(std::memory_order_relaxed) == nullptr) {
+                chunk.store(new Chunk(), std::memory_order_release);
+            }
+        }
+        getSlot(token).store(std::move(object));
+        return token;
+    }
+
+    // Returns nullptr if no object is registered with `token`.
+    std::shared_ptr<Type> get(uint32_t token) const {
+        if (token / kChunkSize >= kMaxChunks) {
+            return nullptr;
+        }
+        const Chunk* chunk = mChunks[token / kChunkSize].load(std::memory_order_acquire);
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        return (*chunk)[token % kChunkSize].load();
+    }
+
+    // Unregisters the object registered with `token`, and returns it, or nullptr
+    // if there is none.
+    std::shared_ptr<Type> free(uint32_t token) {
+        std::lock_guard<std::mutex> guard(mMutex);
+        if (token == 0 || token >= mNextToken) {
+            return nullptr;
+        }
+        auto object = getSlot(token).take();
+        if (object != nullptr) {
+            mFreeTokens.push_back(token);
+        }
+        return object;
+    }
+
+   private:
+    // On its own cache line, so that lookups of different tokens do not contend.
+    // store() and take() are called with the lock of the table held.
+    class alignas(64) Slot {
+       public:
+        std::shared_ptr<Type> load() const {
+            // Sequentially consistent, together with the accesses of take(),
+            // so that either take() sees this reader or this reader sees that
+            // the slot is cleared.
+            mReaders.fetch_add(1);
+            std::shared_ptr<Type> object;
+            if (mIsSet.load()) {
+                object = mObject;
+            }
+            mReaders.fetch_sub(1, std::memory_order_release);
+            return object;
+        }
+
+        // Precondition: the slot is not set.
+        void store(std::shared_ptr<Type> object) {
+            mObject = std::move(object);
+            mIsSet.store(true);
+        }
+
+        std::shared_ptr<Type> take() {
+            if (!mIsSet.load(std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            mIsSet.store(false);
+            while (mReaders.load() != 0) {
+                // The readers only copy a shared_ptr, but may have been
+                // preempted.
+                std::this_thread::yield();
+            }
+            return std::move(mObject);
+        }
+
+       private:
+        mutable std::atomic<uint32_t> mReaders = 0;
+        std::atomic<bool> mIsSet = false;
+        std::shared_ptr<Type> mObject;
+    };
+    using Chunk = std::array<Slot, kChunkSize>;
+
+    // Precondition: token < mNextToken
+    Slot& getSlot(uint32_t token) REQUIRES(mMutex) {
+        return (*mChunks[token / kChunkSize].load(std::memory_order_relaxed))[token % kChunkSize];
+    }
+
+    std::mutex mMutex;
+    std::vector<uint32_t> mFreeTokens GUARDED_BY(mMutex);
+    uint32_t mNextToken GUARDED_BY(mMutex) = 1;
+    std::array<std::atomic<Chunk*>, kMaxChunks> mChunks = {};
+};
+
+}  // namespace android::nn
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_TOKEN_TABLE_H
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_TYPES_TRACE_RECORDER_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_TYPES_TRACE_RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// In-process recorder of the NNTRACE spans (see Tracing.h), for profiling
+// without a systrace capture, e.g. on Linux hosts, and with several clients of
+// the runtime in the same process.
+//
+// While recording, each thread appends the spans it ends to its own ring
+// buffer, without locks. A buffer holds the last kTraceEventsPerThread spans of
+// its thread. The buffer of a thread that exits is reused by the next thread
+// that records, and its spans are kept until they are overwritten.
+//
+// Recording starts either with startTraceRecording(), or when the process
+// starts if the NN_TRACE_FILE environment variable is set, in which case the
+// spans are written to the file it names when the process exits.
+//
+// The spans are exported in the JSON format of the Chrome trace viewer, which
+// Perfetto (ui.perfetto.dev) also reads. Each span is named after its detail,
+// with its layer as the category and its phase as an argument.
+
+namespace android::nn {
+
+constexpr uint32_t kTraceEventsPerThread = 1 << 15;
+
+void startTraceRecording();
+void stopTraceRecording();
+
+// Drops the spans recorded so far.
+void clearTraceRecording();
+
+// Writes the spans recorded so far by all threads.
+void writeChromeTrace(std::ostream* out);
+bool writeChromeTrace(const std::string& path);
+
+// Implementation of the NNTRACE macros.
+
+extern std::atomic<bool> gTraceRecording;
+
+inline bool isTraceRecording() {
+    return gTraceRecording.load(std::memory_order_relaxed);
+}
+
+// Nanoseconds on a monotonic clock, never 0.
+int64_t getTraceTimestamp();
+
+// `name` must outlive the recorder, as the names of NNTRACE spans, which are
+// string literals, do.
+void recordTraceSpan(const char* name, int64_t begin, int64_t end);
+
+}  // namespace android::nn
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_COMMON_TYPES_TRACE_RECORDER_H
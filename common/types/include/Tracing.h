@@ -22,18 +22,22 @@
 #include <utils/Trace.h>
 #endif  // NN_COMPATIBILITY_LIBRARY_BUILD
 
+#include "TraceRecorder.h"
+
 // Neural Networks API (NNAPI) systracing
 //
 // Primary goal of the tracing is to capture and present timings for NNAPI.
 // (Other uses include providing visibility to split of execution between
 // drivers and the CPU fallback, and the ability to visualize call sequences).
 //
-// The tracing has three parts:
+// The tracing has four parts:
 //  1 Trace macros defined in this file and used throughout the codebase,
 //    modelled after and using atrace. These implement a naming convention for
 //    the tracepoints, interpreted by the systrace parser.
 //  2 Android systrace (atrace) on-device capture and host-based analysis.
 //  3 A systrace parser (TODO) to summarize the timings.
+//  4 An in-process recorder of the same tracepoints, exporting Chrome trace
+//    JSON, for hosts and concurrent clients. See TraceRecorder.h.
 //
 // For an overview and introduction, please refer to the "NNAPI Systrace design
 // and HOWTO" (internal Docs for now). This header doesn't try to replicate all
@@ -121,8 +125,9 @@
 #define NNTRACE_FULL_SUBTRACT(layer, phase, detail) \
     NNTRACE_NAME_1(("[SUB][NN_" layer "_" phase "]" detail))
 // Raw macro without scoping requirements, for special cases
-#define NNTRACE_FULL_RAW(layer, phase, detail) \
-    android::ScopedTrace PASTE(___tracer, __LINE__)(ATRACE_TAG, ("[NN_" layer "_" phase "]" detail))
+#define NNTRACE_FULL_RAW(layer, phase, detail)                 \
+    ::android::nn::TraceScope NNTRACE_PASTE(___tracer, __LINE__)( \
+            ("[NN_" layer "_" phase "]" detail))
 
 // Tracing buckets - for calculating timing summaries over.
 //
@@ -151,28 +156,55 @@
 #define NNTRACE_LAYER_OTHER "LO"
 #define NNTRACE_LAYER_UTILITY "LU"  // Code used from multiple layers
 
-#ifndef NN_COMPATIBILITY_LIBRARY_BUILD
-
 // Implementation
 //
 // Almost same as ATRACE_NAME, but enforcing explicit distinction between
 // phase-per-scope and switching phases.
 //
 // Basic trace, one per scope allowed to enforce disjointness
-#define NNTRACE_NAME_1(name) ::android::ScopedTrace ___tracer_1(ATRACE_TAG, name)
+#define NNTRACE_NAME_1(name) ::android::nn::TraceScope ___tracer_1(name)
 // Switching trace, more than one per scope allowed, translated by
 // systrace_parser.py. This is mainly useful for tracing multiple phases through
 // one function / scope.
-#define NNTRACE_NAME_SWITCH(name)                                        \
-    ::android::ScopedTrace PASTE(___tracer, __LINE__)(ATRACE_TAG, name); \
+#define NNTRACE_NAME_SWITCH(name)                                       \
+    ::android::nn::TraceScope NNTRACE_PASTE(___tracer, __LINE__)(name); \
     (void)___tracer_1  // ensure switch is only used after a basic trace
 
-#else
+#define NNTRACE_PASTE(x, y) NNTRACE_PASTE_(x, y)
+#define NNTRACE_PASTE_(x, y) x##y
 
-#define NNTRACE_NAME_1(name)       // empty
-#define NNTRACE_NAME_SWITCH(name)  // empty
+namespace android::nn {
+
+// Traces a scope with atrace, and with the in-process recorder while it
+// records. Its cost is a relaxed atomic load when the recorder is not
+// recording.
+class TraceScope {
+   public:
+    explicit TraceScope(const char* name)
+        : mName(name), mBegin(isTraceRecording() ? getTraceTimestamp() : 0) {
+#ifndef NN_COMPATIBILITY_LIBRARY_BUILD
+        ATRACE_BEGIN(name);
+#endif  // NN_COMPATIBILITY_LIBRARY_BUILD
+    }
 
+    ~TraceScope() {
+#ifndef NN_COMPATIBILITY_LIBRARY_BUILD
+        ATRACE_END();
 #endif  // NN_COMPATIBILITY_LIBRARY_BUILD
+        if (mBegin != 0) {
+            recordTraceSpan(mName, mBegin, getTraceTimestamp());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+   private:
+    const char* const mName;
+    const int64_t mBegin;
+};
+
+}  // namespace android::nn
 
 // Disallow use of raw ATRACE macros
 #undef ATRACE_NAME
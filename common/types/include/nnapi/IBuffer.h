@@ -61,6 +61,26 @@ class IBuffer {
     virtual GeneralResult<void> copyFrom(const SharedMemory& src,
                                          const Dimensions& dimensions) const = 0;
 
+    /**
+     * Sets the content of another buffer from this buffer, without going through a shared memory
+     * region.
+     *
+     * This method is optional. The runtime only calls it when both buffers were allocated by the
+     * same IDevice, and falls back to IBuffer::copyTo and IBuffer::copyFrom through a shared
+     * memory region if it fails. The default implementation always fails.
+     *
+     * The IBuffer object must have been initialized before the call to IBuffer::copyToBuffer.
+     *
+     * @param dst The destination buffer, allocated by the same IDevice as this buffer.
+     * @param dimensions Updated dimensional information for dst, with the same requirements as
+     *     the dimensions passed to IBuffer::copyFrom.
+     * @return Nothing on success, otherwise GeneralError.
+     */
+    virtual GeneralResult<void> copyToBuffer(const IBuffer& /*dst*/,
+                                             const Dimensions& /*dimensions*/) const {
+        return NN_ERROR(ErrorStatus::GENERAL_FAILURE) << "IBuffer::copyToBuffer is not supported";
+    }
+
     // Public virtual destructor to allow objects to be stored (and destroyed) as smart pointers.
     // E.g., std::unique_ptr<IBuffer>.
     virtual ~IBuffer() = default;
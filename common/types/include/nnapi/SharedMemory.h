@@ -88,6 +88,13 @@ GeneralResult<SharedMemory> createSharedMemory(size_t size);
 // Precondition: size > 0
 GeneralResult<SharedMemory> createSharedMemoryFromFd(size_t size, int prot, int fd, size_t offset);
 
+// Makes the content of `memory` immutable if its backing supports it, which is the case of the
+// memfd regions that createSharedMemory returns on Linux host builds, and returns a read-only
+// memory object for the same region. Otherwise, or if `memory` is still mapped for writing,
+// returns `memory` unchanged.
+// Precondition: memory != nullptr
+GeneralResult<SharedMemory> sealSharedMemory(SharedMemory memory);
+
 #ifdef __ANDROID__
 // Precondition: ahwb != nullptr
 GeneralResult<SharedMemory> createSharedMemoryFromAHWB(AHardwareBuffer* ahwb, bool takeOwnership);
@@ -42,6 +42,7 @@ struct LSTMParams {
     bool output_state;
 };
 
+class CancellationToken;
 struct RunTimeOperandInfo;
 struct Shape;
 
@@ -126,7 +127,8 @@ class LSTMCell {
             const float* cell_layer_norm_weights_buffer,
             const float* output_layer_norm_weights_buffer, float* output_state_out_buffer,
             float* cell_state_out_buffer, float* output_buffer, float* scratch_buffer_buffer,
-            bool timeMajor = true, bool forwardSequence = true);
+            bool timeMajor = true, bool forwardSequence = true,
+            const CancellationToken* cancellationToken = nullptr);
 
     static bool LSTMEvalFloat16(
             const LSTMParams& params, const _Float16* input_buffer, const Shape& input_shape,
@@ -154,7 +156,8 @@ class LSTMCell {
             const _Float16* cell_layer_norm_weights_buffer,
             const _Float16* output_layer_norm_weights_buffer, _Float16* output_state_out_buffer,
             _Float16* cell_state_out_buffer, _Float16* output_buffer,
-            _Float16* scratch_buffer_buffer, bool timeMajor = true, bool forwardSequence = true);
+            _Float16* scratch_buffer_buffer, bool timeMajor = true, bool forwardSequence = true,
+            const CancellationToken* cancellationToken = nullptr);
 
     static bool LSTMStep(
             const LSTMParams& params, const float* input_buffer, const Shape& input_shape,
@@ -124,18 +124,21 @@ GeneralResult<SharedMemory> ConstantMemoryBuilder::finish() {
     // Allocate the memory.
     auto memory = NN_TRY(mBuilder.finish());
 
-    // Map the memory.
-    const auto [pointer, size, context] = NN_TRY(map(memory););
+    {
+        // Map the memory.
+        const auto [pointer, size, context] = NN_TRY(map(memory););
 
-    // Get mutable pointer.
-    uint8_t* mutablePointer = static_cast<uint8_t*>(std::get<void*>(pointer));
+        // Get mutable pointer.
+        uint8_t* mutablePointer = static_cast<uint8_t*>(std::get<void*>(pointer));
 
-    // Copy data to the memory pool.
-    std::for_each(mSlices.begin(), mSlices.end(), [mutablePointer](const auto& slice) {
-        std::memcpy(mutablePointer + slice.offset, slice.data, slice.length);
-    });
+        // Copy data to the memory pool.
+        std::for_each(mSlices.begin(), mSlices.end(), [mutablePointer](const auto& slice) {
+            std::memcpy(mutablePointer + slice.offset, slice.data, slice.length);
+        });
+    }
 
-    return memory;
+    // Now that the memory is unmapped, prevent further writes to the constants.
+    return sealSharedMemory(std::move(memory));
 }
 
 bool hasNoPointerData(const Model& model) {
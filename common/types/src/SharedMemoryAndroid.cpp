@@ -24,6 +24,17 @@
 #include <android/hardware_buffer.h>
 #endif  // __ANDROID__
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#endif  // defined(__linux__) && !defined(__ANDROID__)
+
 #include <algorithm>
 #include <any>
 #include <iterator>
@@ -45,6 +56,30 @@
 #include "DynamicCLDeps.h"
 #endif  // NN_COMPATIBILITY_LIBRARY_BUILD
 
+#if defined(__linux__) && !defined(__ANDROID__)
+// The host sysroot may predate memfd_create and file sealing.
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_GET_SEALS 1034
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+#endif  // defined(__linux__) && !defined(__ANDROID__)
+
 namespace android::nn {
 namespace {
 
@@ -59,9 +94,74 @@ GeneralResult<SharedMemory> createSharedMemoryFromUniqueFd(size_t size, int prot
     return std::make_shared<const Memory>(Memory{.handle = std::move(handle)});
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+
+// Regions of at least this size are backed by huge pages when possible.
+constexpr size_t kHugePageThreshold = 2 * 1024 * 1024;
+
+// Large regions rely on transparent huge pages, which the kernel uses for
+// shared memory only if /sys/kernel/mm/transparent_hugepage/shmem_enabled
+// allows it. Setting NN_MEMFD_HUGETLB instead backs them with pages reserved in
+// hugetlbfs, when their size is a multiple of the huge page size.
+bool useHugetlb() {
+    static const bool enabled = std::getenv("NN_MEMFD_HUGETLB") != nullptr;
+    return enabled;
+}
+
+base::unique_fd createMemfd(unsigned int flags) {
+#ifdef SYS_memfd_create
+    return base::unique_fd(static_cast<int>(syscall(SYS_memfd_create, "nnapi_memfd", flags)));
+#else   // SYS_memfd_create
+    (void)flags;
+    return {};
+#endif  // SYS_memfd_create
+}
+
+bool isMemfd(int fd) {
+    // Only memfds support sealing.
+    return fcntl(fd, F_GET_SEALS) != -1;
+}
+
+// Fixes the size of a memfd, so that a process sharing it cannot shrink it
+// under the mappings of another one.
+bool sealSize(int fd) {
+    return fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) == 0;
+}
+
+// Returns an invalid fd if the region cannot be backed by hugetlbfs, or if its
+// size cannot be sealed: not every kernel supports seals on hugetlbfs.
+base::unique_fd createHugetlbMemfd(size_t size) {
+    auto fd = createMemfd(MFD_CLOEXEC | MFD_ALLOW_SEALING | MFD_HUGETLB);
+    if (!fd.ok()) {
+        return {};
+    }
+    struct stat fileStatus = {};
+    if (fstat(fd.get(), &fileStatus) != 0 || fileStatus.st_blksize <= 0 ||
+        size % fileStatus.st_blksize != 0) {
+        return {};
+    }
+    // Reserve the huge pages now, because touching a page that cannot be
+    // backed raises SIGBUS instead of failing.
+    if (ftruncate(fd.get(), size) != 0 || fallocate(fd.get(), 0, 0, size) != 0 ||
+        !sealSize(fd.get())) {
+        return {};
+    }
+    return fd;
+}
+
+void adviseHugePages(const Memory::Fd& memory, void* data) {
+    if (memory.size < kHugePageThreshold || memory.offset != 0 || !isMemfd(memory.fd.get())) {
+        return;
+    }
+    // Best effort: the kernel may not support transparent huge pages.
+    madvise(data, memory.size, MADV_HUGEPAGE);
+}
+
+#endif  // defined(__linux__) && !defined(__ANDROID__)
+
 #ifndef NN_COMPATIBILITY_LIBRARY_BUILD
 
-GeneralResult<SharedMemory> allocateSharedMemory(size_t size) {
+GeneralResult<SharedMemory> allocateAshmem(size_t size) {
     CHECK_GT(size, 0u);
 
     auto fd = base::unique_fd(ashmem_create_region("nnapi_ashmem", size));
@@ -78,6 +178,44 @@ GeneralResult<SharedMemory> allocateSharedMemory(size_t size) {
     return std::make_shared<const Memory>(Memory{.handle = std::move(handle)});
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+
+GeneralResult<SharedMemory> allocateSharedMemory(size_t size) {
+    CHECK_GT(size, 0u);
+
+    // A hugetlbfs memfd is sealed when it is created. Otherwise fall back to a
+    // regular memfd.
+    base::unique_fd fd;
+    if (size >= kHugePageThreshold && useHugetlb()) {
+        fd = createHugetlbMemfd(size);
+    }
+    if (!fd.ok()) {
+        fd = createMemfd(MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (!fd.ok()) {
+            // The kernel predates memfd_create.
+            return allocateAshmem(size);
+        }
+        if (ftruncate(fd.get(), size) != 0) {
+            return NN_ERROR() << "ftruncate of memfd failed";
+        }
+        if (!sealSize(fd.get())) {
+            return NN_ERROR() << "Unable to seal the size of memfd";
+        }
+    }
+
+    constexpr int prot = PROT_READ | PROT_WRITE;
+    constexpr size_t offset = 0;
+    return createSharedMemoryFromUniqueFd(size, prot, std::move(fd), offset);
+}
+
+#else  // defined(__linux__) && !defined(__ANDROID__)
+
+GeneralResult<SharedMemory> allocateSharedMemory(size_t size) {
+    return allocateAshmem(size);
+}
+
+#endif  // defined(__linux__) && !defined(__ANDROID__)
+
 GeneralResult<Mapping> map(const Memory::Ashmem& memory) {
     constexpr off64_t offset = 0;
     constexpr int prot = PROT_READ | PROT_WRITE;
@@ -158,6 +296,9 @@ GeneralResult<Mapping> map(const Memory::Fd& memory) {
         return NN_ERROR() << "Can't mmap the file descriptor.";
     }
     char* data = mapping->data();
+#if defined(__linux__) && !defined(__ANDROID__)
+    adviseHugePages(memory, data);
+#endif  // defined(__linux__) && !defined(__ANDROID__)
 
     const bool writable = (memory.prot & PROT_WRITE) != 0;
     std::variant<const void*, void*> pointer;
@@ -240,6 +381,25 @@ GeneralResult<SharedMemory> createSharedMemoryFromFd(size_t size, int prot, int
     return createSharedMemoryFromUniqueFd(size, prot, NN_TRY(dupFd(fd)), offset);
 }
 
+GeneralResult<SharedMemory> sealSharedMemory(SharedMemory memory) {
+    CHECK(memory != nullptr);
+#if defined(__linux__) && !defined(__ANDROID__)
+    const auto* fdMemory = std::get_if<Memory::Fd>(&memory->handle);
+    if (fdMemory == nullptr || !isMemfd(fdMemory->fd.get())) {
+        return memory;
+    }
+    // Fails if the region is still mapped for writing, or if the file system
+    // does not support write seals.
+    if (fcntl(fdMemory->fd.get(), F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        return memory;
+    }
+    return createSharedMemoryFromUniqueFd(fdMemory->size, PROT_READ,
+                                          NN_TRY(dupFd(fdMemory->fd.get())), fdMemory->offset);
+#else   // defined(__linux__) && !defined(__ANDROID__)
+    return memory;
+#endif  // defined(__linux__) && !defined(__ANDROID__)
+}
+
 #ifdef __ANDROID__
 GeneralResult<SharedMemory> createSharedMemoryFromAHWB(AHardwareBuffer* ahwb, bool takeOwnership) {
     CHECK(ahwb != nullptr);
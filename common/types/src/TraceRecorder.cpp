@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TraceRecorder.h"
+
+#include <android-base/chrono_utils.h>
+#include <android-base/logging.h>
+#include <android-base/no_destructor.h>
+#include <android-base/thread_annotations.h>
+#include <android-base/threads.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace android::nn {
+
+std::atomic<bool> gTraceRecording = false;
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t begin;
+    int64_t end;
+    int32_t threadId;
+};
+
+// A ring buffer written by a single thread at a time, and read by any thread.
+// Each slot is a sequence lock: the sequence number of the span it holds is
+// cleared while the span is written, so that readers skip the slots that are
+// being overwritten.
+class TraceBuffer {
+   public:
+    TraceBuffer() : mSlots(new Slot[kTraceEventsPerThread]) {}
+
+    void record(const TraceEvent& event) {
+        const uint64_t index = mHead.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[index % kTraceEventsPerThread];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(event.name, std::memory_order_relaxed);
+        slot.begin.store(event.begin, std::memory_order_relaxed);
+        slot.end.store(event.end, std::memory_order_relaxed);
+        slot.threadId.store(event.threadId, std::memory_order_relaxed);
+        slot.sequence.store(index + 1, std::memory_order_release);
+        mHead.store(index + 1, std::memory_order_release);
+    }
+
+    // Appends the spans that began at or after `since`.
+    void collect(int64_t since, std::vector<TraceEvent>* events) const {
+        const uint64_t head = mHead.load(std::memory_order_acquire);
+        const uint64_t tail = head > kTraceEventsPerThread ? head - kTraceEventsPerThread : 0;
+        for (uint64_t index = tail; index < head; ++index) {
+            const Slot& slot = mSlots[index % kTraceEventsPerThread];
+            if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+                continue;
+            }
+            const TraceEvent event = {.name = slot.name.load(std::memory_order_relaxed),
+                                      .begin = slot.begin.load(std::memory_order_relaxed),
+                                      .end = slot.end.load(std::memory_order_relaxed),
+                                      .threadId = slot.threadId.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == index + 1 &&
+                event.begin >= since) {
+                events->push_back(event);
+            }
+        }
+    }
+
+   private:
+    struct Slot {
+        std::atomic<uint64_t> sequence = 0;
+        std::atomic<const char*> name = nullptr;
+        std::atomic<int64_t> begin = 0;
+        std::atomic<int64_t> end = 0;
+        std::atomic<int32_t> threadId = 0;
+    };
+
+    std::unique_ptr<Slot[]> mSlots;
+    std::atomic<uint64_t> mHead = 0;
+};
+
+// Owns the buffers of all threads. Only taking a buffer, releasing it and
+// collecting the spans take the lock.
+class TraceBuffers {
+   public:
+    static TraceBuffers& get() {
+        // Not destroyed, as threads may still record when the process exits.
+        static base::NoDestructor<TraceBuffers> buffers;
+        return *buffers;
+    }
+
+    TraceBuffer* acquire() {
+        std::lock_guard<std::mutex> guard(mMutex);
+        if (!mFreeBuffers.empty()) {
+            TraceBuffer* buffer = mFreeBuffers.back();
+            mFreeBuffers.pop_back();
+            return buffer;
+        }
+        mBuffers.push_back(std::make_unique<TraceBuffer>());
+        return mBuffers.back().get();
+    }
+
+    void release(TraceBuffer* buffer) {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mFreeBuffers.push_back(buffer);
+    }
+
+    std::vector<TraceEvent> collect(int64_t since) const {
+        std::vector<TraceEvent> events;
+        std::lock_guard<std::mutex> guard(mMutex);
+        for (const auto& buffer : mBuffers) {
+            buffer->collect(since, &events);
+        }
+        return events;
+    }
+
+   private:
+    mutable std::mutex mMutex;
+    std::vector<std::unique_ptr<TraceBuffer>> mBuffers GUARDED_BY(mMutex);
+    std::vector<TraceBuffer*> mFreeBuffers GUARDED_BY(mMutex);
+};
+
+// The buffer of the current thread, taken when the thread records its first
+// span and released when the thread exits.
+class ThreadTraceBuffer {
+   public:
+    ~ThreadTraceBuffer() {
+        if (mBuffer != nullptr) {
+            TraceBuffers::get().release(mBuffer);
+        }
+    }
+
+    void record(const char* name, int64_t begin, int64_t end) {
+        if (mBuffer == nullptr) {
+            mBuffer = TraceBuffers::get().acquire();
+            mThreadId = base::GetThreadId();
+        }
+        mBuffer->record({.name = name, .begin = begin, .end = end, .threadId = mThreadId});
+    }
+
+   private:
+    TraceBuffer* mBuffer = nullptr;
+    int32_t mThreadId = 0;
+};
+
+thread_local ThreadTraceBuffer tThreadTraceBuffer;
+
+// The spans that began before this timestamp were cleared.
+std::atomic<int64_t> gClearedBefore = 0;
+
+// Splits "[SW][NN_LR_PE]detail" into its fields.
+struct TraceName {
+    std::string_view detail;
+    std::string_view layer;
+    std::string_view phase;
+    std::string_view kind;
+};
+
+TraceName parseTraceName(std::string_view name) {
+    TraceName traceName;
+    traceName.detail = name;
+    for (std::string_view kind : {"[SW]", "[SUB]"}) {
+        if (name.substr(0, kind.size()) == kind) {
+            traceName.kind = kind.substr(1, kind.size() - 2);
+            name.remove_prefix(kind.size());
+        }
+    }
+    constexpr std::string_view kPrefix = "[NN_";
+    const size_t separator = name.find('_', kPrefix.size());
+    const size_t close = name.find(']');
+    if (name.substr(0, kPrefix.size()) != kPrefix || separator == std::string_view::npos ||
+        close == std::string_view::npos || separator > close) {
+        return traceName;
+    }
+    traceName.layer = name.substr(kPrefix.size(), separator - kPrefix.size());
+    traceName.phase = name.substr(separator + 1, close - separator - 1);
+    traceName.detail = name.substr(close + 1);
+    return traceName;
+}
+
+std::string_view getLayerName(std::string_view layer) {
+    constexpr std::pair<std::string_view, std::string_view> kLayers[] = {
+            {"LA", "application"}, {"LR", "runtime"}, {"LI", "ipc"},     {"LD", "driver"},
+            {"LC", "cpu"},         {"LO", "other"},   {"LU", "utility"},
+    };
+    for (const auto& [code, name] : kLayers) {
+        if (layer == code) return name;
+    }
+    return layer.empty() ? "unknown" : layer;
+}
+
+std::string_view getPhaseName(std::string_view phase) {
+    constexpr std::pair<std::string_view, std::string_view> kPhases[] = {
+            {"PO", "overall"},           {"PWU", "warmup"},
+            {"PBM", "benchmark"},        {"PI", "initialization"},
+            {"PP", "preparation"},       {"PC", "compilation"},
+            {"PE", "execution"},         {"PT", "termination"},
+            {"PU", "unspecified"},       {"PIO", "inputs_and_outputs"},
+            {"PTR", "transformation"},   {"PCO", "computation"},
+            {"PR", "results"},
+    };
+    for (const auto& [code, name] : kPhases) {
+        if (phase == code) return name;
+    }
+    return phase;
+}
+
+void writeJsonString(std::ostream* out, std::string_view value) {
+    *out << '"';
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            *out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            *out << ' ';
+        } else {
+            *out << c;
+        }
+    }
+    *out << '"';
+}
+
+void writeMicroseconds(std::ostream* out, int64_t nanoseconds) {
+    *out << nanoseconds / 1000 << '.' << static_cast<char>('0' + nanoseconds / 100 % 10)
+         << static_cast<char>('0' + nanoseconds / 10 % 10)
+         << static_cast<char>('0' + nanoseconds % 10);
+}
+
+void writeTraceFileAtExit() {
+    const char* path = std::getenv("NN_TRACE_FILE");
+    if (path != nullptr) {
+        stopTraceRecording();
+        writeChromeTrace(std::string(path));
+    }
+}
+
+// Starts recording when the library is loaded if NN_TRACE_FILE is set.
+[[maybe_unused]] const bool kRecordingFromEnvironment = [] {
+    const char* path = std::getenv("NN_TRACE_FILE");
+    if (path == nullptr || *path == '\0') {
+        return false;
+    }
+    startTraceRecording();
+    std::atexit(writeTraceFileAtExit);
+    return true;
+}();
+
+}  // namespace
+
+void startTraceRecording() {
+    gTraceRecording.store(true, std::memory_order_relaxed);
+}
+
+void stopTraceRecording() {
+    gTraceRecording.store(false, std::memory_order_relaxed);
+}
+
+void clearTraceRecording() {
+    gClearedBefore.store(getTraceTimestamp(), std::memory_order_relaxed);
+}
+
+int64_t getTraceTimestamp() {
+    const auto now = base::boot_clock::now().time_since_epoch();
+    return std::max<int64_t>(std::chrono::nanoseconds(now).count(), 1);
+}
+
+void recordTraceSpan(const char* name, int64_t begin, int64_t end) {
+    tThreadTraceBuffer.record(name, begin, end);
+}
+
+void writeChromeTrace(std::ostream* out) {
+    auto events = TraceBuffers::get().collect(gClearedBefore.load(std::memory_order_relaxed));
+    // Parents before their children, which end later and are recorded later.
+    std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        return a.begin != b.begin ? a.begin < b.begin : a.end > b.end;
+    });
+    const int processId = getpid();
+    *out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        const TraceName name = parseTraceName(event.name);
+        *out << (i == 0 ? "\n" : ",\n") << "{\"ph\":\"X\",\"name\":";
+        writeJsonString(out, name.detail);
+        *out << ",\"cat\":";
+        writeJsonString(out, getLayerName(name.layer));
+        *out << ",\"pid\":" << processId << ",\"tid\":" << event.threadId << ",\"ts\":";
+        writeMicroseconds(out, event.begin);
+        *out << ",\"dur\":";
+        writeMicroseconds(out, event.end - event.begin);
+        *out << ",\"args\":{\"phase\":";
+        writeJsonString(out, getPhaseName(name.phase));
+        if (!name.kind.empty()) {
+            *out << ",\"kind\":";
+            writeJsonString(out, name.kind);
+        }
+        *out << "}}";
+    }
+    *out << "\n]}\n";
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        LOG(ERROR) << "Unable to open " << path << " to write the NNAPI trace";
+        return false;
+    }
+    writeChromeTrace(&out);
+    out.close();
+    if (!out) {
+        LOG(ERROR) << "Unable to write the NNAPI trace to " << path;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace android::nn
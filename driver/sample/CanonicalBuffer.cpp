@@ -36,6 +36,26 @@ void copyRunTimePoolInfos(const RunTimePoolInfo& srcPool, const RunTimePoolInfo&
     dstPool.flush();
 }
 
+GeneralResult<void> copyToBufferInternal(const std::shared_ptr<ManagedBuffer>& srcWrapper,
+                                         const Dimensions& dimensions,
+                                         const std::shared_ptr<ManagedBuffer>& dstWrapper) {
+    CHECK(srcWrapper != nullptr);
+    CHECK(dstWrapper != nullptr);
+    const auto srcPool = srcWrapper->createRunTimePoolInfo();
+    ErrorStatus validationStatus = srcWrapper->validateCopyTo(srcPool.getSize());
+    if (validationStatus != ErrorStatus::NONE) {
+        return NN_ERROR(validationStatus);
+    }
+    validationStatus = dstWrapper->validateCopyFrom(dimensions, srcPool.getSize());
+    if (validationStatus != ErrorStatus::NONE) {
+        return NN_ERROR(validationStatus);
+    }
+    const auto dstPool = dstWrapper->createRunTimePoolInfo();
+    copyRunTimePoolInfos(srcPool, dstPool);
+
+    return {};
+}
+
 GeneralResult<void> copyFromInternal(const SharedMemory& src, const Dimensions& dimensions,
                                      const std::shared_ptr<ManagedBuffer>& bufferWrapper) {
     CHECK(bufferWrapper != nullptr);
@@ -57,10 +77,14 @@ GeneralResult<void> copyFromInternal(const SharedMemory& src, const Dimensions&
 
 }  // namespace
 
-Buffer::Buffer(std::shared_ptr<ManagedBuffer> buffer, std::unique_ptr<BufferTracker::Token> token)
-    : kBuffer(std::move(buffer)), kToken(std::move(token)) {
+Buffer::Buffer(std::shared_ptr<ManagedBuffer> buffer, std::unique_ptr<BufferTracker::Token> token,
+               std::shared_ptr<BufferTracker> bufferTracker)
+    : kBuffer(std::move(buffer)),
+      kToken(std::move(token)),
+      kBufferTracker(std::move(bufferTracker)) {
     CHECK(kBuffer != nullptr);
     CHECK(kToken != nullptr);
+    CHECK(kBufferTracker != nullptr);
 }
 
 Request::MemoryDomainToken Buffer::getToken() const {
@@ -97,4 +121,25 @@ GeneralResult<void> Buffer::copyFrom(const SharedMemory& src, const Dimensions&
     return {};
 }
 
+GeneralResult<void> Buffer::copyToBuffer(const IBuffer& dst, const Dimensions& dimensions) const {
+    // Only buffers allocated by the same device are registered in kBufferTracker.
+    const auto dstWrapper = kBufferTracker->get(dst.getToken());
+    if (dstWrapper == nullptr) {
+        return NN_ERROR(ErrorStatus::INVALID_ARGUMENT)
+               << "SampleBuffer::copyToBuffer -- dst was not allocated by this device.";
+    }
+    if (dstWrapper == kBuffer) {
+        return {};
+    }
+    if (const auto result = copyToBufferInternal(kBuffer, dimensions, dstWrapper); !result.ok()) {
+        dstWrapper->setInitialized(false);
+        NN_TRY(result);
+    }
+
+    dstWrapper->updateDimensions(dimensions);
+    dstWrapper->setInitialized(true);
+
+    return {};
+}
+
 }  // namespace android::nn::sample
@@ -29,17 +29,23 @@ namespace android::nn::sample {
 
 class Buffer final : public IBuffer {
    public:
-    Buffer(std::shared_ptr<ManagedBuffer> buffer, std::unique_ptr<BufferTracker::Token> token);
+    Buffer(std::shared_ptr<ManagedBuffer> buffer, std::unique_ptr<BufferTracker::Token> token,
+           std::shared_ptr<BufferTracker> bufferTracker);
 
     Request::MemoryDomainToken getToken() const override;
 
     GeneralResult<void> copyTo(const SharedMemory& dst) const override;
     GeneralResult<void> copyFrom(const SharedMemory& src,
                                  const Dimensions& dimensions) const override;
+    GeneralResult<void> copyToBuffer(const IBuffer& dst,
+                                     const Dimensions& dimensions) const override;
 
    private:
     const std::shared_ptr<ManagedBuffer> kBuffer;
     const std::unique_ptr<BufferTracker::Token> kToken;
+    // The tracker of the device that allocated this buffer, which resolves the
+    // token of a destination buffer in copyToBuffer.
+    const std::shared_ptr<BufferTracker> kBufferTracker;
 };
 
 }  // namespace android::nn::sample
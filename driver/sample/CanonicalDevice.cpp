@@ -252,7 +252,8 @@ GeneralResult<SharedBuffer> Device::allocate(const BufferDesc& desc,
                << "sample::Device::allocate -- BufferTracker returned invalid token.";
     }
 
-    auto sampleBuffer = std::make_shared<const Buffer>(std::move(bufferWrapper), std::move(token));
+    auto sampleBuffer = std::make_shared<const Buffer>(std::move(bufferWrapper), std::move(token),
+                                                       kBufferTracker);
     VLOG(DRIVER) << "sample::Device::allocate -- successfully allocates the requested memory";
     return sampleBuffer;
 }
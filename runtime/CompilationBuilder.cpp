@@ -19,11 +19,15 @@
 #include "CompilationBuilder.h"
 
 #include <LegacyUtils.h>
+#include <Tracing.h>
+#include <android-base/scopeguard.h>
 #include <nnapi/IBurst.h>
 #include <nnapi/SharedMemory.h>
 #include <nnapi/Types.h>
 
 #include <algorithm>
+#include <chrono>
+#include <future>
 #include <limits>
 #include <memory>
 #include <string>
@@ -31,10 +35,13 @@
 #include <vector>
 
 #include "BurstBuilder.h"
+#include "DynamicBatcher.h"
 #include "ExecutionBuilder.h"
 #include "ExecutionPlan.h"
 #include "Manager.h"
 #include "ModelBuilder.h"
+#include "SharedCompilationCache.h"
+#include "Telemetry.h"
 #include "TypeManager.h"
 
 namespace android {
@@ -51,11 +58,97 @@ CompilationBuilder::CompilationBuilder(const ModelBuilder* model,
     VLOG(COMPILATION) << "CompilationBuilder::CompilationBuilder";
 }
 
+CompilationBuilder::~CompilationBuilder() {
+    // The compilation thread refers to this object.
+    if (mAsyncFinish.valid()) {
+        mAsyncFinish.wait();
+    }
+}
+
 int CompilationBuilder::finish() {
     if (mFinished) {
         LOG(ERROR) << "ANeuralNetworksCompilation_finish called more than once";
         return ANEURALNETWORKS_BAD_STATE;
     }
+    mFinished = true;
+    return finishInternal();
+}
+
+int CompilationBuilder::finishAsync(CompilationProgressCallback onProgress,
+                                    std::function<void(int)> onFinish) {
+    if (mFinished) {
+        LOG(ERROR) << "CompilationBuilder::finishAsync called on a finished compilation";
+        return ANEURALNETWORKS_BAD_STATE;
+    }
+    mFinished = true;
+    if (mSpeculativeCpuExecution) {
+        prepareCpuPlan();
+    }
+    mPlan.setProgressCallback(std::move(onProgress));
+    const auto compile = [this, onFinish = std::move(onFinish)] {
+        NNTRACE_RT(NNTRACE_PHASE_COMPILATION, "CompilationBuilder::finishAsync");
+        const int n = finishInternal();
+        telemetry::onCompilationFinish(this, n);
+        if (onFinish) {
+            onFinish(n);
+        }
+        return n;
+    };
+    mAsyncFinish = std::async(std::launch::async, compile).share();
+    return ANEURALNETWORKS_NO_ERROR;
+}
+
+int CompilationBuilder::waitForFinish() const {
+    if (!mAsyncFinish.valid()) {
+        return ANEURALNETWORKS_NO_ERROR;
+    }
+    return mAsyncFinish.get();
+}
+
+int CompilationBuilder::setSpeculativeCpuExecution(bool enable) {
+    if (mFinished) {
+        LOG(ERROR) << "CompilationBuilder::setSpeculativeCpuExecution can't modify after "
+                      "compilation finished";
+        return ANEURALNETWORKS_BAD_STATE;
+    }
+    mSpeculativeCpuExecution = enable;
+    return ANEURALNETWORKS_NO_ERROR;
+}
+
+void CompilationBuilder::prepareCpuPlan() {
+    NNTRACE_RT(NNTRACE_PHASE_COMPILATION, "CompilationBuilder::prepareCpuPlan");
+    const std::shared_ptr<Device> cpuDevice = DeviceManager::getCpuDevice();
+    if (std::all_of(mDevices.begin(), mDevices.end(),
+                    [&cpuDevice](const auto& device) { return device == cpuDevice; })) {
+        VLOG(COMPILATION) << "CompilationBuilder::prepareCpuPlan: no driver to speculate for";
+        return;
+    }
+    if (mExplicitDeviceList || !DeviceManager::partitioningAllowsFallback(mPartitioning) ||
+        mModel->hasOEMOperation() || mModel->hasExtensionOperation()) {
+        VLOG(COMPILATION) << "CompilationBuilder::prepareCpuPlan: model cannot run on the CPU";
+        return;
+    }
+    mCpuPlan.becomeSingleStep(cpuDevice, mModel);
+    const int n = mCpuPlan.finish(mPreference, mPriority, makeDeadline(mTimeoutDuration),
+                                  mMetadata, ANEURALNETWORKS_NO_ERROR);
+    if (n != ANEURALNETWORKS_NO_ERROR) {
+        LOG(WARNING) << "CompilationBuilder::prepareCpuPlan failed with " << n
+                     << ", executions will wait for the compilation";
+    }
+}
+
+const ExecutionPlan& CompilationBuilder::getPlanForExecution() const {
+    if (mCpuPlan.isValid() && mAsyncFinish.valid() &&
+        mAsyncFinish.wait_for(std::chrono::seconds::zero()) != std::future_status::ready) {
+        VLOG(EXECUTION) << "CompilationBuilder::getPlanForExecution: speculating on the CPU";
+        return mCpuPlan;
+    }
+    waitForFinish();
+    return mPlan;
+}
+
+int CompilationBuilder::finishInternal() {
+    CHECK(mFinished);
     // TODO validate the rest
 
     // Init telemetry info, start measuring compilation time
@@ -64,10 +157,22 @@ int CompilationBuilder::finish() {
 
     const auto deadline = makeDeadline(mTimeoutDuration);
 
-    mFinished = true;
+    // Without caching information from the application, use the shared
+    // compilation cache if there is one.
+    std::shared_ptr<SharedCompilationCache> sharedCache;
     if (mIsCacheInfoProvided) {
         mPlan.setCaching(&mCacheInfo, mToken);
+    } else if (auto cache = SharedCompilationCache::get();
+               cache != nullptr && cache->lookUp(*mModel, &mCacheInfo, mToken)) {
+        mPlan.setCaching(&mCacheInfo, mToken);
+        sharedCache = std::move(cache);
     }
+    const auto finishSharedCache = base::make_scope_guard([this, &sharedCache] {
+        if (sharedCache != nullptr) {
+            sharedCache->onCompilationFinish(mCacheInfo);
+        }
+    });
+
     if (mPartitioning) {
         int n = mModel->partitionTheWork(mDevices, mPreference, mPriority, deadline, &mPlan,
                                          mMetadata, mFailPartitioning);
@@ -283,6 +388,7 @@ int CompilationBuilder::getPreferredMemoryAlignmentForInput(uint32_t index,
                       "unfinished compilation";
         return ANEURALNETWORKS_BAD_STATE;
     }
+    waitForFinish();
     if (!mPlan.isValid()) {
         LOG(ERROR) << "ANeuralNetworksCompilation_getPreferredMemoryAlignmentForInput passed an "
                       "invalid compilation";
@@ -305,6 +411,7 @@ int CompilationBuilder::getPreferredMemoryPaddingForInput(uint32_t index, uint32
                       "unfinished compilation";
         return ANEURALNETWORKS_BAD_STATE;
     }
+    waitForFinish();
     if (!mPlan.isValid()) {
         LOG(ERROR) << "ANeuralNetworksCompilation_getPreferredMemoryPaddingForInput passed an "
                       "invalid compilation";
@@ -328,6 +435,7 @@ int CompilationBuilder::getPreferredMemoryAlignmentForOutput(uint32_t index,
                       "unfinished compilation";
         return ANEURALNETWORKS_BAD_STATE;
     }
+    waitForFinish();
     if (!mPlan.isValid()) {
         LOG(ERROR) << "ANeuralNetworksCompilation_getPreferredMemoryAlignmentForOutput passed an "
                       "invalid compilation";
@@ -351,6 +459,7 @@ int CompilationBuilder::getPreferredMemoryPaddingForOutput(uint32_t index,
                       "unfinished compilation";
         return ANEURALNETWORKS_BAD_STATE;
     }
+    waitForFinish();
     if (!mPlan.isValid()) {
         LOG(ERROR) << "ANeuralNetworksCompilation_getPreferredMemoryPaddingForOutput passed an "
                       "invalid compilation";
@@ -372,15 +481,16 @@ int CompilationBuilder::createExecution(ExecutionBuilder** execution) {
         *execution = nullptr;
         return ANEURALNETWORKS_BAD_STATE;
     }
-    if (!mPlan.isValid()) {
+    const ExecutionPlan& plan = getPlanForExecution();
+    if (!plan.isValid()) {
         LOG(ERROR) << "ANeuralNetworksExecution_create passed an invalid compilation";
         *execution = nullptr;
         return ANEURALNETWORKS_BAD_STATE;
     }
-    if (mPlan.isSimple()) {
-        *execution = new (std::nothrow) SimpleExecutionBuilder(this);
+    if (plan.isSimple()) {
+        *execution = new (std::nothrow) SimpleExecutionBuilder(this, &plan);
     } else {
-        *execution = new (std::nothrow) CompoundExecutionBuilder(this);
+        *execution = new (std::nothrow) CompoundExecutionBuilder(this, &plan);
     }
     return (*execution ? ANEURALNETWORKS_NO_ERROR : ANEURALNETWORKS_OUT_OF_MEMORY);
 }
@@ -391,6 +501,7 @@ int CompilationBuilder::createBurst(BurstBuilder** burst) {
         *burst = nullptr;
         return ANEURALNETWORKS_BAD_STATE;
     }
+    waitForFinish();
     if (!mPlan.isValid()) {
         LOG(ERROR) << "ANeuralNetworksBurst_create passed an invalid compilation";
         *burst = nullptr;
@@ -401,12 +512,47 @@ int CompilationBuilder::createBurst(BurstBuilder** burst) {
     return (*burst ? ANEURALNETWORKS_NO_ERROR : ANEURALNETWORKS_OUT_OF_MEMORY);
 }
 
+int CompilationBuilder::setDynamicBatching(std::chrono::nanoseconds window,
+                                           uint32_t maxBatchSize, bool rowsAreIndependent) {
+    if (!mFinished) {
+        LOG(ERROR) << "setDynamicBatching passed an unfinished compilation";
+        return ANEURALNETWORKS_BAD_STATE;
+    }
+    waitForFinish();
+    if (!mPlan.isValid()) {
+        LOG(ERROR) << "setDynamicBatching passed an invalid compilation";
+        return ANEURALNETWORKS_BAD_STATE;
+    }
+    if (mDynamicBatcher != nullptr) {
+        LOG(ERROR) << "setDynamicBatching called more than once";
+        return ANEURALNETWORKS_BAD_STATE;
+    }
+    if (window.count() < 0 || maxBatchSize < 2) {
+        LOG(ERROR) << "setDynamicBatching passed an invalid window " << window.count()
+                   << "ns or maximum batch size " << maxBatchSize;
+        return ANEURALNETWORKS_BAD_DATA;
+    }
+    if (!rowsAreIndependent) {
+        LOG(ERROR) << "setDynamicBatching passed a compilation of a model whose rows are not "
+                      "independent";
+        return ANEURALNETWORKS_BAD_DATA;
+    }
+    if (!DynamicBatcher::isBatchable(mModel)) {
+        LOG(ERROR) << "setDynamicBatching passed a compilation of a model without a batch "
+                      "dimension";
+        return ANEURALNETWORKS_BAD_DATA;
+    }
+    mDynamicBatcher = std::make_unique<DynamicBatcher>(this, window, maxBatchSize);
+    return ANEURALNETWORKS_NO_ERROR;
+}
+
 int CompilationBuilder::forEachStepRoleOfInput(uint32_t index,
                                                const StepRoleCallback& callback) const {
     if (!mFinished) {
         LOG(ERROR) << "ANeuralNetworksMemoryDesc_addInputRole passed an unfinished compilation";
         return ANEURALNETWORKS_BAD_STATE;
     }
+    waitForFinish();
     if (!mPlan.isValid()) {
         LOG(ERROR) << "ANeuralNetworksMemoryDesc_addInputRole passed an invalid compilation";
         return ANEURALNETWORKS_BAD_STATE;
@@ -426,6 +572,7 @@ int CompilationBuilder::forEachStepRoleOfOutput(uint32_t index,
         LOG(ERROR) << "ANeuralNetworksMemoryDesc_addOutputRole passed an unfinished compilation";
         return ANEURALNETWORKS_BAD_STATE;
     }
+    waitForFinish();
     if (!mPlan.isValid()) {
         LOG(ERROR) << "ANeuralNetworksMemoryDesc_addOutputRole passed an invalid compilation";
         return ANEURALNETWORKS_BAD_STATE;
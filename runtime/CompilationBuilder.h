@@ -20,6 +20,8 @@
 #include <nnapi/Types.h>
 
 #include <chrono>
+#include <functional>
+#include <future>
 #include <limits>
 #include <memory>
 #include <optional>
@@ -37,6 +39,7 @@ namespace nn {
 
 class BurstBuilder;
 class Device;
+class DynamicBatcher;
 class ExecutionBuilder;
 class ModelBuilder;
 
@@ -50,6 +53,7 @@ class CompilationBuilder {
     CompilationBuilder(const ModelBuilder* model,
                        const std::vector<std::shared_ptr<Device>>& devices,
                        bool explicitDeviceList = false);
+    ~CompilationBuilder();
 
     int setPreference(int32_t preference);
 
@@ -68,6 +72,46 @@ class CompilationBuilder {
 
     int finish();
 
+    // Like finish(), but partitions and prepares the model on a separate
+    // thread and returns as soon as that work has been launched. onProgress is
+    // invoked as step models become prepared (see CompilationProgressCallback),
+    // and onFinish is invoked exactly once with the result code of the
+    // compilation; either may be empty. Both are invoked on the compilation
+    // thread. Every method below that requires a finished compilation blocks
+    // until the asynchronous compilation is done.
+    int finishAsync(CompilationProgressCallback onProgress, std::function<void(int)> onFinish);
+
+    // Blocks until an asynchronous compilation launched by finishAsync() is
+    // done and returns its result code. Returns ANEURALNETWORKS_NO_ERROR
+    // immediately if finishAsync() has not been called.
+    int waitForFinish() const;
+
+    // If enabled, finishAsync() first prepares the whole model on the CPU and
+    // executions created while the asynchronous compilation is still in
+    // flight run entirely on the CPU. Once the compilation is done, newly
+    // created executions use the partitioned plan. Has no effect on finish(),
+    // or if the model cannot fall back to the CPU (explicit device list, OEM
+    // or extension operations, or partitioning without fallback).
+    int setSpeculativeCpuExecution(bool enable);
+
+    // Computes the asynchronous executions of this compilation that start
+    // within window of each other, up to maxBatchSize of them, as a single
+    // execution; see DynamicBatcher. Requires a finished compilation of a model
+    // whose inputs and outputs all leave dimension 0 unspecified, and must be
+    // called before any execution of the compilation is started.
+    //
+    // Batching is only correct if each row of dimension 0 of the outputs
+    // depends on the same row of the inputs alone. The runtime cannot check
+    // this: operations such as REDUCE_MEAN or SOFTMAX over axis 0, or a
+    // TRANSPOSE of axis 0, would mix the rows of different executions. The
+    // caller vouches for it by passing rowsAreIndependent = true; otherwise
+    // the call fails with ANEURALNETWORKS_BAD_DATA.
+    int setDynamicBatching(std::chrono::nanoseconds window, uint32_t maxBatchSize,
+                           bool rowsAreIndependent);
+
+    // Returns nullptr if setDynamicBatching() has not been called.
+    DynamicBatcher* getDynamicBatcher() const { return mDynamicBatcher.get(); }
+
     int getPreferredMemoryAlignmentForInput(uint32_t index, uint32_t* alignment) const;
     int getPreferredMemoryPaddingForInput(uint32_t index, uint32_t* padding) const;
     int getPreferredMemoryAlignmentForOutput(uint32_t index, uint32_t* alignment) const;
@@ -88,6 +132,7 @@ class CompilationBuilder {
     bool hasDynamicTemporaries() const { return mPlan.hasDynamicTemporaries(); }
     bool isCacheInfoProvided() const { return mIsCacheInfoProvided; }
     bool isFinished() const { return mFinished; }
+    int32_t getPriority() const { return mPriority; }
 
     // These functions are solely intended for use by unit tests of the
     // partitioning algorithm.
@@ -103,10 +148,29 @@ class CompilationBuilder {
     const std::optional<TelemetryInfo>& getTelemetryInfo() const { return mTelemetryInfo; }
 
    private:
+    // Partitions and prepares the model. Called by finish() and finishAsync()
+    // after they have set mFinished.
+    int finishInternal();
+
+    // Prepares mCpuPlan for speculative execution, if the model is eligible.
+    // Leaves mCpuPlan invalid otherwise.
+    void prepareCpuPlan();
+
+    // Returns the plan that an execution created now should use: mCpuPlan if
+    // it is valid and the asynchronous compilation is still in flight, or
+    // mPlan (after waiting for the compilation to be done) otherwise.
+    const ExecutionPlan& getPlanForExecution() const;
+
     const ModelBuilder* mModel;
 
     ExecutionPlan mPlan;
 
+    // Single-step CPU plan used by executions created while an asynchronous
+    // compilation with speculative CPU execution is in flight. See
+    // setSpeculativeCpuExecution().
+    ExecutionPlan mCpuPlan;
+    bool mSpeculativeCpuExecution = false;
+
     // Whether the application prefers to go fast or use low power for this execution.
     int32_t mPreference = ANEURALNETWORKS_PREFER_FAST_SINGLE_ANSWER;
 
@@ -147,6 +211,14 @@ class CompilationBuilder {
 
     // Vendor specific metadata
     std::vector<TokenValuePair> mMetadata;
+
+    // The result of an asynchronous compilation launched by finishAsync().
+    // Invalid if finishAsync() has not been called.
+    std::shared_future<int> mAsyncFinish;
+
+    // Declared last so that it is destroyed first: its batches in flight use
+    // the plan.
+    std::unique_ptr<DynamicBatcher> mDynamicBatcher;
 };
 
 }  // namespace nn
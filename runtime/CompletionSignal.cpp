@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CompletionSignal"
+
+#include "CompletionSignal.h"
+
+#include <android-base/logging.h>
+
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif  // defined(__linux__)
+
+namespace android::nn {
+namespace {
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+bool isMultiCore() {
+    static const bool multiCore = std::thread::hardware_concurrency() > 1;
+    return multiCore;
+}
+
+#if defined(__linux__)
+// The futex word must be a 32-bit integer, which std::atomic<uint32_t> is
+// layout-compatible with.
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected) {
+    // Returns immediately with EAGAIN if *word no longer holds expected; the
+    // caller checks the word again in either case.
+    if (syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected,
+                nullptr, nullptr, 0) == -1 &&
+        errno != EAGAIN && errno != EINTR) {
+        PLOG(FATAL) << "futex wait failed";
+    }
+}
+
+void futexWakeAll(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+            nullptr, 0);
+}
+#endif  // defined(__linux__)
+
+}  // namespace
+
+CompletionSignal::CompletionSignal(std::chrono::nanoseconds spinDuration)
+    : kSpinDuration(isMultiCore() ? spinDuration : std::chrono::nanoseconds::zero()) {}
+
+void CompletionSignal::signal() {
+    const uint32_t previous = mState.exchange(kSignaled, std::memory_order_acq_rel);
+    if (previous != kPendingWithWaiters) {
+        return;
+    }
+#if defined(__linux__)
+    futexWakeAll(&mState);
+#else
+    // Waiters check the state under mMutex before sleeping.
+    { std::lock_guard<std::mutex> lock(mMutex); }
+    mCondition.notify_all();
+#endif  // defined(__linux__)
+}
+
+void CompletionSignal::wait() const {
+    if (isSignaled()) {
+        return;
+    }
+    if (kSpinDuration.count() > 0) {
+        const auto spinUntil = std::chrono::steady_clock::now() + kSpinDuration;
+        do {
+            // Check the clock only every few iterations, as it is slower than
+            // the load.
+            for (int i = 0; i < 64; ++i) {
+                if (isSignaled()) {
+                    return;
+                }
+                cpuRelax();
+            }
+        } while (std::chrono::steady_clock::now() < spinUntil);
+    }
+
+    // Announce that a thread is about to block, so that signal() wakes it up.
+    uint32_t state = mState.load(std::memory_order_acquire);
+    while (state != kSignaled) {
+        if (state == kPending &&
+            !mState.compare_exchange_weak(state, kPendingWithWaiters, std::memory_order_acq_rel,
+                                          std::memory_order_acquire)) {
+            continue;
+        }
+#if defined(__linux__)
+        futexWait(&mState, kPendingWithWaiters);
+#else
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return isSignaled(); });
+#endif  // defined(__linux__)
+        state = mState.load(std::memory_order_acquire);
+    }
+}
+
+}  // namespace android::nn
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_COMPLETION_SIGNAL_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_COMPLETION_SIGNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if !defined(__linux__)
+#include <condition_variable>
+#include <mutex>
+#endif  // !defined(__linux__)
+
+namespace android::nn {
+
+// A one-shot signal that threads wait on until it is raised, such as the
+// completion of an execution.
+//
+// Raising the signal is a single atomic exchange, and only makes a system call
+// if a thread is blocked in wait(). A waiter first spins for up to
+// spinDuration, so that a signal raised shortly after the wait starts, as for
+// small models, is noticed without sleeping and being woken up by the kernel.
+// It then blocks on a futex. Spinning is skipped on single core devices, where
+// it would only delay the thread that raises the signal.
+//
+// Everything written by the thread that raises the signal before signal()
+// is visible to the threads that return from wait() or see isSignaled().
+class CompletionSignal {
+   public:
+    // Short enough to be negligible next to the duration of an execution that
+    // needs a driver, and long enough to cover a small CPU execution.
+    static constexpr std::chrono::nanoseconds kDefaultSpinDuration = std::chrono::microseconds(20);
+
+    explicit CompletionSignal(std::chrono::nanoseconds spinDuration = kDefaultSpinDuration);
+
+    CompletionSignal(const CompletionSignal&) = delete;
+    CompletionSignal& operator=(const CompletionSignal&) = delete;
+
+    // Raises the signal and wakes up all waiters. Later calls have no effect.
+    void signal();
+
+    // Returns once the signal has been raised.
+    void wait() const;
+
+    bool isSignaled() const { return mState.load(std::memory_order_acquire) == kSignaled; }
+
+   private:
+    enum : uint32_t { kPending = 0, kPendingWithWaiters = 1, kSignaled = 2 };
+
+    const std::chrono::nanoseconds kSpinDuration;
+    mutable std::atomic<uint32_t> mState = kPending;
+
+#if !defined(__linux__)
+    mutable std::mutex mMutex;
+    mutable std::condition_variable mCondition;
+#endif  // !defined(__linux__)
+};
+
+}  // namespace android::nn
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_COMPLETION_SIGNAL_H
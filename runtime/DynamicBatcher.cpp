@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "DynamicBatcher"
+
+#include "DynamicBatcher.h"
+
+#include <LegacyUtils.h>
+#include <Tracing.h>
+#include <android-base/logging.h>
+#include <nnapi/TypeUtils.h>
+#include <nnapi/Types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "CompilationBuilder.h"
+#include "ExecutionBuilder.h"
+#include "ExecutionCallback.h"
+#include "ExecutionThreadPool.h"
+#include "ModelArgumentInfo.h"
+#include "ModelBuilder.h"
+#include "TypeManager.h"
+
+namespace android {
+namespace nn {
+
+namespace {
+
+bool hasBatchDimension(const Operand& operand) {
+    return !isExtension(operand.type) &&
+           operand.type != OperandType::TENSOR_QUANT8_SYMM_PER_CHANNEL &&
+           operand.type != OperandType::TENSOR_OEM_BYTE && !operand.dimensions.empty() &&
+           operand.dimensions[0] == 0;
+}
+
+}  // namespace
+
+OptionalTimePoint DynamicBatcher::getEarliestDeadline(
+        const std::vector<PendingExecution>& executions) {
+    OptionalTimePoint deadline;
+    for (const PendingExecution& pending : executions) {
+        if (pending.deadline.has_value()) {
+            deadline = std::min(deadline.value_or(*pending.deadline), *pending.deadline);
+        }
+    }
+    return deadline;
+}
+
+bool DynamicBatcher::isBatchable(const ModelBuilder* model) {
+    for (uint32_t i = 0; i < model->inputCount(); ++i) {
+        if (!hasBatchDimension(model->getInputOperand(i))) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < model->outputCount(); ++i) {
+        if (!hasBatchDimension(model->getOutputOperand(i))) {
+            return false;
+        }
+    }
+    return model->inputCount() > 0 && model->outputCount() > 0;
+}
+
+DynamicBatcher::DynamicBatcher(CompilationBuilder* compilation, std::chrono::nanoseconds window,
+                               uint32_t maxBatchSize)
+    : kCompilation(compilation), kWindow(window), kMaxBatchSize(maxBatchSize) {
+    CHECK(compilation != nullptr);
+    CHECK_GE(maxBatchSize, 2u);
+    mCollector = std::thread([this] { runCollector(); });
+}
+
+DynamicBatcher::~DynamicBatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWindowOpened.notify_one();
+    mCollector.join();
+    std::unique_lock<std::mutex> lock(mMutex);
+    mBatchFinished.wait(lock, [this]() REQUIRES(mMutex) { return mBatchesInFlight == 0; });
+}
+
+bool DynamicBatcher::submit(ExecutionBuilder* execution, const OptionalTimePoint& deadline,
+                            const std::shared_ptr<ExecutionCallback>& callback) {
+    // Timing cannot be attributed to the executions of a batch.
+    if (execution->measureTiming()) {
+        return false;
+    }
+    const ModelBuilder* model = kCompilation->getModel();
+    Signature signature;
+    signature.reserve(model->inputCount());
+    uint32_t rows = 0;
+    for (uint32_t i = 0; i < model->inputCount(); ++i) {
+        const ModelArgumentInfo& info = execution->getInputInfo(i);
+        if (info.state() != ModelArgumentInfo::POINTER || info.dimensions().empty()) {
+            return false;
+        }
+        const std::vector<uint32_t>& dimensions = info.dimensions();
+        if (i == 0) {
+            rows = dimensions[0];
+        } else if (dimensions[0] != rows) {
+            return false;
+        }
+        signature.emplace_back(dimensions.begin() + 1, dimensions.end());
+    }
+    if (rows == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < model->outputCount(); ++i) {
+        if (execution->getOutputInfo(i).state() != ModelArgumentInfo::POINTER) {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mStats.executionCount;
+    auto [it, opened] = mWindows.try_emplace(std::move(signature));
+    Window& window = it->second;
+    if (opened) {
+        window.closesAt = Clock::now() + std::chrono::duration_cast<Duration>(kWindow);
+    }
+    window.executions.push_back({.execution = execution,
+                                 .deadline = deadline,
+                                 .callback = callback,
+                                 .rows = rows});
+    if (window.executions.size() >= kMaxBatchSize) {
+        launchLocked(std::move(window.executions));
+        mWindows.erase(it);
+    } else if (opened) {
+        mWindowOpened.notify_one();
+    }
+    return true;
+}
+
+DynamicBatcher::Stats DynamicBatcher::getStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+void DynamicBatcher::runCollector() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        const TimePoint now = Clock::now();
+        std::optional<TimePoint> nextClose;
+        for (auto it = mWindows.begin(); it != mWindows.end();) {
+            if (mStopping || it->second.closesAt <= now) {
+                launchLocked(std::move(it->second.executions));
+                it = mWindows.erase(it);
+            } else {
+                nextClose = std::min(nextClose.value_or(it->second.closesAt), it->second.closesAt);
+                ++it;
+            }
+        }
+        if (mStopping) {
+            return;
+        }
+        if (nextClose.has_value()) {
+            mWindowOpened.wait_until(lock, *nextClose);
+        } else {
+            mWindowOpened.wait(lock);
+        }
+    }
+}
+
+void DynamicBatcher::launchLocked(std::vector<PendingExecution> executions) {
+    CHECK(!executions.empty());
+    ++mBatchesInFlight;
+    if (executions.size() > 1) {
+        ++mStats.batchCount;
+    }
+    mStats.maxBatchSize = std::max<uint64_t>(mStats.maxBatchSize, executions.size());
+
+    // The batch is as urgent as its most urgent execution.
+    const OptionalTimePoint deadline = getEarliestDeadline(executions);
+    // The executions of a batch share their compilation, so they may block in
+    // drivers if the first one may.
+    executions.front().execution->getAsyncThreadPool().schedule(
+            convertToCanonicalPriority(kCompilation->getPriority()), deadline,
+            [this, executions = std::move(executions)] {
+                computeBatch(executions);
+                std::lock_guard<std::mutex> lock(mMutex);
+                --mBatchesInFlight;
+                mBatchFinished.notify_all();
+            });
+}
+
+void DynamicBatcher::computeAlone(const PendingExecution& pending) {
+    const auto [n, outputShapes, timing] =
+            pending.execution->computeInternal(pending.deadline, nullptr);
+    pending.callback->notify(convertResultCodeToErrorStatus(n), outputShapes, timing);
+}
+
+void DynamicBatcher::computeBatch(const std::vector<PendingExecution>& executions) {
+    NNTRACE_RT(NNTRACE_PHASE_EXECUTION, "DynamicBatcher::computeBatch");
+    if (executions.size() == 1) {
+        computeAlone(executions.front());
+        return;
+    }
+    const auto fallBack = [this, &executions] {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStats.fallbackCount += executions.size();
+        }
+        for (const PendingExecution& pending : executions) {
+            computeAlone(pending);
+        }
+    };
+
+    ExecutionBuilder* rawBatch = nullptr;
+    if (kCompilation->createExecution(&rawBatch) != ANEURALNETWORKS_NO_ERROR) {
+        fallBack();
+        return;
+    }
+    const std::unique_ptr<ExecutionBuilder> batch(rawBatch);
+
+    // The batch must not outlive the deadline or the loop timeout of any of
+    // its executions.
+    uint64_t loopTimeout = std::numeric_limits<uint64_t>::max();
+    for (const PendingExecution& pending : executions) {
+        loopTimeout = std::min(loopTimeout, pending.execution->getLoopTimeoutDuration());
+    }
+    if (batch->setLoopTimeout(loopTimeout) != ANEURALNETWORKS_NO_ERROR) {
+        fallBack();
+        return;
+    }
+    if (const OptionalTimePoint deadline = getEarliestDeadline(executions)) {
+        const auto remaining =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - Clock::now());
+        if (remaining.count() <= 0 ||
+            batch->setTimeoutDuration(remaining.count()) != ANEURALNETWORKS_NO_ERROR) {
+            fallBack();
+            return;
+        }
+    }
+    const ModelBuilder* model = kCompilation->getModel();
+    const TypeManager* typeManager = TypeManager::get();
+    uint32_t totalRows = 0;
+    for (const PendingExecution& pending : executions) {
+        totalRows += pending.rows;
+    }
+
+    // Concatenate the inputs along dimension 0.
+    std::vector<std::vector<uint8_t>> inputs(model->inputCount());
+    for (uint32_t i = 0; i < model->inputCount(); ++i) {
+        const Operand& operand = model->getInputOperand(i);
+        for (const PendingExecution& pending : executions) {
+            const ModelArgumentInfo& info = pending.execution->getInputInfo(i);
+            const auto* data = static_cast<const uint8_t*>(info.buffer());
+            inputs[i].insert(inputs[i].end(), data,
+                             data + typeManager->getSizeOfData(operand.type, info.dimensions()));
+        }
+        std::vector<uint32_t> dimensions =
+                executions.front().execution->getInputInfo(i).dimensions();
+        dimensions[0] = totalRows;
+        const ANeuralNetworksOperandType type = {
+                .type = static_cast<int32_t>(operand.type),
+                .dimensionCount = static_cast<uint32_t>(dimensions.size()),
+                .dimensions = dimensions.data(),
+                .scale = operand.scale,
+                .zeroPoint = operand.zeroPoint};
+        if (batch->setInput(i, &type, inputs[i].data(), inputs[i].size()) !=
+            ANEURALNETWORKS_NO_ERROR) {
+            fallBack();
+            return;
+        }
+    }
+
+    // Each output of the batch has room for the outputs of all executions.
+    std::vector<std::vector<uint8_t>> outputs(model->outputCount());
+    for (uint32_t i = 0; i < model->outputCount(); ++i) {
+        size_t length = 0;
+        for (const PendingExecution& pending : executions) {
+            length += pending.execution->getOutputInfo(i).length();
+        }
+        outputs[i].resize(length);
+        if (batch->setOutput(i, nullptr, outputs[i].data(), outputs[i].size()) !=
+            ANEURALNETWORKS_NO_ERROR) {
+            fallBack();
+            return;
+        }
+    }
+
+    if (batch->computeSynchronously() != ANEURALNETWORKS_NO_ERROR) {
+        fallBack();
+        return;
+    }
+    for (uint32_t i = 0; i < model->outputCount(); ++i) {
+        const std::vector<uint32_t>& dimensions = batch->getOutputInfo(i).dimensions();
+        if (dimensions.empty() || dimensions[0] != totalRows) {
+            LOG(ERROR) << "DynamicBatcher: output " << i
+                       << " does not have a row for each of the " << totalRows << " input rows";
+            fallBack();
+            return;
+        }
+    }
+
+    // Split the outputs along dimension 0.
+    std::vector<size_t> offsets(model->outputCount(), 0);
+    for (const PendingExecution& pending : executions) {
+        ErrorStatus status = ErrorStatus::NONE;
+        std::vector<OutputShape> outputShapes(model->outputCount());
+        for (uint32_t i = 0; i < model->outputCount(); ++i) {
+            const ModelArgumentInfo& batchInfo = batch->getOutputInfo(i);
+            const ModelArgumentInfo& info = pending.execution->getOutputInfo(i);
+            const size_t rowLength =
+                    typeManager->getSizeOfData(model->getOutputOperand(i).type,
+                                               batchInfo.dimensions()) /
+                    totalRows;
+            const size_t length = rowLength * pending.rows;
+            outputShapes[i].dimensions = batchInfo.dimensions();
+            outputShapes[i].dimensions[0] = pending.rows;
+            outputShapes[i].isSufficient = length <= info.length();
+            if (outputShapes[i].isSufficient) {
+                std::memcpy(info.buffer(), outputs[i].data() + offsets[i], length);
+            } else {
+                status = ErrorStatus::OUTPUT_INSUFFICIENT_SIZE;
+            }
+            offsets[i] += length;
+        }
+        pending.callback->notify(status, outputShapes, {});
+    }
+}
+
+}  // namespace nn
+}  // namespace android
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_DYNAMIC_BATCHER_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_DYNAMIC_BATCHER_H
+
+#include <android-base/thread_annotations.h>
+#include <nnapi/Types.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace nn {
+
+class CompilationBuilder;
+class ExecutionBuilder;
+class ExecutionCallback;
+class ModelBuilder;
+
+// Collects the asynchronous executions of one compilation that start within a
+// time window of each other, and computes them as a single execution whose
+// inputs are the inputs of the individual executions concatenated along
+// dimension 0. The outputs of that execution are split along dimension 0 and
+// copied back, and each execution is then notified through its own
+// ExecutionCallback.
+//
+// Only models whose inputs and outputs all leave dimension 0, the batch
+// dimension, unspecified can be batched, and only executions whose inputs and
+// outputs are all given by pointers. The model must also compute each row of
+// its outputs from the same row of its inputs alone; isBatchable() cannot
+// check this, so the caller of CompilationBuilder::setDynamicBatching vouches
+// for it. Executions are batched together if their inputs have the same
+// dimensions apart from dimension 0. Other executions are computed as usual.
+//
+// A batch runs with the earliest deadline and the shortest loop timeout of its
+// executions.
+//
+// A batch is computed on ExecutionThreadPool once the window of its first
+// execution has elapsed, or as soon as it holds maxBatchSize executions. If
+// the batched execution fails, or if its outputs do not have one row per
+// input row, the executions of the batch are computed one by one instead.
+class DynamicBatcher {
+   public:
+    struct Stats {
+        // Number of executions taken over by submit().
+        uint64_t executionCount = 0;
+        // Number of batches of more than one execution that were computed.
+        uint64_t batchCount = 0;
+        // Number of executions in the largest batch.
+        uint64_t maxBatchSize = 0;
+        // Number of executions computed one by one after their batch failed.
+        uint64_t fallbackCount = 0;
+    };
+
+    // Returns true if the inputs and outputs of model allow batching.
+    static bool isBatchable(const ModelBuilder* model);
+
+    // compilation must be finished, and must outlive the batcher.
+    DynamicBatcher(CompilationBuilder* compilation, std::chrono::nanoseconds window,
+                   uint32_t maxBatchSize);
+
+    // Computes the executions that are still waiting for their window to
+    // close, then waits for all batches to finish.
+    ~DynamicBatcher();
+
+    DynamicBatcher(const DynamicBatcher&) = delete;
+    DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+
+    // Takes over the computation of execution, whose computation has started,
+    // and notifies callback once it is done. Returns false, leaving the
+    // execution to the caller, if the execution cannot be batched.
+    bool submit(ExecutionBuilder* execution, const OptionalTimePoint& deadline,
+                const std::shared_ptr<ExecutionCallback>& callback);
+
+    Stats getStats() const;
+
+   private:
+    struct PendingExecution {
+        ExecutionBuilder* execution;
+        OptionalTimePoint deadline;
+        std::shared_ptr<ExecutionCallback> callback;
+        // The size of dimension 0 of the inputs.
+        uint32_t rows;
+    };
+
+    // The dimensions of each input, apart from dimension 0.
+    using Signature = std::vector<std::vector<uint32_t>>;
+
+    struct Window {
+        TimePoint closesAt;
+        std::vector<PendingExecution> executions;
+    };
+
+    static OptionalTimePoint getEarliestDeadline(const std::vector<PendingExecution>& executions);
+
+    // Launches the windows as they close, until the batcher is destroyed.
+    void runCollector();
+    void launchLocked(std::vector<PendingExecution> executions) REQUIRES(mMutex);
+    void computeBatch(const std::vector<PendingExecution>& executions);
+    // Computes an execution on its own, as ExecutionBuilder::compute does.
+    static void computeAlone(const PendingExecution& pending);
+
+    CompilationBuilder* const kCompilation;
+    const std::chrono::nanoseconds kWindow;
+    const uint32_t kMaxBatchSize;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mWindowOpened;
+    std::condition_variable mBatchFinished;
+    std::map<Signature, Window> mWindows GUARDED_BY(mMutex);
+    uint32_t mBatchesInFlight GUARDED_BY(mMutex) = 0;
+    bool mStopping GUARDED_BY(mMutex) = false;
+    Stats mStats GUARDED_BY(mMutex);
+    std::thread mCollector;
+};
+
+}  // namespace nn
+}  // namespace android
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_DYNAMIC_BATCHER_H
@@ -44,10 +44,9 @@ class CallbackEvent : public IEvent {
         CHECK(kExecutionCallback != nullptr);
     }
 
-    ErrorStatus wait() const override {
-        kExecutionCallback->wait();
-        return kExecutionCallback->getStatus();
-    }
+    // Waits on the CompletionSignal of the callback, which spins briefly
+    // before blocking.
+    ErrorStatus wait() const override { return kExecutionCallback->getStatus(); }
 
     // Always return -1 as this is not backed by a sync fence.
     int getSyncFenceFd(bool /*should_dup*/) const override { return -1; }
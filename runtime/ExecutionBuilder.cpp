@@ -28,19 +28,22 @@
 #include <nnapi/Types.h>
 
 #include <algorithm>
+#include <condition_variable>
 #include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <set>
 #include <string>
-#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include "BurstBuilder.h"
 #include "CompilationBuilder.h"
+#include "DynamicBatcher.h"
+#include "ExecutionThreadPool.h"
 #include "Manager.h"
 #include "ModelArgumentInfo.h"
 #include "ModelBuilder.h"
@@ -150,10 +153,11 @@ static bool checkDimensionInfo(const Operand& operand, const ANeuralNetworksOper
     return true;
 }
 
-ExecutionBuilder::ExecutionBuilder(const CompilationBuilder* compilation)
+ExecutionBuilder::ExecutionBuilder(const CompilationBuilder* compilation,
+                                   const ExecutionPlan* plan)
     : mCompilation(compilation),
       mModel(compilation->mModel),
-      mPlan(&compilation->mPlan),
+      mPlan(plan),
       mAllowCpuFallback(DeviceManager::partitioningAllowsFallback(compilation->mPartitioning)),
       mInputs(mModel->inputCount()),
       mOutputs(mModel->outputCount()) {
@@ -161,16 +165,22 @@ ExecutionBuilder::ExecutionBuilder(const CompilationBuilder* compilation)
                     << " inputs and " << mOutputs.size() << " outputs";
 }
 
-SimpleExecutionBuilder::SimpleExecutionBuilder(const CompilationBuilder* compilation)
-    : ExecutionBuilder(compilation) {
+SimpleExecutionBuilder::SimpleExecutionBuilder(const CompilationBuilder* compilation,
+                                               const ExecutionPlan* plan)
+    : ExecutionBuilder(compilation, plan) {
     CHECK(mPlan->isSimple());
 }
 
-CompoundExecutionBuilder::CompoundExecutionBuilder(const CompilationBuilder* compilation)
-    : ExecutionBuilder(compilation) {
+CompoundExecutionBuilder::CompoundExecutionBuilder(const CompilationBuilder* compilation,
+                                                   const ExecutionPlan* plan)
+    : ExecutionBuilder(compilation, plan) {
     CHECK(mPlan->isCompound());
 }
 
+bool ExecutionBuilder::hasDynamicTemporaries() const {
+    return mPlan->hasDynamicTemporaries();
+}
+
 const ModelBuilder* ExecutionBuilder::getSourceModel(uint32_t index) const {
     return mPlan->getSourceModels().getModel(index);
 }
@@ -579,9 +589,21 @@ bool ExecutionBuilder::checkAndSetComputationState(const char* name) {
         return false;
     }
     mState = State::COMPUTATION;
+    mCancellationToken.reset();
     return true;
 }
 
+int ExecutionBuilder::cancel() {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    if (mState != State::COMPUTATION) {
+        LOG(ERROR) << "ExecutionBuilder::cancel called on an execution that is not in flight";
+        return ANEURALNETWORKS_BAD_STATE;
+    }
+    VLOG(EXECUTION) << "ExecutionBuilder::cancel";
+    mCancellationToken.cancel();
+    return ANEURALNETWORKS_NO_ERROR;
+}
+
 // TODO(b/132321855): validate that we have full types for all inputs and outputs,
 // that the graph is not cyclic,
 static int validateRequest(const std::vector<ModelArgumentInfo>& inputs,
@@ -705,6 +727,11 @@ std::tuple<int, std::vector<OutputShape>, Timing> SimpleExecutionBuilder::comput
         return {n, {}, {}};
     }
 
+    // If the execution was cancelled, do not perform CPU fallback.
+    if (isCancelRequested()) {
+        return {ANEURALNETWORKS_OP_FAILED, {}, {}};
+    }
+
     // If CPU execution was already attempted, do not perform CPU fallback.
     if (mExecutor->isCpu()) {
         return {n, {}, {}};
@@ -728,6 +755,15 @@ std::tuple<int, std::vector<OutputShape>, Timing> CompoundExecutionBuilder::comp
     bool doInsufficientSizeFallback = false;
 
     while (true) {
+        // Let more urgent executions run between steps, including the steps
+        // that interpret control flow.
+        ExecutionThreadPool::preemptionPoint();
+
+        if (isCancelRequested()) {
+            VLOG(EXECUTION) << "CompoundExecutionBuilder::computeInternal cancelled";
+            return {ANEURALNETWORKS_OP_FAILED, {}, {}};
+        }
+
         VLOG(EXECUTION) << "looking for next StepExecutor";
 
         // Get the current step of the execution.
@@ -749,6 +785,7 @@ std::tuple<int, std::vector<OutputShape>, Timing> CompoundExecutionBuilder::comp
         // If the code reached the end of the plan without error, then return
         // with no error.
         if (executor == nullptr) {
+            mPlan->recordDynamicTemporaryShapes(*controller);
             return {ANEURALNETWORKS_NO_ERROR, outputShapes, {}};
         }
         const bool executorIsCpu = executor->isCpu();
@@ -788,6 +825,7 @@ std::tuple<int, std::vector<OutputShape>, Timing> CompoundExecutionBuilder::comp
             // Every main model output is of sufficient size.  This implies that
             // at least one dynamic temporary is not of sufficient size.  This
             // is recoverable.
+            mPlan->countInsufficientSizeRetry();
             doInsufficientSizeFallback = true;
             continue;
         }
@@ -797,6 +835,11 @@ std::tuple<int, std::vector<OutputShape>, Timing> CompoundExecutionBuilder::comp
             return {stepN, {}, {}};
         }
 
+        // If the execution was cancelled, do not perform CPU fallback.
+        if (isCancelRequested()) {
+            return {ANEURALNETWORKS_OP_FAILED, {}, {}};
+        }
+
         // If CPU execution was already attempted, perform a full CPU fallback.
         if (executorIsCpu) {
             break;
@@ -846,6 +889,7 @@ std::tuple<int, std::vector<OutputShape>, Timing> CompoundExecutionBuilder::comp
                 // Every main model output is of sufficient size.  This implies
                 // that at least one dynamic temporary is not of sufficient
                 // size.  This is recoverable.
+                mPlan->countInsufficientSizeRetry();
                 continue;
             }
 
@@ -941,7 +985,7 @@ std::tuple<int, int, ExecuteFencedInfoCallback> CompoundExecutionBuilder::comput
     // - Implement something similar to the code in CompoundExecutionBuilder::computeInternal()
     //   that handles a step execution that fails with
     //   ANEURALNETWORKS_OUTPUT_INSUFFICIENT_SIZE.
-    CHECK(!mCompilation->hasDynamicTemporaries());
+    CHECK(!hasDynamicTemporaries());
 
     // Initiate waitForFds, syncFence for the first step.
     std::vector<int> waitForFds = waitFor;
@@ -1048,20 +1092,7 @@ int ExecutionBuilder::computeFenced(const std::vector<int>& waitFor,
     return result;
 }
 
-int ExecutionBuilder::compute(std::shared_ptr<ExecutionCallback>* synchronizationCallback,
-                              BurstBuilder* burstBuilder) {
-    CHECK(synchronizationCallback == nullptr || burstBuilder == nullptr)
-            << "synchronizationCallback and burstBuilder cannot simultaneously be used";
-
-    const bool synchronous = (synchronizationCallback == nullptr);
-    if (!synchronous) {
-        *synchronizationCallback = nullptr;
-    }
-
-    const char* name = burstBuilder ? "burstCompute" : synchronous ? "compute" : "startCompute";
-    const ExecutionMode mode = burstBuilder
-                                       ? ExecutionMode::BURST
-                                       : synchronous ? ExecutionMode::SYNC : ExecutionMode::ASYNC;
+int ExecutionBuilder::startCompute(const char* name, ExecutionMode mode) {
     NN_RETURN_IF_ERROR(prepareForCompute(name, mode));
 
     // Validate input memory dimensions. We need to do the validation in every computation because
@@ -1082,28 +1113,51 @@ int ExecutionBuilder::compute(std::shared_ptr<ExecutionCallback>* synchronizatio
         }
     }
 
-    const auto deadline = makeDeadline(mTimeoutDuration);
     mComputeStartTimePoint = Clock::now();
+    return ANEURALNETWORKS_NO_ERROR;
+}
+
+int ExecutionBuilder::computeAndFinish(const OptionalTimePoint& deadline,
+                                       BurstBuilder* burstBuilder, ExecutionMode mode) {
+    // The burst controllers belong to the compilation's partitioned plan,
+    // not to a speculative CPU plan.
+    const auto [n, outputShapes, timing] =
+            computeInternal(deadline, mPlan == &mCompilation->mPlan ? burstBuilder : nullptr);
+    if (mMeasureTiming) {
+        mTimingWithoutFencedExecutionCallback = timing;
+    }
+    return finishComputation(n, outputShapes, mode);
+}
+
+int ExecutionBuilder::compute(std::shared_ptr<ExecutionCallback>* synchronizationCallback,
+                              BurstBuilder* burstBuilder) {
+    CHECK(synchronizationCallback == nullptr || burstBuilder == nullptr)
+            << "synchronizationCallback and burstBuilder cannot simultaneously be used";
+
+    const bool synchronous = (synchronizationCallback == nullptr);
+    if (!synchronous) {
+        *synchronizationCallback = nullptr;
+    }
+
+    const char* name = burstBuilder ? "burstCompute" : synchronous ? "compute" : "startCompute";
+    const ExecutionMode mode = burstBuilder
+                                       ? ExecutionMode::BURST
+                                       : synchronous ? ExecutionMode::SYNC : ExecutionMode::ASYNC;
+    NN_RETURN_IF_ERROR(startCompute(name, mode));
+
+    const auto deadline = makeDeadline(mTimeoutDuration);
     if (synchronous) {
         if (burstBuilder) {
             VLOG(EXECUTION) << "ExecutionBuilder::compute (synchronous API, burst)";
         } else {
             VLOG(EXECUTION) << "ExecutionBuilder::compute (synchronous API)";
         }
-        const auto [n, outputShapes, timing] = computeInternal(deadline, burstBuilder);
-        if (mMeasureTiming) {
-            mTimingWithoutFencedExecutionCallback = timing;
-        }
-        return finishComputation(n, outputShapes, mode);
+        return computeAndFinish(deadline, burstBuilder, mode);
     } else /* asynchronous */ {
         // TODO: For asynchronous execution, entire plan-based-path should run in an
         // asynchronous thread -- take the asynchronous thread logic out of
         // CpuExecution::compute() and use it to wrap the plan-based-path.
 
-        // TODO: use a thread pool
-        // TODO(mikie): this could have NNTRACE so we could measure the overhead
-        //              of spinning up a new thread.
-
         // Prepare the callback for asynchronous execution.
         // std::shared_ptr<ExecutionCallback> object is returned when the
         // execution has been successfully launched, otherwise a
@@ -1119,19 +1173,158 @@ int ExecutionBuilder::compute(std::shared_ptr<ExecutionCallback>* synchronizatio
             const auto status = convertResultCodeToErrorStatus(n);
             executionCallback->notify(status, outputShapes, timing);
         };
-        if (DeviceManager::get()->syncExecRuntime()) {
+        DynamicBatcher* dynamicBatcher = mCompilation->getDynamicBatcher();
+        if (dynamicBatcher != nullptr &&
+            dynamicBatcher->submit(this, deadline, executionCallback)) {
+            VLOG(EXECUTION) << "ExecutionBuilder::compute (asynchronous API, dynamically batched)";
+        } else if (DeviceManager::get()->syncExecRuntime()) {
             VLOG(EXECUTION) << "ExecutionBuilder::compute (asynchronous API, non-threaded)";
             asyncStartCompute();
         } else {
             VLOG(EXECUTION) << "ExecutionBuilder::compute (asynchronous API)";
-            std::thread asyncExecution(asyncStartCompute);
-            executionCallback->bindThread(std::move(asyncExecution));
+            getAsyncThreadPool().schedule(convertToCanonicalPriority(mCompilation->mPriority),
+                                          deadline, asyncStartCompute);
         }
         *synchronizationCallback = executionCallback;
         return ANEURALNETWORKS_NO_ERROR;
     }
 }
 
+ExecutionThreadPool& ExecutionBuilder::getAsyncThreadPool() const {
+    return mPlan->isSimpleCpu() ? ExecutionThreadPool::get()
+                                : ExecutionThreadPool::getForDriverWaits();
+}
+
+int ExecutionBuilder::computeBatch(const std::vector<ExecutionBuilder*>& executions,
+                                   BurstBuilder* burstBuilder, std::vector<int>* results) {
+    NNTRACE_RT(NNTRACE_PHASE_EXECUTION, "ExecutionBuilder::computeBatch");
+    CHECK(results != nullptr);
+    results->assign(executions.size(), ANEURALNETWORKS_NO_ERROR);
+    if (executions.empty()) {
+        return ANEURALNETWORKS_NO_ERROR;
+    }
+
+    // Validate the batch as a whole.
+    const auto failAll = [results](int n) {
+        std::fill(results->begin(), results->end(), n);
+        return n;
+    };
+    if (std::find(executions.begin(), executions.end(), nullptr) != executions.end()) {
+        LOG(ERROR) << "ExecutionBuilder::computeBatch passed a nullptr";
+        return failAll(ANEURALNETWORKS_UNEXPECTED_NULL);
+    }
+    const CompilationBuilder* compilation = executions.front()->mCompilation;
+    if (std::any_of(executions.begin(), executions.end(), [compilation](const auto* execution) {
+            return execution->mCompilation != compilation;
+        })) {
+        LOG(ERROR) << "ExecutionBuilder::computeBatch passed executions that do not originate "
+                      "from the same ANeuralNetworksCompilation";
+        return failAll(ANEURALNETWORKS_BAD_DATA);
+    }
+    if (std::set<const ExecutionBuilder*>(executions.begin(), executions.end()).size() !=
+        executions.size()) {
+        LOG(ERROR) << "ExecutionBuilder::computeBatch passed the same execution more than once";
+        return failAll(ANEURALNETWORKS_BAD_DATA);
+    }
+    if (burstBuilder != nullptr && burstBuilder->getCompilation() != compilation) {
+        LOG(ERROR) << "ExecutionBuilder::computeBatch passed an ANeuralNetworksBurst that does not "
+                      "originate from the same ANeuralNetworksCompilation as the executions";
+        return failAll(ANEURALNETWORKS_BAD_DATA);
+    }
+    if (burstBuilder != nullptr && !burstBuilder->tryLock()) {
+        LOG(ERROR) << "ExecutionBuilder::computeBatch passed an ANeuralNetworksBurst that is "
+                      "already in use";
+        return failAll(ANEURALNETWORKS_BAD_STATE);
+    }
+
+    // Executions that fail to start have already completed. Split the others between the ones
+    // that run entirely on the CPU, in parallel on the thread pool, and the ones that need a
+    // driver. A worker thread must not wait for other tasks of the pool, so it runs everything
+    // itself.
+    const bool parallel =
+            !DeviceManager::get()->syncExecRuntime() && !ExecutionThreadPool::isWorkerThread();
+    const auto runsOnCpu = [parallel](const ExecutionBuilder* execution) {
+        return parallel && execution->mPlan->isSimpleCpu();
+    };
+
+    // The executions on this thread are pipelined through a single burst, so that drivers can
+    // reuse the resources of one execution for the next. The bursts are made for the plan of the
+    // finished compilation, so this is only possible if every such execution uses that plan and
+    // not the speculative CPU plan. The mode must be known before the executions start.
+    size_t onThisThreadCount = 0;
+    bool allUseCompiledPlan = true;
+    for (const ExecutionBuilder* execution : executions) {
+        if (!runsOnCpu(execution)) {
+            ++onThisThreadCount;
+            allUseCompiledPlan &= execution->mPlan == &compilation->mPlan;
+        }
+    }
+    const bool useBatchBurst =
+            burstBuilder == nullptr && onThisThreadCount > 1 && allUseCompiledPlan;
+    const ExecutionMode onThisThreadMode =
+            burstBuilder != nullptr || useBatchBurst ? ExecutionMode::BURST : ExecutionMode::SYNC;
+
+    std::vector<size_t> onCpu;
+    std::vector<size_t> onThisThread;
+    for (size_t i = 0; i < executions.size(); ++i) {
+        ExecutionBuilder* execution = executions[i];
+        const bool onCpuPool = runsOnCpu(execution);
+        (*results)[i] = execution->startCompute(
+                "computeBatch", onCpuPool ? ExecutionMode::SYNC : onThisThreadMode);
+        if ((*results)[i] == ANEURALNETWORKS_NO_ERROR) {
+            (onCpuPool ? onCpu : onThisThread).push_back(i);
+        }
+    }
+    VLOG(EXECUTION) << "ExecutionBuilder::computeBatch " << onCpu.size() << " in parallel on the "
+                    << "CPU, " << onThisThread.size() << " on this thread";
+
+    std::mutex mutex;
+    std::condition_variable allFinished;
+    size_t pending = onCpu.size();
+    const Priority priority = convertToCanonicalPriority(compilation->mPriority);
+    for (size_t i : onCpu) {
+        ExecutionBuilder* execution = executions[i];
+        const auto deadline = makeDeadline(execution->mTimeoutDuration);
+        ExecutionThreadPool::get().schedule(priority, deadline, [&, i, execution, deadline] {
+            const int n = execution->computeAndFinish(deadline, nullptr, ExecutionMode::SYNC);
+            std::lock_guard<std::mutex> lock(mutex);
+            (*results)[i] = n;
+            if (--pending == 0) {
+                allFinished.notify_one();
+            }
+        });
+    }
+
+    // Meanwhile, run the other executions. Every execution of the batch burst uses
+    // compilation->mPlan, so the compilation is finished and its plan can be read.
+    std::optional<BurstBuilder> batchBurst;
+    if (useBatchBurst && !onThisThread.empty()) {
+        batchBurst.emplace(compilation, compilation->mPlan.makeBursts());
+    }
+    BurstBuilder* burst = burstBuilder != nullptr ? burstBuilder
+                          : batchBurst.has_value() ? &*batchBurst
+                                                   : nullptr;
+    for (size_t i : onThisThread) {
+        ExecutionBuilder* execution = executions[i];
+        const auto deadline = makeDeadline(execution->mTimeoutDuration);
+        const int n = execution->computeAndFinish(deadline, burst, onThisThreadMode);
+        std::lock_guard<std::mutex> lock(mutex);
+        (*results)[i] = n;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        allFinished.wait(lock, [&pending] { return pending == 0; });
+    }
+    if (burstBuilder != nullptr) {
+        burstBuilder->unlock();
+    }
+
+    const auto firstError = std::find_if(results->begin(), results->end(),
+                                         [](int n) { return n != ANEURALNETWORKS_NO_ERROR; });
+    return firstError != results->end() ? *firstError : ANEURALNETWORKS_NO_ERROR;
+}
+
 std::vector<OutputShape> ExecutionBuilder::getInitialOutputShapes() const {
     std::vector<OutputShape> outputShapes(mOutputs.size());
     std::transform(mOutputs.begin(), mOutputs.end(), outputShapes.begin(),
@@ -1520,7 +1713,8 @@ std::tuple<int, std::vector<OutputShape>, Timing> StepExecutor::compute(
         if (nCreate != ANEURALNETWORKS_NO_ERROR) {
             return {nCreate, {}, {}};
         }
-        std::tie(n, outputShapes, timing) = execution->compute(burstController, deadline);
+        std::tie(n, outputShapes, timing) = execution->compute(
+                burstController, deadline, &mExecutionBuilder->mCancellationToken);
     } else {
         CHECK(mPreparedModel != nullptr);
         const MeasureTiming measure = measureTiming(mExecutionBuilder);
@@ -1528,7 +1722,8 @@ std::tuple<int, std::vector<OutputShape>, Timing> StepExecutor::compute(
                 makeTimeoutDuration(mExecutionBuilder->getLoopTimeoutDuration());
         std::tie(n, outputShapes, timing) = mPreparedModel->execute(
                 mInputs, mOutputs, mMemories.getObjects(), burstController, measure, deadline,
-                loopTimeoutDuration, mExecutionBuilder->getMetadata());
+                loopTimeoutDuration, mExecutionBuilder->getMetadata(),
+                &mExecutionBuilder->mCancellationToken);
     }
     mExecutionBuilder->reportTimingWithoutFencedExecutionCallback(timing);
     return {n, std::move(outputShapes), std::move(timing)};
@@ -1640,8 +1835,9 @@ std::tuple<int, std::vector<OutputShape>, Timing> StepExecutor::computeOnCpuFall
     const MeasureTiming measure = measureTiming(mExecutionBuilder);
     const OptionalDuration loopTimeoutDuration =
             makeTimeoutDuration(mExecutionBuilder->getLoopTimeoutDuration());
-    auto [nExecute, outputShapes, timing] = preparedModel->execute(
-            mInputs, mOutputs, memories, nullptr, measure, {}, loopTimeoutDuration, {});
+    auto [nExecute, outputShapes, timing] =
+            preparedModel->execute(mInputs, mOutputs, memories, nullptr, measure, {},
+                                   loopTimeoutDuration, {}, &mExecutionBuilder->mCancellationToken);
     mExecutionBuilder->reportTimingWithoutFencedExecutionCallback(timing);
     if (nExecute != ANEURALNETWORKS_NO_ERROR) {
         return {nExecute, std::move(outputShapes), timing};
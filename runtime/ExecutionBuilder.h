@@ -17,6 +17,7 @@
 #ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_EXECUTION_BUILDER_H
 #define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_EXECUTION_BUILDER_H
 
+#include <CancellationToken.h>
 #include <ControlFlow.h>
 #include <CpuExecutor.h>
 #include <android-base/thread_annotations.h>
@@ -33,6 +34,7 @@
 #include <vector>
 
 #include "ExecutionCallback.h"
+#include "ExecutionThreadPool.h"
 #include "Memory.h"
 #include "ModelArgumentInfo.h"
 #include "ModelBuilder.h"
@@ -58,9 +60,12 @@ enum class ExecutionMode { ASYNC, SYNC, BURST, ASYNC_WITH_DEPS };
 
 class ExecutionBuilder {
     friend class StepExecutor;
+    friend class DynamicBatcher;
 
    public:
-    explicit ExecutionBuilder(const CompilationBuilder* compilation);
+    // plan is the plan of compilation that this execution runs; see
+    // CompilationBuilder::setSpeculativeCpuExecution().
+    ExecutionBuilder(const CompilationBuilder* compilation, const ExecutionPlan* plan);
     virtual ~ExecutionBuilder() = default;
 
     int setInput(uint32_t index, const ANeuralNetworksOperandType* type, const void* buffer,
@@ -101,6 +106,25 @@ class ExecutionBuilder {
     int computeSynchronously() { return compute(nullptr); }
     int burstCompute(BurstBuilder* burst) { return compute(nullptr, burst); }
 
+    // Asks an in-flight computation to stop early. Computation on the CPU stops at the next
+    // operation boundary, or at the next tile or time step of a long running operation; a step
+    // running on a driver runs to completion, but no further step starts. The computation then
+    // completes with ANEURALNETWORKS_OP_FAILED, without falling back to the CPU, unless it
+    // finishes before noticing the request. Returns ANEURALNETWORKS_BAD_STATE if no computation
+    // is in flight. May be called from any thread.
+    int cancel();
+    bool isCancelRequested() const { return mCancellationToken.isCancelRequested(); }
+
+    // Synchronously computes executions, which must be distinct and all created from the same
+    // compilation, as one batch. The checks that do not depend on the inputs and outputs of an
+    // execution are made once for the whole batch. Executions of a plan that runs entirely on the
+    // CPU run in parallel on ExecutionThreadPool. The others run one after another through burst,
+    // or through a burst made for the batch if burst is nullptr, so that drivers see them as a
+    // pipelined burst. Stores the result code of each execution in *results, and returns the
+    // first of them that is an error, or ANEURALNETWORKS_NO_ERROR.
+    static int computeBatch(const std::vector<ExecutionBuilder*>& executions, BurstBuilder* burst,
+                            std::vector<int>* results);
+
     // Initialize output dimensional information from ModelArgumentInfo.
     std::vector<OutputShape> getInitialOutputShapes() const;
 
@@ -115,6 +139,7 @@ class ExecutionBuilder {
 
     const CompilationBuilder* getCompilation() const { return mCompilation; }
     const ModelBuilder* getModel() const { return mModel; }
+    bool hasDynamicTemporaries() const;
     const ModelBuilder* getSourceModel(uint32_t index) const;
     const Operand& getSourceOperand(const std::pair<uint32_t, uint32_t>& sourceOperandIndex) const {
         return getSourceModel(sourceOperandIndex.first)->getOperand(sourceOperandIndex.second);
@@ -178,6 +203,17 @@ class ExecutionBuilder {
     // It will be called at the start of every computation.
     int prepareForCompute(const char* name, ExecutionMode mode);
 
+    // The preparation of compute and computeBatch, on top of prepareForCompute.
+    int startCompute(const char* name, ExecutionMode mode);
+
+    // Runs a synchronous computation started by startCompute to completion.
+    int computeAndFinish(const OptionalTimePoint& deadline, BurstBuilder* burstBuilder,
+                         ExecutionMode mode);
+
+    // Returns the pool that runs this execution asynchronously. Executions that
+    // may block in drivers do not run on the pool of CPU work.
+    ExecutionThreadPool& getAsyncThreadPool() const;
+
     const CompilationBuilder* mCompilation;
 
     // Update output dimensional information from OutputShape to ModelArgumentInfo.
@@ -242,6 +278,9 @@ class ExecutionBuilder {
     // Otherwise, return true and set the state to State::COMPUTATION.
     bool checkAndSetComputationState(const char* name);
 
+    // Polled by the computation; see cancel(). Reset each time a computation starts.
+    CancellationToken mCancellationToken;
+
     // With what error status has execution completed?
     enum class Completion { NO_ERROR, OUTPUT_INSUFFICIENT_SIZE, OTHER_ERROR };
     Completion mCompletion = Completion::OTHER_ERROR;
@@ -285,7 +324,7 @@ class ExecutionBuilder {
 // For execution plan with a SIMPLE body, i.e. the whole model will be executed on a single device.
 class SimpleExecutionBuilder : public ExecutionBuilder {
    public:
-    SimpleExecutionBuilder(const CompilationBuilder* compilation);
+    SimpleExecutionBuilder(const CompilationBuilder* compilation, const ExecutionPlan* plan);
 
     std::tuple<int, std::vector<OutputShape>, Timing> computeInternal(
             const OptionalTimePoint& deadline, BurstBuilder* burstBuilder) override;
@@ -301,7 +340,7 @@ class SimpleExecutionBuilder : public ExecutionBuilder {
 // For execution plan with a COMPOUND body, i.e. partitioned execution with multiple steps.
 class CompoundExecutionBuilder : public ExecutionBuilder {
    public:
-    CompoundExecutionBuilder(const CompilationBuilder* compilation);
+    CompoundExecutionBuilder(const CompilationBuilder* compilation, const ExecutionPlan* plan);
 
     std::tuple<int, std::vector<OutputShape>, Timing> computeInternal(
             const OptionalTimePoint& deadline, BurstBuilder* burstBuilder) override;
@@ -20,6 +20,7 @@
 
 #include <ControlFlow.h>
 #include <CpuExecutor.h>
+#include <FastHash.h>
 #include <GraphDump.h>
 #include <LegacyUtils.h>
 #include <MetaModel.h>
@@ -40,6 +41,7 @@
 #include <queue>
 #include <set>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_set>
 #include <utility>
@@ -441,6 +443,14 @@ std::optional<DynamicTemporaries::LocationAndShape> DynamicTemporaries::lookup(
     return std::nullopt;
 }
 
+std::map<SourceOperandIndex, DynamicTemporaries::Shape> DynamicTemporaries::getShapes() const {
+    std::map<SourceOperandIndex, Shape> shapes;
+    for (const auto& [sourceOperandIndex, temp] : mSourceOperandToTemporary) {
+        shapes.emplace(sourceOperandIndex, Shape{temp.dimensions, temp.paddedLength});
+    }
+    return shapes;
+}
+
 ExecutionStep::ExecutionStep(ExecutionPlan* plan, uint32_t stepIndex, uint32_t sourceModelIndex,
                              std::shared_ptr<Device> device)
     : mPlan(plan),
@@ -781,14 +791,19 @@ static bool hasUnknownSize(const Operand& operand) {
     return false;
 }
 
-int ExecutionStep::finishStepModel(const ModelBuilder* mainModel, bool* hasOutputOfUnknownSize,
-                                   int32_t executionPreference, int32_t priority) {
+struct ExecutionStep::ShapeInferenceModel {
+    Model model;
+    std::vector<RunTimePoolInfo> poolInfos;
+};
+
+int ExecutionStep::finishStepModel(const ModelBuilder* mainModel, bool* hasOutputOfUnknownSize) {
     CHECK(mDevice != nullptr);
 
     for (const auto& stepModelOutput : mTempsAsStepModelOutputs) {
         const Operand& operand = mStepModel.getOperand(stepModelOutput.second);
         if (hasUnknownSize(operand)) {
             *hasOutputOfUnknownSize = true;
+            mDefinesDynamicTemporaries = true;
             VLOG(COMPILATION) << "StepModelOutput (operand#" << stepModelOutput.first
                               << " of source graph) has unknown size: " << operand;
         }
@@ -869,9 +884,53 @@ int ExecutionStep::finishStepModel(const ModelBuilder* mainModel, bool* hasOutpu
     NN_RETURN_IF_ERROR(mStepModel.identifyInputsAndOutputs(inputs.size(), inputs.data(),
                                                            outputs.size(), outputs.data()));
     NN_RETURN_IF_ERROR(mStepModel.finish());
+    return ANEURALNETWORKS_NO_ERROR;
+}
+
+const ExecutionStep::ShapeInferenceModel* ExecutionStep::getShapeInferenceModel() const {
+    CHECK(mDefinesDynamicTemporaries);
+    std::call_once(mShapeInferenceModelOnce, [this] {
+        auto shapeInferenceModel = std::make_unique<ShapeInferenceModel>();
+        shapeInferenceModel->model = mStepModel.makeModel();
+        if (setRunTimePoolInfosFromCanonicalMemories(&shapeInferenceModel->poolInfos,
+                                                     shapeInferenceModel->model.pools)) {
+            mShapeInferenceModel = std::move(shapeInferenceModel);
+        } else {
+            VLOG(EXECUTION) << "ExecutionStep::getShapeInferenceModel: unable to map the pools of "
+                               "the step model, its output shapes will not be inferred";
+        }
+    });
+    return mShapeInferenceModel.get();
+}
+
+std::optional<std::vector<OutputShape>> ExecutionStep::inferOutputShapes(
+        std::vector<Request::Argument> inputs) const {
+    NNTRACE_RT(NNTRACE_PHASE_EXECUTION, "ExecutionStep::inferOutputShapes");
+    const ShapeInferenceModel* shapeInferenceModel = getShapeInferenceModel();
+    if (shapeInferenceModel == nullptr) {
+        return std::nullopt;
+    }
+    CHECK_EQ(inputs.size(), mStepModelInputs.size());
+    // The outputs have no memory: the CpuExecutor only records their shapes.
+    const Request::Argument output = {.lifetime = Request::Argument::LifeTime::POINTER,
+                                      .location = {.pointer = static_cast<void*>(nullptr)}};
+    const Request request = {.inputs = std::move(inputs),
+                             .outputs = std::vector<Request::Argument>(mStepModelOutputs.size(),
+                                                                       output)};
+    CpuExecutor executor;
+    if (executor.inferOutputShapes(shapeInferenceModel->model, request,
+                                   shapeInferenceModel->poolInfos,
+                                   {}) != ANEURALNETWORKS_NO_ERROR) {
+        return std::nullopt;
+    }
+    return executor.getOutputShapes();
+}
 
-    // TODO: Move compilation elsewhere?
-    VLOG(COMPILATION) << "ExecutionStep::finishStepModel, compilation on " << mDevice->getName();
+int ExecutionStep::compileStepModel(int32_t executionPreference, int32_t priority) {
+    CHECK(mDevice != nullptr);
+    CHECK(mStepModel.isFinished());
+    NNTRACE_RT(NNTRACE_PHASE_COMPILATION, "ExecutionStep::compileStepModel");
+    VLOG(COMPILATION) << "ExecutionStep::compileStepModel, compilation on " << mDevice->getName();
     return compile(*mDevice, mStepModel, executionPreference, priority, {}, *mPlan->getCacheInfo(),
                    &mToken, {}, &mPreparedStepModel);
 }
@@ -934,11 +993,11 @@ int ExecutionPlan::CompoundBody::finish(const SourceModels* sourceModels,
     };
 
     findTempsAsStepModelOutputs();
+    std::vector<ExecutionStep*> executionSteps;
     for (const auto& logicalStep : mSteps) {
         if (ExecutionStep* step = logicalStep->tryExecutionStep()) {
             bool stepHasDynamicTemporaries = false;
-            int n = step->finishStepModel(mainModel, &stepHasDynamicTemporaries,
-                                          executionPreference, priority);
+            int n = step->finishStepModel(mainModel, &stepHasDynamicTemporaries);
             if (stepHasDynamicTemporaries) {
                 mHasDynamicTemporaries = true;
                 if (!isCompliantVersion(kHalVersionV1_2ToApi.canonical,
@@ -962,6 +1021,7 @@ int ExecutionPlan::CompoundBody::finish(const SourceModels* sourceModels,
                         << "ExecutionPlan::CompoundBody::finish -- finishStepModel failed";
                 return n;
             }
+            executionSteps.push_back(step);
         } else if (IfStep* step = logicalStep->tryIfStep()) {
             // The partitioner does not support dynamic temporaries (b/132458982).
             CHECK(!containsUnknownSize(step->outerInputOperands));
@@ -984,6 +1044,12 @@ int ExecutionPlan::CompoundBody::finish(const SourceModels* sourceModels,
         }
     }
 
+    if (int n = compileStepModels(executionSteps, executionPreference, priority);
+        n != ANEURALNETWORKS_NO_ERROR) {
+        VLOG(COMPILATION) << "ExecutionPlan::CompoundBody::finish -- compileStepModel failed";
+        return n;
+    }
+
     if (simulateFailureResultCode != ANEURALNETWORKS_NO_ERROR) {
         VLOG(COMPILATION) << "ExecutionPlan::CompoundeBody::finish: simulating failure, ResultCode "
                           << simulateFailureResultCode;
@@ -1008,6 +1074,55 @@ int ExecutionPlan::CompoundBody::finish(const SourceModels* sourceModels,
     return ANEURALNETWORKS_NO_ERROR;
 }
 
+int ExecutionPlan::CompoundBody::compileStepModels(const std::vector<ExecutionStep*>& steps,
+                                                   int32_t executionPreference,
+                                                   int32_t priority) const {
+    // Group the steps by device, keeping plan order within each group.
+    std::vector<std::vector<size_t>> stepsPerDevice;
+    std::map<const Device*, size_t> deviceToGroup;
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const Device* device = steps[i]->getDevice().get();
+        const auto [it, isNew] = deviceToGroup.emplace(device, stepsPerDevice.size());
+        if (isNew) {
+            stepsPerDevice.emplace_back();
+        }
+        stepsPerDevice[it->second].push_back(i);
+    }
+
+    std::vector<int> results(steps.size(), ANEURALNETWORKS_NO_ERROR);
+    std::mutex progressMutex;
+    uint32_t numPrepared = 0;
+    const auto compileGroup = [&](const std::vector<size_t>& group) {
+        for (size_t i : group) {
+            results[i] = steps[i]->compileStepModel(executionPreference, priority);
+            if (results[i] != ANEURALNETWORKS_NO_ERROR) {
+                // Later steps for this device will not be used.
+                return;
+            }
+            std::lock_guard<std::mutex> lock(progressMutex);
+            mPlan->reportProgress(++numPrepared, steps.size());
+        }
+    };
+
+    // The caller's thread compiles the first group.
+    std::vector<std::thread> threads;
+    threads.reserve(stepsPerDevice.size());
+    for (size_t g = 1; g < stepsPerDevice.size(); ++g) {
+        threads.emplace_back(compileGroup, std::cref(stepsPerDevice[g]));
+    }
+    if (!stepsPerDevice.empty()) {
+        compileGroup(stepsPerDevice[0]);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto firstFailure = std::find_if(results.begin(), results.end(), [](int n) {
+        return n != ANEURALNETWORKS_NO_ERROR;
+    });
+    return firstFailure == results.end() ? ANEURALNETWORKS_NO_ERROR : *firstFailure;
+}
+
 void ExecutionPlan::CompoundBody::findControlFlowBoundaryConstants(
         const SourceModels* sourceModels) {
     auto handleBoundaryConstants = [this,
@@ -1162,8 +1277,12 @@ int ExecutionPlan::finish(int32_t executionPreference, int32_t priority,
                           const std::vector<TokenValuePair>& metadata,
                           int simulateFailureResultCode) {
     CHECK(mBody != nullptr);
-    return mBody->finish(&getSourceModels(), executionPreference, priority, deadline, metadata,
-                         simulateFailureResultCode);
+    const int n = mBody->finish(&getSourceModels(), executionPreference, priority, deadline,
+                                metadata, simulateFailureResultCode);
+    if (n == ANEURALNETWORKS_NO_ERROR && mState == SIMPLE) {
+        reportProgress(1, 1);
+    }
+    return n;
 }
 
 ExecutionPlan::Controller::Controller(
@@ -1416,11 +1535,25 @@ std::shared_ptr<ExecutionPlan::Controller> ExecutionPlan::makeController(
     // TODO(b/157236079): Move some or all of this work to compilation time?
     DynamicTemporaries dynamicTemporaries;
     const TypeManager* typeManager = TypeManager::get();
-    forEachDynamicTemporary([body, typeManager, &dynamicTemporaries](
-                                    SourceOperandIndex sourceOperandIndex,
-                                    const Operand& sourceOperand, uint32_t definingStepIndex) {
+    const auto cachedShapes = body->hasDynamicTemporaries()
+                                      ? lookupDynamicTemporaryShapes(executionBuilder)
+                                      : std::nullopt;
+    bool allShapesCached = cachedShapes.has_value();
+    forEachDynamicTemporary([body, typeManager, &cachedShapes, &allShapesCached,
+                             &dynamicTemporaries](SourceOperandIndex sourceOperandIndex,
+                                                  const Operand& sourceOperand,
+                                                  uint32_t definingStepIndex) {
         CHECK(typeManager->isTensorType(sourceOperand.type));
         const auto memoryPreference = body->getMemoryPreferenceOfSourceOperand(sourceOperandIndex);
+        if (cachedShapes.has_value()) {
+            if (auto it = cachedShapes->find(sourceOperandIndex); it != cachedShapes->end()) {
+                dynamicTemporaries.declare(sourceOperandIndex, definingStepIndex,
+                                           it->second.dimensions, it->second.paddedLength,
+                                           memoryPreference.alignment, memoryPreference.padding);
+                return;
+            }
+        }
+        allShapesCached = false;
         // TODO: For now we guess an initial size equal to element
         // size, which is overly conservative.
         const uint32_t size = typeManager->getSizeOfData(sourceOperand.type, {1});
@@ -1430,12 +1563,75 @@ std::shared_ptr<ExecutionPlan::Controller> ExecutionPlan::makeController(
     dynamicTemporaries.endDeclarations();
     dynamicTemporaries.vlogDump("finished declarations");
 
-    return std::shared_ptr<Controller>(new Controller(
+    auto controller = std::shared_ptr<Controller>(new Controller(
             this, executionBuilder, burstBuilder, totalSizeOfTemporaries,
             std::move(sourceOperandToLocationOfTemporary),
             std::move(sourceOperandToLocationOfTemporary2), body->mSourceOperandToInputIndex,
             body->mSourceOperandToOutputIndex, body->mSourceOperandToBoundaryConstantCopy,
             body->mSourceOperandToBoundaryConstantReference, std::move(dynamicTemporaries)));
+    controller->mDynamicTemporaryShapesAreCached = allShapesCached;
+    return controller;
+}
+
+ExecutionPlan::InputShapeSignature ExecutionPlan::getInputShapeSignature(
+        const ExecutionBuilder* executionBuilder) {
+    InputShapeSignature signature;
+    for (uint32_t i = 0, n = executionBuilder->getModel()->inputCount(); i < n; ++i) {
+        const ModelArgumentInfo& info = executionBuilder->getInputInfo(i);
+        const std::vector<uint32_t>& dimensions = info.dimensions();
+        signature.push_back(static_cast<uint32_t>(info.state()));
+        signature.push_back(dimensions.size());
+        signature.insert(signature.end(), dimensions.begin(), dimensions.end());
+    }
+    return signature;
+}
+
+std::optional<std::map<SourceOperandIndex, DynamicTemporaries::Shape>>
+ExecutionPlan::lookupDynamicTemporaryShapes(const ExecutionBuilder* executionBuilder) const {
+    const InputShapeSignature signature = getInputShapeSignature(executionBuilder);
+    const uint64_t key = fastHash64(signature.data(), signature.size() * sizeof(signature[0]));
+    std::lock_guard<std::mutex> guard(mShapeCacheMutex);
+    if (auto it = mShapeCache.find(key);
+        it != mShapeCache.end() && it->second->second.signature == signature) {
+        mShapeCacheList.splice(mShapeCacheList.begin(), mShapeCacheList, it->second);
+        ++mDynamicTemporaryStats.shapeCacheHits;
+        VLOG(EXECUTION) << "ExecutionPlan: declaring dynamic temporaries at cached shapes";
+        return it->second->second.shapes;
+    }
+    ++mDynamicTemporaryStats.shapeCacheMisses;
+    return std::nullopt;
+}
+
+void ExecutionPlan::recordDynamicTemporaryShapes(const Controller& controller) const {
+    if (controller.mDynamicTemporaries.empty()) {
+        return;
+    }
+    const InputShapeSignature signature = getInputShapeSignature(controller.mExecutionBuilder);
+    const uint64_t key = fastHash64(signature.data(), signature.size() * sizeof(signature[0]));
+    auto shapes = controller.mDynamicTemporaries.getShapes();
+    ShapeCacheEntry entry = {.signature = signature, .shapes = std::move(shapes)};
+    std::lock_guard<std::mutex> guard(mShapeCacheMutex);
+    if (auto it = mShapeCache.find(key); it != mShapeCache.end()) {
+        it->second->second = std::move(entry);
+        mShapeCacheList.splice(mShapeCacheList.begin(), mShapeCacheList, it->second);
+        return;
+    }
+    if (mShapeCache.size() >= kMaxShapeCacheEntries) {
+        mShapeCache.erase(mShapeCacheList.back().first);
+        mShapeCacheList.pop_back();
+    }
+    mShapeCacheList.emplace_front(key, std::move(entry));
+    mShapeCache.emplace(key, mShapeCacheList.begin());
+}
+
+ExecutionPlan::DynamicTemporaryStats ExecutionPlan::getDynamicTemporaryStats() const {
+    std::lock_guard<std::mutex> guard(mShapeCacheMutex);
+    return mDynamicTemporaryStats;
+}
+
+void ExecutionPlan::countInsufficientSizeRetry() const {
+    std::lock_guard<std::mutex> guard(mShapeCacheMutex);
+    mDynamicTemporaryStats.insufficientSizeRetries++;
 }
 
 // TODO: Find a better way to provide this functionality.
@@ -1606,6 +1802,84 @@ int ExecutionPlan::nextCompound(std::shared_ptr<Controller> controller,
     }
 }
 
+void ExecutionPlan::inferDynamicTemporaryShapes(
+        const ExecutionStep* step, std::shared_ptr<Controller> controller,
+        const std::vector<OutputShape>* mainModelOutputShapes) const {
+    DynamicTemporaries& dynamicTemporaries = controller->mDynamicTemporaries;
+    if (!step->canInferOutputShapes() || dynamicTemporaries.empty() ||
+        controller->mDynamicTemporaryShapesAreCached) {
+        return;
+    }
+    const uint32_t sourceModelIndex = step->getSourceModelIndex();
+
+    std::vector<Request::Argument> inputs;
+    inputs.reserve(step->getStepModelInputs().size());
+    for (const auto& [sourceIndex, stepIndex] : step->getStepModelInputs()) {
+        const SourceOperandIndex sourceOperandIndex(sourceModelIndex, sourceIndex);
+        Request::Argument argument = {.lifetime = Request::Argument::LifeTime::POINTER};
+        if (auto loc = dynamicTemporaries.lookup(sourceOperandIndex, /*mustBeAllocated=*/false)) {
+            const std::optional<RunTimePoolInfo> info =
+                    loc->memory != nullptr ? loc->memory->getRunTimePoolInfo() : std::nullopt;
+            if (info == std::nullopt) {
+                return;
+            }
+            const uint8_t* pointer = info->getBuffer() + loc->offset;
+            argument.location = {.pointer = static_cast<const void*>(pointer),
+                                 .length = loc->paddedLength};
+            argument.dimensions = *loc->dimensions;
+            inputs.push_back(std::move(argument));
+            continue;
+        }
+        if (auto it = controller->mSourceOperandToInputIndex.find(sourceOperandIndex);
+            it != controller->mSourceOperandToInputIndex.end()) {
+            const ModelArgumentInfo& info = controller->mExecutionBuilder->getInputInfo(it->second);
+            if (info.state() == ModelArgumentInfo::HAS_NO_VALUE) {
+                inputs.push_back({.lifetime = Request::Argument::LifeTime::NO_VALUE});
+                continue;
+            }
+            argument.dimensions = info.dimensions();
+        } else if (auto it = controller->mSourceOperandToOutputIndex.find(sourceOperandIndex);
+                   it != controller->mSourceOperandToOutputIndex.end() &&
+                   mainModelOutputShapes != nullptr) {
+            argument.dimensions = mainModelOutputShapes->at(it->second).dimensions;
+        }
+        const std::optional<Buffer> buffer = getBuffer(controller, sourceOperandIndex);
+        if (buffer == std::nullopt) {
+            return;
+        }
+        argument.location = {.pointer = static_cast<const void*>(buffer->getPointer()),
+                             .length = buffer->getSize()};
+        inputs.push_back(std::move(argument));
+    }
+
+    const std::optional<std::vector<OutputShape>> outputShapes =
+            step->inferOutputShapes(std::move(inputs));
+    if (outputShapes == std::nullopt) {
+        return;
+    }
+    uint64_t inferredShapes = 0;
+    const auto& stepModelOutputs = step->getStepModelOutputs();
+    for (uint32_t i = 0, n = stepModelOutputs.size(); i < n; ++i) {
+        const SourceOperandIndex sourceOperandIndex(sourceModelIndex, stepModelOutputs[i].first);
+        if (!dynamicTemporaries.lookup(sourceOperandIndex, /*mustBeAllocated=*/false)) {
+            continue;
+        }
+        const Dimensions& dimensions = outputShapes->at(i).dimensions;
+        const uint32_t size = TypeManager::get()->getSizeOfData(
+                step->getStepModel()->getOperand(stepModelOutputs[i].second).type, dimensions);
+        if (dimensions.empty() || size == 0) {
+            // The shape depends on the results of other operations of the step.
+            continue;
+        }
+        dynamicTemporaries.redeclare(sourceOperandIndex, dimensions, size);
+        inferredShapes++;
+    }
+    if (inferredShapes > 0) {
+        std::lock_guard<std::mutex> guard(mShapeCacheMutex);
+        mDynamicTemporaryStats.inferredShapes += inferredShapes;
+    }
+}
+
 int ExecutionPlan::nextCompound(const ExecutionStep* step, std::shared_ptr<Controller> controller,
                                 std::shared_ptr<StepExecutor>* executor,
                                 SharedBurst* burstController,
@@ -1613,6 +1887,7 @@ int ExecutionPlan::nextCompound(const ExecutionStep* step, std::shared_ptr<Contr
     VLOG(EXECUTION) << "next: Step#" << controller->mNextStepIndex << ": execute on "
                     << step->getDevice()->getName();
 
+    inferDynamicTemporaryShapes(step, controller, mainModelOutputShapes);
     NN_RETURN_IF_ERROR(controller->mDynamicTemporaries.allocate(step->getIndex()));
     controller->mDynamicTemporaries.vlogDump("finished allocating for a step");
 
@@ -1970,6 +2245,9 @@ void ExecutionPlan::reset() {
         mBody = nullptr;
     }
     mState = EMPTY;
+    std::lock_guard<std::mutex> guard(mShapeCacheMutex);
+    mShapeCache.clear();
+    mShapeCacheList.clear();
 }
 
 bool ExecutionPlan::isSimpleCpu() const {
@@ -2516,6 +2794,42 @@ bool ModelBuilder::supportedByControlFlowInterpreter(uint32_t operationIndex) co
            !isControlFlowOperationWithOperandOfUnknownSize(operationIndex);
 }
 
+bool ModelBuilder::referencedModelsRunOnCpu(uint32_t preference,
+                                            const std::vector<std::shared_ptr<Device>>& devices,
+                                            uint32_t operationIndex,
+                                            RunsOnCpuCache* runsOnCpuCache) const {
+    const std::shared_ptr<Device> cpuDevice = DeviceManager::getCpuDevice();
+    for (uint32_t operandIndex : getOperation(operationIndex).inputs) {
+        const Operand& operand = getOperand(operandIndex);
+        if (operand.lifetime != Operand::LifeTime::SUBGRAPH) {
+            continue;
+        }
+        const ModelBuilder* model = getReferencedModel(operand);
+        if (const auto it = runsOnCpuCache->find(model); it != runsOnCpuCache->end()) {
+            if (!it->second) {
+                return false;
+            }
+            continue;
+        }
+        std::vector<int> bestDeviceForOperation(model->operationCount());
+        bool runsOnCpu = model->findBestDeviceForEachOperation(preference, devices,
+                                                               &bestDeviceForOperation,
+                                                               runsOnCpuCache) ==
+                         ANEURALNETWORKS_NO_ERROR;
+        // A nested control flow operation scheduled for interpreted execution
+        // has referenced models that do not all run on the CPU.
+        for (int deviceIndex : bestDeviceForOperation) {
+            runsOnCpu = runsOnCpu && size_t(deviceIndex) < devices.size() &&
+                        devices[deviceIndex] == cpuDevice;
+        }
+        runsOnCpuCache->emplace(model, runsOnCpu);
+        if (!runsOnCpu) {
+            return false;
+        }
+    }
+    return true;
+}
+
 namespace {
 
 // This class determines whether a given device can execute a given operation
@@ -2537,7 +2851,11 @@ class CanDo {
 
 int ModelBuilder::findBestDeviceForEachOperation(
         uint32_t preference, const std::vector<std::shared_ptr<Device>>& devices,
-        std::vector<int>* bestDeviceForOperation) const {
+        std::vector<int>* bestDeviceForOperation, RunsOnCpuCache* runsOnCpuCache) const {
+    RunsOnCpuCache localRunsOnCpuCache;
+    if (runsOnCpuCache == nullptr) {
+        runsOnCpuCache = &localRunsOnCpuCache;
+    }
     const MetaModel metaModel(makeModel(), DeviceManager::get()->strictSlicing());
 
     const size_t deviceCount = devices.size();
@@ -2593,7 +2911,10 @@ int ModelBuilder::findBestDeviceForEachOperation(
             LOG(ERROR) << "No driver can do operation " << operation.type;
             return ANEURALNETWORKS_BAD_DATA;
         } else if (devices[bestChoice] == DeviceManager::getCpuDevice() &&
-                   supportedByControlFlowInterpreter(operationIndex)) {
+                   supportedByControlFlowInterpreter(operationIndex) &&
+                   !(DeviceManager::get()->fuseCpuControlFlow() &&
+                     referencedModelsRunOnCpu(preference, devices, operationIndex,
+                                              runsOnCpuCache))) {
             // Run control flow on the ExecutionPlan::next() interpreter and try
             // to delegate referenced models.
             const int kControlFlowInterpreter = deviceCount;
@@ -22,14 +22,18 @@
 #include <LegacyUtils.h>
 #include <TokenHasher.h>
 #include <android-base/logging.h>
+#include <android-base/thread_annotations.h>
 #include <nnapi/IBurst.h>
 #include <nnapi/Types.h>
 
 #include <algorithm>
 #include <chrono>
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
 #include <set>
 #include <string>
@@ -193,6 +197,13 @@ class DynamicTemporaries {
     // Have any dynamic temporaries been declared?
     bool empty() const { return mSourceOperandToTemporary.empty(); }
 
+    // The shape of each dynamic temporary as currently declared.
+    struct Shape {
+        Dimensions dimensions;
+        uint32_t paddedLength;
+    };
+    std::map<SourceOperandIndex, Shape> getShapes() const;
+
    private:
     // The same as LocationAndShape, except that:
     // - the base of the location is represented not by memory but by defining stepIndex
@@ -274,13 +285,17 @@ class ExecutionStep {
     // If this step has a step model output of unknown size, sets
     // *hasOutputOfUnknownSize to true; otherwise, leaves it
     // unchanged.
-    int finishStepModel(const ModelBuilder* mainModel, bool* hasOutputOfUnknownSize,
-                        int32_t executionPreference, int32_t priority);
+    int finishStepModel(const ModelBuilder* mainModel, bool* hasOutputOfUnknownSize);
+
+    // Prepares the step model on the step's device. Only legal to call after
+    // finishStepModel() has succeeded. Steps assigned to different devices may
+    // be compiled concurrently.
+    int compileStepModel(int32_t executionPreference, int32_t priority);
 
     const ModelBuilder* getStepModel() const { return &mStepModel; }
     std::shared_ptr<Device> getDevice() const { return mDevice; }
 
-    // only available after calling finishStepModel()
+    // only available after calling compileStepModel()
     std::shared_ptr<RuntimePreparedModel> getPreparedStepModel() const {
         return mPreparedStepModel;
     }
@@ -308,6 +323,18 @@ class ExecutionStep {
         return mStepModelInputs.empty() || mStepModelOutputs.empty();
     }
 
+    // Only a step that defines dynamic temporaries infers its output shapes.
+    bool canInferOutputShapes() const { return mDefinesDynamicTemporaries; }
+
+    // Computes the shapes of the step model outputs with the prepare functions
+    // of the CPU implementation of the step model operations, without running
+    // the step. inputs are the arguments of the step model inputs, in order.
+    // The outputs of the operations that need the results of other operations
+    // of the step keep their declared shapes. Returns std::nullopt if the
+    // shapes cannot be inferred.
+    std::optional<std::vector<OutputShape>> inferOutputShapes(
+            std::vector<Request::Argument> inputs) const;
+
     void dump() const;
 
     // For test only, get the transformed cache token.
@@ -328,6 +355,19 @@ class ExecutionStep {
     std::shared_ptr<Device> mDevice;
     std::shared_ptr<RuntimePreparedModel> mPreparedStepModel;
 
+    // Set by finishStepModel() if a step model output is a temporary of
+    // unknown size.
+    bool mDefinesDynamicTemporaries = false;
+
+    // The step model and its pools, as the CpuExecutor reads them, for
+    // inferOutputShapes(). Created by getShapeInferenceModel() on the first
+    // inference, so that steps whose shapes are never inferred do not keep a
+    // copy of their model. nullptr if the pools cannot be mapped.
+    struct ShapeInferenceModel;
+    const ShapeInferenceModel* getShapeInferenceModel() const;
+    mutable std::once_flag mShapeInferenceModelOnce;
+    mutable std::unique_ptr<const ShapeInferenceModel> mShapeInferenceModel;
+
     // All inputs of this step model:
     //     (source model operand index, step model operand index)
     //
@@ -565,6 +605,11 @@ using StepRole = std::tuple<uint32_t, IOType, uint32_t>;
 // A callback function that takes the prepared_model, io_type, and io_index of a step role.
 using StepRoleCallback = std::function<void(const RuntimePreparedModel*, IOType, uint32_t)>;
 
+// A callback function that takes the number of step models prepared so far and the total number
+// of step models in the plan. It may be invoked from a thread other than the one that called
+// ExecutionPlan::finish(), but invocations for the same plan never overlap.
+using CompilationProgressCallback = std::function<void(uint32_t numPrepared, uint32_t numTotal)>;
+
 class ExecutionPlan {
    public:
     ExecutionPlan(const ExecutionPlan&) = delete;
@@ -661,6 +706,10 @@ class ExecutionPlan {
         std::unique_ptr<MemoryAshmem> mTemporaries;
 
         DynamicTemporaries mDynamicTemporaries;
+        // Whether every dynamic temporary was declared at the shape recorded by
+        // an earlier execution with the same input shapes, in which case the
+        // shapes are not inferred again.
+        bool mDynamicTemporaryShapesAreCached = false;
 
         // Index of the next step to be processed by ExecutionPlan::next().
         size_t mNextStepIndex;
@@ -690,6 +739,29 @@ class ExecutionPlan {
              SharedBurst* burstController, const std::vector<OutputShape>* mainModelOutputShapes,
              int syncFdOfLastStep = -1) const;
 
+    // Records the shapes of the dynamic temporaries of an execution that
+    // completed successfully, so that the next executions whose inputs have
+    // the same dimensions declare them at these shapes rather than at a guess.
+    void recordDynamicTemporaryShapes(const Controller& controller) const;
+
+    struct DynamicTemporaryStats {
+        // Number of executions whose dynamic temporaries were declared at the
+        // shapes recorded by an execution with the same input dimensions.
+        uint64_t shapeCacheHits = 0;
+        // Number of executions with dynamic temporaries that found no such shapes.
+        uint64_t shapeCacheMisses = 0;
+        // Number of dynamic temporaries whose shapes were inferred before the
+        // steps that define them ran.
+        uint64_t inferredShapes = 0;
+        // Number of steps that ran again because one of their outputs was
+        // too small.
+        uint64_t insufficientSizeRetries = 0;
+    };
+    DynamicTemporaryStats getDynamicTemporaryStats() const;
+
+    // Counts a step that runs again because one of its outputs was too small.
+    void countInsufficientSizeRetry() const;
+
     // Create the same executor as the last one created by next().
     int fallback(std::shared_ptr<Controller> controller, std::shared_ptr<StepExecutor>* executor,
                  SharedBurst* burstController,
@@ -734,6 +806,16 @@ class ExecutionPlan {
     const CacheInfo* getCacheInfo() const { return mCacheInfo; }
     const uint8_t* getCacheToken() const { return mToken; }
 
+    // The callback survives reset(), so that it also observes a CPU fallback plan.
+    void setProgressCallback(CompilationProgressCallback callback) {
+        mProgressCallback = std::move(callback);
+    }
+    void reportProgress(uint32_t numPrepared, uint32_t numTotal) const {
+        if (mProgressCallback) {
+            mProgressCallback(numPrepared, numTotal);
+        }
+    }
+
     // The caller is responsible for making sure the index is within range.
     void forEachStepRoleOfInput(uint32_t index, const StepRoleCallback& callback) const {
         CHECK(mBody != nullptr);
@@ -811,6 +893,15 @@ class ExecutionPlan {
     // Reads the value of a partition boundary boolean condition operand.
     int readConditionValue(std::shared_ptr<Controller> controller, SourceOperandIndex operandIndex,
                            bool* value) const;
+    // Redeclares the dynamic temporaries defined by a step at the shapes that
+    // ExecutionStep::inferOutputShapes() finds from the current values of the
+    // step inputs, so that the step does not run into output buffers that are
+    // too small. Leaves the declarations as they are if the shapes cannot be
+    // inferred or if they came from the shapes recorded for the same input
+    // shapes.
+    void inferDynamicTemporaryShapes(const ExecutionStep* step,
+                                     std::shared_ptr<Controller> controller,
+                                     const std::vector<OutputShape>* mainModelOutputShapes) const;
 
     // Handles control flow. See LogicalStep.
     int nextCompound(std::shared_ptr<Controller> controller,
@@ -941,6 +1032,15 @@ class ExecutionPlan {
         bool mHasDynamicTemporaries = false;
 
        private:
+        // Prepares the step models of the given ExecutionSteps. The steps
+        // assigned to one device are compiled in plan order on a single thread,
+        // while different devices compile concurrently, so the compilation time
+        // is bounded by the slowest device rather than by the sum over all
+        // devices. Returns the result code of the first failing step in plan
+        // order, or ANEURALNETWORKS_NO_ERROR.
+        int compileStepModels(const std::vector<ExecutionStep*>& steps,
+                              int32_t executionPreference, int32_t priority) const;
+
         void findTempsAsStepModelOutputs();
 
         void findModelOutputsThatAreDownstreamInputs();
@@ -999,7 +1099,37 @@ class ExecutionPlan {
     const CacheInfo* mCacheInfo = nullptr;
     const uint8_t* mToken = nullptr;
 
+    // Observer of step model preparation; see setProgressCallback().
+    CompilationProgressCallback mProgressCallback;
+
     SourceModels mSourceModels;
+
+    // The dimensions of the inputs of an execution, which key the shapes of
+    // its dynamic temporaries.
+    using InputShapeSignature = std::vector<uint32_t>;
+    static InputShapeSignature getInputShapeSignature(const ExecutionBuilder* executionBuilder);
+
+    // The shapes recorded by recordDynamicTemporaryShapes(), if any.
+    std::optional<std::map<SourceOperandIndex, DynamicTemporaries::Shape>>
+    lookupDynamicTemporaryShapes(const ExecutionBuilder* executionBuilder) const;
+
+    // The shapes of the dynamic temporaries are only the initial declarations:
+    // a step that finds one of them too small still reports its actual shape,
+    // so shapes that depend on input values rather than input dimensions only
+    // cost the same retries as without the cache.
+    struct ShapeCacheEntry {
+        InputShapeSignature signature;
+        std::map<SourceOperandIndex, DynamicTemporaries::Shape> shapes;
+    };
+    static constexpr size_t kMaxShapeCacheEntries = 16;
+    mutable std::mutex mShapeCacheMutex;
+    // The entries from the most to the least recently used, keyed by the
+    // fastHash64 of the signature. The least recently used entry is evicted.
+    using ShapeCacheList = std::list<std::pair<uint64_t, ShapeCacheEntry>>;
+    mutable ShapeCacheList mShapeCacheList GUARDED_BY(mShapeCacheMutex);
+    mutable std::unordered_map<uint64_t, ShapeCacheList::iterator> mShapeCache
+            GUARDED_BY(mShapeCacheMutex);
+    mutable DynamicTemporaryStats mDynamicTemporaryStats GUARDED_BY(mShapeCacheMutex);
 };
 
 inline std::ostream& operator<<(std::ostream& out, ExecutionPlan::Kind kind) {
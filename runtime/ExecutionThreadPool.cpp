@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "ExecutionThreadPool"
+
+#include "ExecutionThreadPool.h"
+
+#include <android-base/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace android {
+namespace nn {
+
+namespace {
+
+uint32_t getDefaultMaxWorkerCount() {
+    // Asynchronous executions spend most of their time waiting for drivers, so
+    // allow more workers than cores.
+    const uint32_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+    return std::clamp(2 * cores, 4u, 32u);
+}
+
+// Workers of the driver pool are mostly blocked, so the bound only limits the
+// number of threads.
+constexpr uint32_t kMaxDriverWaitWorkerCount = 64;
+
+}  // namespace
+
+thread_local ExecutionThreadPool::WorkerState ExecutionThreadPool::tWorkerState;
+
+ExecutionThreadPool& ExecutionThreadPool::get() {
+    // Never destroyed, so that workers need not be joined at process exit.
+    static ExecutionThreadPool* const pool =
+            new ExecutionThreadPool(getDefaultMaxWorkerCount(), kDefaultStackSize);
+    return *pool;
+}
+
+ExecutionThreadPool& ExecutionThreadPool::getForDriverWaits() {
+    static ExecutionThreadPool* const pool =
+            new ExecutionThreadPool(kMaxDriverWaitWorkerCount, kDefaultStackSize);
+    return *pool;
+}
+
+bool ExecutionThreadPool::isWorkerThread() {
+    return tWorkerState.pool != nullptr;
+}
+
+void ExecutionThreadPool::preemptionPoint() {
+    WorkerState& state = tWorkerState;
+    if (state.pool == nullptr || state.preemptionDepth >= kMaxPreemptionDepth) {
+        return;
+    }
+    ExecutionThreadPool* pool = state.pool;
+    // Cheap check for the common case where nothing more urgent is waiting.
+    bool anyWaiting = false;
+    for (size_t lane = state.lane + 1; lane < kLaneCount; ++lane) {
+        anyWaiting |= pool->mQueueDepths[lane].load(std::memory_order_relaxed) > 0;
+    }
+    if (!anyWaiting) {
+        return;
+    }
+
+    const size_t preemptedLane = state.lane;
+    QueuedTask task;
+    size_t lane;
+    while (pool->takePreemptingTask(preemptedLane, &task, &lane)) {
+        VLOG(EXECUTION) << "ExecutionThreadPool: a task of lane " << lane
+                        << " preempts a task of lane " << preemptedLane;
+        state.lane = lane;
+        ++state.preemptionDepth;
+        task.task();
+        task.task = nullptr;
+        --state.preemptionDepth;
+        state.lane = preemptedLane;
+    }
+}
+
+ExecutionThreadPool::ExecutionThreadPool(uint32_t maxWorkers, size_t stackSize)
+    : kMaxWorkers(std::max(maxWorkers, 1u)), kStackSize(stackSize) {}
+
+ExecutionThreadPool::~ExecutionThreadPool() {
+    std::vector<pthread_t> workers;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+        workers = mWorkers;
+    }
+    mTaskAvailable.notify_all();
+    for (pthread_t worker : workers) {
+        pthread_join(worker, nullptr);
+    }
+}
+
+size_t ExecutionThreadPool::getLane(Priority priority) {
+    switch (priority) {
+        case Priority::LOW:
+            return 0;
+        case Priority::MEDIUM:
+            return 1;
+        case Priority::HIGH:
+            return 2;
+    }
+    LOG(FATAL) << "unrecognized priority: " << priority;
+    return 1;
+}
+
+uint32_t ExecutionThreadPool::getWorkerCount() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mWorkers.size();
+}
+
+ExecutionThreadPool::LaneStats ExecutionThreadPool::getLaneStats(Priority priority) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLaneStats[getLane(priority)];
+}
+
+void ExecutionThreadPool::schedule(Priority priority, const OptionalTimePoint& deadline,
+                                   Task task) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    CHECK(!mStopping);
+    // Only add a worker if the idle workers cannot absorb the queued tasks.
+    if (mQueuedTaskCount >= mIdleWorkerCount && mWorkers.size() < kMaxWorkers &&
+        !spawnWorkerLocked() && mWorkers.empty()) {
+        // There is no worker to run the task, so run it on this thread.
+        lock.unlock();
+        task();
+        return;
+    }
+    const size_t lane = getLane(priority);
+    mLanes[lane].emplace(deadline.value_or(TimePoint::max()),
+                         QueuedTask{.task = std::move(task), .scheduledAt = WaitClock::now()});
+    ++mQueuedTaskCount;
+    LaneStats& stats = mLaneStats[lane];
+    ++stats.scheduledTaskCount;
+    stats.queueDepth = mLanes[lane].size();
+    stats.maxQueueDepth = std::max(stats.maxQueueDepth, stats.queueDepth);
+    mQueueDepths[lane].store(stats.queueDepth, std::memory_order_relaxed);
+    lock.unlock();
+    mTaskAvailable.notify_one();
+}
+
+void ExecutionThreadPool::runAndWait(Priority priority, const OptionalTimePoint& deadline,
+                                     const Task& task) {
+    if (isWorkerThread()) {
+        task();
+        return;
+    }
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool done = false;
+    schedule(priority, deadline, [&task, &mutex, &condition, &done] {
+        task();
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        // Notify while holding the lock: the waiter owns condition and may
+        // destroy it as soon as it observes done.
+        condition.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&done] { return done; });
+}
+
+bool ExecutionThreadPool::spawnWorkerLocked() {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (const int error = pthread_attr_setstacksize(&attr, kStackSize); error != 0) {
+        LOG(WARNING) << "ExecutionThreadPool failed to set the stack size to " << kStackSize
+                     << ": " << strerror(error);
+    }
+    pthread_t worker;
+    const int error = pthread_create(&worker, &attr, &ExecutionThreadPool::workerMain, this);
+    pthread_attr_destroy(&attr);
+    if (error != 0) {
+        LOG(ERROR) << "ExecutionThreadPool failed to create a worker: " << strerror(error);
+        return false;
+    }
+    mWorkers.push_back(worker);
+    VLOG(EXECUTION) << "ExecutionThreadPool now has " << mWorkers.size() << " workers";
+    return true;
+}
+
+void* ExecutionThreadPool::workerMain(void* pool) {
+    tWorkerState.pool = static_cast<ExecutionThreadPool*>(pool);
+    tWorkerState.pool->runWorker();
+    return nullptr;
+}
+
+void ExecutionThreadPool::runWorker() {
+    QueuedTask task;
+    size_t lane;
+    while (takeTask(&task, &lane)) {
+        tWorkerState.lane = lane;
+        task.task();
+        // Release the captures of the task before waiting for the next one.
+        task.task = nullptr;
+    }
+}
+
+bool ExecutionThreadPool::takeTask(QueuedTask* task, size_t* lane) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    ++mIdleWorkerCount;
+    mTaskAvailable.wait(lock, [this] { return mQueuedTaskCount > 0 || mStopping; });
+    --mIdleWorkerCount;
+    if (mQueuedTaskCount == 0) {
+        return false;
+    }
+    for (size_t i = kLaneCount; i-- > 0;) {
+        if (!mLanes[i].empty()) {
+            *task = popTaskLocked(i);
+            *lane = i;
+            return true;
+        }
+    }
+    LOG(FATAL) << "ExecutionThreadPool has " << mQueuedTaskCount << " queued tasks in no lane";
+    return false;
+}
+
+bool ExecutionThreadPool::takePreemptingTask(size_t minLane, QueuedTask* task, size_t* lane) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Waiting tasks will soon be taken by an idle or new worker.
+    if (mIdleWorkerCount > 0 || mWorkers.size() < kMaxWorkers) {
+        return false;
+    }
+    for (size_t i = kLaneCount; i-- > minLane + 1;) {
+        if (!mLanes[i].empty()) {
+            *task = popTaskLocked(i);
+            *lane = i;
+            ++mLaneStats[i].preemptingTaskCount;
+            return true;
+        }
+    }
+    return false;
+}
+
+ExecutionThreadPool::QueuedTask ExecutionThreadPool::popTaskLocked(size_t lane) {
+    auto first = mLanes[lane].begin();
+    QueuedTask task = std::move(first->second);
+    mLanes[lane].erase(first);
+    --mQueuedTaskCount;
+
+    LaneStats& stats = mLaneStats[lane];
+    stats.queueDepth = mLanes[lane].size();
+    mQueueDepths[lane].store(stats.queueDepth, std::memory_order_relaxed);
+    const auto waitTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            WaitClock::now() - task.scheduledAt);
+    stats.totalWaitTime += waitTime;
+    stats.maxWaitTime = std::max(stats.maxWaitTime, waitTime);
+    return task;
+}
+
+}  // namespace nn
+}  // namespace android
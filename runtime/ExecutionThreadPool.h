@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_EXECUTION_THREAD_POOL_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_EXECUTION_THREAD_POOL_H
+
+#include <android-base/thread_annotations.h>
+#include <nnapi/Types.h>
+#include <pthread.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace android {
+namespace nn {
+
+// A bounded pool of worker threads that runs asynchronous executions and CPU
+// executions, so that an execution does not pay for spawning a thread.
+//
+// Workers are created on demand, up to a fixed maximum, and are given a large
+// stack: the CPU executor recurses into referenced models for control flow and
+// must not be limited by the stack of the application thread.
+//
+// Tasks are ordered by (priority, deadline). Each Priority has its own lane;
+// idle workers take a task from the highest priority lane that is not empty,
+// choosing the task with the earliest deadline, and tasks without a deadline
+// in the order they were scheduled.
+//
+// When every worker is busy, tasks of a lower priority cannot be interrupted,
+// so tasks call preemptionPoint() at convenient boundaries (between operations
+// of the CPU executor and between steps of an execution plan). If a task of a
+// higher priority is waiting, it then runs on the same worker before the
+// preempted task resumes.
+//
+// A task that blocks holds its worker until it returns. Asynchronous
+// executions that call drivers therefore run on a separate pool, returned by
+// getForDriverWaits(), so that executions blocked in drivers cannot take every
+// worker of the pool that runs CPU work.
+class ExecutionThreadPool {
+   public:
+    using Task = std::function<void()>;
+
+    // Stack size of the workers.
+    static constexpr size_t kDefaultStackSize = 8 * 1024 * 1024;
+
+    // Maximum number of tasks that can be nested on one worker by preemption.
+    static constexpr uint32_t kMaxPreemptionDepth = 2;
+
+    // Queueing metrics of one priority lane.
+    struct LaneStats {
+        // Number of tasks that were scheduled in the lane.
+        uint64_t scheduledTaskCount = 0;
+        // Number of those tasks that ran by preempting a lower priority task.
+        uint64_t preemptingTaskCount = 0;
+        // Number of tasks currently waiting, and the highest number seen.
+        size_t queueDepth = 0;
+        size_t maxQueueDepth = 0;
+        // Time between scheduling a task and starting it, summed over all the
+        // tasks that started, and the longest such time.
+        std::chrono::nanoseconds totalWaitTime{0};
+        std::chrono::nanoseconds maxWaitTime{0};
+    };
+
+    // Returns the process-wide pool. It is never destroyed.
+    static ExecutionThreadPool& get();
+
+    // Returns the process-wide pool for asynchronous executions that may block
+    // in drivers. It is never destroyed. Its workers run the CPU steps of those
+    // executions directly, so they have the same stack size.
+    static ExecutionThreadPool& getForDriverWaits();
+
+    // Returns true if the calling thread is a worker of any pool.
+    static bool isWorkerThread();
+
+    // If the calling thread is a worker and a task of a higher priority than
+    // the one it is running waits for a worker that is not available, runs
+    // that task now. Does nothing otherwise. Must only be called when the
+    // calling task holds no locks that other tasks may need.
+    static void preemptionPoint();
+
+    ExecutionThreadPool(uint32_t maxWorkers, size_t stackSize);
+
+    // Runs the tasks that are still queued, then joins the workers.
+    ~ExecutionThreadPool();
+
+    ExecutionThreadPool(const ExecutionThreadPool&) = delete;
+    ExecutionThreadPool& operator=(const ExecutionThreadPool&) = delete;
+
+    // Queues task to be run by a worker.
+    void schedule(Priority priority, const OptionalTimePoint& deadline, Task task);
+
+    // Runs task on a worker and waits for it to finish. If the calling thread
+    // is already a worker, runs task directly: the caller already has a large
+    // stack, and waiting for another worker could deadlock a saturated pool.
+    void runAndWait(Priority priority, const OptionalTimePoint& deadline, const Task& task);
+
+    uint32_t getMaxWorkerCount() const { return kMaxWorkers; }
+    uint32_t getWorkerCount() const;
+    LaneStats getLaneStats(Priority priority) const;
+
+   private:
+    using WaitClock = std::chrono::steady_clock;
+
+    struct QueuedTask {
+        Task task;
+        WaitClock::time_point scheduledAt;
+    };
+
+    // What the calling worker thread is running.
+    struct WorkerState {
+        ExecutionThreadPool* pool = nullptr;
+        size_t lane = 0;
+        uint32_t preemptionDepth = 0;
+    };
+    static thread_local WorkerState tWorkerState;
+
+    static constexpr size_t kLaneCount = 3;
+    static size_t getLane(Priority priority);
+    static void* workerMain(void* pool);
+
+    void runWorker();
+    // Returns true if a task was taken, or false if the pool is stopping.
+    bool takeTask(QueuedTask* task, size_t* lane);
+    // Takes the most urgent task of a lane above minLane, if every worker is
+    // busy. Returns false if there is no such task.
+    bool takePreemptingTask(size_t minLane, QueuedTask* task, size_t* lane);
+    // Removes the most urgent task of a non-empty lane and records its wait.
+    QueuedTask popTaskLocked(size_t lane) REQUIRES(mMutex);
+    // Returns false if the thread could not be created.
+    bool spawnWorkerLocked() REQUIRES(mMutex);
+
+    const uint32_t kMaxWorkers;
+    const size_t kStackSize;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mTaskAvailable;
+    // Indexed by getLane(). Within a lane, tasks are keyed by deadline, with
+    // TimePoint::max() for tasks without one. std::multimap keeps tasks with
+    // equal keys in insertion order.
+    std::array<std::multimap<TimePoint, QueuedTask>, kLaneCount> mLanes GUARDED_BY(mMutex);
+    std::array<LaneStats, kLaneCount> mLaneStats GUARDED_BY(mMutex);
+    // Lets preemptionPoint() check for waiting tasks without locking.
+    std::array<std::atomic<size_t>, kLaneCount> mQueueDepths = {};
+    size_t mQueuedTaskCount GUARDED_BY(mMutex) = 0;
+    uint32_t mIdleWorkerCount GUARDED_BY(mMutex) = 0;
+    std::vector<pthread_t> mWorkers GUARDED_BY(mMutex);
+    bool mStopping GUARDED_BY(mMutex) = false;
+};
+
+}  // namespace nn
+}  // namespace android
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_EXECUTION_THREAD_POOL_H
@@ -19,6 +19,7 @@
 #include "Manager.h"
 
 #include <CpuExecutor.h>
+#include <CpuModelOptimizer.h>
 #include <LegacyUtils.h>
 #include <MetaModel.h>
 #include <Tracing.h>
@@ -45,6 +46,7 @@
 #include <vector>
 
 #include "ExecutionCallback.h"
+#include "ExecutionThreadPool.h"
 #include "Memory.h"
 #include "ModelArgumentInfo.h"
 #include "ServerFlag.h"
@@ -196,7 +198,8 @@ class DriverPreparedModel : public RuntimePreparedModel {
             const std::vector<const RuntimeMemory*>& memories, const SharedBurst& burstController,
             MeasureTiming measure, const OptionalTimePoint& deadline,
             const OptionalDuration& loopTimeoutDuration,
-            const std::vector<TokenValuePair>& metaData) const override;
+            const std::vector<TokenValuePair>& metaData,
+            const CancellationToken* cancellationToken) const override;
 
     std::tuple<int, int, ExecuteFencedInfoCallback, Timing> executeFenced(
             const std::vector<ModelArgumentInfo>& inputs,
@@ -250,7 +253,8 @@ class DriverExecution : public RuntimeExecution {
     }
 
     std::tuple<int, std::vector<OutputShape>, Timing> compute(
-            const SharedBurst& burstController, const OptionalTimePoint& deadline) const override;
+            const SharedBurst& burstController, const OptionalTimePoint& deadline,
+            const CancellationToken* cancellationToken) const override;
 
     std::tuple<int, int, ExecuteFencedInfoCallback, Timing> computeFenced(
             const std::vector<int>& waitFor, const OptionalTimePoint& deadline,
@@ -551,7 +555,7 @@ std::pair<int, std::unique_ptr<RuntimeMemory>> DriverDevice::allocate(const Memo
                    << " failed!";
         return {convertErrorStatusToResultCode(result.error().code), nullptr};
     }
-    return MemoryFromDevice::create(std::move(result).value());
+    return MemoryFromDevice::create(std::move(result).value(), kInterface);
 }
 
 static Request createDriverRequest(const std::vector<ModelArgumentInfo>& inputs,
@@ -580,8 +584,8 @@ std::tuple<int, std::vector<OutputShape>, Timing> DriverPreparedModel::execute(
         const std::vector<ModelArgumentInfo>& inputs, const std::vector<ModelArgumentInfo>& outputs,
         const std::vector<const RuntimeMemory*>& memories, const SharedBurst& burstController,
         MeasureTiming measure, const OptionalTimePoint& deadline,
-        const OptionalDuration& loopTimeoutDuration,
-        const std::vector<TokenValuePair>& metaData) const {
+        const OptionalDuration& loopTimeoutDuration, const std::vector<TokenValuePair>& metaData,
+        const CancellationToken* /*cancellationToken*/) const {
     NNTRACE_RT(NNTRACE_PHASE_INPUTS_AND_OUTPUTS, "DriverPreparedModel::execute");
 
     auto request = createDriverRequest(inputs, outputs, memories);
@@ -731,7 +735,8 @@ std::pair<int, std::shared_ptr<RuntimeExecution>> DriverPreparedModel::createReu
 }
 
 std::tuple<int, std::vector<OutputShape>, Timing> DriverExecution::compute(
-        const SharedBurst& burstController, const OptionalTimePoint& deadline) const {
+        const SharedBurst& burstController, const OptionalTimePoint& deadline,
+        const CancellationToken* /*cancellationToken*/) const {
     NNTRACE_RT(NNTRACE_PHASE_EXECUTION, "DriverExecution::compute");
 
     // compute using burst if present, otherwise compute from IPreparedModel
@@ -923,7 +928,8 @@ class CpuPreparedModel : public RuntimePreparedModel {
     // Factory method for CpuPreparedModel. Returns ANEURALNETWORKS_NO_ERROR and
     // a prepared model object if successfully created. Returns an error code
     // and nullptr otherwise.
-    static std::pair<int, std::shared_ptr<RuntimePreparedModel>> create(Model model);
+    static std::pair<int, std::shared_ptr<RuntimePreparedModel>> create(Model model,
+                                                                        Priority priority);
 
     const Device* getDevice() const override { return CpuDevice::get().get(); }
     SharedPreparedModel getInterface() const override { return nullptr; }
@@ -934,7 +940,8 @@ class CpuPreparedModel : public RuntimePreparedModel {
             const std::vector<const RuntimeMemory*>& memories, const SharedBurst& burstController,
             MeasureTiming measure, const OptionalTimePoint& deadline,
             const OptionalDuration& loopTimeoutDuration,
-            const std::vector<TokenValuePair>& metaData) const override;
+            const std::vector<TokenValuePair>& metaData,
+            const CancellationToken* cancellationToken) const override;
 
     GeneralResult<SharedBurst> configureExecutionBurst() const override { return nullptr; }
 
@@ -959,11 +966,13 @@ class CpuPreparedModel : public RuntimePreparedModel {
     }
 
     // Prefer to use CpuPreparedModel::create.
-    CpuPreparedModel(Model model, std::vector<RunTimePoolInfo> poolInfos)
-        : mModel(std::move(model)), mModelPoolInfos(std::move(poolInfos)) {}
+    CpuPreparedModel(Model model, std::vector<RunTimePoolInfo> poolInfos, Priority priority)
+        : mModel(std::move(model)), mModelPoolInfos(std::move(poolInfos)), mPriority(priority) {}
 
     const Model& getModel() const { return mModel; }
     const std::vector<RunTimePoolInfo>& getModelPoolInfos() const { return mModelPoolInfos; }
+    // The lane of ExecutionThreadPool that executions run in.
+    Priority getPriority() const { return mPriority; }
 
    private:
     // TFLite kernels prefers 64 bytes for padding and alignment.
@@ -972,6 +981,7 @@ class CpuPreparedModel : public RuntimePreparedModel {
 
     const Model mModel;
     const std::vector<RunTimePoolInfo> mModelPoolInfos;
+    const Priority mPriority;
 };
 
 class CpuExecution : public RuntimeExecution {
@@ -985,7 +995,8 @@ class CpuExecution : public RuntimeExecution {
           kLoopTimeoutDuration(std::move(loopTimeoutDuration)) {}
 
     std::tuple<int, std::vector<OutputShape>, Timing> compute(
-            const SharedBurst& burstController, const OptionalTimePoint& deadline) const override;
+            const SharedBurst& burstController, const OptionalTimePoint& deadline,
+            const CancellationToken* cancellationToken) const override;
 
     std::tuple<int, int, ExecuteFencedInfoCallback, Timing> computeFenced(
             const std::vector<int>& waitFor, const OptionalTimePoint& deadline,
@@ -1049,7 +1060,7 @@ std::pair<int, std::shared_ptr<RuntimePreparedModel>> CpuDevice::prepareModel(
         return {ANEURALNETWORKS_MISSED_DEADLINE_PERSISTENT, nullptr};
     }
 
-    return CpuPreparedModel::create(model);
+    return CpuPreparedModel::create(model, priority);
 }
 
 std::pair<int, std::unique_ptr<RuntimeMemory>> CpuDevice::allocate(const MemoryDescriptor& desc,
@@ -1062,14 +1073,19 @@ std::pair<int, std::unique_ptr<RuntimeMemory>> CpuDevice::allocate(const MemoryD
     return MemoryAshmem::create(size);
 }
 
-std::pair<int, std::shared_ptr<RuntimePreparedModel>> CpuPreparedModel::create(Model model) {
+std::pair<int, std::shared_ptr<RuntimePreparedModel>> CpuPreparedModel::create(
+        Model model, Priority priority) {
     std::vector<RunTimePoolInfo> poolInfos;
     if (!setRunTimePoolInfosFromCanonicalMemories(&poolInfos, model.pools)) {
         return {ANEURALNETWORKS_UNMAPPABLE, nullptr};
     }
+    const CpuModelOptimizationStats stats = optimizeModelForCpu(&model, poolInfos);
+    VLOG(COMPILATION) << "CpuPreparedModel::create folded " << stats.foldedOperations
+                      << " operations and hoisted " << stats.hoistedOperations
+                      << " operations out of loops";
 
     std::shared_ptr<RuntimePreparedModel> preparedModel =
-            std::make_shared<CpuPreparedModel>(std::move(model), std::move(poolInfos));
+            std::make_shared<CpuPreparedModel>(std::move(model), std::move(poolInfos), priority);
     return {ANEURALNETWORKS_NO_ERROR, std::move(preparedModel)};
 }
 
@@ -1077,7 +1093,7 @@ static std::tuple<int, std::vector<OutputShape>, Timing> computeOnCpu(
         const Model& model, const Request& request,
         const std::vector<RunTimePoolInfo>& modelPoolInfos,
         const std::vector<RunTimePoolInfo>& requestPoolInfos, const OptionalTimePoint& deadline,
-        const OptionalDuration& loopTimeoutDuration) {
+        const OptionalDuration& loopTimeoutDuration, const CancellationToken* cancellationToken) {
     NNTRACE_RT(NNTRACE_PHASE_EXECUTION, "computeOnCpu");
     CpuExecutor executor;
     if (loopTimeoutDuration.has_value()) {
@@ -1086,6 +1102,10 @@ static std::tuple<int, std::vector<OutputShape>, Timing> computeOnCpu(
     if (deadline.has_value()) {
         executor.setDeadline(*deadline);
     }
+    executor.setCancellationToken(cancellationToken);
+    if (ExecutionThreadPool::isWorkerThread()) {
+        executor.setOperationBoundaryCallback(&ExecutionThreadPool::preemptionPoint);
+    }
     int err = executor.run(model, request, modelPoolInfos, requestPoolInfos);
     const auto& outputShapes = executor.getOutputShapes();
     return {err, outputShapes, {}};
@@ -1118,8 +1138,9 @@ std::tuple<int, int, ExecuteFencedInfoCallback, Timing> CpuPreparedModel::execut
         }
     }
 
-    const auto [result, outputShapes, timing] = execute(inputs, outputs, memories, nullptr, measure,
-                                                        closestDeadline, loopTimeoutDuration, {});
+    const auto [result, outputShapes, timing] =
+            execute(inputs, outputs, memories, nullptr, measure, closestDeadline,
+                    loopTimeoutDuration, {}, /*cancellationToken=*/nullptr);
     return {result, -1, nullptr, timing};
 }
 
@@ -1173,7 +1194,8 @@ std::tuple<int, std::vector<OutputShape>, Timing> CpuPreparedModel::execute(
         const std::vector<const RuntimeMemory*>& memories, const SharedBurst& /*burstController*/,
         MeasureTiming /*measure*/, const OptionalTimePoint& deadline,
         const OptionalDuration& loopTimeoutDuration,
-        const std::vector<TokenValuePair>& /*metaData*/) const {
+        const std::vector<TokenValuePair>& /*metaData*/,
+        const CancellationToken* cancellationToken) const {
     if (hasDeadlinePassed(deadline)) {
         return {ANEURALNETWORKS_MISSED_DEADLINE_PERSISTENT, {}, {}};
     }
@@ -1188,19 +1210,18 @@ std::tuple<int, std::vector<OutputShape>, Timing> CpuPreparedModel::execute(
     }
 
     if (!DeviceManager::get()->syncExecCpu()) {
-        // TODO: use a thread pool
-        // TODO(mikie): this could have NNTRACE so we could measure the overhead
-        //              of spinning up a new thread.
         std::tuple<int, std::vector<OutputShape>, Timing> result = {};
-        std::thread([this, &request, &requestPoolInfos, &deadline, &loopTimeoutDuration, &result] {
+        const auto compute = [this, &request, &requestPoolInfos, &deadline, &loopTimeoutDuration,
+                              cancellationToken, &result] {
             result = computeOnCpu(mModel, request, mModelPoolInfos, requestPoolInfos, deadline,
-                                  loopTimeoutDuration);
-        }).join();
+                                  loopTimeoutDuration, cancellationToken);
+        };
+        ExecutionThreadPool::get().runAndWait(mPriority, deadline, compute);
         return result;
     }
 
     return computeOnCpu(mModel, request, mModelPoolInfos, requestPoolInfos, deadline,
-                        loopTimeoutDuration);
+                        loopTimeoutDuration, cancellationToken);
 }
 
 std::pair<int, std::shared_ptr<RuntimeExecution>> CpuPreparedModel::createReusableExecution(
@@ -1218,26 +1239,25 @@ std::pair<int, std::shared_ptr<RuntimeExecution>> CpuPreparedModel::createReusab
 }
 
 std::tuple<int, std::vector<OutputShape>, Timing> CpuExecution::compute(
-        const SharedBurst& /*burstController*/, const OptionalTimePoint& deadline) const {
+        const SharedBurst& /*burstController*/, const OptionalTimePoint& deadline,
+        const CancellationToken* cancellationToken) const {
     if (hasDeadlinePassed(deadline)) {
         return {ANEURALNETWORKS_MISSED_DEADLINE_PERSISTENT, {}, {}};
     }
 
     if (!DeviceManager::get()->syncExecCpu()) {
-        // TODO: use a thread pool
-        // TODO(mikie): this could have NNTRACE so we could measure the overhead
-        //              of spinning up a new thread.
         std::tuple<int, std::vector<OutputShape>, Timing> result = {};
-        std::thread([this, &deadline, &result] {
+        const auto compute = [this, &deadline, cancellationToken, &result] {
             result = computeOnCpu(kPreparedModel.getModel(), kRequest,
                                   kPreparedModel.getModelPoolInfos(), kRequestPoolInfos, deadline,
-                                  kLoopTimeoutDuration);
-        }).join();
+                                  kLoopTimeoutDuration, cancellationToken);
+        };
+        ExecutionThreadPool::get().runAndWait(kPreparedModel.getPriority(), deadline, compute);
         return result;
     }
 
     return computeOnCpu(kPreparedModel.getModel(), kRequest, kPreparedModel.getModelPoolInfos(),
-                        kRequestPoolInfos, deadline, kLoopTimeoutDuration);
+                        kRequestPoolInfos, deadline, kLoopTimeoutDuration, cancellationToken);
 }
 
 std::tuple<int, int, ExecuteFencedInfoCallback, Timing> CpuExecution::computeFenced(
@@ -1264,7 +1284,8 @@ std::tuple<int, int, ExecuteFencedInfoCallback, Timing> CpuExecution::computeFen
         }
     }
 
-    const auto [result, outputShapes, timing] = compute(nullptr, closestDeadline);
+    const auto [result, outputShapes, timing] =
+            compute(nullptr, closestDeadline, /*cancellationToken=*/nullptr);
     return {result, -1, nullptr, timing};
 }
 
@@ -1369,6 +1390,7 @@ DeviceManager::DeviceManager() {
     mDebugNNCpuOnly = (getProp("debug.nn.cpuonly") != 0);
     mSyncExecCpu = (getProp("debug.nn.syncexec-cpu", 1) != 0);
     mSyncExecRuntime = (getProp("debug.nn.syncexec-runtime") != 0);
+    mFuseCpuControlFlow = (getProp("debug.nn.fuse-cpu-control-flow", 1) != 0);
 #endif  // NN_DEBUGGABLE
 }
 
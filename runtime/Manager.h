@@ -17,6 +17,7 @@
 #ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_MANAGER_H
 #define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_MANAGER_H
 
+#include <CancellationToken.h>
 #include <LegacyUtils.h>
 #include <android-base/macros.h>
 #include <nnapi/IBurst.h>
@@ -54,8 +55,12 @@ class RuntimeExecution {
     RuntimeExecution() = default;
     virtual ~RuntimeExecution() = default;
 
+    // The computation stops early with ANEURALNETWORKS_OP_FAILED if cancellationToken is not
+    // nullptr and is cancelled while it runs. Only the CPU polls the token; a driver execution runs
+    // to completion.
     virtual std::tuple<int, std::vector<OutputShape>, Timing> compute(
-            const SharedBurst& burstController, const OptionalTimePoint& deadline) const = 0;
+            const SharedBurst& burstController, const OptionalTimePoint& deadline,
+            const CancellationToken* cancellationToken) const = 0;
 
     // The returned timing information is only valid if the callback is nullptr.
     // Returns error_code, sync_fence, callback and timing.
@@ -76,13 +81,15 @@ class RuntimePreparedModel {
     virtual SharedPreparedModel getInterface() const = 0;
 
     // Perform computation with given input/output argument info and memory pools.
+    // cancellationToken, if not nullptr, is polled as in RuntimeExecution::compute.
     virtual std::tuple<int, std::vector<OutputShape>, Timing> execute(
             const std::vector<ModelArgumentInfo>& inputs,
             const std::vector<ModelArgumentInfo>& outputs,
             const std::vector<const RuntimeMemory*>& memories, const SharedBurst& burstController,
             MeasureTiming measure, const OptionalTimePoint& deadline,
             const OptionalDuration& loopTimeoutDuration,
-            const std::vector<TokenValuePair>& metaData) const = 0;
+            const std::vector<TokenValuePair>& metaData,
+            const CancellationToken* cancellationToken) const = 0;
 
     // Perform fenced computation with given input/output argument info and memory pools.
     // The returned timing information is only valid if the callback is nullptr.
@@ -206,6 +213,16 @@ class DeviceManager {
 
     bool strictSlicing() const { return mStrictSlicing; }
 
+    // Whether an IF or WHILE operation whose referenced models run entirely on
+    // the CPU is executed by the CPU device, rather than interpreted by the
+    // runtime (see ModelBuilder::findBestDeviceForEachOperation).
+    bool fuseCpuControlFlow() const { return mFuseCpuControlFlow; }
+
+    // For testing only:
+    void setFuseCpuControlFlow(bool fuseCpuControlFlow) {
+        mFuseCpuControlFlow = fuseCpuControlFlow;
+    }
+
     // Returns the singleton manager.
     static DeviceManager* get();
 
@@ -274,6 +291,8 @@ class DeviceManager {
     uint32_t mPartitioning = kPartitioningDefault;
 
     bool mStrictSlicing = false;
+
+    bool mFuseCpuControlFlow = true;  // system property debug.nn.fuse-cpu-control-flow
 };
 
 std::vector<SharedDevice> getDevices();
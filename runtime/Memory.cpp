@@ -20,6 +20,7 @@
 
 #include <CpuExecutor.h>
 #include <LegacyUtils.h>
+#include <android-base/no_destructor.h>
 #include <android-base/scopeguard.h>
 #include <nnapi/IBurst.h>
 #include <nnapi/SharedMemory.h>
@@ -28,7 +29,11 @@
 #include <nnapi/Validation.h>
 
 #include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <tuple>
 #include <utility>
@@ -208,10 +213,32 @@ std::optional<RunTimePoolInfo> RuntimeMemory::getRunTimePoolInfo() const {
     if (!mHasCachedRunTimePoolInfo) {
         mCachedRunTimePoolInfo = RunTimePoolInfo::createFromMemory(kMemory);
         mHasCachedRunTimePoolInfo = true;
+        ++mMappingStats.mapCount;
     }
     return mCachedRunTimePoolInfo;
 }
 
+void RuntimeMemory::releaseRunTimePoolInfo() const {
+    std::optional<RunTimePoolInfo> released;
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        if (!mHasCachedRunTimePoolInfo) {
+            return;
+        }
+        released = std::move(mCachedRunTimePoolInfo);
+        mCachedRunTimePoolInfo.reset();
+        mHasCachedRunTimePoolInfo = false;
+        ++mMappingStats.releaseCount;
+    }
+    // If this was the last reference, the memory is unmapped here, outside of
+    // the lock.
+}
+
+RuntimeMemory::MappingStats RuntimeMemory::getMappingStats() const {
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mMappingStats;
+}
+
 void RuntimeMemory::hold(const IBurst::OptionalCacheHold& cacheHold) const {
     if (cacheHold != nullptr) {
         std::lock_guard<std::mutex> guard(mMutex);
@@ -255,18 +282,119 @@ int copyMemoryToIBuffer(const SharedMemory& src, const SharedBuffer& dst,
     return ANEURALNETWORKS_NO_ERROR;
 }
 
-static int copyIBuffers(const SharedBuffer& src, const SharedBuffer& dst,
-                        const MemoryValidatorBase::Metadata& srcMetadata) {
+namespace {
+
+// See RuntimeMemory::DeviceCopyOptions.
+std::atomic<bool> gAllowDirectCopy = true;
+std::atomic<bool> gReuseStagingMemory = true;
+
+// See RuntimeMemory::DeviceCopyStats.
+std::atomic<uint64_t> gDirectCopyCount = 0;
+std::atomic<uint64_t> gStagingCopyCount = 0;
+std::atomic<uint64_t> gStagingAllocationCount = 0;
+
+// The shared memories that copies between two driver-allocated buffers go
+// through, when the buffers cannot be copied directly. A memory is taken out of
+// the pool for the duration of a copy, so concurrent copies never share one.
+// Drivers require the shared memory to have exactly the size of the buffer, so
+// the memories are kept by size. At most getMaxIdleBytes() are kept, the
+// largest memories being dropped first.
+class StagingMemoryPool {
+   public:
+    static StagingMemoryPool& get() {
+        static base::NoDestructor<StagingMemoryPool> pool;
+        return *pool;
+    }
+
+    static std::pair<int, std::unique_ptr<RuntimeMemory>> allocate(uint32_t size) {
+        ++gStagingAllocationCount;
 #ifdef __ANDROID__
-    const auto [n, runtimeMemory] = MemoryRuntimeAHWB::create(srcMetadata.logicalSize);
+        auto [n, memory] = MemoryRuntimeAHWB::create(size);
 #else   // __ANDROID__
-    const auto [n, runtimeMemory] = MemoryAshmem::create(srcMetadata.logicalSize);
+        auto [n, memory] = MemoryAshmem::create(size);
 #endif  // __ANDROID__
+        return {n, std::move(memory)};
+    }
+
+    // Returns an idle memory of the given size, or allocates a new one.
+    std::pair<int, std::unique_ptr<RuntimeMemory>> acquire(uint32_t size) {
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            if (const auto it = mIdleMemories.find(size); it != mIdleMemories.end()) {
+                std::unique_ptr<RuntimeMemory> memory = std::move(it->second);
+                mIdleMemories.erase(it);
+                mIdleBytes -= size;
+                return {ANEURALNETWORKS_NO_ERROR, std::move(memory)};
+            }
+        }
+        return allocate(size);
+    }
+
+    // Keeps a memory returned by acquire() for a later copy.
+    void release(uint32_t size, std::unique_ptr<RuntimeMemory> memory) {
+        // Freed outside of the lock.
+        std::vector<std::unique_ptr<RuntimeMemory>> evicted;
+        std::lock_guard<std::mutex> guard(mMutex);
+        if (size > mMaxIdleBytes) return;
+        while (mIdleBytes + size > mMaxIdleBytes) {
+            const auto largest = std::prev(mIdleMemories.end());
+            mIdleBytes -= largest->first;
+            evicted.push_back(std::move(largest->second));
+            mIdleMemories.erase(largest);
+        }
+        mIdleBytes += size;
+        mIdleMemories.emplace(size, std::move(memory));
+    }
+
+    // Drops the idle memories and sets the most bytes that are kept idle.
+    void reset(size_t maxIdleBytes) {
+        std::multimap<uint32_t, std::unique_ptr<RuntimeMemory>> idleMemories;
+        std::lock_guard<std::mutex> guard(mMutex);
+        mIdleMemories.swap(idleMemories);
+        mIdleBytes = 0;
+        mMaxIdleBytes = maxIdleBytes;
+    }
+
+    size_t getIdleBytes() {
+        std::lock_guard<std::mutex> guard(mMutex);
+        return mIdleBytes;
+    }
+
+   private:
+    std::mutex mMutex;
+    std::multimap<uint32_t, std::unique_ptr<RuntimeMemory>> mIdleMemories;
+    size_t mIdleBytes = 0;
+    size_t mMaxIdleBytes = RuntimeMemory::kMaxIdleStagingBytes;
+};
+
+}  // namespace
+
+static int copyIBuffers(const RuntimeMemory& src, const RuntimeMemory& dst,
+                        const MemoryValidatorBase::Metadata& srcMetadata) {
+    const IDevice* device = src.getIBufferDevice();
+    if (gAllowDirectCopy && device != nullptr && device == dst.getIBufferDevice()) {
+        const auto ret = src.getIBuffer()->copyToBuffer(*dst.getIBuffer(), srcMetadata.dimensions);
+        if (ret.has_value()) {
+            ++gDirectCopyCount;
+            return ANEURALNETWORKS_NO_ERROR;
+        }
+        VLOG(MEMORY) << "ANeuralNetworksMemory_copy -- direct copy failed, fallback to a "
+                     << "staging memory: " << ret.error().message;
+    }
+
+    ++gStagingCopyCount;
+    const uint32_t size = srcMetadata.logicalSize;
+    const bool reuseStagingMemory = gReuseStagingMemory;
+    auto [n, runtimeMemory] = reuseStagingMemory ? StagingMemoryPool::get().acquire(size)
+                                                 : StagingMemoryPool::allocate(size);
     NN_RETURN_IF_ERROR(n);
     const SharedMemory& memory = runtimeMemory->getMemory();
     if (!validate(memory).ok()) return ANEURALNETWORKS_OUT_OF_MEMORY;
-    NN_RETURN_IF_ERROR(copyIBufferToMemory(src, memory));
-    NN_RETURN_IF_ERROR(copyMemoryToIBuffer(memory, dst, srcMetadata.dimensions));
+    NN_RETURN_IF_ERROR(copyIBufferToMemory(src.getIBuffer(), memory));
+    NN_RETURN_IF_ERROR(copyMemoryToIBuffer(memory, dst.getIBuffer(), srcMetadata.dimensions));
+    if (reuseStagingMemory) {
+        StagingMemoryPool::get().release(size, std::move(runtimeMemory));
+    }
     return ANEURALNETWORKS_NO_ERROR;
 }
 
@@ -289,7 +417,7 @@ static int copyInternal(const RuntimeMemory& src, const RuntimeMemory& dst) {
     bool srcHasIBuffer = src.getIBuffer() != nullptr;
     bool dstHasIBuffer = dst.getIBuffer() != nullptr;
     if (srcHasIBuffer && dstHasIBuffer) {
-        return copyIBuffers(src.getIBuffer(), dst.getIBuffer(), srcMetadata);
+        return copyIBuffers(src, dst, srcMetadata);
     } else if (srcHasMemory && dstHasMemory) {
         return copyHidlMemories(src.getRunTimePoolInfo(), dst.getRunTimePoolInfo());
     } else if (srcHasMemory && dstHasIBuffer) {
@@ -306,6 +434,22 @@ int RuntimeMemory::copy(const RuntimeMemory& src, const RuntimeMemory& dst) {
     return n;
 }
 
+void RuntimeMemory::forTest_setDeviceCopyOptions(const DeviceCopyOptions& options) {
+    gAllowDirectCopy = options.allowDirectCopy;
+    gReuseStagingMemory = options.reuseStagingMemory;
+    StagingMemoryPool::get().reset(options.maxIdleStagingBytes);
+    gDirectCopyCount = 0;
+    gStagingCopyCount = 0;
+    gStagingAllocationCount = 0;
+}
+
+RuntimeMemory::DeviceCopyStats RuntimeMemory::forTest_getDeviceCopyStats() {
+    return {.directCopyCount = gDirectCopyCount,
+            .stagingCopyCount = gStagingCopyCount,
+            .stagingAllocationCount = gStagingAllocationCount,
+            .idleStagingBytes = StagingMemoryPool::get().getIdleBytes()};
+}
+
 bool MemoryBuilder::badState(const char* name) const {
     if (mFinished) {
         LOG(ERROR) << "ANeuralNetworksMemoryDesc_" << name << " can't modify after finished";
@@ -623,15 +767,18 @@ uint8_t* MemoryRuntimeAHWB::getPointer() const {
 MemoryRuntimeAHWB::MemoryRuntimeAHWB(SharedMemory memory, Mapping mapping)
     : RuntimeMemory(std::move(memory)), kMapping(std::move(mapping)) {}
 
-std::pair<int, std::unique_ptr<MemoryFromDevice>> MemoryFromDevice::create(SharedBuffer buffer) {
+std::pair<int, std::unique_ptr<MemoryFromDevice>> MemoryFromDevice::create(SharedBuffer buffer,
+                                                                           SharedDevice device) {
     if (buffer == nullptr) {
         LOG(ERROR) << "nullptr IBuffer for device memory.";
         return {ANEURALNETWORKS_OP_FAILED, nullptr};
     }
-    return {ANEURALNETWORKS_NO_ERROR, std::make_unique<MemoryFromDevice>(std::move(buffer))};
+    return {ANEURALNETWORKS_NO_ERROR,
+            std::make_unique<MemoryFromDevice>(std::move(buffer), std::move(device))};
 }
 
-MemoryFromDevice::MemoryFromDevice(SharedBuffer buffer) : RuntimeMemory(std::move(buffer)) {}
+MemoryFromDevice::MemoryFromDevice(SharedBuffer buffer, SharedDevice device)
+    : RuntimeMemory(std::move(buffer)), kDevice(std::move(device)) {}
 
 }  // namespace nn
 }  // namespace android
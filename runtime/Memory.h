@@ -175,9 +175,27 @@ class RuntimeMemory {
     Request::MemoryPool getMemoryPool() const;
     const SharedMemory& getMemory() const { return kMemory; }
     const SharedBuffer& getIBuffer() const { return kBuffer; }
+    // The driver device that allocated getIBuffer(), or nullptr if unknown.
+    virtual const IDevice* getIBufferDevice() const { return nullptr; }
     virtual uint32_t getSize() const { return nn::getSize(getMemory()); }
+    // Maps the memory on first use, and returns the same mapping until
+    // releaseRunTimePoolInfo() is called, so that repeated executions against
+    // the memory do not map it again. Thread-safe.
     virtual std::optional<RunTimePoolInfo> getRunTimePoolInfo() const;
 
+    // Drops the mapping cached by getRunTimePoolInfo(). The memory is unmapped
+    // once the executions in flight that use the mapping are done, and mapped
+    // again by the next call to getRunTimePoolInfo(). Thread-safe.
+    void releaseRunTimePoolInfo() const;
+
+    // Number of times getRunTimePoolInfo() mapped the memory and
+    // releaseRunTimePoolInfo() released a mapping. For testing.
+    struct MappingStats {
+        uint32_t mapCount = 0;
+        uint32_t releaseCount = 0;
+    };
+    MappingStats getMappingStats() const;
+
     MemoryValidatorBase& getValidator() const {
         CHECK(mValidator != nullptr);
         return *mValidator;
@@ -194,6 +212,35 @@ class RuntimeMemory {
 
     static int copy(const RuntimeMemory& src, const RuntimeMemory& dst);
 
+    // The most staging memory that copy() keeps idle for reuse, by default.
+    static constexpr size_t kMaxIdleStagingBytes = 128 * 1024 * 1024;
+
+    // How copy() moves data between two driver-allocated buffers. By default, it
+    // asks the driver to copy directly when both buffers were allocated by the same
+    // device, and otherwise goes through a staging memory that is kept for reuse by
+    // later copies of the same size. For testing and benchmarking.
+    struct DeviceCopyOptions {
+        bool allowDirectCopy = true;
+        bool reuseStagingMemory = true;
+        size_t maxIdleStagingBytes = kMaxIdleStagingBytes;
+    };
+    // Also drops the idle staging memories and clears the DeviceCopyStats.
+    static void forTest_setDeviceCopyOptions(const DeviceCopyOptions& options);
+
+    // What copy() did between two driver-allocated buffers since the last call
+    // to forTest_setDeviceCopyOptions(). For testing.
+    struct DeviceCopyStats {
+        // Copies that the driver did directly.
+        uint64_t directCopyCount = 0;
+        // Copies through a staging memory, and the staging memories allocated
+        // for them.
+        uint64_t stagingCopyCount = 0;
+        uint64_t stagingAllocationCount = 0;
+        // Bytes of staging memory currently kept for reuse.
+        size_t idleStagingBytes = 0;
+    };
+    static DeviceCopyStats forTest_getDeviceCopyStats();
+
    protected:
     explicit RuntimeMemory(SharedMemory memory);
     RuntimeMemory(SharedMemory memory, std::unique_ptr<MemoryValidatorBase> validator);
@@ -215,6 +262,7 @@ class RuntimeMemory {
 
     mutable std::optional<RunTimePoolInfo> mCachedRunTimePoolInfo;
     mutable bool mHasCachedRunTimePoolInfo = false;
+    mutable MappingStats mMappingStats;
 };
 
 class MemoryBuilder {
@@ -349,10 +397,16 @@ class MemoryFromDevice : public RuntimeMemory {
     //
     // On success, returns ANEURALNETWORKS_NO_ERROR and a memory object.
     // On error, returns the appropriate NNAPI error code and nullptr.
-    static std::pair<int, std::unique_ptr<MemoryFromDevice>> create(SharedBuffer buffer);
+    static std::pair<int, std::unique_ptr<MemoryFromDevice>> create(SharedBuffer buffer,
+                                                                    SharedDevice device);
 
     // prefer using MemoryFromDevice::create
-    explicit MemoryFromDevice(SharedBuffer buffer);
+    MemoryFromDevice(SharedBuffer buffer, SharedDevice device);
+
+    const IDevice* getIBufferDevice() const override { return kDevice.get(); }
+
+   private:
+    const SharedDevice kDevice;
 };
 
 using MemoryTracker = ObjectTracker<RuntimeMemory>;
@@ -18,10 +18,17 @@
 
 #include "ModelArchHasher.h"
 
+#include <CpuExecutor.h>
+#include <FastHash.h>
 #include <android-base/logging.h>
+#include <nnapi/TypeUtils.h>
 #include <nnapi/Types.h>
 #include <openssl/sha.h>
 
+#include <optional>
+#include <variant>
+#include <vector>
+
 namespace android::nn {
 
 namespace {
@@ -30,62 +37,173 @@ bool update(SHA256_CTX* hasher, const void* bytes, size_t length) {
     return SHA256_Update(hasher, bytes, length) != 0;
 }
 
-bool updateSubgraph(SHA256_CTX* hasher, const Model::Subgraph& subgraph) {
-    bool success = true;
+// Appends extraParams by value. Its object representation holds heap
+// pointers, which would make the hash differ between processes.
+void appendExtraParams(HashBuffer* buffer, const Operand::ExtraParams& extraParams) {
+    buffer->append(static_cast<uint32_t>(extraParams.index()));
+    if (const auto* params = std::get_if<Operand::SymmPerChannelQuantParams>(&extraParams)) {
+        buffer->append(params->scales);
+        buffer->append(params->channelDim);
+    } else if (const auto* params = std::get_if<Operand::ExtensionParams>(&extraParams)) {
+        buffer->append(*params);
+    }
+}
+
+// Appends the fields of subgraph that determine its architecture to buffer.
+// Counts and vectors are preceded by their lengths, so that two different
+// subgraphs never append the same bytes.
+void appendSubgraph(HashBuffer* buffer, const Model::Subgraph& subgraph) {
+    buffer->append(static_cast<uint64_t>(subgraph.operands.size()));
     for (auto& operand : subgraph.operands) {
-        success &= update(hasher, static_cast<const void*>(&operand.type), sizeof(operand.type));
-        success &= update(
-                hasher, static_cast<const void*>(operand.dimensions.data()),
-                sizeof(decltype(operand.dimensions)::value_type) * operand.dimensions.size());
-        success &= update(hasher, static_cast<const void*>(&operand.scale), sizeof(operand.scale));
-        success &= update(hasher, static_cast<const void*>(&operand.zeroPoint),
-                          sizeof(operand.zeroPoint));
-        success &= update(hasher, static_cast<const void*>(&operand.lifetime),
-                          sizeof(operand.lifetime));
-        success &= update(hasher, static_cast<const void*>(&operand.extraParams),
-                          sizeof(operand.extraParams));
+        buffer->append(operand.type);
+        buffer->append(operand.dimensions);
+        buffer->append(operand.scale);
+        buffer->append(operand.zeroPoint);
+        buffer->append(operand.lifetime);
+        appendExtraParams(buffer, operand.extraParams);
     }
 
+    buffer->append(static_cast<uint64_t>(subgraph.operations.size()));
     for (auto& operation : subgraph.operations) {
-        success &=
-                update(hasher, static_cast<const void*>(&operation.type), sizeof(operation.type));
-        success &= update(hasher, static_cast<const void*>(operation.inputs.data()),
-                          sizeof(decltype(operation.inputs)::value_type) * operation.inputs.size());
-        success &=
-                update(hasher, static_cast<const void*>(operation.outputs.data()),
-                       sizeof(decltype(operation.outputs)::value_type) * operation.outputs.size());
+        buffer->append(operation.type);
+        buffer->append(operation.inputs);
+        buffer->append(operation.outputs);
+    }
+
+    buffer->append(subgraph.inputIndexes);
+    buffer->append(subgraph.outputIndexes);
+}
+
+void appendModelArch(HashBuffer* buffer, const Model& model) {
+    // Roughly the per-operand and per-operation sizes appended above, to
+    // avoid regrowing the buffer.
+    size_t numOperands = model.main.operands.size();
+    size_t numOperations = model.main.operations.size();
+    for (auto& subgraph : model.referenced) {
+        numOperands += subgraph.operands.size();
+        numOperations += subgraph.operations.size();
     }
+    buffer->reserve(numOperands * (sizeof(Operand) + 4 * sizeof(uint32_t)) +
+                    numOperations * (sizeof(OperationType) + 4 * sizeof(uint32_t)));
+
+    appendSubgraph(buffer, model.main);
+    buffer->append(static_cast<uint64_t>(model.referenced.size()));
+    for (auto& subgraph : model.referenced) {
+        appendSubgraph(buffer, subgraph);
+    }
+}
+
+// Hashes the index and the length of a constant operand before its value, so
+// that the values of different operands are never concatenated into the same
+// bytes.
+bool updateOperandHeader(SHA256_CTX* hasher, uint32_t operandIndex, uint32_t length) {
+    const uint32_t header[] = {operandIndex, length};
+    return update(hasher, header, sizeof(header));
+}
 
-    success &= update(
-            hasher, static_cast<const void*>(subgraph.inputIndexes.data()),
-            sizeof(decltype(subgraph.inputIndexes)::value_type) * subgraph.inputIndexes.size());
-    success &= update(
-            hasher, static_cast<const void*>(subgraph.outputIndexes.data()),
-            sizeof(decltype(subgraph.outputIndexes)::value_type) * subgraph.outputIndexes.size());
+bool updateOperandValues(SHA256_CTX* hasher, const Model& model,
+                         const Model::Subgraph& subgraph,
+                         std::vector<std::optional<RunTimePoolInfo>>* poolInfos) {
+    const uint64_t operandCount = subgraph.operands.size();
+    bool success = update(hasher, &operandCount, sizeof(operandCount));
+    for (uint32_t i = 0; i < subgraph.operands.size(); ++i) {
+        const Operand& operand = subgraph.operands[i];
+        if (isExtension(operand.type)) {
+            VLOG(COMPILATION) << "calcModelWeightsDigest: extension operand type " << operand.type;
+            return false;
+        }
+        const DataLocation& location = operand.location;
+        switch (operand.lifetime) {
+            case Operand::LifeTime::CONSTANT_COPY:
+                if (location.offset + location.length > model.operandValues.size()) {
+                    return false;
+                }
+                success &= updateOperandHeader(hasher, i, location.length);
+                success &= update(hasher, model.operandValues.data() + location.offset,
+                                  location.length);
+                break;
+            case Operand::LifeTime::POINTER: {
+                const void* pointer = std::visit(
+                        [](auto* ptr) { return static_cast<const void*>(ptr); }, location.pointer);
+                success &= updateOperandHeader(hasher, i, location.length);
+                success &= update(hasher, pointer, location.length);
+                break;
+            }
+            case Operand::LifeTime::CONSTANT_REFERENCE: {
+                if (location.poolIndex >= poolInfos->size()) {
+                    return false;
+                }
+                auto& poolInfo = (*poolInfos)[location.poolIndex];
+                if (!poolInfo.has_value()) {
+                    poolInfo = RunTimePoolInfo::createFromMemory(model.pools[location.poolIndex]);
+                    if (!poolInfo.has_value()) {
+                        VLOG(COMPILATION) << "calcModelWeightsDigest: cannot map memory pool "
+                                          << location.poolIndex;
+                        return false;
+                    }
+                }
+                if (location.offset + location.length > poolInfo->getSize()) {
+                    return false;
+                }
+                success &= updateOperandHeader(hasher, i, location.length);
+                success &= update(hasher, poolInfo->getBuffer() + location.offset,
+                                  location.length);
+                break;
+            }
+            case Operand::LifeTime::SUBGRAPH:
+                success &= updateOperandHeader(hasher, i, sizeof(location.offset));
+                success &= update(hasher, static_cast<const void*>(&location.offset),
+                                  sizeof(location.offset));
+                break;
+            default:
+                break;
+        }
+    }
     return success;
 }
 
 }  // namespace
 
 bool calcModelArchHash(const Model& model, uint8_t* data) {
-    SHA256_CTX mHasher;
-    if (SHA256_Init(&mHasher) == 0) {
+    static_assert(BYTE_SIZE_OF_MODEL_ARCH_HASH == kFastHash256Size);
+    HashBuffer buffer;
+    appendModelArch(&buffer, model);
+    fastHash256(buffer.data(), buffer.size(), data);
+    return true;
+}
+
+bool calcModelArchDigest(const Model& model, uint8_t* data) {
+    static_assert(BYTE_SIZE_OF_MODEL_ARCH_DIGEST == SHA256_DIGEST_LENGTH);
+    HashBuffer buffer;
+    appendModelArch(&buffer, model);
+    return SHA256(buffer.data(), buffer.size(), data) != nullptr;
+}
+
+bool calcModelWeightsDigest(const Model& model, uint8_t* data) {
+    SHA256_CTX hasher;
+    if (SHA256_Init(&hasher) == 0) {
         return false;
     }
 
-    bool success = true;
-    success &= updateSubgraph(&mHasher, model.main);
-    for (auto& subgraph : model.referenced) {
-        success &= updateSubgraph(&mHasher, subgraph);
+    std::vector<std::optional<RunTimePoolInfo>> poolInfos(model.pools.size());
+    if (!updateOperandValues(&hasher, model, model.main, &poolInfos)) {
+        return false;
     }
-    if (!success) {
+    const uint64_t referencedCount = model.referenced.size();
+    if (!update(&hasher, &referencedCount, sizeof(referencedCount))) {
         return false;
     }
-
-    if (SHA256_Final(data, &mHasher) == 0) {
+    for (auto& subgraph : model.referenced) {
+        if (!updateOperandValues(&hasher, model, subgraph, &poolInfos)) {
+            return false;
+        }
+    }
+    const uint8_t relaxed = model.relaxComputationFloat32toFloat16 ? 1 : 0;
+    if (!update(&hasher, &relaxed, sizeof(relaxed))) {
         return false;
     }
-    return true;
+
+    return SHA256_Final(data, &hasher) != 0;
 }
 
 }  // namespace android::nn
@@ -22,11 +22,26 @@
 namespace android::nn {
 
 // Generated hash from canonical model operations and operands.
-// Weights do not affect this hash.
+// Weights do not affect this hash. This is a fast non-cryptographic hash (see
+// FastHash.h), suitable for identifying models in telemetry.
 bool calcModelArchHash(const Model& model, uint8_t* data);
 
 static const int BYTE_SIZE_OF_MODEL_ARCH_HASH = 32;
 
+// Like calcModelArchHash, but computes the SHA-256 digest of the same fields.
+// Use this where collisions must be hard to construct, such as cache keys.
+bool calcModelArchDigest(const Model& model, uint8_t* data);
+
+static const int BYTE_SIZE_OF_MODEL_ARCH_DIGEST = 32;
+
+// Generated hash from the values of constant operands, the subgraphs referred
+// to by SUBGRAPH operands, and the relaxed computation flag. Together with
+// calcModelArchHash, this identifies the model. Returns false if the model has
+// extension operands or a memory pool that cannot be mapped.
+bool calcModelWeightsDigest(const Model& model, uint8_t* data);
+
+static const int BYTE_SIZE_OF_MODEL_WEIGHTS_DIGEST = 32;
+
 }  // namespace android::nn
 
 #endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_MODEL_ARCH_HASHER_H
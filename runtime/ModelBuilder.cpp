@@ -18,6 +18,7 @@
 
 #include "ModelBuilder.h"
 
+#include <FastHash.h>
 #include <GraphDump.h>
 #include <LegacyUtils.h>
 #include <ModelUtils.h>
@@ -25,15 +26,18 @@
 #include <nnapi/Validation.h>
 
 #include <algorithm>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <set>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "CompilationBuilder.h"
 #include "Manager.h"
 #include "ModelArchHasher.h"
+#include "SharedCompilationCache.h"
 #include "TypeManager.h"
 
 namespace android {
@@ -56,6 +60,39 @@ static std::vector<Type> makeVector(const Type* data, uint32_t length) {
     return length > 0 ? std::vector<Type>(data, data + length) : std::vector<Type>();
 }
 
+namespace {
+
+// Finds constant operand values with identical contents, so that they can
+// share storage. Values are identified by caller-chosen ids.
+class ValueDeduplicator {
+   public:
+    // Returns the id of a previously added value whose contents equal the
+    // length bytes at value. Otherwise, adds value under newId and returns
+    // newId. getValue(id) must return the contents of the value added under
+    // id; it is only called for values that share a hash with value.
+    template <typename GetValue>
+    uint32_t findOrAdd(const void* value, uint32_t length, uint32_t newId,
+                       const GetValue& getValue) {
+        const uint64_t hash = fastHash64(value, length, length);
+        const auto [begin, end] = mValues.equal_range(hash);
+        for (auto it = begin; it != end; ++it) {
+            const auto& [candidateLength, candidateId] = it->second;
+            if (candidateLength == length &&
+                std::memcmp(getValue(candidateId), value, length) == 0) {
+                return candidateId;
+            }
+        }
+        mValues.emplace(hash, std::make_pair(length, newId));
+        return newId;
+    }
+
+   private:
+    // Maps the hash of a value to its length and id.
+    std::unordered_multimap<uint64_t, std::pair<uint32_t, uint32_t>> mValues;
+};
+
+}  // namespace
+
 bool ModelBuilder::badState(const char* name) {
     if (mCompletedModel) {
         LOG(ERROR) << "ANeuralNetworksModel_" << name << " can't modify after model finished";
@@ -291,11 +328,26 @@ int ModelBuilder::copyLargeValuesToSharedMemory() {
     VLOG(MODEL) << __func__ << " has " << mLargeOperandValues.size() << " values.";
     if (!mLargeOperandValues.empty()) {
         // Calculate the size of the shared memory needed for all the large values.
-        // Also sets the offset for each value within the memory.
+        // Also sets the offset for each value within the memory. Values that are
+        // identical to an earlier value share its offset and are not copied.
         size_t poolSize = 0;
-        for (LargeValue& l : mLargeOperandValues) {
+        ValueDeduplicator deduplicator;
+        std::vector<bool> isDuplicate(mLargeOperandValues.size(), false);
+        for (uint32_t i = 0; i < mLargeOperandValues.size(); ++i) {
+            const LargeValue& l = mLargeOperandValues[i];
             Operand& operand = mOperands[l.operandIndex];
             CHECK_EQ(operand.lifetime, Operand::LifeTime::CONSTANT_REFERENCE);
+            const uint32_t original = deduplicator.findOrAdd(
+                    l.buffer, operand.location.length, i, [this](uint32_t id) {
+                        return static_cast<const uint8_t*>(mLargeOperandValues[id].buffer);
+                    });
+            if (original != i) {
+                isDuplicate[i] = true;
+                operand.location.offset =
+                        mOperands[mLargeOperandValues[original].operandIndex].location.offset;
+                mDeduplicatedValueBytes += operand.location.length;
+                continue;
+            }
             poolSize += alignBytesNeeded(poolSize, operand.location.length);
             operand.location.offset = poolSize;
             poolSize += operand.location.length;
@@ -311,16 +363,46 @@ int ModelBuilder::copyLargeValuesToSharedMemory() {
                     << poolIndex;
 
         // Copy the values to this memory.
-        for (LargeValue& l : mLargeOperandValues) {
+        for (uint32_t i = 0; i < mLargeOperandValues.size(); ++i) {
+            const LargeValue& l = mLargeOperandValues[i];
             Operand& operand = mOperands[l.operandIndex];
             operand.location.poolIndex = poolIndex;
-            memcpy(memoryPointer + operand.location.offset, l.buffer, operand.location.length);
+            if (!isDuplicate[i]) {
+                memcpy(memoryPointer + operand.location.offset, l.buffer, operand.location.length);
+            }
         }
     }
 
     return ANEURALNETWORKS_NO_ERROR;
 }
 
+void ModelBuilder::deduplicateSmallOperandValues() {
+    std::vector<uint8_t> values;
+    values.reserve(mSmallOperandValues.size());
+    // The id of a value is its offset in values.
+    ValueDeduplicator deduplicator;
+    for (Operand& operand : mOperands) {
+        if (operand.lifetime != Operand::LifeTime::CONSTANT_COPY) {
+            continue;
+        }
+        const uint8_t* value = &mSmallOperandValues[operand.location.offset];
+        const uint32_t length = operand.location.length;
+        const uint32_t existingSize = static_cast<uint32_t>(values.size());
+        const uint32_t newOffset = existingSize + alignBytesNeeded(existingSize, length);
+        const uint32_t offset = deduplicator.findOrAdd(
+                value, length, newOffset, [&values](uint32_t id) { return values.data() + id; });
+        if (offset == newOffset) {
+            values.resize(newOffset + length);
+            memcpy(&values[newOffset], value, length);
+        }
+        operand.location.offset = offset;
+    }
+    VLOG(MODEL) << __func__ << " shrank the small values from " << mSmallOperandValues.size()
+                << " to " << values.size() << " bytes";
+    mDeduplicatedValueBytes += mSmallOperandValues.size() - values.size();
+    mSmallOperandValues = std::move(values);
+}
+
 int ModelBuilder::setOperandValueFromMemory(uint32_t index, const RuntimeMemory* memory,
                                             uint32_t offset, size_t length) {
     VLOG(MODEL) << __func__ << " for operand " << index << " offset " << offset << " size "
@@ -517,10 +599,13 @@ int ModelBuilder::finish() {
         return ANEURALNETWORKS_BAD_STATE;
     }
 
+    deduplicateSmallOperandValues();
     int n = copyLargeValuesToSharedMemory();
     if (n != ANEURALNETWORKS_NO_ERROR) {
         return n;
     }
+    VLOG(MODEL) << "ModelBuilder::finish saved " << mDeduplicatedValueBytes
+                << " bytes by sharing identical operand values";
 
     // We sort the operations so that they will be in the appropriate
     // order for a single-threaded, op at a time execution.
@@ -563,6 +648,11 @@ int ModelBuilder::finish() {
     mCompletedModel = true;
     CHECK(calcModelArchHash(modelForValidation, mModelArchHash))
             << "Failed to calculate model arch hash";
+    // Computed here rather than at compilation time, so that compiling the
+    // model does not build another canonical model and map its pools.
+    if (SharedCompilationCache::get() != nullptr) {
+        mHasSharedCacheKey = SharedCompilationCache::calcKey(modelForValidation, mSharedCacheKey);
+    }
     return ANEURALNETWORKS_NO_ERROR;
 }
 
@@ -910,6 +1000,11 @@ class ModelBuilder::ModelMaker {
     bool mSimplifyModel;
     std::vector<Model::Subgraph> mRefSubgraphs;
     Model::OperandValues mOperandValues;
+    // Values are deduplicated within each ModelBuilder by finish(). This also
+    // deduplicates them across subgraphs; the id of a value is its index in
+    // mOperandValueLocations.
+    ValueDeduplicator mOperandValueDeduplicator;
+    std::vector<DataLocation> mOperandValueLocations;
     MemoryTracker mMemories;
     std::vector<ExtensionNameAndPrefix> mExtensionNameToPrefix;
     std::set<uint16_t> mPrefixSet;
@@ -960,10 +1055,17 @@ void ModelBuilder::ModelMaker::updateOperandLocations(const ModelBuilder* refMod
                                                       Model::Subgraph* subgraph) {
     for (Operand& operand : subgraph->operands) {
         if (operand.lifetime == Operand::LifeTime::CONSTANT_COPY) {
-            uint32_t valueLength = operand.location.length;
-            uint32_t originalOffset = operand.location.offset;
-            operand.location = mOperandValues.append(&refModel->mSmallOperandValues[originalOffset],
-                                                     valueLength);
+            const uint8_t* value = &refModel->mSmallOperandValues[operand.location.offset];
+            const uint32_t valueLength = operand.location.length;
+            const uint32_t newId = mOperandValueLocations.size();
+            const uint32_t id = mOperandValueDeduplicator.findOrAdd(
+                    value, valueLength, newId, [this](uint32_t candidate) {
+                        return mOperandValues.data() + mOperandValueLocations[candidate].offset;
+                    });
+            if (id == newId) {
+                mOperandValueLocations.push_back(mOperandValues.append(value, valueLength));
+            }
+            operand.location = mOperandValueLocations[id];
         } else if (operand.lifetime == Operand::LifeTime::CONSTANT_REFERENCE) {
             uint32_t originalPoolIndex = operand.location.poolIndex;
             operand.location.poolIndex = mMemories.add(refModel->mMemories[originalPoolIndex]);
@@ -22,6 +22,7 @@
 
 #include <LegacyUtils.h>
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -136,9 +137,20 @@ class ModelBuilder {
 
     const uint8_t* getModelArchHash() const;
 
+    // Returns the key of the model in the shared compilation cache, or nullptr
+    // if the cache was disabled when the model was finished or the model
+    // cannot be cached. See SharedCompilationCache::calcKey.
+    const uint8_t* getSharedCacheKey() const {
+        return mHasSharedCacheKey ? mSharedCacheKey : nullptr;
+    }
+
+    // Returns the number of bytes of operand value storage that finish() saved
+    // by letting constant operands with identical values share storage.
+    uint64_t getDeduplicatedValueBytes() const { return mDeduplicatedValueBytes; }
+
    private:
     // TODO(b/132322449): move partitionTheWork, findBestDeviceForEachOperation,
-    // getPerformance, supportedByControlFlowInterpreter,
+    // getPerformance, supportedByControlFlowInterpreter, referencedModelsRunOnCpu,
     // isControlFlowOperationWithOperandOfUnknownSize, partitionTheWorkInternal,
     // sortIntoRunOrder to CompilationBuilder?
 
@@ -151,14 +163,29 @@ class ModelBuilder {
     // (*bestDeviceForOperation)[i] == devices.size() is a special value meaning
     // that this is a control flow operation scheduled for interpreted execution
     // (see LogicalStep).
+    //
+    // runsOnCpuCache memoizes referencedModelsRunOnCpu() across the referenced
+    // models of one partitioning. If nullptr, a cache local to the call is used.
+    using RunsOnCpuCache = std::map<const ModelBuilder*, bool>;
     int findBestDeviceForEachOperation(uint32_t preference,
                                        const std::vector<std::shared_ptr<Device>>& devices,
-                                       std::vector<int>* bestDeviceForOperation) const;
+                                       std::vector<int>* bestDeviceForOperation,
+                                       RunsOnCpuCache* runsOnCpuCache = nullptr) const;
     float getPerformance(uint32_t preference, const std::shared_ptr<Device> device) const;
     float getPerformance(uint32_t preference, const std::shared_ptr<Device> device,
                          uint32_t operationIndex) const;
     bool supportedByControlFlowInterpreter(uint32_t operationIndex) const;
 
+    // Returns true if all the operations of the models referenced by the IF or
+    // WHILE operation, including those of nested control flow, run best on the
+    // CPU. Such an operation runs as a whole in a single CPU step rather than
+    // on the ExecutionPlan::next() interpreter, which would only add the cost
+    // of a step per branch or loop iteration. Each referenced model is only
+    // examined once per runsOnCpuCache.
+    bool referencedModelsRunOnCpu(uint32_t preference,
+                                  const std::vector<std::shared_ptr<Device>>& devices,
+                                  uint32_t operationIndex, RunsOnCpuCache* runsOnCpuCache) const;
+
     // Returns true if the operation is IF or WHILE and has an inner or outer
     // input or output of unknown size.
     bool isControlFlowOperationWithOperandOfUnknownSize(uint32_t operationIndex) const;
@@ -183,9 +210,14 @@ class ModelBuilder {
     // node-at-a-time execution.
     bool sortIntoRunOrder();
 
-    // Copies the large values to a shared memory, if we have any.
+    // Copies the large values to a shared memory, if we have any. Identical
+    // values are only copied once.
     int copyLargeValuesToSharedMemory();
 
+    // Compacts mSmallOperandValues so that CONSTANT_COPY operands with
+    // identical values share storage.
+    void deduplicateSmallOperandValues();
+
     // Mark that the model should be simplified during ModelBuilder::makeModel, removing arguments
     // from operations that already match the default values, dead operands, dead pools, dead
     // subgraphs, and dead extensions.
@@ -227,6 +259,8 @@ class ModelBuilder {
     std::vector<LargeValue> mLargeOperandValues;
     // The shared memory region that will contain the large values.
     std::unique_ptr<MemoryAshmem> mLargeValueMemory;
+    // Bytes of operand value storage saved by deduplication.
+    uint64_t mDeduplicatedValueBytes = 0;
 
     // Once the model has been finished, we should not allow further
     // modifications to the model.
@@ -255,6 +289,11 @@ class ModelBuilder {
     // Model architecture hash, used for telemetry.
     uint8_t mModelArchHash[BYTE_SIZE_OF_MODEL_ARCH_HASH];
 
+    // Key of the model in the shared compilation cache, computed by finish()
+    // from the canonical model it builds for validation.
+    bool mHasSharedCacheKey = false;
+    uint8_t mSharedCacheKey[ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN];
+
     class ModelMaker;
 };
 
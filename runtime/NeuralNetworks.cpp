@@ -1647,7 +1647,7 @@ int ANeuralNetworksExecution_startComputeWithDependencies(
         }
     }
 
-    if (r->getCompilation()->hasDynamicTemporaries()) {
+    if (r->hasDynamicTemporaries()) {
         // The current implementation of fenced execution does not support
         // dynamic temporaries.  Fall back to non fenced execution.
         LOG(INFO) << "ANeuralNetworksExecution_startComputeWithDependencies falling back"
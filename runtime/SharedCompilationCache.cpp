@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "SharedCompilationCache"
+
+#include "SharedCompilationCache.h"
+
+#include <LegacyUtils.h>
+#include <TokenHasher.h>
+#include <Tracing.h>
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <android-base/thread_annotations.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "ModelArchHasher.h"
+#include "ModelBuilder.h"
+
+namespace android {
+namespace nn {
+
+namespace {
+
+struct ProcessCache {
+    std::mutex mutex;
+    std::shared_ptr<SharedCompilationCache> cache GUARDED_BY(mutex);
+    bool initialized GUARDED_BY(mutex) = false;
+};
+
+ProcessCache& getProcessCache() {
+    static ProcessCache processCache;
+    return processCache;
+}
+
+using UniqueDir = std::unique_ptr<DIR, decltype(&closedir)>;
+
+UniqueDir openDir(const std::string& path) {
+    return UniqueDir(opendir(path.c_str()), &closedir);
+}
+
+// Calls callback with the name of each entry of the directory at path, except
+// for "." and "..".
+template <typename Callback>
+void forEachDirEntry(const std::string& path, Callback callback) {
+    UniqueDir dir = openDir(path);
+    if (dir == nullptr) {
+        return;
+    }
+    while (const dirent* entry = readdir(dir.get())) {
+        const std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            callback(name);
+        }
+    }
+}
+
+// Whether the process is a member of the group gid.
+bool isInGroup(gid_t gid) {
+    if (gid == getegid()) {
+        return true;
+    }
+    const int count = getgroups(0, nullptr);
+    if (count <= 0) {
+        return false;
+    }
+    std::vector<gid_t> groups(count);
+    const int actualCount = getgroups(count, groups.data());
+    return actualCount > 0 &&
+           std::find(groups.begin(), groups.begin() + actualCount, gid) != groups.end();
+}
+
+// Whether the file at path, which is not followed if it is a symbolic link, is
+// of the type in mode, is not writable by others, and is owned by the process
+// or by the group gid.
+bool isTrusted(const std::string& path, mode_t type, gid_t gid) {
+    struct stat pathStat;
+    if (lstat(path.c_str(), &pathStat) != 0) {
+        return false;
+    }
+    return (pathStat.st_mode & S_IFMT) == type && (pathStat.st_mode & S_IWOTH) == 0 &&
+           (pathStat.st_uid == geteuid() || pathStat.st_gid == gid);
+}
+
+std::string toHexString(const uint8_t* bytes, size_t length) {
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    std::string hex(length * 2, '0');
+    for (size_t i = 0; i < length; ++i) {
+        hex[i * 2] = kHexDigits[bytes[i] >> 4];
+        hex[i * 2 + 1] = kHexDigits[bytes[i] & 0x0F];
+    }
+    return hex;
+}
+
+}  // namespace
+
+std::shared_ptr<SharedCompilationCache> SharedCompilationCache::get() {
+    ProcessCache& processCache = getProcessCache();
+    std::lock_guard<std::mutex> lock(processCache.mutex);
+    if (!processCache.initialized) {
+        processCache.initialized = true;
+#ifdef NN_DEBUGGABLE
+        std::string directory = base::GetProperty("debug.nn.shared-cache-dir", "");
+        if (!directory.empty()) {
+            if (directory.back() != '/') {
+                directory.push_back('/');
+            }
+            const uint64_t budgetBytes =
+                    static_cast<uint64_t>(getProp("debug.nn.shared-cache-budget-mb", 64)) << 20;
+            processCache.cache = std::shared_ptr<SharedCompilationCache>(
+                    new SharedCompilationCache(std::move(directory), budgetBytes));
+        }
+#endif  // NN_DEBUGGABLE
+    }
+    return processCache.cache;
+}
+
+void SharedCompilationCache::configure(const std::string& directory, uint64_t budgetBytes) {
+    ProcessCache& processCache = getProcessCache();
+    std::lock_guard<std::mutex> lock(processCache.mutex);
+    processCache.initialized = true;
+    if (directory.empty()) {
+        processCache.cache = nullptr;
+        return;
+    }
+    std::string path = directory;
+    if (path.back() != '/') {
+        path.push_back('/');
+    }
+    processCache.cache = std::shared_ptr<SharedCompilationCache>(
+            new SharedCompilationCache(std::move(path), budgetBytes));
+}
+
+bool SharedCompilationCache::calcKey(const Model& model, uint8_t* key) {
+    NNTRACE_RT(NNTRACE_PHASE_COMPILATION, "SharedCompilationCache::calcKey");
+    CHECK(key != nullptr);
+
+    // The key guards the integrity of the cache, so use the SHA-256 digest of
+    // the architecture rather than ModelBuilder::getModelArchHash().
+    uint8_t weightsDigest[BYTE_SIZE_OF_MODEL_WEIGHTS_DIGEST];
+    if (!calcModelWeightsDigest(model, weightsDigest)) {
+        VLOG(COMPILATION) << "SharedCompilationCache::calcKey: model cannot be cached";
+        return false;
+    }
+    static_assert(BYTE_SIZE_OF_MODEL_ARCH_DIGEST == ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN);
+    uint8_t archDigest[BYTE_SIZE_OF_MODEL_ARCH_DIGEST];
+    if (!calcModelArchDigest(model, archDigest)) {
+        LOG(ERROR) << "SharedCompilationCache::calcKey failed to compute the architecture digest";
+        return false;
+    }
+    TokenHasher hasher(archDigest);
+    if (!hasher.ok() || !hasher.update(weightsDigest, sizeof(weightsDigest)) || !hasher.finish()) {
+        LOG(ERROR) << "SharedCompilationCache::calcKey failed to compute the cache key";
+        return false;
+    }
+    std::copy(hasher.getCacheToken(),
+              hasher.getCacheToken() + ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN, key);
+    return true;
+}
+
+bool SharedCompilationCache::lookUp(const ModelBuilder& model, CacheInfo* cacheInfo,
+                                    uint8_t* token) const {
+    NNTRACE_RT(NNTRACE_PHASE_COMPILATION, "SharedCompilationCache::lookUp");
+    CHECK(cacheInfo != nullptr);
+    CHECK(token != nullptr);
+
+    const uint8_t* key = model.getSharedCacheKey();
+    if (key == nullptr) {
+        VLOG(COMPILATION) << "SharedCompilationCache::lookUp: model has no key";
+        return false;
+    }
+
+    struct stat directoryStat;
+    if (lstat(mDirectory.c_str(), &directoryStat) != 0 || !S_ISDIR(directoryStat.st_mode) ||
+        (directoryStat.st_mode & S_IWOTH) != 0 ||
+        (directoryStat.st_uid != geteuid() && !isInGroup(directoryStat.st_gid))) {
+        LOG(ERROR) << "SharedCompilationCache::lookUp: " << mDirectory
+                   << " is not a directory of the process or of one of its groups that others "
+                      "cannot write to";
+        return false;
+    }
+    const gid_t group = directoryStat.st_gid;
+
+    const std::string entry =
+            mDirectory + toHexString(key, ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN) + "/";
+    if (mkdir(entry.c_str(), S_IRWXU | S_IRWXG) == 0) {
+        // mkdir() applies the umask and does not set the setgid bit.
+        if (chown(entry.c_str(), static_cast<uid_t>(-1), group) != 0 ||
+            chmod(entry.c_str(), S_ISGID | S_IRWXU | S_IRWXG) != 0) {
+            PLOG(ERROR) << "SharedCompilationCache::lookUp failed to share " << entry;
+            return false;
+        }
+    } else if (errno != EEXIST) {
+        PLOG(ERROR) << "SharedCompilationCache::lookUp failed to create " << entry;
+        return false;
+    }
+    if (!isTrusted(entry, S_IFDIR, group)) {
+        LOG(ERROR) << "SharedCompilationCache::lookUp: untrusted entry " << entry;
+        return false;
+    }
+    bool trusted = true;
+    forEachDirEntry(entry, [&entry, group, &trusted](const std::string& name) {
+        const std::string path = entry + name;
+        if (!isTrusted(path, S_IFREG, group) && unlink(path.c_str()) != 0) {
+            PLOG(ERROR) << "SharedCompilationCache::lookUp failed to remove untrusted " << path;
+            trusted = false;
+        }
+    });
+    if (!trusted) {
+        return false;
+    }
+    VLOG(COMPILATION) << "SharedCompilationCache::lookUp: using entry " << entry;
+
+    cacheInfo->variant = entry;
+    std::copy(key, key + ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN, token);
+    return true;
+}
+
+void SharedCompilationCache::onCompilationFinish(const CacheInfo& cacheInfo) {
+    const auto* entry = std::get_if<CacheDir>(&cacheInfo.variant);
+    if (entry == nullptr || entry->size() <= mDirectory.size() ||
+        entry->compare(0, mDirectory.size(), mDirectory) != 0) {
+        return;
+    }
+    // Share the cache files written by this process with the group, as their
+    // mode is subject to the umask.
+    forEachDirEntry(*entry, [entry](const std::string& name) {
+        const std::string path = *entry + name;
+        struct stat fileStat;
+        if (lstat(path.c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode) &&
+            fileStat.st_uid == geteuid() &&
+            chmod(path.c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP) != 0) {
+            PLOG(WARNING) << "SharedCompilationCache failed to share " << path;
+        }
+    });
+    // Bump the modification time of the entry to now.
+    if (utimensat(AT_FDCWD, entry->c_str(), nullptr, 0) != 0) {
+        PLOG(WARNING) << "SharedCompilationCache failed to mark " << *entry << " as used";
+    }
+    // Strip the cache directory and the trailing '/'.
+    trim(entry->substr(mDirectory.size(), entry->size() - mDirectory.size() - 1));
+}
+
+void SharedCompilationCache::trim(const std::string& keep) {
+    NNTRACE_RT(NNTRACE_PHASE_COMPILATION, "SharedCompilationCache::trim");
+    std::lock_guard<std::mutex> lock(mTrimMutex);
+
+    struct Entry {
+        std::string name;
+        timespec lastUsed;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+    forEachDirEntry(mDirectory, [this, &entries, &totalSize](const std::string& name) {
+        const std::string path = mDirectory + name + "/";
+        struct stat entryStat;
+        if (stat(path.c_str(), &entryStat) != 0 || !S_ISDIR(entryStat.st_mode)) {
+            return;
+        }
+        uint64_t size = 0;
+        forEachDirEntry(path, [&path, &size](const std::string& fileName) {
+            struct stat fileStat;
+            if (stat((path + fileName).c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode)) {
+                size += fileStat.st_size;
+            }
+        });
+        entries.push_back({.name = name, .lastUsed = entryStat.st_mtim, .size = size});
+        totalSize += size;
+    });
+    if (totalSize <= mBudgetBytes) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return std::tie(a.lastUsed.tv_sec, a.lastUsed.tv_nsec) <
+               std::tie(b.lastUsed.tv_sec, b.lastUsed.tv_nsec);
+    });
+    for (const Entry& entry : entries) {
+        if (totalSize <= mBudgetBytes) {
+            break;
+        }
+        if (entry.name == keep) {
+            continue;
+        }
+        const std::string path = mDirectory + entry.name + "/";
+        forEachDirEntry(path, [&path](const std::string& fileName) {
+            unlink((path + fileName).c_str());
+        });
+        if (rmdir(path.c_str()) != 0 && errno != ENOENT) {
+            PLOG(WARNING) << "SharedCompilationCache failed to evict " << path;
+            continue;
+        }
+        VLOG(COMPILATION) << "SharedCompilationCache evicted " << path << " (" << entry.size
+                          << " bytes)";
+        totalSize -= entry.size;
+    }
+}
+
+}  // namespace nn
+}  // namespace android
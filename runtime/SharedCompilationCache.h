@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_SHARED_COMPILATION_CACHE_H
+#define ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_SHARED_COMPILATION_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "Manager.h"
+
+namespace android {
+namespace nn {
+
+class ModelBuilder;
+
+// A runtime-managed compilation cache for compilations that do not provide
+// their own caching information.
+//
+// Entries are content addressed: the key of a model is derived from its
+// architecture and weights digests (see ModelArchHasher.h), so identical
+// models built by different processes share an entry. Each entry is a
+// subdirectory of the cache directory that is handed to the devices as their
+// cache directory; compile() further re-hashes the key with the device name,
+// version and compilation settings, so the cache files of every device and
+// every partition live side by side in the entry.
+//
+// The cache directory is kept under a size budget by evicting the least
+// recently used entries after each compilation. The modification time of an
+// entry's directory records when it was last used.
+//
+// Sharing and ownership: the cache is shared by the processes of the group
+// that owns the cache directory, which must not be writable by others, and
+// which the process must own or be a member of the group of. Entries are
+// created as setgid directories of that group with mode 02770, so the files
+// created in them belong to the group, and the cache files written by a
+// compilation are made readable and writable by the group once it finishes.
+// Before an entry is handed to the devices, each of its files must be a
+// regular file that is not writable by others and that is owned either by the
+// process or by the group of the cache. Other files are removed, or if they
+// cannot be, the model is compiled without caching.
+class SharedCompilationCache {
+   public:
+    // Returns the process-wide cache, or nullptr if it is disabled.
+    //
+    // On debuggable builds, the cache is initially configured by the
+    // debug.nn.shared-cache-dir and debug.nn.shared-cache-budget-mb
+    // properties. It is disabled otherwise.
+    static std::shared_ptr<SharedCompilationCache> get();
+
+    // Points the process-wide cache at directory, which must already exist,
+    // and keeps it under budgetBytes. An empty directory disables the cache.
+    // Compilations that are in flight keep using the previous cache.
+    static void configure(const std::string& directory, uint64_t budgetBytes);
+
+    // Computes the key of model from the SHA-256 digests of its architecture
+    // and of its weights, and writes ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN
+    // bytes to key. Returns false if the model cannot be cached (see
+    // calcModelWeightsDigest). ModelBuilder::finish() computes the key of
+    // each model while the cache is enabled.
+    static bool calcKey(const Model& model, uint8_t* key);
+
+    // Makes sure that the entry of model exists and can be trusted. On
+    // success, returns true, sets cacheInfo to the entry directory and writes
+    // ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN bytes to token. Returns false
+    // if the model has no key (see ModelBuilder::getSharedCacheKey), or if the
+    // cache directory or the entry cannot be trusted or created.
+    bool lookUp(const ModelBuilder& model, CacheInfo* cacheInfo, uint8_t* token) const;
+
+    // Makes the files of the process in the entry in cacheInfo accessible to
+    // the group of the cache, marks the entry as most recently used and evicts
+    // least recently used entries until the cache is within its budget. Must
+    // be called once the devices are done writing to the entry.
+    void onCompilationFinish(const CacheInfo& cacheInfo);
+
+    const std::string& getDirectory() const { return mDirectory; }
+    uint64_t getBudgetBytes() const { return mBudgetBytes; }
+
+   private:
+    SharedCompilationCache(std::string directory, uint64_t budgetBytes)
+        : mDirectory(std::move(directory)), mBudgetBytes(budgetBytes) {}
+
+    // Evicts least recently used entries other than keep until the total
+    // size of the cache is at most mBudgetBytes.
+    void trim(const std::string& keep);
+
+    // Cache directory, with a trailing '/'.
+    const std::string mDirectory;
+    const uint64_t mBudgetBytes;
+
+    // Serializes trim() within the process. Concurrent trims by other
+    // processes are harmless: removing a file that is already open does not
+    // affect its readers, and a missing entry is simply a cache miss.
+    std::mutex mTrimMutex;
+};
+
+}  // namespace nn
+}  // namespace android
+
+#endif  // ANDROID_PACKAGES_MODULES_NEURALNETWORKS_RUNTIME_SHARED_COMPILATION_CACHE_H
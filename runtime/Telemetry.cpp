@@ -229,7 +229,7 @@ void onExecutionFinish(ExecutionBuilder* e, ExecutionMode executionMode, int res
             .introspectionEnabled = compilation->createdWithExplicitDeviceList(),
             .cacheEnabled = compilation->isCacheInfoProvided(),
             .hasControlFlow = compilation->getModel()->hasControlFlow(),
-            .hasDynamicTemporaries = compilation->hasDynamicTemporaries(),
+            .hasDynamicTemporaries = e->hasDynamicTemporaries(),
     };
 
 #if defined(__ANDROID__) && !defined(NN_COMPATIBILITY_LIBRARY_BUILD)
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SampleDriverPartial.h>
+#include <android-base/scopeguard.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CompilationBuilder.h"
+#include "ExecutionPlan.h"
+#include "HalUtils.h"
+#include "Manager.h"
+#include "TestNeuralNetworksWrapper.h"
+
+namespace android::nn {
+namespace {
+
+using sample_driver::SampleDriverPartial;
+using Result = test_wrapper::Result;
+using WrapperOperandType = test_wrapper::OperandType;
+using WrapperCompilation = test_wrapper::Compilation;
+using WrapperExecution = test_wrapper::Execution;
+using WrapperType = test_wrapper::Type;
+using WrapperModel = test_wrapper::Model;
+
+constexpr std::chrono::milliseconds kPrepareDelay{100};
+
+// Tracks how many prepareModel calls are in flight across all SlowPrepareDrivers.
+std::atomic<int> gPreparesInFlight = 0;
+std::atomic<int> gMaxPreparesInFlight = 0;
+
+// If valid, prepareModel calls on SlowPrepareDrivers block until it is ready.
+std::shared_future<void> gPrepareGate;
+
+// A driver that supports exactly one operation type and takes kPrepareDelay
+// to prepare a model.
+class SlowPrepareDriver : public SampleDriverPartial {
+   public:
+    SlowPrepareDriver(const char* name, V1_3::OperationType supportedOperation)
+        : SampleDriverPartial(name), kSupportedOperation(supportedOperation) {}
+
+    hardware::Return<void> getCapabilities_1_3(getCapabilities_1_3_cb cb) override {
+        cb(V1_3::ErrorStatus::NONE, makeCapabilities(0.1));  // Faster than CPU.
+        return hardware::Void();
+    }
+
+    hardware::Return<V1_3::ErrorStatus> prepareModel_1_3(
+            const V1_3::Model& model, V1_1::ExecutionPreference preference, V1_3::Priority priority,
+            const V1_3::OptionalTimePoint& deadline,
+            const hardware::hidl_vec<hardware::hidl_handle>& modelCache,
+            const hardware::hidl_vec<hardware::hidl_handle>& dataCache, const HalCacheToken& token,
+            const sp<V1_3::IPreparedModelCallback>& callback) override {
+        const int inFlight = ++gPreparesInFlight;
+        int maxInFlight = gMaxPreparesInFlight;
+        while (inFlight > maxInFlight &&
+               !gMaxPreparesInFlight.compare_exchange_weak(maxInFlight, inFlight)) {
+        }
+        std::this_thread::sleep_for(kPrepareDelay);
+        if (gPrepareGate.valid()) {
+            gPrepareGate.wait();
+        }
+        --gPreparesInFlight;
+        return SampleDriverPartial::prepareModel_1_3(model, preference, priority, deadline,
+                                                     modelCache, dataCache, token, callback);
+    }
+
+   private:
+    std::vector<bool> getSupportedOperationsImpl(const V1_3::Model& model) const override {
+        std::vector<bool> supported(model.main.operations.size());
+        std::transform(model.main.operations.begin(), model.main.operations.end(),
+                       supported.begin(), [this](const V1_3::Operation& operation) {
+                           return operation.type == kSupportedOperation;
+                       });
+        return supported;
+    }
+
+    const V1_3::OperationType kSupportedOperation;
+};
+
+// Model:
+//     tmp = ADD(input0, input1)
+//     output0 = MUL(tmp, input1)
+//
+// ADD is only supported by "slow-add" and MUL only by "slow-mul", so the plan
+// has one step on each device.
+void createAddMulModel(WrapperModel* model) {
+    WrapperOperandType floatType(WrapperType::TENSOR_FLOAT32, {2});
+    WrapperOperandType actType(WrapperType::INT32, {});
+    const uint32_t input0 = model->addOperand(&floatType);
+    const uint32_t input1 = model->addOperand(&floatType);
+    const uint32_t act = model->addOperand(&actType);
+    const uint32_t tmp = model->addOperand(&floatType);
+    const uint32_t output0 = model->addOperand(&floatType);
+    const int32_t actNone = ANEURALNETWORKS_FUSED_NONE;
+    model->setOperandValue(act, &actNone, sizeof(actNone));
+    model->addOperation(ANEURALNETWORKS_ADD, {input0, input1, act}, {tmp});
+    model->addOperation(ANEURALNETWORKS_MUL, {tmp, input1, act}, {output0});
+    model->identifyInputsAndOutputs({input0, input1}, {output0});
+    ASSERT_TRUE(model->isValid());
+    ASSERT_EQ(model->finish(), Result::NO_ERROR);
+}
+
+void computeAddMul(WrapperExecution* execution, const float (&input0)[2],
+                   const float (&input1)[2], float (*output0)[2]) {
+    ASSERT_EQ(execution->setInput(0, &input0), Result::NO_ERROR);
+    ASSERT_EQ(execution->setInput(1, &input1), Result::NO_ERROR);
+    ASSERT_EQ(execution->setOutput(0, output0), Result::NO_ERROR);
+    ASSERT_EQ(execution->compute(), Result::NO_ERROR);
+}
+
+void checkAddMulExecution(WrapperCompilation* compilation) {
+    WrapperExecution execution(compilation);
+    float output0[] = {0, 0};
+    ASSERT_NO_FATAL_FAILURE(computeAddMul(&execution, {1, 2}, {3, 4}, &output0));
+    EXPECT_EQ(output0[0], (1 + 3) * 3);
+    EXPECT_EQ(output0[1], (2 + 4) * 4);
+}
+
+CompilationBuilder* getBuilder(WrapperCompilation* compilation) {
+    return reinterpret_cast<CompilationBuilder*>(compilation->getHandle());
+}
+
+class AsyncCompilationTest : public ::testing::Test {
+    virtual void SetUp() {
+        DeviceManager* deviceManager = DeviceManager::get();
+        if (deviceManager->getUseCpuOnly()) {
+            GTEST_SKIP();
+        }
+        deviceManager->forTest_setDevices({
+                DeviceManager::forTest_makeDriverDevice(makeSharedDevice(
+                        "slow-add", new SlowPrepareDriver("slow-add", V1_3::OperationType::ADD))),
+                DeviceManager::forTest_makeDriverDevice(makeSharedDevice(
+                        "slow-mul", new SlowPrepareDriver("slow-mul", V1_3::OperationType::MUL))),
+                DeviceManager::getCpuDevice(),
+        });
+        gPreparesInFlight = 0;
+        gMaxPreparesInFlight = 0;
+        gPrepareGate = {};
+    }
+
+    virtual void TearDown() {
+        gPrepareGate = {};
+        DeviceManager::get()->forTest_reInitializeDeviceList();
+    }
+};
+
+TEST_F(AsyncCompilationTest, StepsOnDifferentDevicesPrepareConcurrently) {
+    WrapperModel model;
+    ASSERT_NO_FATAL_FAILURE(createAddMulModel(&model));
+
+    WrapperCompilation compilation(&model);
+    ASSERT_EQ(compilation.finish(), Result::NO_ERROR);
+    const ExecutionPlan& plan = getBuilder(&compilation)->forTest_getExecutionPlan();
+    ASSERT_EQ(plan.forTest_getKind(), ExecutionPlan::Kind::COMPOUND);
+    ASSERT_EQ(plan.forTest_compoundGetSteps().size(), 2u);
+    EXPECT_EQ(gMaxPreparesInFlight, 2);
+
+    ASSERT_NO_FATAL_FAILURE(checkAddMulExecution(&compilation));
+}
+
+TEST_F(AsyncCompilationTest, FinishAsyncReportsProgress) {
+    WrapperModel model;
+    ASSERT_NO_FATAL_FAILURE(createAddMulModel(&model));
+
+    std::mutex mutex;
+    std::vector<std::pair<uint32_t, uint32_t>> progress;
+    std::vector<int> results;
+    WrapperCompilation compilation(&model);
+    ASSERT_EQ(getBuilder(&compilation)
+                      ->finishAsync(
+                              [&](uint32_t numPrepared, uint32_t numTotal) {
+                                  std::lock_guard<std::mutex> lock(mutex);
+                                  progress.emplace_back(numPrepared, numTotal);
+                              },
+                              [&](int n) {
+                                  std::lock_guard<std::mutex> lock(mutex);
+                                  results.push_back(n);
+                              }),
+              ANEURALNETWORKS_NO_ERROR);
+
+    // The compilation cannot be finished twice.
+    EXPECT_EQ(compilation.finish(), Result::BAD_STATE);
+
+    EXPECT_EQ(getBuilder(&compilation)->waitForFinish(), ANEURALNETWORKS_NO_ERROR);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        using Progress = std::vector<std::pair<uint32_t, uint32_t>>;
+        EXPECT_EQ(progress, (Progress{{1, 2}, {2, 2}}));
+        EXPECT_EQ(results, std::vector<int>{ANEURALNETWORKS_NO_ERROR});
+    }
+
+    ASSERT_NO_FATAL_FAILURE(checkAddMulExecution(&compilation));
+}
+
+// Executions created while the driver compilation is blocked run on the CPU;
+// executions created after it is done run on the partitioned plan. Both must
+// produce the same outputs.
+TEST_F(AsyncCompilationTest, SpeculativeCpuExecution) {
+    WrapperModel model;
+    ASSERT_NO_FATAL_FAILURE(createAddMulModel(&model));
+
+    std::promise<void> openGate;
+    gPrepareGate = openGate.get_future().share();
+
+    std::atomic<bool> compilationFinished = false;
+    WrapperCompilation compilation(&model);
+    CompilationBuilder* builder = getBuilder(&compilation);
+    // Destroying the compilation waits for the driver compilation, so make
+    // sure the gate gets opened even if an assertion below fails.
+    std::once_flag gateOpened;
+    const auto openGateOnce = [&] { std::call_once(gateOpened, [&] { openGate.set_value(); }); };
+    const auto openGateOnExit = base::make_scope_guard(openGateOnce);
+    ASSERT_EQ(builder->setSpeculativeCpuExecution(true), ANEURALNETWORKS_NO_ERROR);
+    ASSERT_EQ(builder->finishAsync({}, [&compilationFinished](int) { compilationFinished = true; }),
+              ANEURALNETWORKS_NO_ERROR);
+    EXPECT_EQ(builder->setSpeculativeCpuExecution(false), ANEURALNETWORKS_BAD_STATE);
+
+    const std::vector<std::pair<std::array<float, 2>, std::array<float, 2>>> inputs = {
+            {{1, 2}, {3, 4}}, {{-1.5f, 0.25f}, {7, -3}}, {{1e-3f, 1e3f}, {0.5f, 2}}};
+    const auto computeAll = [&compilation, &inputs](std::vector<std::array<float, 2>>* outputs) {
+        for (const auto& [input0, input1] : inputs) {
+            WrapperExecution execution(&compilation);
+            float output0[2] = {};
+            ASSERT_NO_FATAL_FAILURE(computeAddMul(
+                    &execution, {input0[0], input0[1]}, {input1[0], input1[1]}, &output0));
+            outputs->push_back({output0[0], output0[1]});
+        }
+    };
+
+    // The driver compilation cannot finish before the gate is opened.
+    std::vector<std::array<float, 2>> speculativeOutputs;
+    ASSERT_NO_FATAL_FAILURE(computeAll(&speculativeOutputs));
+    EXPECT_FALSE(compilationFinished);
+
+    openGateOnce();
+    ASSERT_EQ(builder->waitForFinish(), ANEURALNETWORKS_NO_ERROR);
+    EXPECT_TRUE(compilationFinished);
+    ASSERT_EQ(builder->forTest_getExecutionPlan().forTest_getKind(),
+              ExecutionPlan::Kind::COMPOUND);
+
+    std::vector<std::array<float, 2>> partitionedOutputs;
+    ASSERT_NO_FATAL_FAILURE(computeAll(&partitionedOutputs));
+    EXPECT_EQ(speculativeOutputs, partitionedOutputs);
+}
+
+// Records the time to the first inference of an app that compiles five models
+// at startup and then executes the first of them. The times are only
+// reported, as they depend on the load of the machine. What is checked is
+// that the first inference does not wait for the other compilations: they
+// are all still blocked in the drivers when it is started.
+TEST_F(AsyncCompilationTest, TimeToFirstInference) {
+    constexpr size_t kNumModels = 5;
+    using Clock = std::chrono::steady_clock;
+    std::vector<WrapperModel> models(kNumModels);
+    for (auto& model : models) {
+        ASSERT_NO_FATAL_FAILURE(createAddMulModel(&model));
+    }
+
+    Clock::duration sequential;
+    {
+        const auto start = Clock::now();
+        std::vector<WrapperCompilation> compilations;
+        for (auto& model : models) {
+            compilations.emplace_back(&model);
+            ASSERT_EQ(compilations.back().finish(), Result::NO_ERROR);
+        }
+        ASSERT_NO_FATAL_FAILURE(checkAddMulExecution(&compilations[0]));
+        sequential = Clock::now() - start;
+    }
+
+    Clock::duration asynchronous;
+    {
+        std::promise<void> openGate;
+        gPrepareGate = openGate.get_future().share();
+        std::once_flag gateOpened;
+        const auto openGateOnce = [&] {
+            std::call_once(gateOpened, [&] { openGate.set_value(); });
+        };
+        std::atomic<size_t> numFinished = 0;
+        const auto start = Clock::now();
+        std::vector<WrapperCompilation> compilations;
+        compilations.reserve(kNumModels);
+        // Destroying the compilations waits for the driver compilations, so
+        // make sure the gate gets opened even if an assertion below fails.
+        const auto openGateOnExit = base::make_scope_guard(openGateOnce);
+        for (auto& model : models) {
+            compilations.emplace_back(&model);
+            ASSERT_EQ(getBuilder(&compilations.back())
+                              ->finishAsync({}, [&numFinished](int) { ++numFinished; }),
+                      ANEURALNETWORKS_NO_ERROR);
+        }
+        // No compilation can finish before the gate is opened, so none of
+        // them blocked the launch of the others.
+        EXPECT_EQ(numFinished, 0u);
+        openGateOnce();
+        ASSERT_NO_FATAL_FAILURE(checkAddMulExecution(&compilations[0]));
+        asynchronous = Clock::now() - start;
+
+        for (auto& compilation : compilations) {
+            EXPECT_EQ(getBuilder(&compilation)->waitForFinish(), ANEURALNETWORKS_NO_ERROR);
+        }
+        EXPECT_EQ(numFinished, kNumModels);
+    }
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    RecordProperty("sequential_ms",
+                   std::to_string(duration_cast<milliseconds>(sequential).count()));
+    RecordProperty("asynchronous_ms",
+                   std::to_string(duration_cast<milliseconds>(asynchronous).count()));
+}
+
+}  // namespace
+}  // namespace android::nn
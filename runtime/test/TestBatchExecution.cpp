@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "ExecutionBuilder.h"
+#include "TestNeuralNetworksWrapper.h"
+
+namespace android::nn {
+namespace {
+
+using Result = test_wrapper::Result;
+using WrapperCompilation = test_wrapper::Compilation;
+using WrapperExecution = test_wrapper::Execution;
+using WrapperModel = test_wrapper::Model;
+using WrapperOperandType = test_wrapper::OperandType;
+using WrapperType = test_wrapper::Type;
+
+constexpr size_t kBatchSize = 16;
+
+// out = in0 + in1 on two floats.
+class BatchExecutionTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        const WrapperOperandType tensorType(WrapperType::TENSOR_FLOAT32, {2});
+        const WrapperOperandType activationType(WrapperType::INT32, {});
+        const uint32_t input0 = mModel.addOperand(&tensorType);
+        const uint32_t input1 = mModel.addOperand(&tensorType);
+        const uint32_t activation =
+                mModel.addConstantOperand(&activationType, int32_t{ANEURALNETWORKS_FUSED_NONE});
+        const uint32_t output = mModel.addOperand(&tensorType);
+        mModel.addOperation(ANEURALNETWORKS_ADD, {input0, input1, activation}, {output});
+        mModel.identifyInputsAndOutputs({input0, input1}, {output});
+        ASSERT_EQ(mModel.finish(), Result::NO_ERROR);
+        mCompilation = std::make_unique<WrapperCompilation>(&mModel);
+        ASSERT_EQ(mCompilation->finish(), Result::NO_ERROR);
+    }
+
+    // Creates an execution of mCompilation that adds {i, i} and {1, 2}.
+    std::unique_ptr<WrapperExecution> makeExecution(size_t i, bool setInput1 = true) {
+        auto execution = std::make_unique<WrapperExecution>(mCompilation.get());
+        mBuffers.push_back(std::make_unique<Buffers>(i));
+        Buffers& buffers = *mBuffers.back();
+        EXPECT_EQ(execution->setInput(0, buffers.input0, sizeof(buffers.input0)),
+                  Result::NO_ERROR);
+        if (setInput1) {
+            EXPECT_EQ(execution->setInput(1, buffers.input1, sizeof(buffers.input1)),
+                      Result::NO_ERROR);
+        }
+        EXPECT_EQ(execution->setOutput(0, buffers.output, sizeof(buffers.output)),
+                  Result::NO_ERROR);
+        return execution;
+    }
+
+    static ExecutionBuilder* getBuilder(WrapperExecution* execution) {
+        return reinterpret_cast<ExecutionBuilder*>(execution->getHandle());
+    }
+
+    struct Buffers {
+        explicit Buffers(size_t i) : input0{float(i), float(i)} {}
+        float input0[2];
+        float input1[2] = {1, 2};
+        float output[2] = {};
+    };
+
+    WrapperModel mModel;
+    std::unique_ptr<WrapperCompilation> mCompilation;
+    std::vector<std::unique_ptr<Buffers>> mBuffers;
+};
+
+TEST_F(BatchExecutionTest, ComputesEveryExecution) {
+    std::vector<std::unique_ptr<WrapperExecution>> executions;
+    std::vector<ExecutionBuilder*> builders;
+    for (size_t i = 0; i < kBatchSize; ++i) {
+        executions.push_back(makeExecution(i));
+        builders.push_back(getBuilder(executions.back().get()));
+    }
+    std::vector<int> results;
+    EXPECT_EQ(ExecutionBuilder::computeBatch(builders, nullptr, &results),
+              ANEURALNETWORKS_NO_ERROR);
+    EXPECT_EQ(results, std::vector<int>(kBatchSize, ANEURALNETWORKS_NO_ERROR));
+    for (size_t i = 0; i < kBatchSize; ++i) {
+        EXPECT_EQ(mBuffers[i]->output[0], i + 1.0f);
+        EXPECT_EQ(mBuffers[i]->output[1], i + 2.0f);
+        EXPECT_TRUE(builders[i]->completed());
+    }
+}
+
+TEST_F(BatchExecutionTest, FailedExecutionDoesNotFailTheOthers) {
+    auto execution0 = makeExecution(0);
+    auto execution1 = makeExecution(1, /*setInput1=*/false);
+    auto execution2 = makeExecution(2);
+    std::vector<int> results;
+    EXPECT_EQ(ExecutionBuilder::computeBatch({getBuilder(execution0.get()),
+                                              getBuilder(execution1.get()),
+                                              getBuilder(execution2.get())},
+                                             nullptr, &results),
+              ANEURALNETWORKS_BAD_DATA);
+    EXPECT_EQ(results, (std::vector<int>{ANEURALNETWORKS_NO_ERROR, ANEURALNETWORKS_BAD_DATA,
+                                         ANEURALNETWORKS_NO_ERROR}));
+    EXPECT_EQ(mBuffers[2]->output[0], 3.0f);
+}
+
+TEST_F(BatchExecutionTest, RejectsRepeatedExecution) {
+    auto execution = makeExecution(0);
+    std::vector<int> results;
+    EXPECT_EQ(ExecutionBuilder::computeBatch(
+                      {getBuilder(execution.get()), getBuilder(execution.get())}, nullptr,
+                      &results),
+              ANEURALNETWORKS_BAD_DATA);
+    // The execution is left untouched.
+    EXPECT_EQ(execution->compute(), Result::NO_ERROR);
+}
+
+TEST_F(BatchExecutionTest, RejectsExecutionsOfDifferentCompilations) {
+    WrapperCompilation otherCompilation(&mModel);
+    ASSERT_EQ(otherCompilation.finish(), Result::NO_ERROR);
+    auto execution = makeExecution(0);
+    WrapperExecution otherExecution(&otherCompilation);
+    std::vector<int> results;
+    EXPECT_EQ(ExecutionBuilder::computeBatch(
+                      {getBuilder(execution.get()), getBuilder(&otherExecution)}, nullptr,
+                      &results),
+              ANEURALNETWORKS_BAD_DATA);
+    EXPECT_EQ(results, (std::vector<int>{ANEURALNETWORKS_BAD_DATA, ANEURALNETWORKS_BAD_DATA}));
+}
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <CancellationToken.h>
+#include <CpuExecutor.h>
+#include <CpuOperationUtils.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ExecutionBuilder.h"
+#include "Manager.h"
+#include "ModelBuilder.h"
+#include "TestNeuralNetworksWrapper.h"
+
+namespace android::nn {
+namespace {
+
+using Result = test_wrapper::Result;
+using WrapperCompilation = test_wrapper::Compilation;
+using WrapperEvent = test_wrapper::Event;
+using WrapperExecution = test_wrapper::Execution;
+using WrapperModel = test_wrapper::Model;
+using WrapperOperandType = test_wrapper::OperandType;
+using WrapperType = test_wrapper::Type;
+
+constexpr uint32_t kInputSize = 256;
+constexpr uint32_t kNumUnits = 256;
+
+// The executions below are made to take at least this long and to run at
+// least kMinTiles tiles, so that they are cancelled partway through.
+constexpr std::chrono::milliseconds kMinDuration{100};
+constexpr uint32_t kMinTiles = 8;
+constexpr uint32_t kMaxBatches = 1 << 16;
+
+// The value of the outputs that the execution has not written.
+constexpr float kUnwritten = -1.0f;
+
+// A single FULLY_CONNECTED operation, whose running time is proportional to
+// the number of batches. Before operations polled for cancellation, a deadline
+// was only noticed between operations, so executions of this model overshot
+// their deadline by nearly the whole running time.
+class FullyConnectedModel {
+   public:
+    explicit FullyConnectedModel(uint32_t batches)
+        : mBatches(batches),
+          mInput(batches * kInputSize, 1.0f),
+          mWeights(kNumUnits * kInputSize, 0.01f),
+          mBias(kNumUnits, 0.0f),
+          mOutput(batches * kNumUnits, kUnwritten) {
+        const WrapperOperandType inputType(WrapperType::TENSOR_FLOAT32, {batches, kInputSize});
+        const WrapperOperandType weightsType(WrapperType::TENSOR_FLOAT32, {kNumUnits, kInputSize});
+        const WrapperOperandType biasType(WrapperType::TENSOR_FLOAT32, {kNumUnits});
+        const WrapperOperandType activationType(WrapperType::INT32, {});
+        const WrapperOperandType outputType(WrapperType::TENSOR_FLOAT32, {batches, kNumUnits});
+        const uint32_t input = mModel.addOperand(&inputType);
+        const uint32_t weights = mModel.addOperand(&weightsType);
+        const uint32_t bias = mModel.addOperand(&biasType);
+        const uint32_t activation =
+                mModel.addConstantOperand(&activationType, int32_t{ANEURALNETWORKS_FUSED_NONE});
+        const uint32_t output = mModel.addOperand(&outputType);
+        mModel.addOperation(ANEURALNETWORKS_FULLY_CONNECTED, {input, weights, bias, activation},
+                            {output});
+        mModel.identifyInputsAndOutputs({input, weights, bias}, {output});
+        mModel.finish();
+    }
+
+    bool isValid() const { return mModel.isValid(); }
+    const WrapperModel* getModel() const { return &mModel; }
+    uint32_t getBatches() const { return mBatches; }
+
+    // Returns the number of batches whose output the last execution wrote.
+    // FULLY_CONNECTED computes whole tiles of batches, in order.
+    uint32_t getWrittenBatches() const {
+        uint32_t written = 0;
+        for (uint32_t i = 0; i < mBatches; ++i) {
+            written += mOutput[i * kNumUnits] != kUnwritten;
+        }
+        return written;
+    }
+
+    // Runs the model directly on a CpuExecutor, and returns the result code.
+    int run(const OptionalTimePoint& deadline, const CancellationToken* cancellationToken) {
+        std::fill(mOutput.begin(), mOutput.end(), kUnwritten);
+        const Model model = reinterpret_cast<const ModelBuilder*>(mModel.getHandle())->makeModel();
+        const auto pointerTo = [](auto* buffer) {
+            return Request::Argument{
+                    .lifetime = Request::Argument::LifeTime::POINTER,
+                    .location = {.pointer = static_cast<void*>(buffer->data()),
+                                 .length = static_cast<uint32_t>(buffer->size() * sizeof(float))}};
+        };
+        const Request request = {.inputs = {pointerTo(&mInput), pointerTo(&mWeights),
+                                            pointerTo(&mBias)},
+                                 .outputs = {pointerTo(&mOutput)}};
+        CpuExecutor executor;
+        if (deadline.has_value()) {
+            executor.setDeadline(*deadline);
+        }
+        executor.setCancellationToken(cancellationToken);
+        return executor.run(model, request, {}, {});
+    }
+
+    // Points the inputs and outputs of execution at the buffers of this model.
+    void setUpExecution(WrapperExecution* execution) {
+        std::fill(mOutput.begin(), mOutput.end(), kUnwritten);
+        ASSERT_EQ(execution->setInput(0, mInput.data(), mInput.size() * sizeof(float)),
+                  Result::NO_ERROR);
+        ASSERT_EQ(execution->setInput(1, mWeights.data(), mWeights.size() * sizeof(float)),
+                  Result::NO_ERROR);
+        ASSERT_EQ(execution->setInput(2, mBias.data(), mBias.size() * sizeof(float)),
+                  Result::NO_ERROR);
+        ASSERT_EQ(execution->setOutput(0, mOutput.data(), mOutput.size() * sizeof(float)),
+                  Result::NO_ERROR);
+    }
+
+   private:
+    const uint32_t mBatches;
+    WrapperModel mModel;
+    std::vector<float> mInput;
+    std::vector<float> mWeights;
+    std::vector<float> mBias;
+    std::vector<float> mOutput;
+};
+
+template <typename Function>
+std::chrono::duration<double, std::milli> timed(const Function& function) {
+    const auto start = Clock::now();
+    function();
+    return Clock::now() - start;
+}
+
+class CancellationTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        DeviceManager* deviceManager = DeviceManager::get();
+        mUseCpuOnly = deviceManager->getUseCpuOnly();
+        deviceManager->setUseCpuOnly(true);
+
+        // Grow the model until an uninterrupted execution takes kMinDuration
+        // and runs kMinTiles tiles.
+        const uint32_t minBatches = kMinTiles * getTileSize(uint64_t{kNumUnits} * kInputSize);
+        for (uint32_t batches = 64; batches <= kMaxBatches; batches *= 2) {
+            mModel = std::make_unique<FullyConnectedModel>(batches);
+            ASSERT_TRUE(mModel->isValid());
+            int n = ANEURALNETWORKS_NO_ERROR;
+            mDuration = timed([this, &n] { n = mModel->run({}, nullptr); });
+            ASSERT_EQ(n, ANEURALNETWORKS_NO_ERROR);
+            ASSERT_EQ(mModel->getWrittenBatches(), batches);
+            if (mDuration >= kMinDuration && batches >= minBatches) {
+                return;
+            }
+        }
+        GTEST_SKIP() << "Could not make an execution last " << kMinDuration.count() << "ms";
+    }
+
+    void TearDown() override { DeviceManager::get()->setUseCpuOnly(mUseCpuOnly); }
+
+    bool mUseCpuOnly = false;
+    std::unique_ptr<FullyConnectedModel> mModel;
+    std::chrono::duration<double, std::milli> mDuration{};
+};
+
+TEST(CancellationTokenTest, Cancel) {
+    CancellationToken token;
+    EXPECT_FALSE(token.isCancelled());
+    token.cancel();
+    EXPECT_TRUE(token.isCancelRequested());
+    EXPECT_TRUE(token.isCancelled());
+    token.reset();
+    EXPECT_FALSE(token.isCancelled());
+    EXPECT_FALSE(isCancelled(nullptr));
+}
+
+TEST(CancellationTokenTest, DeadlineAndParent) {
+    CancellationToken parent;
+    const CancellationToken child(Clock::now() + std::chrono::hours(1), &parent);
+    EXPECT_FALSE(child.isCancelled());
+    parent.cancel();
+    EXPECT_TRUE(child.isCancelRequested());
+    EXPECT_TRUE(child.isCancelled());
+
+    const CancellationToken expired(Clock::now(), nullptr);
+    EXPECT_FALSE(expired.isCancelRequested());
+    EXPECT_TRUE(expired.isCancelled());
+}
+
+TEST(CancellationTokenTest, ForEachTileStopsBetweenTiles) {
+    CancellationToken token;
+    std::vector<uint32_t> counts;
+    EXPECT_TRUE(forEachTile(10, 4, &token, [&counts](uint32_t, uint32_t count) {
+        counts.push_back(count);
+        return true;
+    }));
+    EXPECT_EQ(counts, (std::vector<uint32_t>{4, 4, 2}));
+
+    counts.clear();
+    EXPECT_FALSE(forEachTile(10, 4, &token, [&token, &counts](uint32_t, uint32_t count) {
+        counts.push_back(count);
+        token.cancel();
+        return true;
+    }));
+    EXPECT_EQ(counts, (std::vector<uint32_t>{4}));
+}
+
+// The times below are only recorded, as they depend on the load of the
+// machine. What is checked is that the execution fails and stops before
+// computing every tile.
+
+TEST_F(CancellationTest, DeadlineOvershoot) {
+    // The overshoot is measured against a deadline an eighth of the way into
+    // the execution; without polling it would be the remaining seven eighths.
+    const auto timeout = mDuration / 8;
+    const auto overshootWithoutPolling = mDuration - timeout;
+    int n = ANEURALNETWORKS_NO_ERROR;
+    const auto elapsed = timed([this, timeout, &n] {
+        const TimePoint deadline =
+                Clock::now() + std::chrono::duration_cast<Duration>(timeout);
+        n = mModel->run(deadline, nullptr);
+    });
+    const auto overshoot = elapsed - timeout;
+    RecordProperty("overshoot_without_polling_ms", std::to_string(overshootWithoutPolling.count()));
+    RecordProperty("overshoot_ms", std::to_string(overshoot.count()));
+    EXPECT_EQ(n, ANEURALNETWORKS_MISSED_DEADLINE_TRANSIENT);
+    EXPECT_LT(mModel->getWrittenBatches(), mModel->getBatches());
+}
+
+TEST_F(CancellationTest, CancelCpuExecutor) {
+    CancellationToken token;
+    int n = ANEURALNETWORKS_NO_ERROR;
+    std::thread canceller([&token, this] {
+        std::this_thread::sleep_for(mDuration / 8);
+        token.cancel();
+    });
+    const auto elapsed = timed([this, &token, &n] { n = mModel->run({}, &token); });
+    canceller.join();
+    RecordProperty("elapsed_ms", std::to_string(elapsed.count()));
+    EXPECT_EQ(n, ANEURALNETWORKS_OP_FAILED);
+    EXPECT_LT(mModel->getWrittenBatches(), mModel->getBatches());
+}
+
+TEST_F(CancellationTest, CancelCpuExecutorBeforeRun) {
+    // A token cancelled before the execution stops it after its first tile.
+    CancellationToken token;
+    token.cancel();
+    EXPECT_EQ(mModel->run({}, &token), ANEURALNETWORKS_OP_FAILED);
+    EXPECT_EQ(mModel->getWrittenBatches(), getTileSize(uint64_t{kNumUnits} * kInputSize));
+}
+
+TEST_F(CancellationTest, CancelInFlightExecution) {
+    WrapperCompilation compilation(mModel->getModel());
+    ASSERT_EQ(compilation.finish(), Result::NO_ERROR);
+    WrapperExecution execution(&compilation);
+    ASSERT_NO_FATAL_FAILURE(mModel->setUpExecution(&execution));
+    ExecutionBuilder* builder = reinterpret_cast<ExecutionBuilder*>(execution.getHandle());
+
+    // Not in flight yet.
+    EXPECT_EQ(builder->cancel(), ANEURALNETWORKS_BAD_STATE);
+
+    WrapperEvent event;
+    Result result = Result::NO_ERROR;
+    const auto elapsed = timed([&execution, &event, &builder, &result, this] {
+        ASSERT_EQ(execution.startCompute(&event), Result::NO_ERROR);
+        std::this_thread::sleep_for(mDuration / 8);
+        EXPECT_EQ(builder->cancel(), ANEURALNETWORKS_NO_ERROR);
+        result = event.wait();
+    });
+    RecordProperty("elapsed_ms", std::to_string(elapsed.count()));
+    EXPECT_EQ(result, Result::OP_FAILED);
+    // The CPU computes directly into the output buffer of the execution.
+    EXPECT_LT(mModel->getWrittenBatches(), mModel->getBatches());
+    EXPECT_EQ(builder->cancel(), ANEURALNETWORKS_BAD_STATE);
+}
+
+}  // namespace
+}  // namespace android::nn
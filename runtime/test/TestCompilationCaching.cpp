@@ -21,6 +21,7 @@
 
 #include <cstdlib>
 #include <filesystem>
+#include <iterator>
 #include <numeric>
 #include <string>
 #include <string_view>
@@ -29,6 +30,7 @@
 
 #include "HalUtils.h"
 #include "Manager.h"
+#include "SharedCompilationCache.h"
 #include "TestNeuralNetworksWrapper.h"
 #include "TmpDirectoryUtils.h"
 
@@ -277,11 +279,11 @@ class CachingDriver : public sample_driver::SampleDriver {
     HasCalledPrepareModel mHasCalledPrepareModel = HasCalledPrepareModel::NO;
 };
 
-void CreateBroadcastAddModel(test_wrapper::Model* model) {
+void CreateBroadcastAddModel(test_wrapper::Model* model,
+                             int32_t activation = ANEURALNETWORKS_FUSED_NONE) {
     test_wrapper::OperandType matrixType(Type::TENSOR_FLOAT32, {2, 2});
     test_wrapper::OperandType vectorType(Type::TENSOR_FLOAT32, {2});
     test_wrapper::OperandType scalarType(Type::INT32, {});
-    int32_t activation(ANEURALNETWORKS_FUSED_NONE);
     auto a = model->addOperand(&matrixType);
     auto b = model->addOperand(&vectorType);
     auto c = model->addOperand(&matrixType);
@@ -481,6 +483,150 @@ TEST_P(CompilationCachingTest, TokenNotProvided) {
     EXPECT_EQ(driver->hasCalledPrepareModel(), HasCalledPrepareModel::WITHOUT_CACHING);
 }
 
+// Test the runtime-managed shared compilation cache, which is used when the
+// client does not provide caching information.
+class SharedCompilationCacheTest : public ::testing::Test {
+   protected:
+    virtual void SetUp() override {
+        if (DeviceManager::get()->getUseCpuOnly()) {
+            GTEST_SKIP();
+        }
+        char cacheDirTemp[] = NN_TMP_DIR "/TestSharedCompilationCacheXXXXXX";
+        char* cacheDir = mkdtemp(cacheDirTemp);
+        ASSERT_NE(cacheDir, nullptr);
+        mCacheDir = cacheDir;
+        SharedCompilationCache::configure(mCacheDir, kBudgetBytes);
+    }
+
+    virtual void TearDown() override {
+        SharedCompilationCache::configure("", 0);
+        if (!mCacheDir.empty() && !::testing::Test::HasFailure()) {
+            std::filesystem::remove_all(mCacheDir);
+        }
+    }
+
+    // Compiles a new model built with activation on a new CachingDriver, as
+    // a separate application loading the same model would.
+    void compileModel(int32_t activation, sp<CachingDriver>* driver) {
+        test_wrapper::Model model;
+        ASSERT_NO_FATAL_FAILURE(CreateBroadcastAddModel(&model, activation));
+
+        *driver = new CachingDriver(kDeviceName, V1_3::ErrorStatus::NONE, 1, 1,
+                                    V1_3::ErrorStatus::NONE);
+        DeviceManager::get()->forTest_registerDevice(makeSharedDevice(kDeviceName.data(), *driver));
+        const auto cleanup = android::base::make_scope_guard(
+                [] { DeviceManager::get()->forTest_reInitializeDeviceList(); });
+
+        const ANeuralNetworksDevice* device = nullptr;
+        getDeviceWithName(kDeviceName, &device);
+        ASSERT_NE(device, nullptr);
+
+        ANeuralNetworksCompilation* compilation = nullptr;
+        ASSERT_EQ(ANeuralNetworksCompilation_createForDevices(model.getHandle(), &device, 1,
+                                                              &compilation),
+                  ANEURALNETWORKS_NO_ERROR);
+        EXPECT_EQ(ANeuralNetworksCompilation_finish(compilation), ANEURALNETWORKS_NO_ERROR);
+        ANeuralNetworksCompilation_free(compilation);
+    }
+
+    // Checks whether compiling a model built with activation is served from the cache.
+    void expectWarm(int32_t activation, bool warm) {
+        sp<CachingDriver> driver;
+        ASSERT_NO_FATAL_FAILURE(compileModel(activation, &driver));
+        EXPECT_EQ(driver->hasCalledPrepareModelFromCache(), warm);
+        EXPECT_EQ(driver->hasCalledPrepareModel(),
+                  warm ? HasCalledPrepareModel::NO : HasCalledPrepareModel::WITH_CACHING);
+    }
+
+    size_t countEntries() const {
+        return std::distance(std::filesystem::directory_iterator(mCacheDir),
+                             std::filesystem::directory_iterator());
+    }
+
+    static constexpr std::string_view kDeviceName = "deviceTestSharedCompilationCache";
+    // Each entry holds one model cache file and one data cache file of
+    // CachingDriver::kCacheSize (256) bytes each, so two entries fit.
+    static constexpr uint64_t kBudgetBytes = 1024;
+    std::string mCacheDir;
+};
+
+TEST_F(SharedCompilationCacheTest, SameModelIsWarm) {
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/false));
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/true));
+    EXPECT_EQ(countEntries(), 1u);
+}
+
+TEST_F(SharedCompilationCacheTest, DifferentWeightsAreCold) {
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/false));
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_RELU, /*warm=*/false));
+    EXPECT_EQ(countEntries(), 2u);
+}
+
+TEST_F(SharedCompilationCacheTest, LeastRecentlyUsedEntryIsEvicted) {
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/false));
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_RELU, /*warm=*/false));
+    // Use the first entry again, so that the second one is least recently used.
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/true));
+    // A third entry exceeds the budget.
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_RELU6, /*warm=*/false));
+    EXPECT_EQ(countEntries(), 2u);
+
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/true));
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_RELU, /*warm=*/false));
+}
+
+TEST_F(SharedCompilationCacheTest, EntriesAreSharedWithTheGroup) {
+    namespace fs = std::filesystem;
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/false));
+    ASSERT_EQ(countEntries(), 1u);
+    const fs::directory_entry entry = *fs::directory_iterator(mCacheDir);
+    const fs::perms entryPerms = entry.status().permissions();
+    EXPECT_EQ(entryPerms & (fs::perms::set_gid | fs::perms::group_all),
+              fs::perms::set_gid | fs::perms::group_all);
+    EXPECT_EQ(entryPerms & fs::perms::others_all, fs::perms::none);
+    for (const auto& file : fs::directory_iterator(entry.path())) {
+        EXPECT_EQ(file.status().permissions() & (fs::perms::group_read | fs::perms::group_write),
+                  fs::perms::group_read | fs::perms::group_write)
+                << file.path();
+    }
+}
+
+TEST_F(SharedCompilationCacheTest, UntrustedFilesAreRemoved) {
+    namespace fs = std::filesystem;
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/false));
+    for (const auto& entry : fs::directory_iterator(mCacheDir)) {
+        for (const auto& file : fs::directory_iterator(entry.path())) {
+            fs::permissions(file.path(), fs::perms::others_write, fs::perm_options::add);
+        }
+    }
+    // The files that others could have written are not handed to the driver.
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/false));
+    ASSERT_NO_FATAL_FAILURE(expectWarm(ANEURALNETWORKS_FUSED_NONE, /*warm=*/true));
+}
+
+TEST_F(SharedCompilationCacheTest, DirectoryWritableByOthersIsNotUsed) {
+    namespace fs = std::filesystem;
+    fs::permissions(mCacheDir, fs::perms::others_write, fs::perm_options::add);
+    sp<CachingDriver> driver;
+    ASSERT_NO_FATAL_FAILURE(compileModel(ANEURALNETWORKS_FUSED_NONE, &driver));
+    EXPECT_FALSE(driver->hasCalledPrepareModelFromCache());
+    EXPECT_EQ(driver->hasCalledPrepareModel(), HasCalledPrepareModel::WITHOUT_CACHING);
+    EXPECT_EQ(countEntries(), 0u);
+}
+
+TEST_F(SharedCompilationCacheTest, ClientCachingTakesPrecedence) {
+    test_wrapper::Model model;
+    ASSERT_NO_FATAL_FAILURE(CreateBroadcastAddModel(&model));
+    test_wrapper::Compilation compilation(&model);
+    const std::string clientCacheDir = mCacheDir + "/client";
+    ASSERT_TRUE(std::filesystem::create_directory(clientCacheDir));
+    const std::vector<uint8_t> token(ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN, 0);
+    ASSERT_EQ(compilation.setCaching(clientCacheDir, token), WrapperResult::NO_ERROR);
+    ASSERT_EQ(compilation.finish(), WrapperResult::NO_ERROR);
+    // Only the client cache directory.
+    EXPECT_EQ(countEntries(), 1u);
+}
+
 static const auto kErrorStatusGetNumCacheFilesChoices =
         testing::Values(V1_3::ErrorStatus::NONE, V1_3::ErrorStatus::DEVICE_UNAVAILABLE);
 static const auto kNumCacheChoices =
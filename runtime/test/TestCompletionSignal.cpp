@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "CompletionSignal.h"
+#include "Event.h"
+#include "ExecutionCallback.h"
+
+namespace android::nn {
+namespace {
+
+using namespace std::chrono_literals;
+
+class CompletionSignalTest : public ::testing::TestWithParam<std::chrono::nanoseconds> {};
+
+TEST_P(CompletionSignalTest, SignalBeforeWait) {
+    CompletionSignal signal(GetParam());
+    EXPECT_FALSE(signal.isSignaled());
+    signal.signal();
+    EXPECT_TRUE(signal.isSignaled());
+    signal.wait();
+    // Raising the signal again has no effect.
+    signal.signal();
+    signal.wait();
+}
+
+TEST_P(CompletionSignalTest, WakesEveryWaiter) {
+    constexpr size_t kRounds = 100;
+    constexpr size_t kWaiters = 4;
+    for (size_t round = 0; round < kRounds; ++round) {
+        CompletionSignal signal(GetParam());
+        int result = 0;
+        std::vector<std::thread> waiters;
+        std::vector<int> seen(kWaiters);
+        for (size_t i = 0; i < kWaiters; ++i) {
+            waiters.emplace_back([&signal, &result, &seen, i] {
+                signal.wait();
+                seen[i] = result;
+            });
+        }
+        // Let some of the rounds block past the spin phase.
+        if (round % 2 == 0) {
+            std::this_thread::sleep_for(100us);
+        }
+        result = 42;
+        signal.signal();
+        for (std::thread& waiter : waiters) {
+            waiter.join();
+        }
+        EXPECT_EQ(seen, std::vector<int>(kWaiters, 42));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(SpinDurations, CompletionSignalTest,
+                         ::testing::Values(0ns, CompletionSignal::kDefaultSpinDuration, 10ms));
+
+TEST(ExecutionCallbackTest, CallbackEventSeesResults) {
+    const auto callback = std::make_shared<ExecutionCallback>();
+    const CallbackEvent event(callback);
+    const std::vector<OutputShape> outputShapes = {{.dimensions = {2, 3}, .isSufficient = false}};
+    std::thread notifier([&callback, &outputShapes] {
+        std::this_thread::sleep_for(1ms);
+        callback->notify(ErrorStatus::OUTPUT_INSUFFICIENT_SIZE, outputShapes, {});
+    });
+    EXPECT_EQ(event.wait(), ErrorStatus::OUTPUT_INSUFFICIENT_SIZE);
+    ASSERT_EQ(callback->getOutputShapes().size(), 1u);
+    EXPECT_EQ(callback->getOutputShapes()[0].dimensions, outputShapes[0].dimensions);
+    EXPECT_FALSE(callback->getOutputShapes()[0].isSufficient);
+    notifier.join();
+}
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ControlFlow.h>
+#include <CpuModelOptimizer.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "ModelBuilder.h"
+#include "TestNeuralNetworksWrapper.h"
+
+namespace android::nn {
+namespace {
+
+using Result = test_wrapper::Result;
+using WrapperCompilation = test_wrapper::Compilation;
+using WrapperExecution = test_wrapper::Execution;
+using WrapperModel = test_wrapper::Model;
+using WrapperOperandType = test_wrapper::OperandType;
+using WrapperType = test_wrapper::Type;
+
+constexpr int32_t kNoActivation = ANEURALNETWORKS_FUSED_NONE;
+
+const WrapperOperandType kTensorType(WrapperType::TENSOR_FLOAT32, {4});
+const WrapperOperandType kScalarTensorType(WrapperType::TENSOR_FLOAT32, {1});
+const WrapperOperandType kCounterType(WrapperType::TENSOR_INT32, {1});
+const WrapperOperandType kBoolType(WrapperType::TENSOR_BOOL8, {1});
+const WrapperOperandType kActivationType(WrapperType::INT32, {});
+
+Model makeModel(const WrapperModel& model) {
+    return reinterpret_cast<const ModelBuilder*>(model.getHandle())->makeModel();
+}
+
+std::vector<float> compute(const WrapperModel& model, const std::vector<float>& input0,
+                           const std::vector<float>& input1) {
+    WrapperCompilation compilation(&model);
+    EXPECT_EQ(compilation.finish(), Result::NO_ERROR);
+    std::vector<float> output(4);
+    WrapperExecution execution(&compilation);
+    EXPECT_EQ(execution.setInput(0, input0.data(), input0.size() * sizeof(float)),
+              Result::NO_ERROR);
+    EXPECT_EQ(execution.setInput(1, input1.data(), input1.size() * sizeof(float)),
+              Result::NO_ERROR);
+    EXPECT_EQ(execution.setOutput(0, output.data(), output.size() * sizeof(float)),
+              Result::NO_ERROR);
+    EXPECT_EQ(execution.compute(), Result::NO_ERROR);
+    return output;
+}
+
+// output = input0 + input1 * ((one + one) * two)
+TEST(CpuModelOptimizerTest, FoldsConstantOperations) {
+    WrapperModel model;
+    const uint32_t input0 = model.addOperand(&kTensorType);
+    const uint32_t input1 = model.addOperand(&kTensorType);
+    const uint32_t one = model.addConstantOperand(&kScalarTensorType, 1.0f);
+    const uint32_t two = model.addConstantOperand(&kScalarTensorType, 2.0f);
+    const uint32_t noActivation = model.addConstantOperand(&kActivationType, kNoActivation);
+    const uint32_t sum = model.addOperand(&kScalarTensorType);
+    const uint32_t product = model.addOperand(&kScalarTensorType);
+    const uint32_t scaled = model.addOperand(&kTensorType);
+    const uint32_t output = model.addOperand(&kTensorType);
+    model.addOperation(ANEURALNETWORKS_ADD, {one, one, noActivation}, {sum});
+    model.addOperation(ANEURALNETWORKS_MUL, {sum, two, noActivation}, {product});
+    model.addOperation(ANEURALNETWORKS_MUL, {input1, product, noActivation}, {scaled});
+    model.addOperation(ANEURALNETWORKS_ADD, {input0, scaled, noActivation}, {output});
+    model.identifyInputsAndOutputs({input0, input1}, {output});
+    ASSERT_EQ(model.finish(), Result::NO_ERROR);
+
+    Model canonicalModel = makeModel(model);
+    const CpuModelOptimizationStats stats = optimizeModelForCpu(&canonicalModel, {});
+    EXPECT_EQ(stats.foldedOperations, 2u);
+    EXPECT_EQ(stats.hoistedOperations, 0u);
+    const Model::Subgraph& main = canonicalModel.main;
+    ASSERT_EQ(main.operations.size(), 2u);
+    const Operand& folded = main.operands[main.operations[0].inputs[1]];
+    ASSERT_EQ(folded.lifetime, Operand::LifeTime::CONSTANT_COPY);
+    float value = 0.0f;
+    memcpy(&value, canonicalModel.operandValues.data() + folded.location.offset, sizeof(value));
+    EXPECT_EQ(value, 4.0f);
+
+    EXPECT_EQ(compute(model, {1, 2, 3, 4}, {1, 1, 2, 2}), (std::vector<float>{5, 6, 11, 12}));
+}
+
+// i = 0
+// while i < 3:
+//     x = x + a * (one + one)
+//     i = i + 1
+//
+// (one + one) is folded, then a * 2 is hoisted out of the loop.
+TEST(CpuModelOptimizerTest, HoistsLoopInvariants) {
+    WrapperModel conditionModel;
+    {
+        const uint32_t x = conditionModel.addOperand(&kTensorType);
+        const uint32_t i = conditionModel.addOperand(&kCounterType);
+        const uint32_t a = conditionModel.addOperand(&kTensorType);
+        const uint32_t limit = conditionModel.addConstantOperand(&kCounterType, 3);
+        const uint32_t out = conditionModel.addOperand(&kBoolType);
+        conditionModel.addOperation(ANEURALNETWORKS_LESS, {i, limit}, {out});
+        conditionModel.identifyInputsAndOutputs({x, i, a}, {out});
+        ASSERT_EQ(conditionModel.finish(), Result::NO_ERROR);
+    }
+
+    WrapperModel bodyModel;
+    {
+        const uint32_t x = bodyModel.addOperand(&kTensorType);
+        const uint32_t i = bodyModel.addOperand(&kCounterType);
+        const uint32_t a = bodyModel.addOperand(&kTensorType);
+        const uint32_t one = bodyModel.addConstantOperand(&kScalarTensorType, 1.0f);
+        const uint32_t increment = bodyModel.addConstantOperand(&kCounterType, 1);
+        const uint32_t noActivation = bodyModel.addConstantOperand(&kActivationType, kNoActivation);
+        const uint32_t two = bodyModel.addOperand(&kScalarTensorType);
+        const uint32_t scaled = bodyModel.addOperand(&kTensorType);
+        const uint32_t xOut = bodyModel.addOperand(&kTensorType);
+        const uint32_t iOut = bodyModel.addOperand(&kCounterType);
+        bodyModel.addOperation(ANEURALNETWORKS_ADD, {one, one, noActivation}, {two});
+        bodyModel.addOperation(ANEURALNETWORKS_MUL, {a, two, noActivation}, {scaled});
+        bodyModel.addOperation(ANEURALNETWORKS_ADD, {x, scaled, noActivation}, {xOut});
+        bodyModel.addOperation(ANEURALNETWORKS_ADD, {i, increment, noActivation}, {iOut});
+        bodyModel.identifyInputsAndOutputs({x, i, a}, {xOut, iOut});
+        ASSERT_EQ(bodyModel.finish(), Result::NO_ERROR);
+    }
+
+    WrapperModel model;
+    {
+        const uint32_t x = model.addOperand(&kTensorType);
+        const uint32_t a = model.addOperand(&kTensorType);
+        const uint32_t i = model.addConstantOperand(&kCounterType, 0);
+        const uint32_t condition = model.addModelOperand(&conditionModel);
+        const uint32_t body = model.addModelOperand(&bodyModel);
+        const uint32_t xOut = model.addOperand(&kTensorType);
+        const uint32_t iOut = model.addOperand(&kCounterType);
+        model.addOperation(ANEURALNETWORKS_WHILE, {condition, body, x, i, a}, {xOut, iOut});
+        model.identifyInputsAndOutputs({x, a}, {xOut});
+        ASSERT_EQ(model.finish(), Result::NO_ERROR);
+    }
+
+    Model canonicalModel = makeModel(model);
+    const CpuModelOptimizationStats stats = optimizeModelForCpu(&canonicalModel, {});
+    EXPECT_EQ(stats.foldedOperations, 1u);
+    EXPECT_EQ(stats.hoistedOperations, 1u);
+
+    const Model::Subgraph& main = canonicalModel.main;
+    ASSERT_EQ(main.operations.size(), 2u);
+    EXPECT_EQ(main.operations[0].type, OperationType::MUL);
+    const Operation& whileOperation = main.operations[1];
+    ASSERT_EQ(whileOperation.type, OperationType::WHILE);
+    ASSERT_EQ(whileOperation.inputs.size(), 6u);
+    EXPECT_EQ(whileOperation.inputs[5], main.operations[0].outputs[0]);
+
+    namespace op = operation_while;
+    const auto& getSubgraph = [&](uint32_t input) -> const Model::Subgraph& {
+        const Operand& operand = main.operands[whileOperation.inputs[input]];
+        return canonicalModel.referenced[operand.location.offset];
+    };
+    const Model::Subgraph& conditionSubgraph = getSubgraph(op::kCondModelOperand);
+    const Model::Subgraph& bodySubgraph = getSubgraph(op::kBodyModelOperand);
+    EXPECT_EQ(bodySubgraph.operations.size(), 2u);
+    EXPECT_EQ(bodySubgraph.inputIndexes.size(), 4u);
+    EXPECT_EQ(conditionSubgraph.inputIndexes.size(), 4u);
+
+    EXPECT_EQ(compute(model, {1, 2, 3, 4}, {0.5f, 1, 1.5f, 2}),
+              (std::vector<float>{4, 8, 12, 16}));
+}
+
+// i = 0
+// while i < 0:
+//     x = x + gather(a, index)
+//     i = i + 1
+//
+// gather(a, index) is loop invariant, but fails if index is out of range. It is
+// not hoisted, so the loop, which does not iterate, does not fail.
+TEST(CpuModelOptimizerTest, DoesNotHoistOperationsThatCanFail) {
+    const WrapperOperandType indexType(WrapperType::TENSOR_INT32, {1});
+    const WrapperOperandType axisType(WrapperType::INT32, {});
+
+    WrapperModel conditionModel;
+    {
+        const uint32_t x = conditionModel.addOperand(&kScalarTensorType);
+        const uint32_t i = conditionModel.addOperand(&kCounterType);
+        const uint32_t a = conditionModel.addOperand(&kTensorType);
+        const uint32_t index = conditionModel.addOperand(&indexType);
+        const uint32_t limit = conditionModel.addConstantOperand(&kCounterType, 0);
+        const uint32_t out = conditionModel.addOperand(&kBoolType);
+        conditionModel.addOperation(ANEURALNETWORKS_LESS, {i, limit}, {out});
+        conditionModel.identifyInputsAndOutputs({x, i, a, index}, {out});
+        ASSERT_EQ(conditionModel.finish(), Result::NO_ERROR);
+    }
+
+    WrapperModel bodyModel;
+    {
+        const uint32_t x = bodyModel.addOperand(&kScalarTensorType);
+        const uint32_t i = bodyModel.addOperand(&kCounterType);
+        const uint32_t a = bodyModel.addOperand(&kTensorType);
+        const uint32_t index = bodyModel.addOperand(&indexType);
+        const uint32_t axis = bodyModel.addConstantOperand(&axisType, 0);
+        const uint32_t increment = bodyModel.addConstantOperand(&kCounterType, 1);
+        const uint32_t noActivation = bodyModel.addConstantOperand(&kActivationType, kNoActivation);
+        const uint32_t gathered = bodyModel.addOperand(&kScalarTensorType);
+        const uint32_t xOut = bodyModel.addOperand(&kScalarTensorType);
+        const uint32_t iOut = bodyModel.addOperand(&kCounterType);
+        bodyModel.addOperation(ANEURALNETWORKS_GATHER, {a, axis, index}, {gathered});
+        bodyModel.addOperation(ANEURALNETWORKS_ADD, {x, gathered, noActivation}, {xOut});
+        bodyModel.addOperation(ANEURALNETWORKS_ADD, {i, increment, noActivation}, {iOut});
+        bodyModel.identifyInputsAndOutputs({x, i, a, index}, {xOut, iOut});
+        ASSERT_EQ(bodyModel.finish(), Result::NO_ERROR);
+    }
+
+    WrapperModel model;
+    {
+        const uint32_t x = model.addOperand(&kScalarTensorType);
+        const uint32_t a = model.addOperand(&kTensorType);
+        const uint32_t index = model.addOperand(&indexType);
+        const uint32_t i = model.addConstantOperand(&kCounterType, 0);
+        const uint32_t condition = model.addModelOperand(&conditionModel);
+        const uint32_t body = model.addModelOperand(&bodyModel);
+        const uint32_t xOut = model.addOperand(&kScalarTensorType);
+        const uint32_t iOut = model.addOperand(&kCounterType);
+        model.addOperation(ANEURALNETWORKS_WHILE, {condition, body, x, i, a, index}, {xOut, iOut});
+        model.identifyInputsAndOutputs({x, a, index}, {xOut});
+        ASSERT_EQ(model.finish(), Result::NO_ERROR);
+    }
+
+    Model canonicalModel = makeModel(model);
+    const CpuModelOptimizationStats stats = optimizeModelForCpu(&canonicalModel, {});
+    EXPECT_EQ(stats.hoistedOperations, 0u);
+    ASSERT_EQ(canonicalModel.main.operations.size(), 1u);
+
+    WrapperCompilation compilation(&model);
+    ASSERT_EQ(compilation.finish(), Result::NO_ERROR);
+    const float x = 3.0f;
+    const std::vector<float> a = {1, 2, 3, 4};
+    const int32_t outOfRange = 10;
+    float output = 0.0f;
+    WrapperExecution execution(&compilation);
+    ASSERT_EQ(execution.setInput(0, &x, sizeof(x)), Result::NO_ERROR);
+    ASSERT_EQ(execution.setInput(1, a.data(), a.size() * sizeof(float)), Result::NO_ERROR);
+    ASSERT_EQ(execution.setInput(2, &outOfRange, sizeof(outOfRange)), Result::NO_ERROR);
+    ASSERT_EQ(execution.setOutput(0, &output, sizeof(output)), Result::NO_ERROR);
+    ASSERT_EQ(execution.compute(), Result::NO_ERROR);
+    EXPECT_EQ(output, x);
+}
+
+}  // namespace
+}  // namespace android::nn
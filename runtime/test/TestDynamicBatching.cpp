@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "CompilationBuilder.h"
+#include "DynamicBatcher.h"
+#include "TestNeuralNetworksWrapper.h"
+
+namespace android::nn {
+namespace {
+
+using namespace std::chrono_literals;
+
+using Result = test_wrapper::Result;
+using WrapperCompilation = test_wrapper::Compilation;
+using WrapperEvent = test_wrapper::Event;
+using WrapperExecution = test_wrapper::Execution;
+using WrapperModel = test_wrapper::Model;
+using WrapperOperandType = test_wrapper::OperandType;
+using WrapperType = test_wrapper::Type;
+
+constexpr uint32_t kMaxBatchSize = 8;
+
+// out = in0 + in1 on tensors of shape {batches, 2}, batches being unspecified.
+class DynamicBatchingTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        const WrapperOperandType tensorType(WrapperType::TENSOR_FLOAT32, {0, 2});
+        const WrapperOperandType activationType(WrapperType::INT32, {});
+        const uint32_t input0 = mModel.addOperand(&tensorType);
+        const uint32_t input1 = mModel.addOperand(&tensorType);
+        const uint32_t activation =
+                mModel.addConstantOperand(&activationType, int32_t{ANEURALNETWORKS_FUSED_NONE});
+        const uint32_t output = mModel.addOperand(&tensorType);
+        mModel.addOperation(ANEURALNETWORKS_ADD, {input0, input1, activation}, {output});
+        mModel.identifyInputsAndOutputs({input0, input1}, {output});
+        ASSERT_EQ(mModel.finish(), Result::NO_ERROR);
+        mCompilation = std::make_unique<WrapperCompilation>(&mModel);
+        ASSERT_EQ(mCompilation->finish(), Result::NO_ERROR);
+    }
+
+    CompilationBuilder* getBuilder() {
+        return reinterpret_cast<CompilationBuilder*>(mCompilation->getHandle());
+    }
+
+    // An execution that adds {i, i} to {1, 2}, rows times over.
+    struct Request {
+        Request(WrapperCompilation* compilation, uint32_t i, uint32_t rows)
+            : execution(compilation), input0(2 * rows, float(i)), output(2 * rows) {
+            for (uint32_t row = 0; row < rows; ++row) {
+                input1.insert(input1.end(), {1.0f, 2.0f});
+            }
+            const WrapperOperandType type(WrapperType::TENSOR_FLOAT32, {rows, 2});
+            EXPECT_EQ(execution.setInput(0, input0.data(), input0.size() * sizeof(float),
+                                         &type.operandType),
+                      Result::NO_ERROR);
+            EXPECT_EQ(execution.setInput(1, input1.data(), input1.size() * sizeof(float),
+                                         &type.operandType),
+                      Result::NO_ERROR);
+            EXPECT_EQ(execution.setOutput(0, output.data(), output.size() * sizeof(float)),
+                      Result::NO_ERROR);
+            EXPECT_EQ(execution.startCompute(&event), Result::NO_ERROR);
+        }
+
+        void expectDone(uint32_t i) {
+            EXPECT_EQ(event.wait(), Result::NO_ERROR);
+            std::vector<uint32_t> dimensions;
+            EXPECT_EQ(execution.getOutputOperandDimensions(0, &dimensions), Result::NO_ERROR);
+            EXPECT_EQ(dimensions, (std::vector<uint32_t>{uint32_t(output.size() / 2), 2}));
+            for (size_t row = 0; row < output.size() / 2; ++row) {
+                EXPECT_EQ(output[2 * row], i + 1.0f);
+                EXPECT_EQ(output[2 * row + 1], i + 2.0f);
+            }
+        }
+
+        WrapperExecution execution;
+        WrapperEvent event;
+        std::vector<float> input0;
+        std::vector<float> input1;
+        std::vector<float> output;
+    };
+
+    WrapperModel mModel;
+    std::unique_ptr<WrapperCompilation> mCompilation;
+};
+
+TEST_F(DynamicBatchingTest, FullBatchIsComputedAtOnce) {
+    ASSERT_EQ(getBuilder()->setDynamicBatching(1h, kMaxBatchSize, true), ANEURALNETWORKS_NO_ERROR);
+    std::vector<std::unique_ptr<Request>> requests;
+    for (uint32_t i = 0; i < kMaxBatchSize; ++i) {
+        requests.push_back(std::make_unique<Request>(mCompilation.get(), i, i % 3 + 1));
+    }
+    for (uint32_t i = 0; i < kMaxBatchSize; ++i) {
+        requests[i]->expectDone(i);
+    }
+    const DynamicBatcher::Stats stats = getBuilder()->getDynamicBatcher()->getStats();
+    EXPECT_EQ(stats.executionCount, kMaxBatchSize);
+    EXPECT_EQ(stats.batchCount, 1u);
+    EXPECT_EQ(stats.maxBatchSize, kMaxBatchSize);
+    EXPECT_EQ(stats.fallbackCount, 0u);
+}
+
+TEST_F(DynamicBatchingTest, PartialBatchIsComputedWhenTheWindowCloses) {
+    ASSERT_EQ(getBuilder()->setDynamicBatching(20ms, kMaxBatchSize, true),
+              ANEURALNETWORKS_NO_ERROR);
+    Request request0(mCompilation.get(), 0, 1);
+    Request request1(mCompilation.get(), 1, 2);
+    request0.expectDone(0);
+    request1.expectDone(1);
+    const DynamicBatcher::Stats stats = getBuilder()->getDynamicBatcher()->getStats();
+    EXPECT_EQ(stats.executionCount, 2u);
+    EXPECT_EQ(stats.batchCount, 1u);
+}
+
+TEST_F(DynamicBatchingTest, InsufficientOutputIsReported) {
+    ASSERT_EQ(getBuilder()->setDynamicBatching(20ms, kMaxBatchSize, true),
+              ANEURALNETWORKS_NO_ERROR);
+    Request request(mCompilation.get(), 0, 1);
+    // Has room for one row of output only.
+    WrapperExecution execution(mCompilation.get());
+    const WrapperOperandType type(WrapperType::TENSOR_FLOAT32, {2, 2});
+    float input[4] = {};
+    float output[2] = {};
+    ASSERT_EQ(execution.setInput(0, input, sizeof(input), &type.operandType), Result::NO_ERROR);
+    ASSERT_EQ(execution.setInput(1, input, sizeof(input), &type.operandType), Result::NO_ERROR);
+    ASSERT_EQ(execution.setOutput(0, output, sizeof(output)), Result::NO_ERROR);
+    WrapperEvent event;
+    ASSERT_EQ(execution.startCompute(&event), Result::NO_ERROR);
+    EXPECT_EQ(event.wait(), Result::OUTPUT_INSUFFICIENT_SIZE);
+    std::vector<uint32_t> dimensions;
+    EXPECT_EQ(execution.getOutputOperandDimensions(0, &dimensions),
+              Result::OUTPUT_INSUFFICIENT_SIZE);
+    EXPECT_EQ(dimensions, (std::vector<uint32_t>{2, 2}));
+    request.expectDone(0);
+    EXPECT_EQ(getBuilder()->getDynamicBatcher()->getStats().batchCount, 1u);
+}
+
+TEST_F(DynamicBatchingTest, SynchronousExecutionIsNotBatched) {
+    ASSERT_EQ(getBuilder()->setDynamicBatching(1h, kMaxBatchSize, true), ANEURALNETWORKS_NO_ERROR);
+    WrapperExecution execution(mCompilation.get());
+    const WrapperOperandType type(WrapperType::TENSOR_FLOAT32, {1, 2});
+    float input[2] = {1, 2};
+    float output[2] = {};
+    ASSERT_EQ(execution.setInput(0, input, sizeof(input), &type.operandType), Result::NO_ERROR);
+    ASSERT_EQ(execution.setInput(1, input, sizeof(input), &type.operandType), Result::NO_ERROR);
+    ASSERT_EQ(execution.setOutput(0, output, sizeof(output)), Result::NO_ERROR);
+    ASSERT_EQ(execution.compute(), Result::NO_ERROR);
+    EXPECT_EQ(output[1], 4.0f);
+    EXPECT_EQ(getBuilder()->getDynamicBatcher()->getStats().executionCount, 0u);
+}
+
+TEST_F(DynamicBatchingTest, RejectsInvalidSettings) {
+    EXPECT_EQ(getBuilder()->setDynamicBatching(1ms, kMaxBatchSize, false),
+              ANEURALNETWORKS_BAD_DATA);
+    EXPECT_EQ(getBuilder()->setDynamicBatching(1ms, 1, true), ANEURALNETWORKS_BAD_DATA);
+    EXPECT_EQ(getBuilder()->setDynamicBatching(-1ms, kMaxBatchSize, true),
+              ANEURALNETWORKS_BAD_DATA);
+    EXPECT_EQ(getBuilder()->setDynamicBatching(1ms, kMaxBatchSize, true), ANEURALNETWORKS_NO_ERROR);
+    EXPECT_EQ(getBuilder()->setDynamicBatching(1ms, kMaxBatchSize, true),
+              ANEURALNETWORKS_BAD_STATE);
+}
+
+TEST(DynamicBatchingModelTest, RejectsModelWithoutBatchDimension) {
+    WrapperModel model;
+    const WrapperOperandType tensorType(WrapperType::TENSOR_FLOAT32, {1, 2});
+    const WrapperOperandType activationType(WrapperType::INT32, {});
+    const uint32_t input = model.addOperand(&tensorType);
+    const uint32_t activation =
+            model.addConstantOperand(&activationType, int32_t{ANEURALNETWORKS_FUSED_NONE});
+    const uint32_t output = model.addOperand(&tensorType);
+    model.addOperation(ANEURALNETWORKS_ADD, {input, input, activation}, {output});
+    model.identifyInputsAndOutputs({input}, {output});
+    ASSERT_EQ(model.finish(), Result::NO_ERROR);
+    WrapperCompilation compilation(&model);
+    auto* builder = reinterpret_cast<CompilationBuilder*>(compilation.getHandle());
+    EXPECT_EQ(builder->setDynamicBatching(1ms, kMaxBatchSize, true), ANEURALNETWORKS_BAD_STATE);
+    ASSERT_EQ(compilation.finish(), Result::NO_ERROR);
+    EXPECT_EQ(builder->setDynamicBatching(1ms, kMaxBatchSize, true), ANEURALNETWORKS_BAD_DATA);
+}
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "ExecutionThreadPool.h"
+
+namespace android::nn {
+namespace {
+
+TEST(ExecutionThreadPoolTest, RunAndWaitRunsOnWorker) {
+    ExecutionThreadPool pool(/*maxWorkers=*/2, ExecutionThreadPool::kDefaultStackSize);
+    EXPECT_FALSE(ExecutionThreadPool::isWorkerThread());
+    bool ranOnWorker = false;
+    pool.runAndWait(Priority::MEDIUM, {},
+                    [&ranOnWorker] { ranOnWorker = ExecutionThreadPool::isWorkerThread(); });
+    EXPECT_TRUE(ranOnWorker);
+}
+
+TEST(ExecutionThreadPoolTest, WorkersHaveRequestedStackSize) {
+    constexpr size_t kStackSize = 16 * 1024 * 1024;
+    ExecutionThreadPool pool(/*maxWorkers=*/1, kStackSize);
+    size_t stackSize = 0;
+    pool.runAndWait(Priority::MEDIUM, {}, [&stackSize] {
+        pthread_attr_t attr;
+        ASSERT_EQ(pthread_getattr_np(pthread_self(), &attr), 0);
+        pthread_attr_getstacksize(&attr, &stackSize);
+        pthread_attr_destroy(&attr);
+    });
+    EXPECT_GE(stackSize, kStackSize);
+}
+
+TEST(ExecutionThreadPoolTest, HigherPriorityLanesRunFirst) {
+    ExecutionThreadPool pool(/*maxWorkers=*/1, ExecutionThreadPool::kDefaultStackSize);
+
+    // Keep the only worker busy while the other tasks are queued.
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> blocking;
+    pool.schedule(Priority::MEDIUM, {}, [released, &blocking] {
+        blocking.set_value();
+        released.wait();
+    });
+    blocking.get_future().wait();
+
+    std::mutex mutex;
+    std::vector<Priority> order;
+    for (Priority priority : {Priority::LOW, Priority::HIGH, Priority::MEDIUM, Priority::HIGH}) {
+        pool.schedule(priority, {}, [&mutex, &order, priority] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(priority);
+        });
+    }
+    release.set_value();
+    // Tasks of the same priority run in order, so this runs last.
+    pool.runAndWait(Priority::LOW, {}, [] {});
+
+    EXPECT_EQ(order, (std::vector<Priority>{Priority::HIGH, Priority::HIGH, Priority::MEDIUM,
+                                            Priority::LOW}));
+}
+
+TEST(ExecutionThreadPoolTest, EarlierDeadlinesRunFirst) {
+    ExecutionThreadPool pool(/*maxWorkers=*/1, ExecutionThreadPool::kDefaultStackSize);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> blocking;
+    pool.schedule(Priority::MEDIUM, {}, [released, &blocking] {
+        blocking.set_value();
+        released.wait();
+    });
+    blocking.get_future().wait();
+
+    const TimePoint now = Clock::now();
+    const std::vector<OptionalTimePoint> deadlines = {now + std::chrono::seconds(30), std::nullopt,
+                                                      now + std::chrono::seconds(10),
+                                                      now + std::chrono::seconds(20)};
+    std::mutex mutex;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        pool.schedule(Priority::MEDIUM, deadlines[i], [&mutex, &order, i] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(i);
+        });
+    }
+    release.set_value();
+    // Tasks without a deadline run after all the tasks with one.
+    pool.runAndWait(Priority::MEDIUM, {}, [] {});
+
+    EXPECT_EQ(order, (std::vector<size_t>{2, 3, 0, 1}));
+}
+
+TEST(ExecutionThreadPoolTest, HigherPriorityTaskRunsAtPreemptionPoint) {
+    ExecutionThreadPool pool(/*maxWorkers=*/1, ExecutionThreadPool::kDefaultStackSize);
+
+    std::promise<void> scheduled;
+    std::shared_future<void> wasScheduled = scheduled.get_future().share();
+    std::promise<void> started;
+    bool lowFinished = false;
+    bool highRanBeforeLowFinished = false;
+    pool.schedule(Priority::LOW, {}, [wasScheduled, &started, &lowFinished] {
+        started.set_value();
+        wasScheduled.wait();
+        // Lower priority work, such as the CPU executor between operations.
+        ExecutionThreadPool::preemptionPoint();
+        lowFinished = true;
+    });
+    started.get_future().wait();
+    pool.schedule(Priority::HIGH, {}, [&lowFinished, &highRanBeforeLowFinished] {
+        highRanBeforeLowFinished = !lowFinished;
+    });
+    scheduled.set_value();
+    pool.runAndWait(Priority::LOW, {}, [] {});
+
+    EXPECT_TRUE(lowFinished);
+    EXPECT_TRUE(highRanBeforeLowFinished);
+    EXPECT_EQ(pool.getLaneStats(Priority::HIGH).preemptingTaskCount, 1u);
+    EXPECT_EQ(pool.getLaneStats(Priority::LOW).preemptingTaskCount, 0u);
+}
+
+TEST(ExecutionThreadPoolTest, LaneStatsTrackQueueDepthAndWaitTime) {
+    constexpr size_t kTaskCount = 3;
+    ExecutionThreadPool pool(/*maxWorkers=*/1, ExecutionThreadPool::kDefaultStackSize);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> blocking;
+    pool.schedule(Priority::HIGH, {}, [released, &blocking] {
+        blocking.set_value();
+        released.wait();
+    });
+    blocking.get_future().wait();
+    for (size_t i = 0; i < kTaskCount; ++i) {
+        pool.schedule(Priority::LOW, {}, [] {});
+    }
+    {
+        const ExecutionThreadPool::LaneStats stats = pool.getLaneStats(Priority::LOW);
+        EXPECT_EQ(stats.scheduledTaskCount, kTaskCount);
+        EXPECT_EQ(stats.queueDepth, kTaskCount);
+        EXPECT_EQ(stats.maxQueueDepth, kTaskCount);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    release.set_value();
+    pool.runAndWait(Priority::LOW, {}, [] {});
+
+    const ExecutionThreadPool::LaneStats stats = pool.getLaneStats(Priority::LOW);
+    EXPECT_EQ(stats.scheduledTaskCount, kTaskCount + 1);
+    EXPECT_EQ(stats.queueDepth, 0u);
+    EXPECT_EQ(stats.maxQueueDepth, kTaskCount);
+    EXPECT_GE(stats.maxWaitTime, std::chrono::milliseconds(10));
+    EXPECT_GE(stats.totalWaitTime, stats.maxWaitTime);
+}
+
+TEST(ExecutionThreadPoolTest, NestedRunAndWaitRunsInline) {
+    // With a single worker, waiting for a second worker would deadlock.
+    ExecutionThreadPool pool(/*maxWorkers=*/1, ExecutionThreadPool::kDefaultStackSize);
+    int count = 0;
+    pool.runAndWait(Priority::HIGH, {}, [&pool, &count] {
+        pool.runAndWait(Priority::LOW, {}, [&count] { ++count; });
+        ++count;
+    });
+    EXPECT_EQ(count, 2);
+}
+
+TEST(ExecutionThreadPoolTest, WorkerCountIsBounded) {
+    constexpr uint32_t kMaxWorkers = 3;
+    constexpr int kTaskCount = 64;
+    ExecutionThreadPool pool(kMaxWorkers, ExecutionThreadPool::kDefaultStackSize);
+    std::atomic<int> count = 0;
+    std::vector<std::future<void>> callers;
+    for (int i = 0; i < kTaskCount; ++i) {
+        callers.push_back(std::async(std::launch::async, [&pool, &count] {
+            pool.runAndWait(Priority::MEDIUM, {}, [&count] { ++count; });
+        }));
+    }
+    for (auto& caller : callers) {
+        caller.wait();
+    }
+    EXPECT_EQ(count, kTaskCount);
+    EXPECT_GE(pool.getWorkerCount(), 1u);
+    EXPECT_LE(pool.getWorkerCount(), kMaxWorkers);
+}
+
+// Tasks blocked on the pool of driver waits, like asynchronous executions
+// waiting for a driver, leave the workers of the CPU pool available.
+TEST(ExecutionThreadPoolTest, DriverWaitsDoNotOccupyCpuWorkers) {
+    ExecutionThreadPool& cpuPool = ExecutionThreadPool::get();
+    ExecutionThreadPool& driverPool = ExecutionThreadPool::getForDriverWaits();
+    ASSERT_NE(&cpuPool, &driverPool);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<uint32_t> blocked = 0;
+    const uint32_t blockedCount = cpuPool.getMaxWorkerCount() + 1;
+    for (uint32_t i = 0; i < blockedCount; ++i) {
+        driverPool.schedule(Priority::MEDIUM, {}, [released, &blocked] {
+            ++blocked;
+            released.wait();
+        });
+    }
+
+    bool ran = false;
+    cpuPool.runAndWait(Priority::MEDIUM, {}, [&ran] { ran = true; });
+    EXPECT_TRUE(ran);
+
+    release.set_value();
+    while (blocked < std::min(blockedCount, driverPool.getMaxWorkerCount())) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+}  // namespace android::nn
@@ -14,15 +14,19 @@
  * limitations under the License.
  */
 
+#include <CanonicalDevice.h>
 #include <HalInterfaces.h>
 #include <SampleDriver.h>
 #include <SampleDriverFull.h>
 #include <gtest/gtest.h>
+#include <nnapi/IBuffer.h>
+#include <nnapi/IDevice.h>
 #include <nnapi/SharedMemory.h>
 #include <nnapi/hal/1.2/Device.h>
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <tuple>
@@ -477,4 +481,259 @@ TEST_F(MemoryDomainCopyTest, MemoryCopyTest) {
     EXPECT_EQ(ashmem2->dataAs<float>()[0], initValue1);
 }
 
+// A buffer of the sample driver that cannot be copied directly to another buffer.
+class NoDirectCopyBuffer : public IBuffer {
+   public:
+    explicit NoDirectCopyBuffer(SharedBuffer buffer) : kBuffer(std::move(buffer)) {}
+
+    Request::MemoryDomainToken getToken() const override { return kBuffer->getToken(); }
+    GeneralResult<void> copyTo(const SharedMemory& dst) const override {
+        return kBuffer->copyTo(dst);
+    }
+    GeneralResult<void> copyFrom(const SharedMemory& src,
+                                 const Dimensions& dimensions) const override {
+        return kBuffer->copyFrom(src, dimensions);
+    }
+    GeneralResult<void> copyToBuffer(const IBuffer&, const Dimensions&) const override {
+        return NN_ERROR(ErrorStatus::GENERAL_FAILURE) << "NoDirectCopyBuffer::copyToBuffer";
+    }
+
+   private:
+    const SharedBuffer kBuffer;
+};
+
+// The canonical sample driver, except that its buffers fail IBuffer::copyToBuffer.
+class NoDirectCopyDevice : public IDevice {
+   public:
+    explicit NoDirectCopyDevice(const std::string& name) : kDevice(name) {}
+
+    const std::string& getName() const override { return kDevice.getName(); }
+    const std::string& getVersionString() const override { return kDevice.getVersionString(); }
+    Version getFeatureLevel() const override { return kDevice.getFeatureLevel(); }
+    DeviceType getType() const override { return kDevice.getType(); }
+    const std::vector<Extension>& getSupportedExtensions() const override {
+        return kDevice.getSupportedExtensions();
+    }
+    const Capabilities& getCapabilities() const override { return kDevice.getCapabilities(); }
+    std::pair<uint32_t, uint32_t> getNumberOfCacheFilesNeeded() const override {
+        return kDevice.getNumberOfCacheFilesNeeded();
+    }
+    GeneralResult<void> wait() const override { return kDevice.wait(); }
+    GeneralResult<std::vector<bool>> getSupportedOperations(const Model& model) const override {
+        return kDevice.getSupportedOperations(model);
+    }
+    GeneralResult<SharedPreparedModel> prepareModel(
+            const Model& model, ExecutionPreference preference, Priority priority,
+            OptionalTimePoint deadline, const std::vector<SharedHandle>& modelCache,
+            const std::vector<SharedHandle>& dataCache, const CacheToken& token,
+            const std::vector<TokenValuePair>& hints,
+            const std::vector<ExtensionNameAndPrefix>& extensionNameToPrefix) const override {
+        return kDevice.prepareModel(model, preference, priority, deadline, modelCache, dataCache,
+                                    token, hints, extensionNameToPrefix);
+    }
+    GeneralResult<SharedPreparedModel> prepareModelFromCache(
+            OptionalTimePoint deadline, const std::vector<SharedHandle>& modelCache,
+            const std::vector<SharedHandle>& dataCache, const CacheToken& token) const override {
+        return kDevice.prepareModelFromCache(deadline, modelCache, dataCache, token);
+    }
+    GeneralResult<SharedBuffer> allocate(const BufferDesc& desc,
+                                         const std::vector<SharedPreparedModel>& preparedModels,
+                                         const std::vector<BufferRole>& inputRoles,
+                                         const std::vector<BufferRole>& outputRoles) const override {
+        SharedBuffer buffer =
+                NN_TRY(kDevice.allocate(desc, preparedModels, inputRoles, outputRoles));
+        return std::make_shared<const NoDirectCopyBuffer>(std::move(buffer));
+    }
+
+   private:
+    const sample::Device kDevice;
+};
+
+// Tests how ANeuralNetworksMemory_copy copies between two memories of a canonical driver: directly
+// through IBuffer::copyToBuffer, or through a pooled staging memory.
+class DeviceMemoryCopyTest : public ::testing::Test {
+   protected:
+    static constexpr char kDeviceName[] = "test_driver";
+
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        if (DeviceManager::get()->getUseCpuOnly()) {
+            GTEST_SKIP();
+        }
+        DeviceManager::get()->forTest_setDevices({});
+        RuntimeMemory::forTest_setDeviceCopyOptions({});
+    }
+
+    void TearDown() override {
+        RuntimeMemory::forTest_setDeviceCopyOptions({});
+        DeviceManager::get()->forTest_reInitializeDeviceList();
+        ::testing::Test::TearDown();
+    }
+
+    // Returns two memories of the registered device for a tensor of elementCount floats: the
+    // first one is initialized with a pattern, and the second one is not.
+    std::pair<test_wrapper::Memory, test_wrapper::Memory> createDeviceMemories(
+            uint32_t elementCount) {
+        // ADD(input, input) compiled for the device.
+        auto& model = mModels.emplace_back(std::make_unique<test_wrapper::Model>());
+        test_wrapper::OperandType tensorType(Type::TENSOR_FLOAT32, {elementCount});
+        test_wrapper::OperandType actType(Type::INT32, {});
+        const uint32_t input = model->addOperand(&tensorType);
+        const uint32_t act = model->addConstantOperand<int32_t>(&actType, 0);
+        const uint32_t output = model->addOperand(&tensorType);
+        model->addOperation(ANEURALNETWORKS_ADD, {input, input, act}, {output});
+        model->identifyInputsAndOutputs({input}, {output});
+        EXPECT_EQ(model->finish(), WrapperResult::NO_ERROR);
+        const ANeuralNetworksDevice* device = getDevice();
+        EXPECT_NE(device, nullptr);
+        auto [result, compilation] =
+                test_wrapper::Compilation::createForDevices(model.get(), {device});
+        EXPECT_EQ(result, WrapperResult::NO_ERROR);
+        EXPECT_EQ(compilation.finish(), WrapperResult::NO_ERROR);
+
+        ANeuralNetworksMemoryDesc* desc = nullptr;
+        EXPECT_EQ(ANeuralNetworksMemoryDesc_create(&desc), ANEURALNETWORKS_NO_ERROR);
+        EXPECT_EQ(ANeuralNetworksMemoryDesc_addInputRole(desc, compilation.getHandle(), 0, 1.0f),
+                  ANEURALNETWORKS_NO_ERROR);
+        EXPECT_EQ(ANeuralNetworksMemoryDesc_finish(desc), ANEURALNETWORKS_NO_ERROR);
+        ANeuralNetworksMemory* src = nullptr;
+        ANeuralNetworksMemory* dst = nullptr;
+        EXPECT_EQ(ANeuralNetworksMemory_createFromDesc(desc, &src), ANEURALNETWORKS_NO_ERROR);
+        EXPECT_EQ(ANeuralNetworksMemory_createFromDesc(desc, &dst), ANEURALNETWORKS_NO_ERROR);
+        ANeuralNetworksMemoryDesc_free(desc);
+        mCompilations.push_back(std::move(compilation));
+
+        const std::vector<float> pattern = makePattern(elementCount);
+        auto ashmem = TestAshmem::createFrom(pattern.data(), pattern.size() * sizeof(float));
+        EXPECT_NE(ashmem, nullptr);
+        if (ashmem != nullptr) {
+            EXPECT_EQ(ANeuralNetworksMemory_copy(ashmem->get()->get(), src),
+                      ANEURALNETWORKS_NO_ERROR);
+        }
+        return {test_wrapper::Memory(src), test_wrapper::Memory(dst)};
+    }
+
+    // Checks that a memory created by createDeviceMemories() holds the pattern.
+    static void expectPattern(const test_wrapper::Memory& memory, uint32_t elementCount) {
+        const std::vector<float> zeros(elementCount, 0.0f);
+        auto ashmem = TestAshmem::createFrom(zeros.data(), zeros.size() * sizeof(float));
+        ASSERT_NE(ashmem, nullptr);
+        ASSERT_EQ(ANeuralNetworksMemory_copy(memory.get(), ashmem->get()->get()),
+                  ANEURALNETWORKS_NO_ERROR);
+        const std::vector<float> pattern = makePattern(elementCount);
+        EXPECT_TRUE(std::equal(pattern.begin(), pattern.end(), ashmem->dataAs<float>()));
+    }
+
+   private:
+    static std::vector<float> makePattern(uint32_t elementCount) {
+        std::vector<float> pattern(elementCount);
+        for (uint32_t i = 0; i < elementCount; ++i) {
+            pattern[i] = static_cast<float>(i % 251);
+        }
+        return pattern;
+    }
+
+    static const ANeuralNetworksDevice* getDevice() {
+        uint32_t numDevices = 0;
+        EXPECT_EQ(ANeuralNetworks_getDeviceCount(&numDevices), ANEURALNETWORKS_NO_ERROR);
+        for (uint32_t i = 0; i < numDevices; i++) {
+            ANeuralNetworksDevice* device = nullptr;
+            const char* name = nullptr;
+            EXPECT_EQ(ANeuralNetworks_getDevice(i, &device), ANEURALNETWORKS_NO_ERROR);
+            EXPECT_EQ(ANeuralNetworksDevice_getName(device, &name), ANEURALNETWORKS_NO_ERROR);
+            if (std::string(name) == kDeviceName) {
+                return device;
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<test_wrapper::Model>> mModels;
+    std::vector<test_wrapper::Compilation> mCompilations;
+};
+
+TEST_F(DeviceMemoryCopyTest, CopiesDirectlyWithinADevice) {
+    DeviceManager::get()->forTest_registerDevice(std::make_shared<sample::Device>(kDeviceName));
+    constexpr uint32_t kElementCount = 1024;
+    auto [src, dst] = createDeviceMemories(kElementCount);
+
+    ASSERT_EQ(ANeuralNetworksMemory_copy(src.get(), dst.get()), ANEURALNETWORKS_NO_ERROR);
+    const auto stats = RuntimeMemory::forTest_getDeviceCopyStats();
+    EXPECT_EQ(stats.directCopyCount, 1u);
+    EXPECT_EQ(stats.stagingCopyCount, 0u);
+    expectPattern(dst, kElementCount);
+}
+
+TEST_F(DeviceMemoryCopyTest, FailedDirectCopyFallsBackToStagingMemory) {
+    DeviceManager::get()->forTest_registerDevice(
+            std::make_shared<NoDirectCopyDevice>(kDeviceName));
+    constexpr uint32_t kElementCount = 1024;
+    auto [src, dst] = createDeviceMemories(kElementCount);
+
+    ASSERT_EQ(ANeuralNetworksMemory_copy(src.get(), dst.get()), ANEURALNETWORKS_NO_ERROR);
+    const auto stats = RuntimeMemory::forTest_getDeviceCopyStats();
+    EXPECT_EQ(stats.directCopyCount, 0u);
+    EXPECT_EQ(stats.stagingCopyCount, 1u);
+    EXPECT_EQ(stats.stagingAllocationCount, 1u);
+    expectPattern(dst, kElementCount);
+}
+
+TEST_F(DeviceMemoryCopyTest, StagingMemoryIsReused) {
+    DeviceManager::get()->forTest_registerDevice(std::make_shared<sample::Device>(kDeviceName));
+    RuntimeMemory::forTest_setDeviceCopyOptions({.allowDirectCopy = false});
+    constexpr uint32_t kElementCount = 1024;
+    auto [src, dst] = createDeviceMemories(kElementCount);
+
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(ANeuralNetworksMemory_copy(src.get(), dst.get()), ANEURALNETWORKS_NO_ERROR);
+    }
+    const auto stats = RuntimeMemory::forTest_getDeviceCopyStats();
+    EXPECT_EQ(stats.directCopyCount, 0u);
+    EXPECT_EQ(stats.stagingCopyCount, 3u);
+    EXPECT_EQ(stats.stagingAllocationCount, 1u);
+    EXPECT_EQ(stats.idleStagingBytes, kElementCount * sizeof(float));
+    expectPattern(dst, kElementCount);
+}
+
+TEST_F(DeviceMemoryCopyTest, StagingMemoryIsEvictedPastTheLimit) {
+    DeviceManager::get()->forTest_registerDevice(std::make_shared<sample::Device>(kDeviceName));
+    static constexpr uint32_t kSmall = 1024, kMedium = 1536, kLarge = 2048, kTooLarge = 4096;
+    static constexpr size_t kMaxIdleBytes = 3 * kSmall * sizeof(float);
+    RuntimeMemory::forTest_setDeviceCopyOptions(
+            {.allowDirectCopy = false, .maxIdleStagingBytes = kMaxIdleBytes});
+    auto [small, smallDst] = createDeviceMemories(kSmall);
+    auto [medium, mediumDst] = createDeviceMemories(kMedium);
+    auto [large, largeDst] = createDeviceMemories(kLarge);
+    auto [tooLarge, tooLargeDst] = createDeviceMemories(kTooLarge);
+    const auto copy = [](const test_wrapper::Memory& src, const test_wrapper::Memory& dst) {
+        ASSERT_EQ(ANeuralNetworksMemory_copy(src.get(), dst.get()), ANEURALNETWORKS_NO_ERROR);
+    };
+    const auto expectStats = [](uint64_t allocationCount, uint32_t idleElementCount) {
+        const auto stats = RuntimeMemory::forTest_getDeviceCopyStats();
+        EXPECT_EQ(stats.stagingAllocationCount, allocationCount);
+        EXPECT_EQ(stats.idleStagingBytes, idleElementCount * sizeof(float));
+        EXPECT_LE(stats.idleStagingBytes, kMaxIdleBytes);
+    };
+
+    copy(small, smallDst);
+    copy(large, largeDst);
+    expectStats(2, kSmall + kLarge);
+    // Keeping the medium memory evicts the largest one.
+    copy(medium, mediumDst);
+    expectStats(3, kSmall + kMedium);
+    copy(large, largeDst);
+    expectStats(4, kSmall + kLarge);
+    // The small memory was kept all along.
+    copy(small, smallDst);
+    expectStats(4, kSmall + kLarge);
+    // A memory larger than the limit is not kept.
+    copy(tooLarge, tooLargeDst);
+    expectStats(5, kSmall + kLarge);
+
+    expectPattern(smallDst, kSmall);
+    expectPattern(mediumDst, kMedium);
+    expectPattern(largeDst, kLarge);
+    expectPattern(tooLargeDst, kTooLarge);
+}
+
 }  // namespace
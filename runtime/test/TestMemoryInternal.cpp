@@ -43,12 +43,14 @@ namespace {
 // Tests to ensure that various kinds of memory leaks do not occur.
 //
 // The fixture checks that no anonymous shared memory regions are leaked by
-// comparing the count of /dev/ashmem mappings in SetUp and TearDown. This could
-// break if the test or framework starts lazily instantiating something that
-// creates a mapping - at that point the way the test works needs to be
-// reinvestigated. The filename /dev/ashmem is a documented part of the Android
-// kernel interface (see
-// https://source.android.com/devices/architecture/kernel/reqs-interfaces).
+// comparing the count of /dev/ashmem and memfd mappings in SetUp and TearDown.
+// This could break if the test or framework starts lazily instantiating
+// something that creates a mapping - at that point the way the test works
+// needs to be reinvestigated. The filename /dev/ashmem is a documented part of
+// the Android kernel interface (see
+// https://source.android.com/devices/architecture/kernel/reqs-interfaces). On
+// Linux hosts the runtime allocates memfds instead, which are mapped as
+// /memfd:<name>.
 //
 // (We can also get very unlucky and mask a memory leak by unrelated unmapping
 // somewhere else. This seems unlikely enough to not deal with.)
@@ -58,7 +60,7 @@ class MemoryLeakTest : public ::testing::Test {
     void TearDown() override;
 
    private:
-    size_t GetAshmemMappingsCount();
+    size_t GetSharedMemoryMappingsCount();
 
     size_t mStartingMapCount = 0;
     bool mIsCpuOnly;
@@ -66,16 +68,16 @@ class MemoryLeakTest : public ::testing::Test {
 
 void MemoryLeakTest::SetUp() {
     mIsCpuOnly = android::nn::DeviceManager::get()->getUseCpuOnly();
-    mStartingMapCount = GetAshmemMappingsCount();
+    mStartingMapCount = GetSharedMemoryMappingsCount();
 }
 
 void MemoryLeakTest::TearDown() {
     android::nn::DeviceManager::get()->setUseCpuOnly(mIsCpuOnly);
-    const size_t endingMapCount = GetAshmemMappingsCount();
+    const size_t endingMapCount = GetSharedMemoryMappingsCount();
     ASSERT_EQ(mStartingMapCount, endingMapCount);
 }
 
-size_t MemoryLeakTest::GetAshmemMappingsCount() {
+size_t MemoryLeakTest::GetSharedMemoryMappingsCount() {
     std::ifstream mappingsStream("/proc/self/maps");
     if (!mappingsStream.good()) {
         // errno is set by std::ifstream on Linux
@@ -85,7 +87,8 @@ size_t MemoryLeakTest::GetAshmemMappingsCount() {
     std::string line;
     int mapCount = 0;
     while (std::getline(mappingsStream, line)) {
-        if (line.find("/dev/ashmem") != std::string::npos) {
+        if (line.find("/dev/ashmem") != std::string::npos ||
+            line.find("/memfd:nnapi_memfd") != std::string::npos) {
             ++mapCount;
         }
     }
@@ -255,6 +258,73 @@ TEST_F(MemoryLeakTest, convTooLarge) {
 
     ASSERT_EQ(WrapperResult::OP_FAILED, r);
 }
+
+// Repeated executions against the same memory map it once.
+TEST_F(MemoryLeakTest, MappingIsReusedAcrossExecutions) {
+    constexpr int kExecutionCount = 1000;
+    android::nn::DeviceManager::get()->setUseCpuOnly(true);
+    WrapperModel model;
+    WrapperOperandType matrixType(WrapperType::TENSOR_FLOAT32, {3, 4});
+    WrapperOperandType scalarType(WrapperType::INT32, {});
+    int32_t activation(0);
+    auto a = model.addOperand(&matrixType);
+    auto b = model.addOperand(&scalarType);
+    auto c = model.addOperand(&matrixType);
+    model.setOperandValue(b, &activation, sizeof(activation));
+    model.addOperation(ANEURALNETWORKS_ADD, {a, a, b}, {c});
+    model.identifyInputsAndOutputs({a}, {c});
+    ASSERT_TRUE(model.isValid());
+    model.finish();
+    WrapperCompilation compilation(&model);
+    ASSERT_EQ(compilation.finish(), WrapperResult::NO_ERROR);
+
+    // The input is at offset 0 and the output right after it.
+    constexpr size_t memorySize = 2 * sizeof(Matrix3x4);
+#ifdef __ANDROID__
+    int memoryFd = ASharedMemory_create("io", memorySize);
+#else   // __ANDROID__
+    TemporaryFile tmpFile;
+    int memoryFd = tmpFile.release();
+    CHECK_EQ(ftruncate(memoryFd, memorySize), 0);
+#endif  // __ANDROID__
+    ASSERT_GT(memoryFd, -1);
+    uint8_t* data =
+            (uint8_t*)mmap(nullptr, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+    ASSERT_NE(data, nullptr);
+    memcpy(data, matrix1, sizeof(Matrix3x4));
+    WrapperMemory memory(memorySize, PROT_READ | PROT_WRITE, memoryFd, 0);
+    ASSERT_TRUE(memory.isValid());
+    const auto* runtimeMemory = reinterpret_cast<const android::nn::RuntimeMemory*>(memory.get());
+
+    const auto compute = [&compilation, &memory] {
+        WrapperExecution execution(&compilation);
+        ASSERT_EQ(execution.setInputFromMemory(0, &memory, 0, sizeof(Matrix3x4)),
+                  WrapperResult::NO_ERROR);
+        ASSERT_EQ(execution.setOutputFromMemory(0, &memory, sizeof(Matrix3x4), sizeof(Matrix3x4)),
+                  WrapperResult::NO_ERROR);
+        ASSERT_EQ(execution.compute(), WrapperResult::NO_ERROR);
+    };
+    for (int i = 0; i < kExecutionCount; ++i) {
+        ASSERT_NO_FATAL_FAILURE(compute());
+    }
+    const Matrix3x4 expected = {{2.f, 4.f, 6.f, 8.f}, {10.f, 12.f, 14.f, 16.f},
+                                {18.f, 20.f, 22.f, 24.f}};
+    EXPECT_EQ(CompareMatrices(expected, *reinterpret_cast<Matrix3x4*>(data + sizeof(Matrix3x4))),
+              0);
+    auto stats = runtimeMemory->getMappingStats();
+    EXPECT_EQ(stats.mapCount, 1u);
+    EXPECT_EQ(stats.releaseCount, 0u);
+
+    // After an explicit release, the next execution maps the memory again.
+    runtimeMemory->releaseRunTimePoolInfo();
+    ASSERT_NO_FATAL_FAILURE(compute());
+    stats = runtimeMemory->getMappingStats();
+    EXPECT_EQ(stats.mapCount, 2u);
+    EXPECT_EQ(stats.releaseCount, 1u);
+
+    munmap(data, memorySize);
+    close(memoryFd);
+}
 #endif  // NNTEST_ONLY_PUBLIC_API
 
 }  // end namespace
@@ -19,6 +19,7 @@
 #include <SampleDriver.h>
 #include <Utils.h>
 #include <ValidateHal.h>
+#include <android-base/scopeguard.h>
 #include <gtest/gtest.h>
 
 #include <algorithm>
@@ -2515,6 +2516,42 @@ TEST_F(DynamicTemporariesTest, DynamicTemporariesUnspecifiedOutputs) {
     ASSERT_NO_FATAL_FAILURE(executeCompilationAndCompareOutput(true, true));
 }
 
+TEST_F(DynamicTemporariesTest, DynamicTemporariesShapeCache) {
+    // The purpose of this test is to confirm that an execution whose inputs
+    // have the same dimensions as an earlier execution declares the dynamic
+    // temporaries at the shapes that the earlier execution found, without
+    // inferring them again.
+
+    ASSERT_NO_FATAL_FAILURE(makeModelAndValidate());
+    ASSERT_NO_FATAL_FAILURE(compileModelAndComparePlan());
+    const ExecutionPlan& plan = mCompilation->getExecutionPlan();
+
+    ASSERT_NO_FATAL_FAILURE(executeCompilationAndCompareOutput(true, true));
+    EXPECT_EQ(plan.getDynamicTemporaryStats().shapeCacheHits, 0u);
+    EXPECT_EQ(plan.getDynamicTemporaryStats().shapeCacheMisses, 1u);
+    const uint64_t inferredShapes = plan.getDynamicTemporaryStats().inferredShapes;
+
+    ASSERT_NO_FATAL_FAILURE(executeCompilationAndCompareOutput(true, true));
+    EXPECT_EQ(plan.getDynamicTemporaryStats().shapeCacheHits, 1u);
+    EXPECT_EQ(plan.getDynamicTemporaryStats().shapeCacheMisses, 1u);
+    EXPECT_EQ(plan.getDynamicTemporaryStats().inferredShapes, inferredShapes);
+}
+
+TEST_F(DynamicTemporariesTest, DynamicTemporariesInferredShapes) {
+    // The purpose of this test is to confirm that the runtime infers the shape
+    // of a dynamic temporary from the inputs of the step that defines it, so
+    // that the step does not run again with a larger temporary, even on the
+    // first execution.
+
+    ASSERT_NO_FATAL_FAILURE(makeModelAndValidate());
+    ASSERT_NO_FATAL_FAILURE(compileModelAndComparePlan());
+    const ExecutionPlan& plan = mCompilation->getExecutionPlan();
+
+    ASSERT_NO_FATAL_FAILURE(executeCompilationAndCompareOutput(true, true));
+    EXPECT_EQ(plan.getDynamicTemporaryStats().inferredShapes, 1u);
+    EXPECT_EQ(plan.getDynamicTemporaryStats().insufficientSizeRetries, 0u);
+}
+
 TEST_F(DynamicTemporariesTest, DynamicTemporariesSpecifiedOutputs) {
     // The purpose of this test is to confirm that the partitioner can produce
     // dynamic temporaries and that the runtime can handle them properly.  Note
@@ -3278,6 +3315,54 @@ TEST_F(ControlFlowPartitioningTest, WHILE_SimplePlan) {
     checkExecutionPlanSteps(plan, {"ALL"});
 }
 
+TEST_F(ControlFlowPartitioningTest, IF_FusedOnCpu) {
+    const auto models = createIfModel();
+
+    // The device supports no operation, so both branch models run on the CPU.
+    const auto devices = makeDevices({{"V1_0", 0.9, HalVersion::V1_0, 0U}});
+    const auto& cpuDeviceName = DeviceManager::getCpuDevice()->getName();
+
+    ExecutionPlan fusedPlan;
+    ASSERT_EQ(models[0]->partitionTheWork(devices, ExecutePreference::PREFER_LOW_POWER,
+                                          ExecutePriority::DEFAULT, {}, &fusedPlan),
+              ANEURALNETWORKS_NO_ERROR);
+    checkExecutionPlanSteps(fusedPlan, {cpuDeviceName});
+
+    DeviceManager::get()->setFuseCpuControlFlow(false);
+    const auto restoreFusion = android::base::make_scope_guard(
+            [] { DeviceManager::get()->setFuseCpuControlFlow(true); });
+    ExecutionPlan interpretedPlan;
+    ASSERT_EQ(models[0]->partitionTheWork(devices, ExecutePreference::PREFER_LOW_POWER,
+                                          ExecutePriority::DEFAULT, {}, &interpretedPlan),
+              ANEURALNETWORKS_NO_ERROR);
+    checkExecutionPlanSteps(interpretedPlan, {kIfStep, cpuDeviceName, kGotoStep, cpuDeviceName});
+}
+
+TEST_F(ControlFlowPartitioningTest, WHILE_FusedOnCpu) {
+    const auto models = createWhileModel();
+
+    // The device supports no operation, so the condition and body models run
+    // on the CPU.
+    const auto devices = makeDevices({{"V1_0", 0.9, HalVersion::V1_0, 0U}});
+    const auto& cpuDeviceName = DeviceManager::getCpuDevice()->getName();
+
+    ExecutionPlan fusedPlan;
+    ASSERT_EQ(models[0]->partitionTheWork(devices, ExecutePreference::PREFER_LOW_POWER,
+                                          ExecutePriority::DEFAULT, {}, &fusedPlan),
+              ANEURALNETWORKS_NO_ERROR);
+    checkExecutionPlanSteps(fusedPlan, {cpuDeviceName});
+
+    DeviceManager::get()->setFuseCpuControlFlow(false);
+    const auto restoreFusion = android::base::make_scope_guard(
+            [] { DeviceManager::get()->setFuseCpuControlFlow(true); });
+    ExecutionPlan interpretedPlan;
+    ASSERT_EQ(models[0]->partitionTheWork(devices, ExecutePreference::PREFER_LOW_POWER,
+                                          ExecutePriority::DEFAULT, {}, &interpretedPlan),
+              ANEURALNETWORKS_NO_ERROR);
+    checkExecutionPlanSteps(interpretedPlan,
+                            {kWhileStep, cpuDeviceName, kGotoStep, cpuDeviceName, kGotoStep});
+}
+
 void ControlFlowPartitioningTest::testIfUnknownSize(Dimensioned dimensionedMain,
                                                     Dimensioned dimensionedThen,
                                                     Dimensioned dimensionedElse) {
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests the kernels of quant8 ADD, MUL and SUB specialized for scalar inputs
+// and for inputs quantized like the output against the general kernels.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "TestNeuralNetworksWrapper.h"
+
+namespace android::nn {
+namespace {
+
+using Result = test_wrapper::Result;
+using WrapperCompilation = test_wrapper::Compilation;
+using WrapperExecution = test_wrapper::Execution;
+using WrapperModel = test_wrapper::Model;
+using WrapperOperandType = test_wrapper::OperandType;
+using WrapperType = test_wrapper::Type;
+
+const WrapperOperandType kActivationType(WrapperType::INT32, {});
+
+std::vector<uint8_t> compute(ANeuralNetworksOperationType operation,
+                             const WrapperOperandType& type1, const std::vector<uint8_t>& input1,
+                             const WrapperOperandType& type2, const std::vector<uint8_t>& input2,
+                             const WrapperOperandType& outputType, int32_t activation) {
+    WrapperModel model;
+    const uint32_t in1 = model.addOperand(&type1);
+    const uint32_t in2 = model.addOperand(&type2);
+    const uint32_t act = model.addConstantOperand(&kActivationType, activation);
+    const uint32_t out = model.addOperand(&outputType);
+    model.addOperation(operation, {in1, in2, act}, {out});
+    model.identifyInputsAndOutputs({in1, in2}, {out});
+    EXPECT_EQ(model.finish(), Result::NO_ERROR);
+
+    WrapperCompilation compilation(&model);
+    EXPECT_EQ(compilation.finish(), Result::NO_ERROR);
+    size_t outputSize = 1;
+    for (uint32_t dimension : outputType.dimensions) {
+        outputSize *= dimension;
+    }
+    std::vector<uint8_t> output(outputSize);
+    WrapperExecution execution(&compilation);
+    EXPECT_EQ(execution.setInput(0, input1.data(), input1.size()), Result::NO_ERROR);
+    EXPECT_EQ(execution.setInput(1, input2.data(), input2.size()), Result::NO_ERROR);
+    EXPECT_EQ(execution.setOutput(0, output.data(), output.size()), Result::NO_ERROR);
+    EXPECT_EQ(execution.compute(), Result::NO_ERROR);
+    return output;
+}
+
+std::vector<uint8_t> iota(size_t size, uint32_t step) {
+    std::vector<uint8_t> values(size);
+    for (size_t i = 0; i < size; ++i) {
+        values[i] = static_cast<uint8_t>(i * step);
+    }
+    return values;
+}
+
+std::vector<uint8_t> tile(const std::vector<uint8_t>& values, uint32_t outer, uint32_t repeats,
+                          uint32_t inner) {
+    std::vector<uint8_t> tiled;
+    tiled.reserve(outer * repeats * inner);
+    for (uint32_t i = 0; i < outer; ++i) {
+        for (uint32_t j = 0; j < repeats; ++j) {
+            tiled.insert(tiled.end(), values.begin() + i * inner,
+                         values.begin() + (i + 1) * inner);
+        }
+    }
+    return tiled;
+}
+
+// ADD and SUB whose inputs are quantized like the output, with an input of the
+// shape of the output or repeated along its leading dimensions, give the same
+// output as the general kernels. The general kernels are run on the same
+// values broadcast from inputs of shapes [N, 1, C] and [1, M, C], neither of
+// which is of the shape of the output. C and N * M * C are not multiples of 16.
+TEST(Quant8ArithmeticTest, SameQuantization) {
+    static constexpr uint32_t kN = 5;
+    static constexpr uint32_t kM = 7;
+    static constexpr uint32_t kC = 13;
+    const std::vector<uint8_t> a = iota(kN * kC, 7);
+    const std::vector<uint8_t> b = iota(kM * kC, 13);
+    const std::vector<uint8_t> channel = iota(kC, 17);
+    // [N, 1, C] and [1, M, C] tiled to [N, M, C].
+    const std::vector<uint8_t> fullA = tile(a, kN, kM, kC);
+    const std::vector<uint8_t> fullB = tile(b, 1, kN, kM * kC);
+    // The channel tiled to [1, M, C].
+    const std::vector<uint8_t> channelB = tile(channel, 1, kM, kC);
+
+    for (const WrapperType type :
+         {WrapperType::TENSOR_QUANT8_ASYMM, WrapperType::TENSOR_QUANT8_ASYMM_SIGNED}) {
+        const bool isSigned = type == WrapperType::TENSOR_QUANT8_ASYMM_SIGNED;
+        SCOPED_TRACE(isSigned ? "TENSOR_QUANT8_ASYMM_SIGNED" : "TENSOR_QUANT8_ASYMM");
+        const float scale = 0.5f;
+        const int32_t zeroPoint = isSigned ? -28 : 100;
+        const WrapperOperandType fullType(type, {kN, kM, kC}, scale, zeroPoint);
+        const WrapperOperandType channelType(type, {kC}, scale, zeroPoint);
+        const WrapperOperandType typeA(type, {kN, 1, kC}, scale, zeroPoint);
+        const WrapperOperandType typeB(type, {1, kM, kC}, scale, zeroPoint);
+
+        for (const ANeuralNetworksOperationType operation :
+             {ANEURALNETWORKS_ADD, ANEURALNETWORKS_SUB}) {
+            SCOPED_TRACE(operation == ANEURALNETWORKS_SUB ? "SUB" : "ADD");
+            for (const int32_t activation : {ANEURALNETWORKS_FUSED_NONE,
+                                             ANEURALNETWORKS_FUSED_RELU}) {
+                SCOPED_TRACE(activation);
+                EXPECT_EQ(compute(operation, fullType, fullA, fullType, fullB, fullType,
+                                  activation),
+                          compute(operation, typeA, a, typeB, b, fullType, activation));
+                EXPECT_EQ(compute(operation, fullType, fullA, channelType, channel, fullType,
+                                  activation),
+                          compute(operation, typeA, a, typeB, channelB, fullType, activation));
+                EXPECT_EQ(compute(operation, channelType, channel, fullType, fullA, fullType,
+                                  activation),
+                          compute(operation, typeB, channelB, typeA, a, fullType, activation));
+            }
+        }
+    }
+}
+
+// A scalar input gives the same output as a tensor filled with its value. The
+// table computed for a scalar is cached, and is not reused for another value.
+TEST(Quant8ArithmeticTest, ScalarInput) {
+    constexpr uint32_t kSize = 4096;
+    const WrapperOperandType tensorType(WrapperType::TENSOR_QUANT8_ASYMM, {kSize}, 0.5f, 120);
+    const WrapperOperandType scalarType(WrapperType::TENSOR_QUANT8_ASYMM, {1}, 0.25f, 128);
+    const WrapperOperandType filledType(WrapperType::TENSOR_QUANT8_ASYMM, {kSize}, 0.25f, 128);
+    const WrapperOperandType outputType(WrapperType::TENSOR_QUANT8_ASYMM, {kSize}, 1.0f, 128);
+    const std::vector<uint8_t> input = iota(kSize, 1);
+
+    for (const uint8_t value : {200, 50, 200}) {
+        SCOPED_TRACE(static_cast<int>(value));
+        const std::vector<uint8_t> scalar = {value};
+        const std::vector<uint8_t> filled(kSize, value);
+        for (const ANeuralNetworksOperationType operation :
+             {ANEURALNETWORKS_MUL, ANEURALNETWORKS_SUB}) {
+            SCOPED_TRACE(operation == ANEURALNETWORKS_MUL ? "MUL" : "SUB");
+            EXPECT_EQ(compute(operation, tensorType, input, scalarType, scalar, outputType,
+                              ANEURALNETWORKS_FUSED_RELU6),
+                      compute(operation, tensorType, input, filledType, filled, outputType,
+                              ANEURALNETWORKS_FUSED_RELU6));
+            EXPECT_EQ(compute(operation, scalarType, scalar, tensorType, input, outputType,
+                              ANEURALNETWORKS_FUSED_NONE),
+                      compute(operation, filledType, filled, tensorType, input, outputType,
+                              ANEURALNETWORKS_FUSED_NONE));
+        }
+    }
+}
+
+}  // namespace
+}  // namespace android::nn
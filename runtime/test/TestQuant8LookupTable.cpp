@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests that quant8 elementwise operations computed with a lookup table, on
+// tensors of at least 256 elements, give the same output as the kernels that
+// compute smaller tensors directly.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "TestNeuralNetworksWrapper.h"
+
+namespace android::nn {
+namespace {
+
+using Result = test_wrapper::Result;
+using WrapperCompilation = test_wrapper::Compilation;
+using WrapperExecution = test_wrapper::Execution;
+using WrapperModel = test_wrapper::Model;
+using WrapperOperandType = test_wrapper::OperandType;
+using WrapperType = test_wrapper::Type;
+
+// Tensors of this many elements are computed directly.
+constexpr uint32_t kDirectSize = 128;
+// Tensors of this many elements are computed with the lookup table.
+constexpr uint32_t kTableSize = 4 * kDirectSize;
+
+struct OperationParams {
+    ANeuralNetworksOperationType operation;
+    const char* name;
+    float inputScale;
+    int32_t inputZeroPoint;
+    float outputScale;
+    int32_t outputZeroPoint;
+};
+
+std::vector<uint8_t> compute(const OperationParams& params, WrapperType type,
+                             const std::vector<uint8_t>& input) {
+    const uint32_t size = input.size();
+    const WrapperOperandType inputType(type, {size}, params.inputScale, params.inputZeroPoint);
+    const WrapperOperandType outputType(type, {size}, params.outputScale, params.outputZeroPoint);
+    WrapperModel model;
+    const uint32_t in = model.addOperand(&inputType);
+    const uint32_t out = model.addOperand(&outputType);
+    model.addOperation(params.operation, {in}, {out});
+    model.identifyInputsAndOutputs({in}, {out});
+    EXPECT_EQ(model.finish(), Result::NO_ERROR);
+
+    WrapperCompilation compilation(&model);
+    EXPECT_EQ(compilation.finish(), Result::NO_ERROR);
+    std::vector<uint8_t> output(size);
+    WrapperExecution execution(&compilation);
+    EXPECT_EQ(execution.setInput(0, input.data(), input.size()), Result::NO_ERROR);
+    EXPECT_EQ(execution.setOutput(0, output.data(), output.size()), Result::NO_ERROR);
+    EXPECT_EQ(execution.compute(), Result::NO_ERROR);
+    return output;
+}
+
+TEST(Quant8LookupTableTest, MatchesDirectKernel) {
+    // Every input value appears twice, in a different order each time.
+    std::vector<uint8_t> input(kTableSize);
+    for (uint32_t i = 0; i < kTableSize; ++i) {
+        input[i] = static_cast<uint8_t>(i < 256 ? i : (i * 37 + 11));
+    }
+
+    for (const WrapperType type :
+         {WrapperType::TENSOR_QUANT8_ASYMM, WrapperType::TENSOR_QUANT8_ASYMM_SIGNED}) {
+        const bool isSigned = type == WrapperType::TENSOR_QUANT8_ASYMM_SIGNED;
+        SCOPED_TRACE(isSigned ? "TENSOR_QUANT8_ASYMM_SIGNED" : "TENSOR_QUANT8_ASYMM");
+        const int32_t offset = isSigned ? -128 : 0;
+        // The output quantizations of TANH and LOGISTIC are fixed.
+        const OperationParams allParams[] = {
+                {ANEURALNETWORKS_TANH, "TANH", 0.05f, 128 + offset, 1.0f / 128, 128 + offset},
+                {ANEURALNETWORKS_LOGISTIC, "LOGISTIC", 0.05f, 100 + offset, 1.0f / 256, offset},
+                {ANEURALNETWORKS_HARD_SWISH, "HARD_SWISH", 0.05f, 140 + offset, 0.04f,
+                 50 + offset},
+                {ANEURALNETWORKS_RSQRT, "RSQRT", 0.02f, 10 + offset, 0.1f, offset},
+        };
+        for (const OperationParams& params : allParams) {
+            SCOPED_TRACE(params.name);
+            const std::vector<uint8_t> table = compute(params, type, input);
+            ASSERT_EQ(table.size(), kTableSize);
+            for (uint32_t begin = 0; begin < kTableSize; begin += kDirectSize) {
+                const std::vector<uint8_t> direct =
+                        compute(params, type,
+                                std::vector<uint8_t>(input.begin() + begin,
+                                                     input.begin() + begin + kDirectSize));
+                for (uint32_t i = 0; i < kDirectSize; ++i) {
+                    ASSERT_EQ(table[begin + i], direct[i])
+                            << "for input " << static_cast<int>(input[begin + i]);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests of the memfd backend of createSharedMemory on Linux host builds. The
+// rest of the runtime tests also run against it on the host, and with pages
+// reserved in hugetlbfs when NN_MEMFD_HUGETLB is set.
+
+#include <gtest/gtest.h>
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+#include <fcntl.h>
+#include <nnapi/SharedMemory.h>
+#include <nnapi/Types.h>
+#include <sys/mman.h>
+
+#include <cstring>
+#include <numeric>
+#include <variant>
+#include <vector>
+
+namespace android::nn {
+namespace {
+
+int getSeals(const SharedMemory& memory) {
+    const auto* fdMemory = std::get_if<Memory::Fd>(&memory->handle);
+    return fdMemory == nullptr ? -1 : fcntl(fdMemory->fd.get(), F_GET_SEALS);
+}
+
+TEST(SharedMemoryTest, SizeOfMemfdIsSealed) {
+    constexpr size_t kSize = 1000;
+    const auto memory = createSharedMemory(kSize);
+    ASSERT_TRUE(memory.ok()) << memory.error().message;
+    EXPECT_EQ(getSize(memory.value()), kSize);
+
+    const int seals = getSeals(memory.value());
+    ASSERT_NE(seals, -1);
+    EXPECT_NE(seals & F_SEAL_SHRINK, 0);
+    EXPECT_NE(seals & F_SEAL_GROW, 0);
+    EXPECT_EQ(seals & F_SEAL_WRITE, 0);
+
+    const auto mapping = map(memory.value());
+    ASSERT_TRUE(mapping.ok()) << mapping.error().message;
+    ASSERT_TRUE(std::holds_alternative<void*>(mapping.value().pointer));
+    std::memset(std::get<void*>(mapping.value().pointer), 0x5a, kSize);
+    EXPECT_TRUE(flush(mapping.value()));
+}
+
+TEST(SharedMemoryTest, LargeMemoryIsMapped) {
+    // Large enough for huge pages.
+    constexpr size_t kSize = 8 * 1024 * 1024;
+    const auto memory = createSharedMemory(kSize);
+    ASSERT_TRUE(memory.ok()) << memory.error().message;
+    const auto mapping = map(memory.value());
+    ASSERT_TRUE(mapping.ok()) << mapping.error().message;
+    auto* data = static_cast<uint8_t*>(std::get<void*>(mapping.value().pointer));
+    std::memset(data, 0x5a, kSize);
+    EXPECT_EQ(data[0], 0x5a);
+    EXPECT_EQ(data[kSize - 1], 0x5a);
+}
+
+TEST(SharedMemoryTest, ConstantMemoryIsReadOnly) {
+    std::vector<uint8_t> values(4096);
+    std::iota(values.begin(), values.end(), 0);
+    ConstantMemoryBuilder builder(/*poolIndex=*/0);
+    const DataLocation location = builder.append(values.data(), values.size());
+    const auto memory = builder.finish();
+    ASSERT_TRUE(memory.ok()) << memory.error().message;
+
+    const int seals = getSeals(memory.value());
+    ASSERT_NE(seals, -1);
+    EXPECT_NE(seals & F_SEAL_WRITE, 0);
+    const auto& fdMemory = std::get<Memory::Fd>(memory.value()->handle);
+    EXPECT_EQ(fdMemory.prot, PROT_READ);
+    void* writable = mmap(nullptr, fdMemory.size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          fdMemory.fd.get(), 0);
+    EXPECT_EQ(writable, MAP_FAILED);
+
+    const auto mapping = map(memory.value());
+    ASSERT_TRUE(mapping.ok()) << mapping.error().message;
+    ASSERT_TRUE(std::holds_alternative<const void*>(mapping.value().pointer));
+    const auto* data = static_cast<const uint8_t*>(std::get<const void*>(mapping.value().pointer));
+    EXPECT_EQ(std::memcmp(data + location.offset, values.data(), values.size()), 0);
+}
+
+TEST(SharedMemoryTest, MappedMemoryIsNotSealed) {
+    const auto memory = createSharedMemory(1000);
+    ASSERT_TRUE(memory.ok()) << memory.error().message;
+    const auto mapping = map(memory.value());
+    ASSERT_TRUE(mapping.ok()) << mapping.error().message;
+
+    const auto sealed = sealSharedMemory(memory.value());
+    ASSERT_TRUE(sealed.ok()) << sealed.error().message;
+    EXPECT_EQ(sealed.value(), memory.value());
+    EXPECT_EQ(getSeals(memory.value()) & F_SEAL_WRITE, 0);
+}
+
+}  // namespace
+}  // namespace android::nn
+
+#endif  // defined(__linux__) && !defined(__ANDROID__)
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "TokenTable.h"
+
+namespace android::nn {
+namespace {
+
+TEST(TokenTableTest, TokensAreReused) {
+    TokenTable<int> table;
+    EXPECT_EQ(table.get(0), nullptr);
+    const uint32_t first = table.add(std::make_shared<int>(1));
+    const uint32_t second = table.add(std::make_shared<int>(2));
+    EXPECT_EQ(first, 1u);
+    EXPECT_EQ(second, 2u);
+    EXPECT_EQ(*table.get(first), 1);
+    EXPECT_EQ(*table.get(second), 2);
+
+    EXPECT_EQ(*table.free(first), 1);
+    EXPECT_EQ(table.get(first), nullptr);
+    EXPECT_EQ(table.free(first), nullptr);
+    EXPECT_EQ(table.add(std::make_shared<int>(3)), first);
+    EXPECT_EQ(*table.get(first), 3);
+}
+
+TEST(TokenTableTest, UnknownTokens) {
+    TokenTable<int> table;
+    EXPECT_EQ(table.get(1), nullptr);
+    EXPECT_EQ(table.get(TokenTable<int>::kChunkSize + 1), nullptr);
+    EXPECT_EQ(table.get(TokenTable<int>::kMaxTokens), nullptr);
+    EXPECT_EQ(table.free(0), nullptr);
+    EXPECT_EQ(table.free(1), nullptr);
+}
+
+TEST(TokenTableTest, GrowsAcrossChunks) {
+    TokenTable<uint32_t> table;
+    std::vector<uint32_t> tokens;
+    for (uint32_t i = 0; i < 3 * TokenTable<uint32_t>::kChunkSize; ++i) {
+        tokens.push_back(table.add(std::make_shared<uint32_t>(i)));
+    }
+    for (uint32_t i = 0; i < tokens.size(); ++i) {
+        ASSERT_NE(table.get(tokens[i]), nullptr);
+        EXPECT_EQ(*table.get(tokens[i]), i);
+    }
+}
+
+TEST(TokenTableTest, ConcurrentLookups) {
+    constexpr uint32_t kThreads = 8;
+    constexpr uint32_t kRounds = 2000;
+    TokenTable<uint32_t> table;
+    const uint32_t stable = table.add(std::make_shared<uint32_t>(42));
+    std::atomic<bool> failed = false;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&table, &failed, stable, t] {
+            for (uint32_t i = 0; i < kRounds; ++i) {
+                // Half of the threads also allocate and free tokens, which
+                // writes slots of the table while the others look up.
+                if (t % 2 == 0) {
+                    const uint32_t token = table.add(std::make_shared<uint32_t>(i));
+                    const auto value = table.get(token);
+                    if (value == nullptr || *value != i || table.free(token) == nullptr) {
+                        failed = true;
+                    }
+                }
+                const auto value = table.get(stable);
+                if (value == nullptr || *value != 42) {
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(failed);
+}
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TraceRecorder.h"
+#include "Tracing.h"
+
+namespace android::nn {
+namespace {
+
+class TraceRecorderTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        clearTraceRecording();
+        startTraceRecording();
+    }
+
+    void TearDown() override { stopTraceRecording(); }
+
+    static std::string getTrace() {
+        std::ostringstream out;
+        writeChromeTrace(&out);
+        return out.str();
+    }
+
+    static size_t count(const std::string& trace, const std::string& value) {
+        size_t count = 0;
+        for (size_t i = trace.find(value); i != std::string::npos; i = trace.find(value, i + 1)) {
+            ++count;
+        }
+        return count;
+    }
+};
+
+void execute() {
+    NNTRACE_RT(NNTRACE_PHASE_EXECUTION, "execute");
+    {
+        NNTRACE_TRANS("transform");
+        NNTRACE_COMP_SWITCH("compute");
+    }
+}
+
+TEST_F(TraceRecorderTest, RecordsSpans) {
+    execute();
+    const std::string trace = getTrace();
+    EXPECT_EQ(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0u);
+    EXPECT_NE(trace.find("\"name\":\"execute\",\"cat\":\"runtime\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"transform\",\"cat\":\"cpu\""), std::string::npos);
+    EXPECT_NE(trace.find("\"phase\":\"transformation\""), std::string::npos);
+    EXPECT_NE(trace.find("\"phase\":\"computation\",\"kind\":\"SW\""), std::string::npos);
+    // Parents come first.
+    EXPECT_LT(trace.find("\"execute\""), trace.find("\"transform\""));
+    EXPECT_LT(trace.find("\"transform\""), trace.find("\"compute\""));
+}
+
+TEST_F(TraceRecorderTest, OnlyRecordsWhileRecording) {
+    stopTraceRecording();
+    execute();
+    EXPECT_EQ(count(getTrace(), "\"execute\""), 0u);
+
+    startTraceRecording();
+    execute();
+    execute();
+    EXPECT_EQ(count(getTrace(), "\"execute\""), 2u);
+
+    clearTraceRecording();
+    EXPECT_EQ(count(getTrace(), "\"execute\""), 0u);
+}
+
+TEST_F(TraceRecorderTest, RecordsConcurrentThreads) {
+    constexpr uint32_t kThreads = 8;
+    constexpr uint32_t kExecutions = 100;
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([] {
+            for (uint32_t j = 0; j < kExecutions; ++j) {
+                execute();
+            }
+        });
+    }
+    // Exports while the threads record.
+    getTrace();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(count(getTrace(), "\"execute\""), kThreads * kExecutions);
+}
+
+TEST_F(TraceRecorderTest, KeepsTheLastSpansOfEachThread) {
+    std::thread([] {
+        for (uint32_t i = 0; i < kTraceEventsPerThread + 10; ++i) {
+            NNTRACE_RT(NNTRACE_PHASE_EXECUTION, "overwritten");
+        }
+    }).join();
+    EXPECT_EQ(count(getTrace(), "\"overwritten\""), kTraceEventsPerThread);
+}
+
+}  // namespace
+}  // namespace android::nn
@@ -18,6 +18,10 @@
 
 #include "NeuralNetworks.h"
 
+#ifndef NNTEST_ONLY_PUBLIC_API
+#include "ModelBuilder.h"
+#endif  // NNTEST_ONLY_PUBLIC_API
+
 namespace {
 
 class ValidateModelTest : public ::testing::Test {
@@ -3128,4 +3132,64 @@ TEST_F(ValidateModelTest, MaskRCNN2Go) {
     ANeuralNetworksModel_free(model);
 }
 
+#ifndef NNTEST_ONLY_PUBLIC_API
+// output = (input + large0) + large1, where large0 and large1 hold the same
+// values in separate buffers, and the two activation scalars are equal.
+TEST_F(ValidateModelTest, DeduplicatesConstantValues) {
+    constexpr uint32_t kSize = 64;
+    static_assert(kSize * sizeof(float) > ANEURALNETWORKS_MAX_SIZE_OF_IMMEDIATELY_COPIED_VALUES);
+    ANeuralNetworksModel* model = nullptr;
+    ASSERT_EQ(ANeuralNetworksModel_create(&model), ANEURALNETWORKS_NO_ERROR);
+    const uint32_t dimensions[] = {kSize};
+    ANeuralNetworksOperandType tensorType{};
+    tensorType.type = ANEURALNETWORKS_TENSOR_FLOAT32;
+    tensorType.dimensionCount = 1;
+    tensorType.dimensions = dimensions;
+    ANeuralNetworksOperandType activationType{};
+    activationType.type = ANEURALNETWORKS_INT32;
+    // 0: input, 1: large0, 2: activation0, 3: sum, 4: large1, 5: activation1, 6: output.
+    for (const auto* type : {&tensorType, &tensorType, &activationType, &tensorType, &tensorType,
+                             &activationType, &tensorType}) {
+        ASSERT_EQ(ANeuralNetworksModel_addOperand(model, type), ANEURALNETWORKS_NO_ERROR);
+    }
+    float large0[kSize];
+    float large1[kSize];
+    for (uint32_t i = 0; i < kSize; ++i) {
+        large0[i] = large1[i] = static_cast<float>(i);
+    }
+    const int32_t activation0 = ANEURALNETWORKS_FUSED_NONE;
+    const int32_t activation1 = ANEURALNETWORKS_FUSED_NONE;
+    ASSERT_EQ(ANeuralNetworksModel_setOperandValue(model, 1, large0, sizeof(large0)),
+              ANEURALNETWORKS_NO_ERROR);
+    ASSERT_EQ(ANeuralNetworksModel_setOperandValue(model, 2, &activation0, sizeof(activation0)),
+              ANEURALNETWORKS_NO_ERROR);
+    ASSERT_EQ(ANeuralNetworksModel_setOperandValue(model, 4, large1, sizeof(large1)),
+              ANEURALNETWORKS_NO_ERROR);
+    ASSERT_EQ(ANeuralNetworksModel_setOperandValue(model, 5, &activation1, sizeof(activation1)),
+              ANEURALNETWORKS_NO_ERROR);
+    const uint32_t inputs0[] = {0, 1, 2};
+    const uint32_t outputs0[] = {3};
+    ASSERT_EQ(ANeuralNetworksModel_addOperation(model, ANEURALNETWORKS_ADD, 3, inputs0, 1,
+                                                outputs0),
+              ANEURALNETWORKS_NO_ERROR);
+    const uint32_t inputs1[] = {3, 4, 5};
+    const uint32_t outputs1[] = {6};
+    ASSERT_EQ(ANeuralNetworksModel_addOperation(model, ANEURALNETWORKS_ADD, 3, inputs1, 1,
+                                                outputs1),
+              ANEURALNETWORKS_NO_ERROR);
+    const uint32_t modelInputs[] = {0};
+    const uint32_t modelOutputs[] = {6};
+    ASSERT_EQ(ANeuralNetworksModel_identifyInputsAndOutputs(model, 1, modelInputs, 1,
+                                                            modelOutputs),
+              ANEURALNETWORKS_NO_ERROR);
+    ASSERT_EQ(ANeuralNetworksModel_finish(model), ANEURALNETWORKS_NO_ERROR);
+    // large1 shares the shared memory copy of large0, and activation1 shares
+    // the small value storage of activation0.
+    EXPECT_EQ(reinterpret_cast<const android::nn::ModelBuilder*>(model)
+                      ->getDeduplicatedValueBytes(),
+              sizeof(large1) + sizeof(activation1));
+    ANeuralNetworksModel_free(model);
+}
+#endif  // NNTEST_ONLY_PUBLIC_API
+
 }  // namespace
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Throughput of a small classifier when N requests are computed one after
+// another, and when they are computed with ExecutionBuilder::computeBatch.
+// Reports requests per second.
+
+#include <benchmark/benchmark.h>
+
+#include <iterator>
+#include <vector>
+
+#include "ExecutionBuilder.h"
+#include "NeuralNetworks.h"
+
+namespace android::nn {
+namespace {
+
+constexpr uint32_t kInputSize = 64;
+constexpr uint32_t kHiddenSize = 32;
+constexpr uint32_t kNumClasses = 10;
+
+// SOFTMAX(FULLY_CONNECTED(RELU(FULLY_CONNECTED(input)))) on a single input.
+class SmallClassifier {
+   public:
+    SmallClassifier()
+        : mWeights0(kHiddenSize * kInputSize, 0.01f),
+          mBias0(kHiddenSize, 0.1f),
+          mWeights1(kNumClasses * kHiddenSize, 0.02f),
+          mBias1(kNumClasses, 0.0f) {
+        ANeuralNetworksModel_create(&mModel);
+        const uint32_t inputDimensions[] = {1, kInputSize};
+        const uint32_t weights0Dimensions[] = {kHiddenSize, kInputSize};
+        const uint32_t bias0Dimensions[] = {kHiddenSize};
+        const uint32_t hiddenDimensions[] = {1, kHiddenSize};
+        const uint32_t weights1Dimensions[] = {kNumClasses, kHiddenSize};
+        const uint32_t bias1Dimensions[] = {kNumClasses};
+        const uint32_t outputDimensions[] = {1, kNumClasses};
+        const auto tensor = [](const auto& dimensions) {
+            return ANeuralNetworksOperandType{
+                    .type = ANEURALNETWORKS_TENSOR_FLOAT32,
+                    .dimensionCount = static_cast<uint32_t>(std::size(dimensions)),
+                    .dimensions = dimensions};
+        };
+        const ANeuralNetworksOperandType int32Type = {.type = ANEURALNETWORKS_INT32};
+        const ANeuralNetworksOperandType float32Type = {.type = ANEURALNETWORKS_FLOAT32};
+        addOperand(tensor(inputDimensions));     // 0: input
+        addOperand(tensor(weights0Dimensions));  // 1: weights0
+        addOperand(tensor(bias0Dimensions));     // 2: bias0
+        addOperand(int32Type);                   // 3: activation0
+        addOperand(tensor(hiddenDimensions));    // 4: hidden
+        addOperand(tensor(weights1Dimensions));  // 5: weights1
+        addOperand(tensor(bias1Dimensions));     // 6: bias1
+        addOperand(int32Type);                   // 7: activation1
+        addOperand(tensor(outputDimensions));    // 8: logits
+        addOperand(float32Type);                 // 9: beta
+        addOperand(tensor(outputDimensions));    // 10: output
+        const int32_t relu = ANEURALNETWORKS_FUSED_RELU;
+        const int32_t none = ANEURALNETWORKS_FUSED_NONE;
+        const float beta = 1.0f;
+        ANeuralNetworksModel_setOperandValue(mModel, 1, mWeights0.data(),
+                                             mWeights0.size() * sizeof(float));
+        ANeuralNetworksModel_setOperandValue(mModel, 2, mBias0.data(),
+                                             mBias0.size() * sizeof(float));
+        ANeuralNetworksModel_setOperandValue(mModel, 3, &relu, sizeof(relu));
+        ANeuralNetworksModel_setOperandValue(mModel, 5, mWeights1.data(),
+                                             mWeights1.size() * sizeof(float));
+        ANeuralNetworksModel_setOperandValue(mModel, 6, mBias1.data(),
+                                             mBias1.size() * sizeof(float));
+        ANeuralNetworksModel_setOperandValue(mModel, 7, &none, sizeof(none));
+        ANeuralNetworksModel_setOperandValue(mModel, 9, &beta, sizeof(beta));
+        const uint32_t fc0Inputs[] = {0, 1, 2, 3};
+        const uint32_t fc0Outputs[] = {4};
+        const uint32_t fc1Inputs[] = {4, 5, 6, 7};
+        const uint32_t fc1Outputs[] = {8};
+        const uint32_t softmaxInputs[] = {8, 9};
+        const uint32_t softmaxOutputs[] = {10};
+        ANeuralNetworksModel_addOperation(mModel, ANEURALNETWORKS_FULLY_CONNECTED, 4, fc0Inputs, 1,
+                                          fc0Outputs);
+        ANeuralNetworksModel_addOperation(mModel, ANEURALNETWORKS_FULLY_CONNECTED, 4, fc1Inputs, 1,
+                                          fc1Outputs);
+        ANeuralNetworksModel_addOperation(mModel, ANEURALNETWORKS_SOFTMAX, 2, softmaxInputs, 1,
+                                          softmaxOutputs);
+        const uint32_t modelInputs[] = {0};
+        ANeuralNetworksModel_identifyInputsAndOutputs(mModel, 1, modelInputs, 1, softmaxOutputs);
+        ANeuralNetworksModel_finish(mModel);
+
+        ANeuralNetworksCompilation_create(mModel, &mCompilation);
+        ANeuralNetworksCompilation_finish(mCompilation);
+    }
+
+    ~SmallClassifier() {
+        ANeuralNetworksCompilation_free(mCompilation);
+        ANeuralNetworksModel_free(mModel);
+    }
+
+    // A batch of count executions, each with its own input and output.
+    class Batch {
+       public:
+        Batch(const SmallClassifier& classifier, size_t count)
+            : mInputs(count, std::vector<float>(kInputSize, 1.0f)),
+              mOutputs(count, std::vector<float>(kNumClasses)) {
+            for (size_t i = 0; i < count; ++i) {
+                ANeuralNetworksExecution* execution = nullptr;
+                ANeuralNetworksExecution_create(classifier.mCompilation, &execution);
+                ANeuralNetworksExecution_setReusable(execution, true);
+                ANeuralNetworksExecution_setInput(execution, 0, nullptr, mInputs[i].data(),
+                                                  mInputs[i].size() * sizeof(float));
+                ANeuralNetworksExecution_setOutput(execution, 0, nullptr, mOutputs[i].data(),
+                                                   mOutputs[i].size() * sizeof(float));
+                mExecutions.push_back(execution);
+            }
+        }
+
+        ~Batch() {
+            for (ANeuralNetworksExecution* execution : mExecutions) {
+                ANeuralNetworksExecution_free(execution);
+            }
+        }
+
+        bool computeOneByOne() {
+            for (ANeuralNetworksExecution* execution : mExecutions) {
+                if (ANeuralNetworksExecution_compute(execution) != ANEURALNETWORKS_NO_ERROR) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool computeBatch() {
+            std::vector<ExecutionBuilder*> builders;
+            builders.reserve(mExecutions.size());
+            for (ANeuralNetworksExecution* execution : mExecutions) {
+                builders.push_back(reinterpret_cast<ExecutionBuilder*>(execution));
+            }
+            return ExecutionBuilder::computeBatch(builders, nullptr, &mResults) ==
+                   ANEURALNETWORKS_NO_ERROR;
+        }
+
+       private:
+        std::vector<std::vector<float>> mInputs;
+        std::vector<std::vector<float>> mOutputs;
+        std::vector<ANeuralNetworksExecution*> mExecutions;
+        std::vector<int> mResults;
+    };
+
+   private:
+    void addOperand(const ANeuralNetworksOperandType& type) {
+        ANeuralNetworksModel_addOperand(mModel, &type);
+    }
+
+    std::vector<float> mWeights0;
+    std::vector<float> mBias0;
+    std::vector<float> mWeights1;
+    std::vector<float> mBias1;
+    ANeuralNetworksModel* mModel = nullptr;
+    ANeuralNetworksCompilation* mCompilation = nullptr;
+};
+
+template <bool (SmallClassifier::Batch::*compute)()>
+void BM_SmallClassifier(benchmark::State& state) {
+    const SmallClassifier classifier;
+    SmallClassifier::Batch batch(classifier, state.range(0));
+    for (auto _ : state) {
+        if (!(batch.*compute)()) {
+            state.SkipWithError("execution failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_SmallClassifier, &SmallClassifier::Batch::computeOneByOne)
+        ->RangeMultiplier(2)
+        ->Range(1, 64)
+        ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SmallClassifier, &SmallClassifier::Batch::computeBatch)
+        ->RangeMultiplier(2)
+        ->Range(1, 64)
+        ->UseRealTime();
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Token lookups of the buffer trackers, which drivers make for every memory
+// pool of every execution, from up to 16 threads executing concurrently.
+// Compares TokenTable with the single mutex the trackers used to take.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "TokenTable.h"
+
+namespace android::nn {
+namespace {
+
+constexpr uint32_t kBufferCount = 64;
+
+// How the buffer trackers used to map tokens to buffers.
+template <typename Type>
+class MutexTable {
+   public:
+    MutexTable() : mObjects(1) {}
+
+    uint32_t add(std::shared_ptr<Type> object) {
+        std::lock_guard<std::mutex> guard(mMutex);
+        uint32_t token = 0;
+        if (mFreeTokens.empty()) {
+            token = mObjects.size();
+            mObjects.push_back(std::move(object));
+        } else {
+            token = mFreeTokens.back();
+            mFreeTokens.pop_back();
+            mObjects[token] = std::move(object);
+        }
+        return token;
+    }
+
+    std::shared_ptr<Type> get(uint32_t token) const {
+        std::lock_guard<std::mutex> guard(mMutex);
+        return token < mObjects.size() ? mObjects[token] : nullptr;
+    }
+
+    std::shared_ptr<Type> free(uint32_t token) {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mFreeTokens.push_back(token);
+        return std::move(mObjects[token]);
+    }
+
+   private:
+    mutable std::mutex mMutex;
+    std::vector<uint32_t> mFreeTokens;
+    std::vector<std::shared_ptr<Type>> mObjects;
+};
+
+struct Buffer {
+    std::vector<uint8_t> data = std::vector<uint8_t>(64);
+};
+
+template <typename Table>
+class Tracker {
+   public:
+    static Tracker& get() {
+        static Tracker* const tracker = new Tracker();
+        return *tracker;
+    }
+
+    Table table;
+    std::vector<uint32_t> tokens;
+
+   private:
+    Tracker() {
+        for (uint32_t i = 0; i < kBufferCount; ++i) {
+            tokens.push_back(table.add(std::make_shared<Buffer>()));
+        }
+    }
+};
+
+// Each iteration looks up the buffer of a request.
+template <typename Table>
+void BM_Get(benchmark::State& state) {
+    auto& tracker = Tracker<Table>::get();
+    size_t i = state.thread_index();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tracker.table.get(tracker.tokens[i++ % kBufferCount]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Get, MutexTable<Buffer>)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Get, TokenTable<Buffer>)->ThreadRange(1, 16)->UseRealTime();
+
+// As BM_Get, but every thread looks up the same buffer, as executions of one
+// request running concurrently do.
+template <typename Table>
+void BM_GetSameToken(benchmark::State& state) {
+    auto& tracker = Tracker<Table>::get();
+    const uint32_t token = tracker.tokens.front();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tracker.table.get(token));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_GetSameToken, MutexTable<Buffer>)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_GetSameToken, TokenTable<Buffer>)->ThreadRange(1, 16)->UseRealTime();
+
+// As BM_Get, but the first thread allocates and frees a buffer instead, as a
+// client allocating device memories while the others execute.
+template <typename Table>
+void BM_GetWhileAllocating(benchmark::State& state) {
+    auto& tracker = Tracker<Table>::get();
+    size_t i = state.thread_index();
+    const bool allocates = state.thread_index() == 0;
+    for (auto _ : state) {
+        if (allocates) {
+            tracker.table.free(tracker.table.add(std::make_shared<Buffer>()));
+        } else {
+            benchmark::DoNotOptimize(tracker.table.get(tracker.tokens[i++ % kBufferCount]));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_GetWhileAllocating, MutexTable<Buffer>)->Threads(16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_GetWhileAllocating, TokenTable<Buffer>)->Threads(16)->UseRealTime();
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Notify to wake latency of the completion signal of an execution. Each
+// iteration is a round trip between two threads: the benchmark thread raises a
+// signal that a responder thread waits on, and waits on a signal that the
+// responder raises in turn.
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CompletionSignal.h"
+#include "Event.h"
+#include "ExecutionCallback.h"
+
+namespace android::nn {
+namespace {
+
+// How ExecutionCallback used to wait.
+class MutexSignal {
+   public:
+    void signal() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSignaled = true;
+        }
+        mCondition.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mSignaled; });
+    }
+
+   private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mSignaled = false;
+};
+
+class BlockingSignal : public CompletionSignal {
+   public:
+    BlockingSignal() : CompletionSignal(std::chrono::nanoseconds::zero()) {}
+};
+
+class SpinningSignal : public CompletionSignal {
+   public:
+    SpinningSignal() : CompletionSignal(kDefaultSpinDuration) {}
+};
+
+template <typename Signal>
+void BM_RoundTrip(benchmark::State& state) {
+    const size_t iterations = state.max_iterations;
+    const auto pings = std::make_unique<Signal[]>(iterations);
+    const auto pongs = std::make_unique<Signal[]>(iterations);
+    std::thread responder([&pings, &pongs, iterations] {
+        for (size_t i = 0; i < iterations; ++i) {
+            pings[i].wait();
+            pongs[i].signal();
+        }
+    });
+    size_t i = 0;
+    for (auto _ : state) {
+        pings[i].signal();
+        pongs[i].wait();
+        ++i;
+    }
+    responder.join();
+}
+BENCHMARK_TEMPLATE(BM_RoundTrip, MutexSignal)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_RoundTrip, BlockingSignal)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_RoundTrip, SpinningSignal)->UseRealTime();
+
+// The responder notifies an ExecutionCallback, and the benchmark thread waits
+// on it through the CallbackEvent returned by ANeuralNetworksExecution_startCompute.
+void BM_ExecutionCallbackRoundTrip(benchmark::State& state) {
+    const size_t iterations = state.max_iterations;
+    const auto pings = std::make_unique<SpinningSignal[]>(iterations);
+    std::vector<std::shared_ptr<ExecutionCallback>> callbacks(iterations);
+    for (auto& callback : callbacks) {
+        callback = std::make_shared<ExecutionCallback>();
+    }
+    std::thread responder([&pings, &callbacks, iterations] {
+        for (size_t i = 0; i < iterations; ++i) {
+            pings[i].wait();
+            callbacks[i]->notify(ErrorStatus::NONE, {}, {});
+        }
+    });
+    size_t i = 0;
+    bool failed = false;
+    for (auto _ : state) {
+        const CallbackEvent event(callbacks[i]);
+        pings[i].signal();
+        failed |= event.wait() != ErrorStatus::NONE;
+        ++i;
+    }
+    responder.join();
+    if (failed) {
+        state.SkipWithError("unexpected status");
+    }
+}
+BENCHMARK(BM_ExecutionCallbackRoundTrip)->UseRealTime();
+
+}  // namespace
+}  // namespace android::nn
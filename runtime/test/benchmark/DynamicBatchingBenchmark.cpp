@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Latency and throughput of a small classifier under a synthetic load: a
+// number of clients each start single-sample asynchronous executions and wait
+// for them, one after another. Arguments are the number of clients and the
+// batching window in microseconds, 0 meaning that dynamic batching is off.
+// Reports requests per second, the p50 and p99 latency of a request, and the
+// size of the largest batch.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "CompilationBuilder.h"
+#include "DynamicBatcher.h"
+#include "NeuralNetworks.h"
+
+namespace android::nn {
+namespace {
+
+constexpr uint32_t kInputSize = 64;
+constexpr uint32_t kHiddenSize = 32;
+constexpr uint32_t kNumClasses = 10;
+constexpr uint32_t kMaxBatchSize = 64;
+constexpr size_t kRequestsPerClient = 32;
+
+// SOFTMAX(FULLY_CONNECTED(RELU(FULLY_CONNECTED(input)))), the batch dimension
+// of the input and output being unspecified.
+class BatchableClassifier {
+   public:
+    explicit BatchableClassifier(std::chrono::microseconds window)
+        : mWeights0(kHiddenSize * kInputSize, 0.01f),
+          mBias0(kHiddenSize, 0.1f),
+          mWeights1(kNumClasses * kHiddenSize, 0.02f),
+          mBias1(kNumClasses, 0.0f) {
+        ANeuralNetworksModel_create(&mModel);
+        const uint32_t inputDimensions[] = {0, kInputSize};
+        const uint32_t weights0Dimensions[] = {kHiddenSize, kInputSize};
+        const uint32_t bias0Dimensions[] = {kHiddenSize};
+        const uint32_t hiddenDimensions[] = {0, kHiddenSize};
+        const uint32_t weights1Dimensions[] = {kNumClasses, kHiddenSize};
+        const uint32_t bias1Dimensions[] = {kNumClasses};
+        const uint32_t outputDimensions[] = {0, kNumClasses};
+        const auto tensor = [](const auto& dimensions) {
+            return ANeuralNetworksOperandType{
+                    .type = ANEURALNETWORKS_TENSOR_FLOAT32,
+                    .dimensionCount = static_cast<uint32_t>(std::size(dimensions)),
+                    .dimensions = dimensions};
+        };
+        const ANeuralNetworksOperandType int32Type = {.type = ANEURALNETWORKS_INT32};
+        const ANeuralNetworksOperandType float32Type = {.type = ANEURALNETWORKS_FLOAT32};
+        addOperand(tensor(inputDimensions));     // 0: input
+        addOperand(tensor(weights0Dimensions));  // 1: weights0
+        addOperand(tensor(bias0Dimensions));     // 2: bias0
+        addOperand(int32Type);                   // 3: activation0
+        addOperand(tensor(hiddenDimensions));    // 4: hidden
+        addOperand(tensor(weights1Dimensions));  // 5: weights1
+        addOperand(tensor(bias1Dimensions));     // 6: bias1
+        addOperand(int32Type);                   // 7: activation1
+        addOperand(tensor(outputDimensions));    // 8: logits
+        addOperand(float32Type);                 // 9: beta
+        addOperand(tensor(outputDimensions));    // 10: output
+        const int32_t relu = ANEURALNETWORKS_FUSED_RELU;
+        const int32_t none = ANEURALNETWORKS_FUSED_NONE;
+        const float beta = 1.0f;
+        ANeuralNetworksModel_setOperandValue(mModel, 1, mWeights0.data(),
+                                             mWeights0.size() * sizeof(float));
+        ANeuralNetworksModel_setOperandValue(mModel, 2, mBias0.data(),
+                                             mBias0.size() * sizeof(float));
+        ANeuralNetworksModel_setOperandValue(mModel, 3, &relu, sizeof(relu));
+        ANeuralNetworksModel_setOperandValue(mModel, 5, mWeights1.data(),
+                                             mWeights1.size() * sizeof(float));
+        ANeuralNetworksModel_setOperandValue(mModel, 6, mBias1.data(),
+                                             mBias1.size() * sizeof(float));
+        ANeuralNetworksModel_setOperandValue(mModel, 7, &none, sizeof(none));
+        ANeuralNetworksModel_setOperandValue(mModel, 9, &beta, sizeof(beta));
+        const uint32_t fc0Inputs[] = {0, 1, 2, 3};
+        const uint32_t fc0Outputs[] = {4};
+        const uint32_t fc1Inputs[] = {4, 5, 6, 7};
+        const uint32_t fc1Outputs[] = {8};
+        const uint32_t softmaxInputs[] = {8, 9};
+        const uint32_t softmaxOutputs[] = {10};
+        ANeuralNetworksModel_addOperation(mModel, ANEURALNETWORKS_FULLY_CONNECTED, 4, fc0Inputs, 1,
+                                          fc0Outputs);
+        ANeuralNetworksModel_addOperation(mModel, ANEURALNETWORKS_FULLY_CONNECTED, 4, fc1Inputs, 1,
+                                          fc1Outputs);
+        ANeuralNetworksModel_addOperation(mModel, ANEURALNETWORKS_SOFTMAX, 2, softmaxInputs, 1,
+                                          softmaxOutputs);
+        const uint32_t modelInputs[] = {0};
+        ANeuralNetworksModel_identifyInputsAndOutputs(mModel, 1, modelInputs, 1, softmaxOutputs);
+        ANeuralNetworksModel_finish(mModel);
+
+        ANeuralNetworksCompilation_create(mModel, &mCompilation);
+        ANeuralNetworksCompilation_finish(mCompilation);
+        // Each row is classified on its own, so the rows are independent.
+        if (window.count() > 0) {
+            reinterpret_cast<CompilationBuilder*>(mCompilation)
+                    ->setDynamicBatching(window, kMaxBatchSize, true);
+        }
+    }
+
+    ~BatchableClassifier() {
+        ANeuralNetworksCompilation_free(mCompilation);
+        ANeuralNetworksModel_free(mModel);
+    }
+
+    // Classifies a single input, and waits for the result.
+    bool classify(const float* input, float* output) const {
+        const uint32_t dimensions[] = {1, kInputSize};
+        const ANeuralNetworksOperandType type = {.type = ANEURALNETWORKS_TENSOR_FLOAT32,
+                                                 .dimensionCount = 2,
+                                                 .dimensions = dimensions};
+        ANeuralNetworksExecution* execution = nullptr;
+        ANeuralNetworksEvent* event = nullptr;
+        bool success =
+                ANeuralNetworksExecution_create(mCompilation, &execution) ==
+                        ANEURALNETWORKS_NO_ERROR &&
+                ANeuralNetworksExecution_setInput(execution, 0, &type, input,
+                                                  kInputSize * sizeof(float)) ==
+                        ANEURALNETWORKS_NO_ERROR &&
+                ANeuralNetworksExecution_setOutput(execution, 0, nullptr, output,
+                                                   kNumClasses * sizeof(float)) ==
+                        ANEURALNETWORKS_NO_ERROR &&
+                ANeuralNetworksExecution_startCompute(execution, &event) ==
+                        ANEURALNETWORKS_NO_ERROR;
+        if (event != nullptr) {
+            success = ANeuralNetworksEvent_wait(event) == ANEURALNETWORKS_NO_ERROR && success;
+            ANeuralNetworksEvent_free(event);
+        }
+        ANeuralNetworksExecution_free(execution);
+        return success;
+    }
+
+    const DynamicBatcher* getDynamicBatcher() const {
+        return reinterpret_cast<const CompilationBuilder*>(mCompilation)->getDynamicBatcher();
+    }
+
+   private:
+    void addOperand(const ANeuralNetworksOperandType& type) {
+        ANeuralNetworksModel_addOperand(mModel, &type);
+    }
+
+    std::vector<float> mWeights0;
+    std::vector<float> mBias0;
+    std::vector<float> mWeights1;
+    std::vector<float> mBias1;
+    ANeuralNetworksModel* mModel = nullptr;
+    ANeuralNetworksCompilation* mCompilation = nullptr;
+};
+
+void BM_SyntheticLoad(benchmark::State& state) {
+    const size_t clients = state.range(0);
+    const BatchableClassifier classifier(std::chrono::microseconds(state.range(1)));
+    std::vector<std::chrono::duration<double, std::micro>> latencies;
+    std::atomic<bool> failed = false;
+    for (auto _ : state) {
+        // Each client records the latency of its own requests.
+        std::vector<std::vector<std::chrono::duration<double, std::micro>>> clientLatencies(
+                clients);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < clients; ++i) {
+            threads.emplace_back([&classifier, &failed, &latencies = clientLatencies[i]] {
+                const std::vector<float> input(kInputSize, 1.0f);
+                std::vector<float> output(kNumClasses);
+                for (size_t request = 0; request < kRequestsPerClient; ++request) {
+                    const auto start = Clock::now();
+                    if (!classifier.classify(input.data(), output.data())) {
+                        failed = true;
+                    }
+                    latencies.push_back(Clock::now() - start);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        if (failed) {
+            state.SkipWithError("execution failed");
+            break;
+        }
+        for (const auto& clientLatency : clientLatencies) {
+            latencies.insert(latencies.end(), clientLatency.begin(), clientLatency.end());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * clients * kRequestsPerClient);
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](double p) {
+            return latencies[static_cast<size_t>(p * (latencies.size() - 1))].count();
+        };
+        state.counters["p50_us"] = percentile(0.50);
+        state.counters["p99_us"] = percentile(0.99);
+    }
+    if (const DynamicBatcher* batcher = classifier.getDynamicBatcher()) {
+        const DynamicBatcher::Stats stats = batcher->getStats();
+        state.counters["max_batch"] = stats.maxBatchSize;
+    }
+}
+BENCHMARK(BM_SyntheticLoad)
+        ->ArgNames({"clients", "window_us"})
+        ->ArgsProduct({{1, 4, 16, 64}, {0, 100, 500, 2000}})
+        ->UseRealTime();
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Latency of handing work to another thread, and of asynchronous executions of
+// a tiny model, which are dominated by it. Reports p50 and p99 latencies as
+// counters, in microseconds.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "ExecutionThreadPool.h"
+#include "NeuralNetworks.h"
+
+namespace android::nn {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class LatencyRecorder {
+   public:
+    explicit LatencyRecorder(benchmark::State& state) : mState(state) {
+        mLatencies.reserve(state.max_iterations);
+    }
+
+    template <typename Function>
+    void measure(const Function& function) {
+        const auto start = Clock::now();
+        function();
+        mLatencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start));
+    }
+
+    ~LatencyRecorder() {
+        if (mLatencies.empty()) {
+            return;
+        }
+        std::sort(mLatencies.begin(), mLatencies.end());
+        const auto percentile = [this](double p) {
+            return mLatencies[static_cast<size_t>(p * (mLatencies.size() - 1))].count();
+        };
+        mState.counters["p50_us"] = percentile(0.50);
+        mState.counters["p99_us"] = percentile(0.99);
+    }
+
+   private:
+    benchmark::State& mState;
+    std::vector<std::chrono::duration<double, std::micro>> mLatencies;
+};
+
+// The previous behavior of asynchronous and CPU executions.
+void BM_DispatchSpawnThread(benchmark::State& state) {
+    LatencyRecorder recorder(state);
+    for (auto _ : state) {
+        recorder.measure([] { std::thread([] { benchmark::ClobberMemory(); }).join(); });
+    }
+}
+BENCHMARK(BM_DispatchSpawnThread);
+
+void BM_DispatchThreadPool(benchmark::State& state) {
+    ExecutionThreadPool& pool = ExecutionThreadPool::get();
+    LatencyRecorder recorder(state);
+    for (auto _ : state) {
+        recorder.measure([&pool] {
+            pool.runAndWait(Priority::MEDIUM, {}, [] { benchmark::ClobberMemory(); });
+        });
+    }
+}
+BENCHMARK(BM_DispatchThreadPool);
+
+// out = in + 1 on a single float, compiled for the CPU.
+class TinyModel {
+   public:
+    TinyModel() {
+        ANeuralNetworksModel_create(&mModel);
+        const uint32_t dimensions[] = {1};
+        const ANeuralNetworksOperandType tensor = {.type = ANEURALNETWORKS_TENSOR_FLOAT32,
+                                                   .dimensionCount = 1,
+                                                   .dimensions = dimensions};
+        const ANeuralNetworksOperandType scalar = {.type = ANEURALNETWORKS_INT32};
+        ANeuralNetworksModel_addOperand(mModel, &tensor);  // 0: input
+        ANeuralNetworksModel_addOperand(mModel, &tensor);  // 1: one
+        ANeuralNetworksModel_addOperand(mModel, &scalar);  // 2: activation
+        ANeuralNetworksModel_addOperand(mModel, &tensor);  // 3: output
+        const float one = 1.0f;
+        const int32_t activation = ANEURALNETWORKS_FUSED_NONE;
+        ANeuralNetworksModel_setOperandValue(mModel, 1, &one, sizeof(one));
+        ANeuralNetworksModel_setOperandValue(mModel, 2, &activation, sizeof(activation));
+        const uint32_t inputs[] = {0, 1, 2};
+        const uint32_t outputs[] = {3};
+        ANeuralNetworksModel_addOperation(mModel, ANEURALNETWORKS_ADD, 3, inputs, 1, outputs);
+        const uint32_t modelInputs[] = {0};
+        ANeuralNetworksModel_identifyInputsAndOutputs(mModel, 1, modelInputs, 1, outputs);
+        ANeuralNetworksModel_finish(mModel);
+
+        ANeuralNetworksCompilation_create(mModel, &mCompilation);
+        ANeuralNetworksCompilation_finish(mCompilation);
+    }
+
+    ~TinyModel() {
+        ANeuralNetworksCompilation_free(mCompilation);
+        ANeuralNetworksModel_free(mModel);
+    }
+
+    bool executeAsync() {
+        ANeuralNetworksExecution* execution = nullptr;
+        ANeuralNetworksExecution_create(mCompilation, &execution);
+        ANeuralNetworksExecution_setInput(execution, 0, nullptr, &mInput, sizeof(mInput));
+        ANeuralNetworksExecution_setOutput(execution, 0, nullptr, &mOutput, sizeof(mOutput));
+        ANeuralNetworksEvent* event = nullptr;
+        int n = ANeuralNetworksExecution_startCompute(execution, &event);
+        if (n == ANEURALNETWORKS_NO_ERROR) {
+            n = ANeuralNetworksEvent_wait(event);
+            ANeuralNetworksEvent_free(event);
+        }
+        ANeuralNetworksExecution_free(execution);
+        return n == ANEURALNETWORKS_NO_ERROR;
+    }
+
+   private:
+    ANeuralNetworksModel* mModel = nullptr;
+    ANeuralNetworksCompilation* mCompilation = nullptr;
+    float mInput = 1.0f;
+    float mOutput = 0.0f;
+};
+
+void BM_TinyModelAsyncExecution(benchmark::State& state) {
+    TinyModel model;
+    LatencyRecorder recorder(state);
+    for (auto _ : state) {
+        bool ok = false;
+        recorder.measure([&model, &ok] { ok = model.executeAsync(); });
+        if (!ok) {
+            state.SkipWithError("execution failed");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_TinyModelAsyncExecution);
+
+}  // namespace
+}  // namespace android::nn
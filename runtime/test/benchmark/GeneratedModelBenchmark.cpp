@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compiles and executes every model of the generated test corpus on a single
+// device, on the host as well as on a device. For each model, reports:
+// - compile_ms: the duration of ANeuralNetworksCompilation_finish,
+// - first_inference_us: the duration of the first execution of the compilation,
+// - p50_us, p90_us and p99_us: the percentiles of the following executions,
+// - items_per_second: the executions per second.
+//
+// Usage:
+//   NeuralNetworksGeneratedBenchmark_static [--nnapi_device=cpu|sample]
+//       [--benchmark_filter=<regex>] [--benchmark_out=<file>]
+//       [--benchmark_out_format=json]
+//
+// The benchmarks are named GeneratedModel/<device>/<test model>. The JSON
+// output can be aggregated with tools/parse_benchmark.py.
+
+#include <CanonicalDevice.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "GeneratedTestUtils.h"
+#include "Manager.h"
+#include "TestHarness.h"
+#include "TestNeuralNetworksWrapper.h"
+
+namespace android::nn::generated_tests {
+namespace {
+
+using namespace test_helper;
+using test_wrapper::Compilation;
+using test_wrapper::Execution;
+using test_wrapper::Result;
+using Clock = std::chrono::steady_clock;
+
+constexpr char kDeviceFlag[] = "--nnapi_device=";
+constexpr char kCpuDeviceName[] = "nnapi-reference";
+constexpr char kSampleDeviceName[] = "generated-model-benchmark-driver";
+
+const ANeuralNetworksDevice* findDevice(const char* deviceName) {
+    uint32_t count = 0;
+    ANeuralNetworks_getDeviceCount(&count);
+    for (uint32_t i = 0; i < count; ++i) {
+        ANeuralNetworksDevice* device = nullptr;
+        const char* name = nullptr;
+        ANeuralNetworks_getDevice(i, &device);
+        ANeuralNetworksDevice_getName(device, &name);
+        if (std::strcmp(name, deviceName) == 0) {
+            return device;
+        }
+    }
+    return nullptr;
+}
+
+double toMicroseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// Precondition: !sorted.empty()
+double getPercentile(const std::vector<double>& sorted, double percentile) {
+    const size_t index = static_cast<size_t>(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Executes a new request of the compilation, as an application would for each
+// inference, and returns its duration, or nullopt on failure.
+std::optional<Clock::duration> executeOnce(const TestModel& testModel,
+                                           const Compilation& compilation) {
+    Execution execution(&compilation);
+    std::vector<TestBuffer> outputs;
+    createRequest(testModel, &execution, &outputs);
+    const auto start = Clock::now();
+    if (execution.compute(Execution::ComputeMode::SYNC) != Result::NO_ERROR) {
+        return std::nullopt;
+    }
+    return Clock::now() - start;
+}
+
+void BM_GeneratedModel(benchmark::State& state, const TestModel* testModel,
+                       const ANeuralNetworksDevice* device) {
+    GeneratedModel model;
+    createModel(*testModel, &model);
+    if (!model.isValid() || model.finish() != Result::NO_ERROR) {
+        state.SkipWithError("unable to create the model");
+        return;
+    }
+
+    auto [result, compilation] = Compilation::createForDevice(&model, device);
+    if (result != Result::NO_ERROR) {
+        state.SkipWithError("unable to create the compilation");
+        return;
+    }
+    const auto compileStart = Clock::now();
+    if (compilation.finish() != Result::NO_ERROR) {
+        state.SkipWithError("the device does not support the model");
+        return;
+    }
+    const auto compileDuration = Clock::now() - compileStart;
+
+    const auto firstInference = executeOnce(*testModel, compilation);
+    if (!firstInference.has_value()) {
+        state.SkipWithError("the first execution failed");
+        return;
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(state.max_iterations);
+    for (auto _ : state) {
+        const auto latency = executeOnce(*testModel, compilation);
+        if (!latency.has_value()) {
+            state.SkipWithError("an execution failed");
+            return;
+        }
+        latencies.push_back(toMicroseconds(latency.value()));
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    state.counters["compile_ms"] = toMicroseconds(compileDuration) / 1000.0;
+    state.counters["first_inference_us"] = toMicroseconds(firstInference.value());
+    if (!latencies.empty()) {
+        state.counters["p50_us"] = getPercentile(latencies, 50);
+        state.counters["p90_us"] = getPercentile(latencies, 90);
+        state.counters["p99_us"] = getPercentile(latencies, 99);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Registers one benchmark per test model that is expected to compile and
+// execute successfully.
+void registerBenchmarks(const std::string& deviceFlag, const ANeuralNetworksDevice* device) {
+    const auto testModels = TestModelManager::get().getTestModels(
+            [](const TestModel& testModel) { return !testModel.expectFailure; });
+    for (const auto& [name, testModel] : testModels) {
+        benchmark::RegisterBenchmark(("GeneratedModel/" + deviceFlag + "/" + name).c_str(),
+                                     BM_GeneratedModel, testModel, device)
+                ->Unit(benchmark::kMicrosecond)
+                ->UseRealTime();
+    }
+}
+
+}  // namespace
+}  // namespace android::nn::generated_tests
+
+int main(int argc, char** argv) {
+    using namespace android::nn;
+
+    // Consume the flag selecting the device, which Google Benchmark does not know.
+    std::string deviceFlag = "cpu";
+    int remaining = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], generated_tests::kDeviceFlag,
+                         std::strlen(generated_tests::kDeviceFlag)) == 0) {
+            deviceFlag = argv[i] + std::strlen(generated_tests::kDeviceFlag);
+        } else {
+            argv[remaining++] = argv[i];
+        }
+    }
+    argc = remaining;
+
+    const char* deviceName = nullptr;
+    if (deviceFlag == "cpu") {
+        deviceName = generated_tests::kCpuDeviceName;
+    } else if (deviceFlag == "sample") {
+        DeviceManager::get()->forTest_registerDevice(
+                std::make_shared<const sample::Device>(generated_tests::kSampleDeviceName));
+        deviceName = generated_tests::kSampleDeviceName;
+    } else {
+        fprintf(stderr, "Unknown device \"%s\", expected cpu or sample\n", deviceFlag.c_str());
+        return 1;
+    }
+    const ANeuralNetworksDevice* device = generated_tests::findDevice(deviceName);
+    if (device == nullptr) {
+        fprintf(stderr, "Device %s is not available\n", deviceName);
+        return 1;
+    }
+
+    generated_tests::registerBenchmarks(deviceFlag, device);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
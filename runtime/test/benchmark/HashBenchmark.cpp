@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Hash throughput of the model architecture hash, the cache token hasher and
+// the underlying hash functions.
+
+#include <FastHash.h>
+#include <TokenHasher.h>
+#include <benchmark/benchmark.h>
+#include <nnapi/Types.h>
+#include <openssl/sha.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "ModelArchHasher.h"
+
+namespace android::nn {
+namespace {
+
+// Builds a chain of numOperations ADD operations on 4-D tensors. The model is
+// only meant to be hashed, not executed.
+Model makeLargeModel(uint32_t numOperations) {
+    const int32_t activation = 0;
+    Model model{.operandValues = Model::OperandValues(
+                        reinterpret_cast<const uint8_t*>(&activation), sizeof(activation))};
+    auto& operands = model.main.operands;
+    const Operand tensor = {.type = OperandType::TENSOR_FLOAT32,
+                            .dimensions = {1, 224, 224, 3},
+                            .lifetime = Operand::LifeTime::TEMPORARY_VARIABLE};
+    operands.push_back(tensor);
+    operands.back().lifetime = Operand::LifeTime::SUBGRAPH_INPUT;
+    operands.push_back({.type = OperandType::INT32,
+                        .lifetime = Operand::LifeTime::CONSTANT_COPY,
+                        .location = {.length = sizeof(activation)}});
+    uint32_t previous = 0;
+    for (uint32_t i = 0; i < numOperations; ++i) {
+        const uint32_t output = operands.size();
+        operands.push_back(tensor);
+        model.main.operations.push_back(
+                {.type = OperationType::ADD, .inputs = {previous, 0, 1}, .outputs = {output}});
+        previous = output;
+    }
+    operands.back().lifetime = Operand::LifeTime::SUBGRAPH_OUTPUT;
+    model.main.inputIndexes = {0};
+    model.main.outputIndexes = {previous};
+    return model;
+}
+
+// The architecture hash as computed before fields were batched: one
+// SHA256_Update call per field.
+void perFieldSha256ArchHash(const Model& model, uint8_t* data) {
+    SHA256_CTX hasher;
+    SHA256_Init(&hasher);
+    const auto update = [&hasher](const void* bytes, size_t length) {
+        SHA256_Update(&hasher, bytes, length);
+    };
+    for (auto& operand : model.main.operands) {
+        update(&operand.type, sizeof(operand.type));
+        update(operand.dimensions.data(), sizeof(uint32_t) * operand.dimensions.size());
+        update(&operand.scale, sizeof(operand.scale));
+        update(&operand.zeroPoint, sizeof(operand.zeroPoint));
+        update(&operand.lifetime, sizeof(operand.lifetime));
+        update(&operand.extraParams, sizeof(operand.extraParams));
+    }
+    for (auto& operation : model.main.operations) {
+        update(&operation.type, sizeof(operation.type));
+        update(operation.inputs.data(), sizeof(uint32_t) * operation.inputs.size());
+        update(operation.outputs.data(), sizeof(uint32_t) * operation.outputs.size());
+    }
+    update(model.main.inputIndexes.data(), sizeof(uint32_t) * model.main.inputIndexes.size());
+    update(model.main.outputIndexes.data(), sizeof(uint32_t) * model.main.outputIndexes.size());
+    SHA256_Final(data, &hasher);
+}
+
+template <bool (*hash)(const Model&, uint8_t*)>
+void BM_ModelArch(benchmark::State& state) {
+    const Model model = makeLargeModel(state.range(0));
+    uint8_t result[32];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hash(model, result));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_ModelArch, calcModelArchHash)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK_TEMPLATE(BM_ModelArch, calcModelArchDigest)->RangeMultiplier(10)->Range(100, 100000);
+
+void BM_ModelArchPerFieldSha256(benchmark::State& state) {
+    const Model model = makeLargeModel(state.range(0));
+    uint8_t result[32];
+    for (auto _ : state) {
+        perFieldSha256ArchHash(model, result);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ModelArchPerFieldSha256)->RangeMultiplier(10)->Range(100, 100000);
+
+// Mirrors how ExecutionStep rehashes the cache token with two small updates
+// per operation in the step.
+void BM_TokenHasherPerOperationUpdates(benchmark::State& state) {
+    const std::vector<uint8_t> seed(ANEURALNETWORKS_BYTE_SIZE_OF_CACHE_TOKEN, 0);
+    const uint32_t sourceModelIndex = 0;
+    for (auto _ : state) {
+        TokenHasher hasher(seed.data());
+        for (uint32_t operationIndex = 0; operationIndex < state.range(0); ++operationIndex) {
+            hasher.update(&sourceModelIndex, sizeof(sourceModelIndex));
+            hasher.update(&operationIndex, sizeof(operationIndex));
+        }
+        benchmark::DoNotOptimize(hasher.finish());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TokenHasherPerOperationUpdates)->RangeMultiplier(10)->Range(100, 100000);
+
+void BM_FastHash64(benchmark::State& state) {
+    const std::vector<uint8_t> data(state.range(0), 0x5A);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fastHash64(data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FastHash64)->Range(1 << 10, 1 << 24);
+
+void BM_FastHash256(benchmark::State& state) {
+    const std::vector<uint8_t> data(state.range(0), 0x5A);
+    uint8_t result[kFastHash256Size];
+    for (auto _ : state) {
+        fastHash256(data.data(), data.size(), result);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FastHash256)->Range(1 << 10, 1 << 24);
+
+void BM_Sha256(benchmark::State& state) {
+    const std::vector<uint8_t> data(state.range(0), 0x5A);
+    uint8_t result[SHA256_DIGEST_LENGTH];
+    for (auto _ : state) {
+        SHA256(data.data(), data.size(), result);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Sha256)->Range(1 << 10, 1 << 24);
+
+}  // namespace
+}  // namespace android::nn
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// ANeuralNetworksMemory_copy between two memories allocated by the sample
+// driver, for tensors of 1 MB to 64 MB. Compares the direct copy between two
+// buffers of the same device with copies through a staging memory, either
+// reused across copies or allocated for each copy.
+
+#include <CanonicalDevice.h>
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <benchmark/benchmark.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#ifdef __ANDROID__
+#include <android/sharedmem.h>
+#endif  // __ANDROID__
+
+#include "Manager.h"
+#include "Memory.h"
+#include "NeuralNetworks.h"
+
+namespace android::nn {
+namespace {
+
+constexpr char kDeviceName[] = "memory-copy-benchmark-driver";
+constexpr uint32_t kMegabyte = 1024 * 1024;
+
+const ANeuralNetworksDevice* getSampleDevice() {
+    static const ANeuralNetworksDevice* const device = []() -> const ANeuralNetworksDevice* {
+        DeviceManager::get()->forTest_registerDevice(
+                std::make_shared<const sample::Device>(kDeviceName));
+        uint32_t count = 0;
+        ANeuralNetworks_getDeviceCount(&count);
+        for (uint32_t i = 0; i < count; ++i) {
+            ANeuralNetworksDevice* candidate = nullptr;
+            const char* name = nullptr;
+            ANeuralNetworks_getDevice(i, &candidate);
+            ANeuralNetworksDevice_getName(candidate, &name);
+            if (std::strcmp(name, kDeviceName) == 0) {
+                return candidate;
+            }
+        }
+        return nullptr;
+    }();
+    return device;
+}
+
+// ADD(input, input) compiled for the sample driver, and two memories of the
+// driver that can be used both as its input and its output.
+class DeviceMemories {
+   public:
+    explicit DeviceMemories(uint32_t size) : kSize(size) {
+        const uint32_t dimensions[] = {size / static_cast<uint32_t>(sizeof(float))};
+        const ANeuralNetworksOperandType tensorType = {.type = ANEURALNETWORKS_TENSOR_FLOAT32,
+                                                       .dimensionCount = 1,
+                                                       .dimensions = dimensions};
+        const ANeuralNetworksOperandType activationType = {.type = ANEURALNETWORKS_INT32};
+        const int32_t activation = ANEURALNETWORKS_FUSED_NONE;
+        ANeuralNetworksModel_create(&mModel);
+        ANeuralNetworksModel_addOperand(mModel, &tensorType);
+        ANeuralNetworksModel_addOperand(mModel, &activationType);
+        ANeuralNetworksModel_addOperand(mModel, &tensorType);
+        ANeuralNetworksModel_setOperandValue(mModel, 1, &activation, sizeof(activation));
+        const uint32_t addInputs[] = {0, 0, 1};
+        const uint32_t addOutputs[] = {2};
+        ANeuralNetworksModel_addOperation(mModel, ANEURALNETWORKS_ADD, 3, addInputs, 1,
+                                          addOutputs);
+        const uint32_t modelInputs[] = {0};
+        ANeuralNetworksModel_identifyInputsAndOutputs(mModel, 1, modelInputs, 1, addOutputs);
+        ANeuralNetworksModel_finish(mModel);
+
+        const ANeuralNetworksDevice* device = getSampleDevice();
+        if (device == nullptr ||
+            ANeuralNetworksCompilation_createForDevices(mModel, &device, 1, &mCompilation) !=
+                    ANEURALNETWORKS_NO_ERROR ||
+            ANeuralNetworksCompilation_finish(mCompilation) != ANEURALNETWORKS_NO_ERROR) {
+            return;
+        }
+        ANeuralNetworksMemoryDesc* desc = nullptr;
+        ANeuralNetworksMemoryDesc_create(&desc);
+        ANeuralNetworksMemoryDesc_addInputRole(desc, mCompilation, 0, 1.0f);
+        ANeuralNetworksMemoryDesc_addOutputRole(desc, mCompilation, 0, 1.0f);
+        ANeuralNetworksMemoryDesc_finish(desc);
+        ANeuralNetworksMemory_createFromDesc(desc, &mSource);
+        ANeuralNetworksMemory_createFromDesc(desc, &mDestination);
+        ANeuralNetworksMemoryDesc_free(desc);
+    }
+
+    ~DeviceMemories() {
+        ANeuralNetworksMemory_free(mDestination);
+        ANeuralNetworksMemory_free(mSource);
+        ANeuralNetworksCompilation_free(mCompilation);
+        ANeuralNetworksModel_free(mModel);
+    }
+
+    // Sets the content of the source memory from a shared memory, and checks
+    // that the destination memory has the same content after copy().
+    bool setSourceAndCheckDestination() {
+        if (mSource == nullptr || mDestination == nullptr) return false;
+#ifdef __ANDROID__
+        base::unique_fd fd(ASharedMemory_create(nullptr, kSize));
+#else   // __ANDROID__
+        TemporaryFile file;
+        base::unique_fd fd(file.release());
+        if (ftruncate(fd.get(), kSize) != 0) return false;
+#endif  // __ANDROID__
+        void* data = mmap(nullptr, kSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+        if (data == MAP_FAILED) return false;
+        ANeuralNetworksMemory* host = nullptr;
+        ANeuralNetworksMemory_createFromFd(kSize, PROT_READ | PROT_WRITE, fd.get(), 0, &host);
+        bool success = host != nullptr;
+        if (success) {
+            std::memset(data, 0x5a, kSize);
+            success = ANeuralNetworksMemory_copy(host, mSource) == ANEURALNETWORKS_NO_ERROR &&
+                      copy();
+            std::memset(data, 0, kSize);
+            success = success &&
+                      ANeuralNetworksMemory_copy(mDestination, host) == ANEURALNETWORKS_NO_ERROR;
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            success = success && bytes[0] == 0x5a && bytes[kSize - 1] == 0x5a;
+        }
+        ANeuralNetworksMemory_free(host);
+        munmap(data, kSize);
+        return success;
+    }
+
+    bool copy() const {
+        return ANeuralNetworksMemory_copy(mSource, mDestination) == ANEURALNETWORKS_NO_ERROR;
+    }
+
+   private:
+    const uint32_t kSize;
+    ANeuralNetworksModel* mModel = nullptr;
+    ANeuralNetworksCompilation* mCompilation = nullptr;
+    ANeuralNetworksMemory* mSource = nullptr;
+    ANeuralNetworksMemory* mDestination = nullptr;
+};
+
+void benchmarkCopy(benchmark::State& state, const RuntimeMemory::DeviceCopyOptions& options) {
+    const uint32_t size = static_cast<uint32_t>(state.range(0)) * kMegabyte;
+    RuntimeMemory::forTest_setDeviceCopyOptions(options);
+    DeviceMemories memories(size);
+    if (!memories.setSourceAndCheckDestination()) {
+        state.SkipWithError("unable to set up the device memories");
+        RuntimeMemory::forTest_setDeviceCopyOptions({});
+        return;
+    }
+    bool failed = false;
+    for (auto _ : state) {
+        failed |= !memories.copy();
+    }
+    RuntimeMemory::forTest_setDeviceCopyOptions({});
+    if (failed) {
+        state.SkipWithError("ANeuralNetworksMemory_copy failed");
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+void BM_DirectCopy(benchmark::State& state) {
+    benchmarkCopy(state, {.allowDirectCopy = true, .reuseStagingMemory = true});
+}
+
+void BM_PooledStagingCopy(benchmark::State& state) {
+    benchmarkCopy(state, {.allowDirectCopy = false, .reuseStagingMemory = true});
+}
+
+void BM_StagingCopy(benchmark::State& state) {
+    benchmarkCopy(state, {.allowDirectCopy = false, .reuseStagingMemory = false});
+}
+
+BENCHMARK(BM_DirectCopy)->ArgName("MB")->RangeMultiplier(2)->Range(1, 64);
+BENCHMARK(BM_PooledStagingCopy)->ArgName("MB")->RangeMultiplier(2)->Range(1, 64);
+BENCHMARK(BM_StagingCopy)->ArgName("MB")->RangeMultiplier(2)->Range(1, 64);
+
+}  // namespace
+}  // namespace android::nn
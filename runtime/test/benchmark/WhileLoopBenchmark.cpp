@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A WHILE loop on the CPU, carrying a float32 state tensor of 1K to 1M
+// elements through 10 to 100 iterations, as while_sum_of_powers does with a
+// larger state. Reports the loop iterations per second and the bytes of state
+// read and written by the body.
+//
+// The outputs of a loop with an odd number of iterations are written in place,
+// those of a loop with an even number of iterations are copied once.
+//
+// Also compares the cost of a loop iteration of a small state when the CPU
+// executes the whole loop with its cost when the runtime interprets the loop.
+
+#include <benchmark/benchmark.h>
+
+#include <iterator>
+#include <vector>
+
+#include "Manager.h"
+#include "NeuralNetworks.h"
+
+namespace android::nn {
+namespace {
+
+ANeuralNetworksOperandType tensor(int32_t type, const uint32_t* dimensions) {
+    return {.type = type, .dimensionCount = 1, .dimensions = dimensions};
+}
+
+// state = state * 0.5 + 1, for iterationCount iterations.
+class WhileLoop {
+   public:
+    WhileLoop(uint32_t stateSize, int32_t iterationCount)
+        : kStateDimensions{stateSize}, mState(stateSize, 1.0f), mOutput(stateSize) {
+        buildCondition(iterationCount);
+        buildBody();
+        buildMain();
+        ANeuralNetworksCompilation_create(mMain, &mCompilation);
+        ANeuralNetworksCompilation_finish(mCompilation);
+        ANeuralNetworksExecution_create(mCompilation, &mExecution);
+        ANeuralNetworksExecution_setReusable(mExecution, true);
+        ANeuralNetworksExecution_setInput(mExecution, 0, nullptr, mState.data(),
+                                          mState.size() * sizeof(float));
+        ANeuralNetworksExecution_setInput(mExecution, 1, nullptr, &kCounter, sizeof(kCounter));
+        ANeuralNetworksExecution_setOutput(mExecution, 0, nullptr, mOutput.data(),
+                                           mOutput.size() * sizeof(float));
+        ANeuralNetworksExecution_setOutput(mExecution, 1, nullptr, &mCounterOutput,
+                                           sizeof(mCounterOutput));
+    }
+
+    ~WhileLoop() {
+        ANeuralNetworksExecution_free(mExecution);
+        ANeuralNetworksCompilation_free(mCompilation);
+        ANeuralNetworksModel_free(mMain);
+        ANeuralNetworksModel_free(mBody);
+        ANeuralNetworksModel_free(mCondition);
+    }
+
+    bool compute() {
+        return ANeuralNetworksExecution_compute(mExecution) == ANEURALNETWORKS_NO_ERROR;
+    }
+
+   private:
+    // counter < iterationCount
+    void buildCondition(int32_t iterationCount) {
+        ANeuralNetworksModel_create(&mCondition);
+        addOperand(mCondition, tensor(ANEURALNETWORKS_TENSOR_FLOAT32, kStateDimensions));  // 0
+        addOperand(mCondition, tensor(ANEURALNETWORKS_TENSOR_INT32, kScalarDimensions));   // 1
+        addOperand(mCondition, tensor(ANEURALNETWORKS_TENSOR_INT32, kScalarDimensions));   // 2
+        addOperand(mCondition, tensor(ANEURALNETWORKS_TENSOR_BOOL8, kScalarDimensions));   // 3
+        ANeuralNetworksModel_setOperandValue(mCondition, 2, &iterationCount,
+                                             sizeof(iterationCount));
+        const uint32_t lessInputs[] = {1, 2};
+        const uint32_t lessOutputs[] = {3};
+        ANeuralNetworksModel_addOperation(mCondition, ANEURALNETWORKS_LESS, 2, lessInputs, 1,
+                                          lessOutputs);
+        const uint32_t inputs[] = {0, 1};
+        ANeuralNetworksModel_identifyInputsAndOutputs(mCondition, 2, inputs, 1, lessOutputs);
+        ANeuralNetworksModel_finish(mCondition);
+    }
+
+    // state = state * 0.5 + 1, counter = counter + 1
+    void buildBody() {
+        ANeuralNetworksModel_create(&mBody);
+        const ANeuralNetworksOperandType int32Type = {.type = ANEURALNETWORKS_INT32};
+        addOperand(mBody, tensor(ANEURALNETWORKS_TENSOR_FLOAT32, kStateDimensions));   // 0: state
+        addOperand(mBody, tensor(ANEURALNETWORKS_TENSOR_INT32, kScalarDimensions));    // 1: counter
+        addOperand(mBody, tensor(ANEURALNETWORKS_TENSOR_FLOAT32, kScalarDimensions));  // 2: half
+        addOperand(mBody, tensor(ANEURALNETWORKS_TENSOR_FLOAT32, kScalarDimensions));  // 3: one
+        addOperand(mBody, int32Type);  // 4: activation
+        addOperand(mBody, tensor(ANEURALNETWORKS_TENSOR_FLOAT32, kStateDimensions));  // 5: scaled
+        addOperand(mBody, tensor(ANEURALNETWORKS_TENSOR_FLOAT32, kStateDimensions));  // 6: state
+        addOperand(mBody, tensor(ANEURALNETWORKS_TENSOR_INT32, kScalarDimensions));   // 7: one
+        addOperand(mBody, tensor(ANEURALNETWORKS_TENSOR_INT32, kScalarDimensions));   // 8: counter
+        const float half = 0.5f;
+        const float one = 1.0f;
+        const int32_t none = ANEURALNETWORKS_FUSED_NONE;
+        const int32_t increment = 1;
+        ANeuralNetworksModel_setOperandValue(mBody, 2, &half, sizeof(half));
+        ANeuralNetworksModel_setOperandValue(mBody, 3, &one, sizeof(one));
+        ANeuralNetworksModel_setOperandValue(mBody, 4, &none, sizeof(none));
+        ANeuralNetworksModel_setOperandValue(mBody, 7, &increment, sizeof(increment));
+        const uint32_t mulInputs[] = {0, 2, 4};
+        const uint32_t mulOutputs[] = {5};
+        const uint32_t addInputs[] = {5, 3, 4};
+        const uint32_t addOutputs[] = {6};
+        const uint32_t incrementInputs[] = {1, 7, 4};
+        const uint32_t incrementOutputs[] = {8};
+        ANeuralNetworksModel_addOperation(mBody, ANEURALNETWORKS_MUL, 3, mulInputs, 1, mulOutputs);
+        ANeuralNetworksModel_addOperation(mBody, ANEURALNETWORKS_ADD, 3, addInputs, 1, addOutputs);
+        ANeuralNetworksModel_addOperation(mBody, ANEURALNETWORKS_ADD, 3, incrementInputs, 1,
+                                          incrementOutputs);
+        const uint32_t inputs[] = {0, 1};
+        const uint32_t outputs[] = {6, 8};
+        ANeuralNetworksModel_identifyInputsAndOutputs(mBody, 2, inputs, 2, outputs);
+        ANeuralNetworksModel_finish(mBody);
+    }
+
+    // WHILE(condition, body, state, counter)
+    void buildMain() {
+        ANeuralNetworksModel_create(&mMain);
+        const ANeuralNetworksOperandType modelType = {.type = ANEURALNETWORKS_MODEL};
+        addOperand(mMain, tensor(ANEURALNETWORKS_TENSOR_FLOAT32, kStateDimensions));  // 0
+        addOperand(mMain, tensor(ANEURALNETWORKS_TENSOR_INT32, kScalarDimensions));   // 1
+        addOperand(mMain, modelType);                                                 // 2
+        addOperand(mMain, modelType);                                                 // 3
+        addOperand(mMain, tensor(ANEURALNETWORKS_TENSOR_FLOAT32, kStateDimensions));  // 4
+        addOperand(mMain, tensor(ANEURALNETWORKS_TENSOR_INT32, kScalarDimensions));   // 5
+        ANeuralNetworksModel_setOperandValueFromModel(mMain, 2, mCondition);
+        ANeuralNetworksModel_setOperandValueFromModel(mMain, 3, mBody);
+        const uint32_t whileInputs[] = {2, 3, 0, 1};
+        const uint32_t whileOutputs[] = {4, 5};
+        ANeuralNetworksModel_addOperation(mMain, ANEURALNETWORKS_WHILE, std::size(whileInputs),
+                                          whileInputs, std::size(whileOutputs), whileOutputs);
+        const uint32_t inputs[] = {0, 1};
+        ANeuralNetworksModel_identifyInputsAndOutputs(mMain, 2, inputs, 2, whileOutputs);
+        ANeuralNetworksModel_finish(mMain);
+    }
+
+    static void addOperand(ANeuralNetworksModel* model, const ANeuralNetworksOperandType& type) {
+        ANeuralNetworksModel_addOperand(model, &type);
+    }
+
+    static constexpr uint32_t kScalarDimensions[] = {1};
+    static constexpr int32_t kCounter = 0;
+    const uint32_t kStateDimensions[1];
+    std::vector<float> mState;
+    std::vector<float> mOutput;
+    int32_t mCounterOutput = 0;
+    ANeuralNetworksModel* mCondition = nullptr;
+    ANeuralNetworksModel* mBody = nullptr;
+    ANeuralNetworksModel* mMain = nullptr;
+    ANeuralNetworksCompilation* mCompilation = nullptr;
+    ANeuralNetworksExecution* mExecution = nullptr;
+};
+
+void BM_WhileLoop(benchmark::State& state) {
+    const uint32_t stateSize = state.range(0);
+    const int32_t iterationCount = state.range(1);
+    WhileLoop loop(stateSize, iterationCount);
+    for (auto _ : state) {
+        if (!loop.compute()) {
+            state.SkipWithError("execution failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * iterationCount);
+    state.SetBytesProcessed(state.iterations() * iterationCount * 2 * stateSize * sizeof(float));
+}
+BENCHMARK(BM_WhileLoop)
+        ->ArgNames({"elements", "iterations"})
+        ->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {10, 11, 100}})
+        ->Unit(benchmark::kMicrosecond)
+        ->UseRealTime();
+
+// The cost of a loop iteration with a small state, when the CPU executes the
+// whole WHILE operation, and when the runtime interprets it and executes the
+// condition and body models as separate CPU steps on each iteration.
+template <bool kFuseCpuControlFlow>
+void BM_WhileLoopIteration(benchmark::State& state) {
+    const int32_t iterationCount = state.range(0);
+    DeviceManager::get()->setFuseCpuControlFlow(kFuseCpuControlFlow);
+    WhileLoop loop(/*stateSize=*/4, iterationCount);
+    DeviceManager::get()->setFuseCpuControlFlow(true);
+    for (auto _ : state) {
+        if (!loop.compute()) {
+            state.SkipWithError("execution failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * iterationCount);
+    state.counters["time_per_iteration"] = benchmark::Counter(
+            iterationCount, benchmark::Counter::kIsIterationInvariantRate |
+                                    benchmark::Counter::kInvert);
+}
+BENCHMARK_TEMPLATE(BM_WhileLoopIteration, true)->Arg(10)->Arg(100)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_WhileLoopIteration, false)->Arg(10)->Arg(100)->UseRealTime();
+
+}  // namespace
+}  // namespace android::nn
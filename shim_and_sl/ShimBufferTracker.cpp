@@ -36,34 +36,24 @@ std::unique_ptr<ShimBufferTracker::Token> ShimBufferTracker::add(
     if (buffer == nullptr) {
         return nullptr;
     }
-    std::lock_guard<std::mutex> guard(mMutex);
-    uint32_t token = 0;
-    if (mFreeTokens.empty()) {
-        token = mTokenToBuffers.size();
-        mTokenToBuffers.push_back(std::move(buffer));
-    } else {
-        token = mFreeTokens.top();
-        mFreeTokens.pop();
-        mTokenToBuffers[token] = std::move(buffer);
+    const uint32_t token = mTokenToBuffers.add(std::move(buffer));
+    if (token == 0) {
+        LOG(ERROR) << "ShimBufferTracker::add -- out of tokens";
+        return nullptr;
     }
     return std::make_unique<Token>(token, shared_from_this());
 }
 
 std::shared_ptr<::android::nn::sl_wrapper::Memory> ShimBufferTracker::get(uint32_t token) const {
-    std::lock_guard<std::mutex> guard(mMutex);
-    if (mTokenToBuffers.size() <= token || mTokenToBuffers[token] == nullptr) {
+    auto buffer = mTokenToBuffers.get(token);
+    if (buffer == nullptr) {
         LOG(ERROR) << "ShimBufferTracker::get -- unknown token " << token;
-        return nullptr;
     }
-    return mTokenToBuffers[token];
+    return buffer;
 }
 
 void ShimBufferTracker::free(uint32_t token) {
-    std::lock_guard<std::mutex> guard(mMutex);
-    CHECK_LT(token, mTokenToBuffers.size());
-    CHECK(mTokenToBuffers[token] != nullptr);
-    mTokenToBuffers[token] = nullptr;
-    mFreeTokens.push(token);
+    CHECK(mTokenToBuffers.free(token) != nullptr);
 }
 
 }  // namespace aidl::android::hardware::neuralnetworks
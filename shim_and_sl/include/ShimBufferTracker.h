@@ -21,7 +21,6 @@
 #include <android/binder_auto_utils.h>
 
 #include <memory>
-#include <stack>
 #include <string>
 #include <utility>
 #include <vector>
@@ -29,13 +28,13 @@
 #include "NeuralNetworksShim.h"
 #include "SupportLibrary.h"
 #include "SupportLibraryWrapper.h"
+#include "TokenTable.h"
 
 #include <android-base/macros.h>
 #include <android-base/thread_annotations.h>
 
 namespace aidl::android::hardware::neuralnetworks {
 
-// TODO: This can be templetized.
 // Keep track of all sl_rapper::Memory and assign each with a unique token.
 class ShimBufferTracker : public std::enable_shared_from_this<ShimBufferTracker> {
     DISALLOW_COPY_AND_ASSIGN(ShimBufferTracker);
@@ -64,22 +63,16 @@ class ShimBufferTracker : public std::enable_shared_from_this<ShimBufferTracker>
     }
 
     // Prefer ShimBufferTracker::create.
-    ShimBufferTracker() : mTokenToBuffers(1) {}
+    ShimBufferTracker() = default;
 
     std::unique_ptr<Token> add(std::shared_ptr<::android::nn::sl_wrapper::Memory> buffer);
+    // Thread-safe, and does not contend with other calls to get().
     std::shared_ptr<::android::nn::sl_wrapper::Memory> get(uint32_t token) const;
 
    private:
     void free(uint32_t token);
 
-    mutable std::mutex mMutex;
-    std::stack<uint32_t, std::vector<uint32_t>> mFreeTokens GUARDED_BY(mMutex);
-
-    // Since the tokens are allocated in a non-sparse way, we use a vector to represent the mapping.
-    // The index of the vector is the token. When the token gets freed, the corresponding entry is
-    // set to nullptr. mTokenToBuffers[0] is always set to nullptr because 0 is an invalid token.
-    std::vector<std::shared_ptr<::android::nn::sl_wrapper::Memory>> mTokenToBuffers
-            GUARDED_BY(mMutex);
+    ::android::nn::TokenTable<::android::nn::sl_wrapper::Memory> mTokenToBuffers;
 };
 
 }  // namespace aidl::android::hardware::neuralnetworks
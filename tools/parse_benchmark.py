@@ -5,10 +5,18 @@ Reads a file with output from multiple runs of
   adb shell am instrument
     -w com.android.nn.benchmark.app/androidx.test.runner.AndroidJUnitRunner
 
+or with the JSON output of one or more runs of a Google Benchmark binary such as
+  NeuralNetworksGeneratedBenchmark_static --benchmark_out_format=json
+    --benchmark_out=<file> --benchmark_repetitions=<n>
+
 and provides either raw measurements or aggregated statistics of the runs.
 
+For Google Benchmark output, each benchmark contributes a sample of its real
+time, named after the benchmark, and a sample of each of its counters, named
+<benchmark>_<counter>.
+
 Usage:
-  parse_benchmark --format=[json|table] --output=[full|stats] [adb output filename]
+  parse_benchmark --format=[json|table] --output=[full|stats] [input filename]
 
 """
 import argparse
@@ -43,15 +51,49 @@ def main():
 
 
 def read_data(input_filename):
+  with open(input_filename) as f:
+    if f.read(1) == "{":
+      f.seek(0)
+      return read_benchmark_json(json.load(f))
+    f.seek(0)
+    return read_instrumentation_output(f)
+
+
+def read_instrumentation_output(f):
   data = dict()
 
-  with open(input_filename) as f:
-    for line in f:
-      if "INSTRUMENTATION_STATUS:" in line and "_avg" in line:
-        sample = line.split(": ")[1]
-        name, value = sample.split("=")
-        name = name[:-4]
-        data[name] = data.get(name, []) + [float(value)]
+  for line in f:
+    if "INSTRUMENTATION_STATUS:" in line and "_avg" in line:
+      sample = line.split(": ")[1]
+      name, value = sample.split("=")
+      name = name[:-4]
+      data[name] = data.get(name, []) + [float(value)]
+
+  return data
+
+
+# Fields of a Google Benchmark run that are not user counters.
+BENCHMARK_FIELDS = {
+    "name", "family_index", "per_family_instance_index", "run_name",
+    "run_type", "repetitions", "repetition_index", "threads", "iterations",
+    "real_time", "cpu_time", "time_unit", "error_occurred", "error_message",
+    "aggregate_name", "aggregate_unit", "label", "skipped", "skip_message",
+}
+
+
+def read_benchmark_json(output):
+  data = dict()
+
+  for run in output.get("benchmarks", []):
+    # Aggregates are computed here from the individual repetitions instead.
+    if run.get("run_type") == "aggregate" or run.get("error_occurred"):
+      continue
+    name = run.get("run_name", run["name"])
+    data[name] = data.get(name, []) + [float(run["real_time"])]
+    for counter, value in run.items():
+      if counter not in BENCHMARK_FIELDS and isinstance(value, (int, float)):
+        key = "{0}_{1}".format(name, counter)
+        data[key] = data.get(key, []) + [float(value)]
 
   return data
 
@@ -62,7 +104,7 @@ def compute_stats(data):
   for name in sorted(data):
     values = data[name]
     stat_mean = statistics.mean(values)
-    stat_stdev = statistics.stdev(values)
+    stat_stdev = statistics.stdev(values) if len(values) > 1 else 0.0
     stat_min = min(values)
     stat_max = max(values)
     stat_n = len(values)